@@ -0,0 +1,532 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Headless benchmark. Draws deterministic scenes through a null render back-end, which
+// only counts the geometry, or with -gl through the GL3 back-end into an offscreen
+// framebuffer, and prints the CPU time of each phase and the geometry per frame.
+// -save writes the first measured frame to a capture file, -replay benchmarks a captured frame.
+//
+//   bench [-gl] [-frames n] [-scene demo|text|chart|rects] [-save file] [-replay file]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <time.h>
+#endif
+#ifdef NANOVG_GLEW
+#	include <GL/glew.h>
+#endif
+#ifdef __APPLE__
+#	define GLFW_INCLUDE_GLCOREARB
+#endif
+#include <GLFW/glfw3.h>
+#include "nanovg.h"
+#define NANOVG_GL3_IMPLEMENTATION
+#include "nanovg_gl.h"
+#include "nanovg_gl_utils.h"
+#include "demo.h"
+
+#define WIDTH 1000
+#define HEIGHT 600
+#define WARMUP_FRAMES 10
+#define MAX_NULL_TEXTURES 64
+
+static double getTime(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Null render back-end, which accepts all geometry and only counts it.
+
+struct NullTexture {
+	int width, height;
+};
+typedef struct NullTexture NullTexture;
+
+struct NullRenderer {
+	NullTexture textures[MAX_NULL_TEXTURES];
+	int ntextures;
+	int calls;
+	int verts;
+};
+typedef struct NullRenderer NullRenderer;
+
+static int nullRenderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int nullRenderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	NVG_NOTUSED(type);
+	NVG_NOTUSED(imageFlags);
+	NVG_NOTUSED(data);
+	if (nr->ntextures >= MAX_NULL_TEXTURES) return 0;
+	nr->textures[nr->ntextures].width = w;
+	nr->textures[nr->ntextures].height = h;
+	return ++nr->ntextures;
+}
+
+static int nullRenderDeleteTexture(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	return 1;
+}
+
+static int nullRenderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	NVG_NOTUSED(x);
+	NVG_NOTUSED(y);
+	NVG_NOTUSED(w);
+	NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int nullRenderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	if (image < 1 || image > nr->ntextures) return 0;
+	*w = nr->textures[image-1].width;
+	*h = nr->textures[image-1].height;
+	return 1;
+}
+
+static void nullRenderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	NVG_NOTUSED(width);
+	NVG_NOTUSED(height);
+	NVG_NOTUSED(devicePixelRatio);
+	nr->calls = 0;
+	nr->verts = 0;
+}
+
+static void nullRenderCancel(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+}
+
+static void nullRenderFlush(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+}
+
+static void nullRenderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+						   const float* bounds, const NVGpath* paths, int npaths)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	int i;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(bounds);
+	for (i = 0; i < npaths; i++)
+		nr->verts += paths[i].nfill + paths[i].nstroke;
+	if (npaths > 1 || (!paths[0].convex && !paths[0].triangulated))
+		nr->verts += 4;	// Bounding quad of the stencil fill.
+	nr->calls++;
+}
+
+static void nullRenderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							 float strokeWidth, const NVGpath* paths, int npaths)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	int i;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(strokeWidth);
+	for (i = 0; i < npaths; i++)
+		nr->verts += paths[i].nstroke;
+	nr->calls++;
+}
+
+static void nullRenderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								const NVGvertex* verts, int nverts, float fringe)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(verts);
+	NVG_NOTUSED(fringe);
+	nr->verts += nverts;
+	nr->calls++;
+}
+
+static void nullRenderRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+						   float fringe, const float* rect, float radius)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(rect);
+	NVG_NOTUSED(radius);
+	nr->verts += 6;
+	nr->calls++;
+}
+
+static void nullRenderQuads(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							const NVGvertex* verts, int nquads, float fringe)
+{
+	NullRenderer* nr = (NullRenderer*)uptr;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(verts);
+	NVG_NOTUSED(fringe);
+	nr->verts += nquads*2;
+	nr->calls++;
+}
+
+static void nullRenderDelete(void* uptr)
+{
+	free(uptr);
+}
+
+static NVGcontext* createNull(void)
+{
+	NVGparams params;
+	NullRenderer* nr = (NullRenderer*)malloc(sizeof(NullRenderer));
+	if (nr == NULL) return NULL;
+	memset(nr, 0, sizeof(NullRenderer));
+
+	// Mirrors the callbacks of the GL3 back-end, so that the core takes the same paths.
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = nullRenderCreate;
+	params.renderCreateTexture = nullRenderCreateTexture;
+	params.renderDeleteTexture = nullRenderDeleteTexture;
+	params.renderUpdateTexture = nullRenderUpdateTexture;
+	params.renderGetTextureSize = nullRenderGetTextureSize;
+	params.renderViewport = nullRenderViewport;
+	params.renderCancel = nullRenderCancel;
+	params.renderFlush = nullRenderFlush;
+	params.renderFill = nullRenderFill;
+	params.renderStroke = nullRenderStroke;
+	params.renderTriangles = nullRenderTriangles;
+	params.renderRect = nullRenderRect;
+	params.renderQuads = nullRenderQuads;
+	params.renderDelete = nullRenderDelete;
+	params.userPtr = nr;
+	params.edgeAntiAlias = 1;
+
+	return nvgCreateInternal(&params);
+}
+
+// Scenes, which only depend on the frame number.
+
+static void drawDemo(NVGcontext* vg, DemoData* data, int frame)
+{
+	renderDemo(vg, WIDTH*0.5f, HEIGHT*0.5f, WIDTH, HEIGHT, 1.0f + frame / 60.0f, 0, data);
+}
+
+static void drawText(NVGcontext* vg, DemoData* data, int frame)
+{
+	static const char* words[] = { "lorem", "ipsum", "dolor", "sit", "amet,", "consectetur", "adipiscing", "elit,",
+		"sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore", "magna", "aliqua." };
+	int nwords = (int)(sizeof(words) / sizeof(words[0]));
+	char line[256];
+	float y = 12.0f;
+	int row = 0, i;
+	NVG_NOTUSED(data);
+
+	nvgFontFace(vg, "sans");
+	nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(240,240,240,255));
+	while (y < HEIGHT) {
+		float size = 10.0f + (float)(row % 4) * 2.0f;
+		int n = 0;
+		line[0] = '\0';
+		for (i = 0; i < 16; i++) {
+			const char* w = words[(row*7 + i*3 + frame) % nwords];
+			if (n + (int)strlen(w) + 2 > (int)sizeof(line)) break;
+			n += snprintf(line + n, sizeof(line) - n, "%s ", w);
+		}
+		nvgFontSize(vg, size);
+		nvgText(vg, 10.0f, y, line, NULL);
+		y += size * 1.2f;
+		row++;
+	}
+}
+
+static void drawChart(NVGcontext* vg, DemoData* data, int frame)
+{
+	const int npts = 10000;
+	float dx = (float)WIDTH / (float)(npts-1);
+	int i;
+	NVG_NOTUSED(data);
+
+	nvgBeginPath(vg);
+	for (i = 0; i < npts; i++) {
+		float x = i * dx;
+		float y = HEIGHT*0.5f + sinf(i*0.013f + frame*0.05f) * 150.0f + sinf(i*0.31f) * 30.0f;
+		if (i == 0)
+			nvgMoveTo(vg, x, y);
+		else
+			nvgLineTo(vg, x, y);
+	}
+	nvgStrokeColor(vg, nvgRGBA(0,160,192,255));
+	nvgStrokeWidth(vg, 1.5f);
+	nvgStroke(vg);
+
+	nvgLineTo(vg, WIDTH, HEIGHT);
+	nvgLineTo(vg, 0, HEIGHT);
+	nvgFillColor(vg, nvgRGBA(0,160,192,64));
+	nvgFill(vg);
+}
+
+static void drawRects(NVGcontext* vg, DemoData* data, int frame)
+{
+	int x, y;
+	NVG_NOTUSED(data);
+
+	for (y = 0; y < HEIGHT / 12; y++) {
+		for (x = 0; x < WIDTH / 12; x++) {
+			int c = (x*7 + y*13 + frame) & 255;
+			nvgBeginPath(vg);
+			nvgRoundedRect(vg, x*12.0f + 1.0f, y*12.0f + 1.0f, 10.0f, 10.0f, 3.0f);
+			nvgFillColor(vg, nvgRGBA((unsigned char)c, 128, (unsigned char)(255-c), 255));
+			nvgFill(vg);
+			if (((x + y) & 7) == 0) {
+				nvgStrokeColor(vg, nvgRGBA(255,255,255,128));
+				nvgStrokeWidth(vg, 1.0f);
+				nvgStroke(vg);
+			}
+		}
+	}
+}
+
+static NVGcapture* replayCapture = NULL;
+
+static void drawReplay(NVGcontext* vg, DemoData* data, int frame)
+{
+	NVG_NOTUSED(data);
+	NVG_NOTUSED(frame);
+	nvgReplayCapture(vg, replayCapture);
+}
+
+typedef void (*SceneFunc)(NVGcontext* vg, DemoData* data, int frame);
+
+struct Scene {
+	const char* name;
+	SceneFunc draw;
+};
+typedef struct Scene Scene;
+
+static Scene scenes[] = {
+	{ "demo", drawDemo },
+	{ "text", drawText },
+	{ "chart", drawChart },
+	{ "rects", drawRects },
+};
+
+static int timingNotice = 0;
+
+static void runScene(NVGcontext* vg, NVGLUframebuffer* fb, DemoData* data, const Scene* scene, const char* backend, int frames,
+					 const char* saveName)
+{
+	double frameTime = 0, minTime = 1e9, flatten = 0, expand = 0, text = 0, flush = 0;
+	double calls = 0, verts = 0, tris = 0;
+	NullRenderer* nr = fb == NULL ? (NullRenderer*)nvgInternalParams(vg)->userPtr : NULL;
+	int i;
+
+	for (i = -WARMUP_FRAMES; i < frames; i++) {
+		NVGframeStats stats;
+		double t0, t;
+
+		if (fb != NULL) {
+			nvgluBindFramebuffer(fb);
+			glViewport(0, 0, WIDTH, HEIGHT);
+			glClearColor(0.3f, 0.3f, 0.32f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		}
+
+		if (i == 0 && saveName != NULL)
+			nvgCaptureFrame(vg);
+
+		t0 = getTime();
+		nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+		scene->draw(vg, data, i < 0 ? 0 : i);
+		nvgEndFrame(vg);
+		if (fb != NULL)
+			glFinish();
+		t = getTime() - t0;
+
+		if (i == 0 && saveName != NULL && !nvgSaveCapture(vg, saveName))
+			printf("Could not save capture to %s.\n", saveName);
+
+		if (i < 0) continue;
+
+		nvgFrameStats(vg, &stats);
+		frameTime += t;
+		if (t < minTime) minTime = t;
+		flatten += stats.flattenTime;
+		expand += stats.expandTime;
+		text += stats.textTime;
+		flush += stats.flushTime;
+		calls += stats.drawCalls;
+		tris += stats.fillTriangles + stats.strokeTriangles + stats.textTriangles;
+		verts += nr != NULL ? nr->verts : stats.vertexBytes / (double)sizeof(NVGvertex);
+	}
+
+	if (flatten == 0 && expand == 0 && text == 0 && flush == 0 && !timingNotice) {
+		printf("nanovg was compiled without NVG_STATS_TIMING, the phase times are not measured.\n");
+		timingNotice = 1;
+	}
+	printf("%-6s %-5s %9.3f %9.3f %9.0f %9.0f %9.0f %9.0f %7.0f %8.0f %8.0f\n", scene->name, backend,
+		frameTime / frames * 1e3, minTime * 1e3,
+		flatten / frames * 1e9, expand / frames * 1e9, text / frames * 1e9, flush / frames * 1e9,
+		calls / frames, tris / frames, verts / frames);
+}
+
+static void errorcb(int error, const char* desc)
+{
+	printf("GLFW error %d: %s\n", error, desc);
+}
+
+int main(int argc, char** argv)
+{
+	GLFWwindow* window = NULL;
+	NVGLUframebuffer* fb = NULL;
+	NVGcontext* vg = NULL;
+	DemoData data;
+	const char* sceneName = NULL;
+	const char* saveName = NULL;
+	const char* replayName = NULL;
+	Scene replay = { "replay", drawReplay };
+	int gl = 0, frames = 100, i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-gl") == 0) {
+			gl = 1;
+		} else if (strcmp(argv[i], "-frames") == 0 && i+1 < argc) {
+			frames = atoi(argv[++i]);
+			if (frames < 1) frames = 1;
+		} else if (strcmp(argv[i], "-scene") == 0 && i+1 < argc) {
+			sceneName = argv[++i];
+		} else if (strcmp(argv[i], "-save") == 0 && i+1 < argc) {
+			saveName = argv[++i];
+		} else if (strcmp(argv[i], "-replay") == 0 && i+1 < argc) {
+			replayName = argv[++i];
+		} else {
+			printf("usage: %s [-gl] [-frames n] [-scene demo|text|chart|rects] [-save file] [-replay file]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	if (gl) {
+		if (!glfwInit()) {
+			printf("Failed to init GLFW.");
+			return -1;
+		}
+		glfwSetErrorCallback(errorcb);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		window = glfwCreateWindow(WIDTH, HEIGHT, "NanoVG bench", NULL, NULL);
+		if (!window) {
+			glfwTerminate();
+			return -1;
+		}
+		glfwMakeContextCurrent(window);
+#ifdef NANOVG_GLEW
+		glewExperimental = GL_TRUE;
+		if(glewInit() != GLEW_OK) {
+			printf("Could not init glew.\n");
+			return -1;
+		}
+		// GLEW generates GL error because it calls glGetString(GL_EXTENSIONS), we'll consume it here.
+		glGetError();
+#endif
+		glfwSwapInterval(0);
+		vg = nvgCreateGL3(NVG_ANTIALIAS | NVG_STENCIL_STROKES);
+	} else {
+		vg = createNull();
+	}
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+
+	if (loadDemoData(vg, &data) == -1)
+		return -1;
+
+	if (gl) {
+		fb = nvgluCreateFramebuffer(vg, WIDTH, HEIGHT, 0);
+		if (fb == NULL) {
+			printf("Could not create FBO.\n");
+			return -1;
+		}
+	}
+
+	if (replayName != NULL) {
+		replayCapture = nvgLoadCaptureFile(vg, replayName);
+		if (replayCapture == NULL) {
+			printf("Could not load capture %s.\n", replayName);
+			return -1;
+		}
+	}
+
+	// Times are per frame, the phases in nanoseconds. Vertices are what the back-end received.
+	printf("%-6s %-5s %9s %9s %9s %9s %9s %9s %7s %8s %8s\n", "scene", "back", "ms", "min ms",
+		"flatten", "expand", "text", "flush", "calls", "tris", "verts");
+	if (replayCapture != NULL) {
+		runScene(vg, fb, &data, &replay, gl ? "gl3" : "null", frames, saveName);
+	} else {
+		for (i = 0; i < (int)(sizeof(scenes) / sizeof(scenes[0])); i++) {
+			if (sceneName != NULL && strcmp(sceneName, scenes[i].name) != 0) continue;
+			runScene(vg, fb, &data, &scenes[i], gl ? "gl3" : "null", frames, saveName);
+		}
+	}
+
+	nvgDeleteCapture(replayCapture);
+	freeDemoData(vg, &data);
+	if (fb != NULL) nvgluDeleteFramebuffer(fb);
+	if (gl) {
+		nvgDeleteGL3(vg);
+		glfwTerminate();
+	} else {
+		nvgDeleteInternal(vg);
+	}
+	return 0;
+}
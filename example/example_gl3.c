@@ -17,6 +17,7 @@
 //
 
 #include <stdio.h>
+#include <string.h>
 #ifdef NANOVG_GLEW
 #	include <GL/glew.h>
 #endif
@@ -61,7 +62,8 @@ int main()
 	DemoData data;
 	NVGcontext* vg = NULL;
 	GPUtimer gpuTimer;
-	PerfGraph fps, cpuGraph, gpuGraph;
+	PerfGraph fps, cpuGraph, gpuGraph, nvgGraph;
+	NVGframeStats stats;
 	double prevt = 0, cpuTime = 0;
 
 	if (!glfwInit()) {
@@ -72,6 +74,8 @@ int main()
 	initGraph(&fps, GRAPH_RENDER_FPS, "Frame Time");
 	initGraph(&cpuGraph, GRAPH_RENDER_MS, "CPU Time");
 	initGraph(&gpuGraph, GRAPH_RENDER_MS, "GPU Time");
+	initGraph(&nvgGraph, GRAPH_RENDER_MS, "NanoVG Time");
+	memset(&stats, 0, sizeof(stats));
 
 	glfwSetErrorCallback(errorcb);
 #ifndef _WIN32 // don't require this on win32, and works with more cards
@@ -162,14 +166,18 @@ int main()
 		renderGraph(vg, 5+200+5,5, &cpuGraph);
 		if (gpuTimer.supported)
 			renderGraph(vg, 5+200+5+200+5,5, &gpuGraph);
+		renderGraph(vg, 5,5+35+5, &nvgGraph);
+		renderFrameStats(vg, 5,5+35+5+35+5, &stats);
 
 		nvgEndFrame(vg);
+		nvgFrameStats(vg, &stats);
 
 		// Measure the CPU time taken excluding swap buffers (as the swap may wait for GPU)
 		cpuTime = glfwGetTime() - t;
 
 		updateGraph(&fps, dt);
 		updateGraph(&cpuGraph, cpuTime);
+		updateGraph(&nvgGraph, stats.flattenTime + stats.expandTime + stats.flushTime);
 
 		// We may get multiple results.
 		n = stopGPUTimer(&gpuTimer, gpuTimes, 3);
@@ -192,6 +200,7 @@ int main()
 	printf("Average Frame Time: %.2f ms\n", getGraphAverage(&fps) * 1000.0f);
 	printf("          CPU Time: %.2f ms\n", getGraphAverage(&cpuGraph) * 1000.0f);
 	printf("          GPU Time: %.2f ms\n", getGraphAverage(&gpuGraph) * 1000.0f);
+	printf("       NanoVG Time: %.2f ms\n", getGraphAverage(&nvgGraph) * 1000.0f);
 
 	glfwTerminate();
 	return 0;
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nanovg.h"
+#define NANOVG_SW_IMPLEMENTATION
+#include "nanovg_sw.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define WIDTH 640
+#define HEIGHT 480
+
+static void drawThumbnail(NVGcontext* vg, int image, float w, float h)
+{
+	NVGpaint paint;
+	int i;
+
+	// Background
+	paint = nvgLinearGradient(vg, 0, 0, 0, h, nvgRGBA(60,64,72,255), nvgRGBA(28,30,34,255));
+	nvgBeginPath(vg);
+	nvgRect(vg, 0, 0, w, h);
+	nvgFillPaint(vg, paint);
+	nvgFill(vg);
+
+	// Image with a drop shadow
+	paint = nvgBoxGradient(vg, 40, 44, 260, 180, 10, 20, nvgRGBA(0,0,0,160), nvgRGBA(0,0,0,0));
+	nvgBeginPath(vg);
+	nvgRect(vg, 20, 24, 300, 220);
+	nvgFillPaint(vg, paint);
+	nvgFill(vg);
+	if (image != 0) {
+		paint = nvgImagePattern(vg, 40, 40, 260, 180, 0, image, 1.0f);
+		nvgBeginPath(vg);
+		nvgRoundedRect(vg, 40, 40, 260, 180, 8);
+		nvgFillPaint(vg, paint);
+		nvgFill(vg);
+	}
+
+	// Chart
+	nvgBeginPath(vg);
+	nvgMoveTo(vg, 340, 220);
+	for (i = 0; i <= 10; i++)
+		nvgLineTo(vg, 340 + i*26, 220 - (float)((i*37) % 11) * 14.0f);
+	nvgStrokeColor(vg, nvgRGBA(0,160,192,255));
+	nvgStrokeWidth(vg, 3.0f);
+	nvgLineJoin(vg, NVG_ROUND);
+	nvgStroke(vg);
+
+	nvgBeginPath(vg);
+	nvgCircle(vg, 480, 360, 70);
+	nvgPathWinding(vg, NVG_SOLID);
+	nvgCircle(vg, 480, 360, 40);
+	nvgPathWinding(vg, NVG_HOLE);
+	nvgFillColor(vg, nvgRGBA(255,192,0,255));
+	nvgFill(vg);
+
+	// Text
+	nvgFontSize(vg, 28.0f);
+	nvgFontFace(vg, "sans");
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(255,255,255,255));
+	nvgText(vg, 40, 280, "Rendered without a GPU", NULL);
+	nvgFontSize(vg, 16.0f);
+	nvgFillColor(vg, nvgRGBA(255,255,255,160));
+	nvgTextBox(vg, 40, 320, 320, "The software renderer splits the frame into tiles and rasterizes them on worker threads.", NULL);
+}
+
+int main(int argc, char** argv)
+{
+	NVGcontext* vg = NULL;
+	unsigned char* pixels = NULL;
+	int image, nthreads = argc > 1 ? atoi(argv[1]) : 4;
+
+	vg = nvgCreateSW(nthreads);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+
+	pixels = (unsigned char*)malloc(WIDTH*HEIGHT*4);
+	if (pixels == NULL) {
+		nvgDeleteSW(vg);
+		return -1;
+	}
+
+	if (nvgCreateFont(vg, "sans", "../example/Roboto-Regular.ttf") == -1) {
+		printf("Could not add font.\n");
+		return -1;
+	}
+	image = nvgCreateImage(vg, "../example/images/image1.jpg", 0);
+
+	nvgswSetFramebuffer(vg, pixels, WIDTH, HEIGHT, WIDTH*4);
+	memset(pixels, 0, WIDTH*HEIGHT*4);
+
+	nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f);
+	drawThumbnail(vg, image, WIDTH, HEIGHT);
+	nvgEndFrame(vg);
+
+	stbi_write_png("example_sw.png", WIDTH, HEIGHT, 4, pixels, WIDTH*4);
+	printf("Wrote example_sw.png\n");
+
+	if (image != 0) nvgDeleteImage(vg, image);
+	nvgDeleteSW(vg);
+	free(pixels);
+
+	return 0;
+}
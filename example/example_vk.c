@@ -0,0 +1,629 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include "nanovg.h"
+#define NANOVG_VK_IMPLEMENTATION
+#include "nanovg_vk.h"
+#include "demo.h"
+#include "perf.h"
+
+#define FRAMES 2
+#define MAX_IMAGES 8
+
+struct Swapchain {
+	VkSwapchainKHR swapchain;
+	VkFormat format;
+	VkExtent2D extent;
+	uint32_t nimages;
+	VkImage images[MAX_IMAGES];
+	VkImageView views[MAX_IMAGES];
+	VkFramebuffer framebuffers[MAX_IMAGES];
+	VkSemaphore renderDone[MAX_IMAGES];	// Presenting an image waits for the frame which rendered it.
+	VkImage stencil;
+	VkDeviceMemory stencilMemory;
+	VkImageView stencilView;
+};
+typedef struct Swapchain Swapchain;
+
+struct Frame {
+	VkCommandPool pool;
+	VkCommandBuffer cmd;
+	VkFence fence;
+	VkSemaphore acquired;
+};
+typedef struct Frame Frame;
+
+VkInstance instance = VK_NULL_HANDLE;
+VkSurfaceKHR surface = VK_NULL_HANDLE;
+VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+VkDevice device = VK_NULL_HANDLE;
+VkQueue queue = VK_NULL_HANDLE;
+uint32_t queueFamily = 0;
+VkFormat stencilFormat = VK_FORMAT_UNDEFINED;
+VkSurfaceFormatKHR surfaceFormat;
+VkRenderPass renderPass = VK_NULL_HANDLE;
+Swapchain sc;
+Frame frames[FRAMES];
+
+void errorcb(int error, const char* desc)
+{
+	printf("GLFW error %d: %s\n", error, desc);
+}
+
+int blowup = 0;
+int premult = 0;
+
+static void key(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	NVG_NOTUSED(scancode);
+	NVG_NOTUSED(mods);
+	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+	if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
+		blowup = !blowup;
+	if (key == GLFW_KEY_P && action == GLFW_PRESS)
+		premult = !premult;
+}
+
+static uint32_t* loadSpirv(const char* path, size_t* size)
+{
+	FILE* fp = fopen(path, "rb");
+	uint32_t* code = NULL;
+	long n;
+	if (fp == NULL) return NULL;
+	fseek(fp, 0, SEEK_END);
+	n = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (n > 0 && (n % 4) == 0)
+		code = (uint32_t*)malloc((size_t)n);
+	if (code != NULL && fread(code, 1, (size_t)n, fp) != (size_t)n) {
+		free(code);
+		code = NULL;
+	}
+	fclose(fp);
+	*size = (size_t)n;
+	return code;
+}
+
+static int memoryType(uint32_t typeBits, VkMemoryPropertyFlags props, uint32_t* index)
+{
+	VkPhysicalDeviceMemoryProperties memProps;
+	uint32_t i;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProps);
+	for (i = 0; i < memProps.memoryTypeCount; i++) {
+		if ((typeBits & (1u << i)) != 0 && (memProps.memoryTypes[i].propertyFlags & props) == props) {
+			*index = i;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int initDevice(GLFWwindow* window)
+{
+	VkApplicationInfo app;
+	VkInstanceCreateInfo instInfo;
+	VkDeviceQueueCreateInfo queueInfo;
+	VkDeviceCreateInfo devInfo;
+	VkPhysicalDevice devices[8];
+	VkQueueFamilyProperties families[16];
+	VkSurfaceFormatKHR formats[32];
+	VkFormat stencilFormats[3] = { VK_FORMAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT };
+	const char* devExtensions[1] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+	float priority = 1.0f;
+	uint32_t ndevices = 8, nfamilies, nformats = 32, next, i, j;
+
+	memset(&app, 0, sizeof(app));
+	app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	app.pApplicationName = "NanoVG";
+	app.apiVersion = VK_API_VERSION_1_0;
+	memset(&instInfo, 0, sizeof(instInfo));
+	instInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instInfo.pApplicationInfo = &app;
+	instInfo.ppEnabledExtensionNames = glfwGetRequiredInstanceExtensions(&next);
+	instInfo.enabledExtensionCount = next;
+	if (vkCreateInstance(&instInfo, NULL, &instance) != VK_SUCCESS) return 0;
+	if (glfwCreateWindowSurface(instance, window, NULL, &surface) != VK_SUCCESS) return 0;
+
+	// Use the first device with a queue which can draw and present.
+	if (vkEnumeratePhysicalDevices(instance, &ndevices, devices) < 0) return 0;
+	for (i = 0; i < ndevices && physicalDevice == VK_NULL_HANDLE; i++) {
+		nfamilies = 16;
+		vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &nfamilies, families);
+		for (j = 0; j < nfamilies; j++) {
+			VkBool32 present = VK_FALSE;
+			vkGetPhysicalDeviceSurfaceSupportKHR(devices[i], j, surface, &present);
+			if ((families[j].queueFlags & VK_QUEUE_GRAPHICS_BIT) && present) {
+				physicalDevice = devices[i];
+				queueFamily = j;
+				break;
+			}
+		}
+	}
+	if (physicalDevice == VK_NULL_HANDLE) return 0;
+
+	for (i = 0; i < 3 && stencilFormat == VK_FORMAT_UNDEFINED; i++) {
+		VkFormatProperties props;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, stencilFormats[i], &props);
+		if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			stencilFormat = stencilFormats[i];
+	}
+	if (stencilFormat == VK_FORMAT_UNDEFINED) return 0;
+
+	if (vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &nformats, formats) < 0 || nformats == 0) return 0;
+	surfaceFormat = formats[0];
+	for (i = 0; i < nformats; i++) {
+		if (formats[i].format == VK_FORMAT_B8G8R8A8_UNORM || formats[i].format == VK_FORMAT_R8G8B8A8_UNORM) {
+			surfaceFormat = formats[i];
+			break;
+		}
+	}
+
+	memset(&queueInfo, 0, sizeof(queueInfo));
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &priority;
+	memset(&devInfo, 0, sizeof(devInfo));
+	devInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	devInfo.queueCreateInfoCount = 1;
+	devInfo.pQueueCreateInfos = &queueInfo;
+	devInfo.enabledExtensionCount = 1;
+	devInfo.ppEnabledExtensionNames = devExtensions;
+	if (vkCreateDevice(physicalDevice, &devInfo, NULL, &device) != VK_SUCCESS) return 0;
+	vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+	return 1;
+}
+
+static int initRenderPass(void)
+{
+	VkAttachmentDescription attachments[2];
+	VkAttachmentReference colorRef, stencilRef;
+	VkSubpassDescription subpass;
+	VkSubpassDependency dep;
+	VkRenderPassCreateInfo info;
+
+	memset(attachments, 0, sizeof(attachments));
+	attachments[0].format = surfaceFormat.format;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	attachments[1].format = stencilFormat;
+	attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	colorRef.attachment = 0;
+	colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	stencilRef.attachment = 1;
+	stencilRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	memset(&subpass, 0, sizeof(subpass));
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorRef;
+	subpass.pDepthStencilAttachment = &stencilRef;
+
+	// The acquired image and the stencil of the previous frame must be free before they are cleared.
+	memset(&dep, 0, sizeof(dep));
+	dep.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dep.dstSubpass = 0;
+	dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dep.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	info.attachmentCount = 2;
+	info.pAttachments = attachments;
+	info.subpassCount = 1;
+	info.pSubpasses = &subpass;
+	info.dependencyCount = 1;
+	info.pDependencies = &dep;
+	return vkCreateRenderPass(device, &info, NULL, &renderPass) == VK_SUCCESS;
+}
+
+static int initFrames(void)
+{
+	VkCommandPoolCreateInfo poolInfo;
+	VkCommandBufferAllocateInfo alloc;
+	VkFenceCreateInfo fenceInfo;
+	VkSemaphoreCreateInfo semInfo;
+	int i;
+
+	memset(&poolInfo, 0, sizeof(poolInfo));
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamily;
+	memset(&fenceInfo, 0, sizeof(fenceInfo));
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	memset(&semInfo, 0, sizeof(semInfo));
+	semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (i = 0; i < FRAMES; i++) {
+		if (vkCreateCommandPool(device, &poolInfo, NULL, &frames[i].pool) != VK_SUCCESS) return 0;
+		memset(&alloc, 0, sizeof(alloc));
+		alloc.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc.commandPool = frames[i].pool;
+		alloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(device, &alloc, &frames[i].cmd) != VK_SUCCESS) return 0;
+		if (vkCreateFence(device, &fenceInfo, NULL, &frames[i].fence) != VK_SUCCESS) return 0;
+		if (vkCreateSemaphore(device, &semInfo, NULL, &frames[i].acquired) != VK_SUCCESS) return 0;
+	}
+	return 1;
+}
+
+static void deleteSwapchain(void)
+{
+	uint32_t i;
+	for (i = 0; i < sc.nimages; i++) {
+		vkDestroyFramebuffer(device, sc.framebuffers[i], NULL);
+		vkDestroyImageView(device, sc.views[i], NULL);
+		vkDestroySemaphore(device, sc.renderDone[i], NULL);
+	}
+	if (sc.stencilView != VK_NULL_HANDLE) vkDestroyImageView(device, sc.stencilView, NULL);
+	if (sc.stencil != VK_NULL_HANDLE) vkDestroyImage(device, sc.stencil, NULL);
+	if (sc.stencilMemory != VK_NULL_HANDLE) vkFreeMemory(device, sc.stencilMemory, NULL);
+	if (sc.swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device, sc.swapchain, NULL);
+	memset(&sc, 0, sizeof(sc));
+}
+
+static int initSwapchain(int width, int height)
+{
+	VkSurfaceCapabilitiesKHR caps;
+	VkSwapchainCreateInfoKHR info;
+	VkImageCreateInfo imageInfo;
+	VkImageViewCreateInfo viewInfo;
+	VkFramebufferCreateInfo fbInfo;
+	VkSemaphoreCreateInfo semInfo;
+	VkMemoryAllocateInfo alloc;
+	VkMemoryRequirements req;
+	VkImageView attachments[2];
+	uint32_t i;
+
+	memset(&sc, 0, sizeof(sc));
+	if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps) != VK_SUCCESS) return 0;
+	sc.format = surfaceFormat.format;
+	sc.extent = caps.currentExtent;
+	if (sc.extent.width == 0xffffffff) {
+		sc.extent.width = (uint32_t)width;
+		sc.extent.height = (uint32_t)height;
+	}
+	if (sc.extent.width == 0 || sc.extent.height == 0) return 0;
+
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	info.surface = surface;
+	info.minImageCount = caps.minImageCount + 1;
+	if (caps.maxImageCount > 0 && info.minImageCount > caps.maxImageCount)
+		info.minImageCount = caps.maxImageCount;
+	if (info.minImageCount > MAX_IMAGES)
+		info.minImageCount = MAX_IMAGES;
+	info.imageFormat = surfaceFormat.format;
+	info.imageColorSpace = surfaceFormat.colorSpace;
+	info.imageExtent = sc.extent;
+	info.imageArrayLayers = 1;
+	info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.preTransform = caps.currentTransform;
+	info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	info.clipped = VK_TRUE;
+	if (vkCreateSwapchainKHR(device, &info, NULL, &sc.swapchain) != VK_SUCCESS) return 0;
+	sc.nimages = MAX_IMAGES;
+	if (vkGetSwapchainImagesKHR(device, sc.swapchain, &sc.nimages, sc.images) < 0) return 0;
+
+	// The stencil is cleared at the start of each frame, so the frames in flight can share it.
+	memset(&imageInfo, 0, sizeof(imageInfo));
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = stencilFormat;
+	imageInfo.extent.width = sc.extent.width;
+	imageInfo.extent.height = sc.extent.height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(device, &imageInfo, NULL, &sc.stencil) != VK_SUCCESS) return 0;
+	vkGetImageMemoryRequirements(device, sc.stencil, &req);
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc.allocationSize = req.size;
+	if (!memoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc.memoryTypeIndex)) return 0;
+	if (vkAllocateMemory(device, &alloc, NULL, &sc.stencilMemory) != VK_SUCCESS) return 0;
+	if (vkBindImageMemory(device, sc.stencil, sc.stencilMemory, 0) != VK_SUCCESS) return 0;
+
+	memset(&viewInfo, 0, sizeof(viewInfo));
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.layerCount = 1;
+	viewInfo.image = sc.stencil;
+	viewInfo.format = stencilFormat;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_STENCIL_BIT;
+	if (stencilFormat != VK_FORMAT_S8_UINT)
+		viewInfo.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_DEPTH_BIT;
+	if (vkCreateImageView(device, &viewInfo, NULL, &sc.stencilView) != VK_SUCCESS) return 0;
+
+	memset(&semInfo, 0, sizeof(semInfo));
+	semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	for (i = 0; i < sc.nimages; i++) {
+		viewInfo.image = sc.images[i];
+		viewInfo.format = sc.format;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		if (vkCreateImageView(device, &viewInfo, NULL, &sc.views[i]) != VK_SUCCESS) return 0;
+
+		attachments[0] = sc.views[i];
+		attachments[1] = sc.stencilView;
+		memset(&fbInfo, 0, sizeof(fbInfo));
+		fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		fbInfo.renderPass = renderPass;
+		fbInfo.attachmentCount = 2;
+		fbInfo.pAttachments = attachments;
+		fbInfo.width = sc.extent.width;
+		fbInfo.height = sc.extent.height;
+		fbInfo.layers = 1;
+		if (vkCreateFramebuffer(device, &fbInfo, NULL, &sc.framebuffers[i]) != VK_SUCCESS) return 0;
+		if (vkCreateSemaphore(device, &semInfo, NULL, &sc.renderDone[i]) != VK_SUCCESS) return 0;
+	}
+
+	return 1;
+}
+
+int main()
+{
+	GLFWwindow* window;
+	DemoData data;
+	NVGcontext* vg = NULL;
+	NVGVKcreateInfo info;
+	PerfGraph fps, cpuGraph, nvgGraph;
+	NVGframeStats stats;
+	double prevt = 0, cpuTime = 0;
+	int frame = 0, resized = 0, i;
+
+	if (!glfwInit()) {
+		printf("Failed to init GLFW.");
+		return -1;
+	}
+	if (!glfwVulkanSupported()) {
+		printf("Vulkan is not supported.\n");
+		glfwTerminate();
+		return -1;
+	}
+
+	initGraph(&fps, GRAPH_RENDER_FPS, "Frame Time");
+	initGraph(&cpuGraph, GRAPH_RENDER_MS, "CPU Time");
+	initGraph(&nvgGraph, GRAPH_RENDER_MS, "NanoVG Time");
+	memset(&stats, 0, sizeof(stats));
+	memset(&sc, 0, sizeof(sc));
+	memset(frames, 0, sizeof(frames));
+
+	glfwSetErrorCallback(errorcb);
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	window = glfwCreateWindow(1000, 600, "NanoVG", NULL, NULL);
+	if (!window) {
+		glfwTerminate();
+		return -1;
+	}
+	glfwSetKeyCallback(window, key);
+
+	if (!initDevice(window) || !initRenderPass() || !initFrames()) {
+		printf("Could not init Vulkan.\n");
+		return -1;
+	}
+	{
+		int fbWidth, fbHeight;
+		glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+		if (!initSwapchain(fbWidth, fbHeight)) {
+			printf("Could not create swapchain.\n");
+			return -1;
+		}
+	}
+
+	// The shaders are compiled to the build directory, see premake4.lua.
+	memset(&info, 0, sizeof(info));
+	info.physicalDevice = physicalDevice;
+	info.device = device;
+	info.renderPass = renderPass;
+	info.subpass = 0;
+	info.framesInFlight = FRAMES;
+	info.vertCode = loadSpirv("nanovg_vk.vert.spv", &info.vertCodeSize);
+	info.fragCode = loadSpirv("nanovg_vk.frag.spv", &info.fragCodeSize);
+	if (info.vertCode == NULL || info.fragCode == NULL) {
+		printf("Could not load nanovg_vk.vert.spv and nanovg_vk.frag.spv.\n");
+		return -1;
+	}
+
+	vg = nvgCreateVk(&info, NVGVK_ANTIALIAS | NVGVK_STENCIL_STROKES | NVGVK_DEBUG);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+	free((void*)info.vertCode);
+	free((void*)info.fragCode);
+
+	if (loadDemoData(vg, &data) == -1)
+		return -1;
+
+	glfwSetTime(0);
+	prevt = glfwGetTime();
+
+	while (!glfwWindowShouldClose(window))
+	{
+		Frame* f = &frames[frame];
+		VkCommandBufferBeginInfo begin;
+		VkRenderPassBeginInfo passInfo;
+		VkClearValue clears[2];
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		VkSubmitInfo submit;
+		VkPresentInfoKHR present;
+		VkResult res;
+		uint32_t image;
+		double mx, my, t, dt;
+		int winWidth, winHeight;
+		int fbWidth, fbHeight;
+		float pxRatio;
+
+		glfwPollEvents();
+		glfwGetCursorPos(window, &mx, &my);
+		glfwGetWindowSize(window, &winWidth, &winHeight);
+		glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+		if (fbWidth == 0 || fbHeight == 0) {
+			// Minimized.
+			glfwWaitEvents();
+			continue;
+		}
+		if (resized || (uint32_t)fbWidth != sc.extent.width || (uint32_t)fbHeight != sc.extent.height) {
+			vkDeviceWaitIdle(device);
+			deleteSwapchain();
+			if (!initSwapchain(fbWidth, fbHeight))
+				continue;
+			resized = 0;
+		}
+
+		t = glfwGetTime();
+		dt = t - prevt;
+		prevt = t;
+
+		// The GPU is done with the previous use of this frame, nanovg may reuse its buffers.
+		vkWaitForFences(device, 1, &f->fence, VK_TRUE, UINT64_MAX);
+		res = vkAcquireNextImageKHR(device, sc.swapchain, UINT64_MAX, f->acquired, VK_NULL_HANDLE, &image);
+		if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+			resized = 1;
+			continue;
+		}
+		vkResetFences(device, 1, &f->fence);
+		vkResetCommandPool(device, f->pool, 0);
+
+		memset(&begin, 0, sizeof(begin));
+		begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(f->cmd, &begin);
+
+		// Calculate pixel ration for hi-dpi devices.
+		pxRatio = (float)fbWidth / (float)winWidth;
+
+		// The texture uploads of the frame are recorded by nvgEndFrame(), outside of the render pass.
+		nvgvkBeginFrame(vg, f->cmd, frame);
+		nvgBeginFrame(vg, winWidth, winHeight, pxRatio);
+
+		renderDemo(vg, mx,my, winWidth,winHeight, t, blowup, &data);
+
+		renderGraph(vg, 5,5, &fps);
+		renderGraph(vg, 5+200+5,5, &cpuGraph);
+		renderGraph(vg, 5,5+35+5, &nvgGraph);
+		renderFrameStats(vg, 5,5+35+5+35+5, &stats);
+
+		nvgEndFrame(vg);
+		nvgFrameStats(vg, &stats);
+
+		memset(clears, 0, sizeof(clears));
+		if (!premult) {
+			clears[0].color.float32[0] = 0.3f;
+			clears[0].color.float32[1] = 0.3f;
+			clears[0].color.float32[2] = 0.32f;
+			clears[0].color.float32[3] = 1.0f;
+		}
+		memset(&passInfo, 0, sizeof(passInfo));
+		passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		passInfo.renderPass = renderPass;
+		passInfo.framebuffer = sc.framebuffers[image];
+		passInfo.renderArea.extent = sc.extent;
+		passInfo.clearValueCount = 2;
+		passInfo.pClearValues = clears;
+		vkCmdBeginRenderPass(f->cmd, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+		nvgvkRenderFrame(vg);
+		vkCmdEndRenderPass(f->cmd);
+		vkEndCommandBuffer(f->cmd);
+
+		// nanovg does not use the queue, the application submits everything.
+		memset(&submit, 0, sizeof(submit));
+		submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit.waitSemaphoreCount = 1;
+		submit.pWaitSemaphores = &f->acquired;
+		submit.pWaitDstStageMask = &waitStage;
+		submit.commandBufferCount = 1;
+		submit.pCommandBuffers = &f->cmd;
+		submit.signalSemaphoreCount = 1;
+		submit.pSignalSemaphores = &sc.renderDone[image];
+		vkQueueSubmit(queue, 1, &submit, f->fence);
+
+		memset(&present, 0, sizeof(present));
+		present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		present.waitSemaphoreCount = 1;
+		present.pWaitSemaphores = &sc.renderDone[image];
+		present.swapchainCount = 1;
+		present.pSwapchains = &sc.swapchain;
+		present.pImageIndices = &image;
+		res = vkQueuePresentKHR(queue, &present);
+		if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR)
+			resized = 1;
+
+		// Measure the CPU time taken excluding the wait for the frame.
+		cpuTime = glfwGetTime() - t;
+
+		updateGraph(&fps, dt);
+		updateGraph(&cpuGraph, cpuTime);
+		updateGraph(&nvgGraph, stats.flattenTime + stats.expandTime + stats.flushTime);
+
+		frame = (frame + 1) % FRAMES;
+	}
+
+	// nanovg resources may only be destroyed after the GPU is done with them.
+	vkDeviceWaitIdle(device);
+	freeDemoData(vg, &data);
+	nvgDeleteVk(vg);
+
+	deleteSwapchain();
+	for (i = 0; i < FRAMES; i++) {
+		vkDestroySemaphore(device, frames[i].acquired, NULL);
+		vkDestroyFence(device, frames[i].fence, NULL);
+		vkDestroyCommandPool(device, frames[i].pool, NULL);
+	}
+	vkDestroyRenderPass(device, renderPass, NULL);
+	vkDestroyDevice(device, NULL);
+	vkDestroySurfaceKHR(instance, surface, NULL);
+	vkDestroyInstance(instance, NULL);
+
+	printf("Average Frame Time: %.2f ms\n", getGraphAverage(&fps) * 1000.0f);
+	printf("          CPU Time: %.2f ms\n", getGraphAverage(&cpuGraph) * 1000.0f);
+	printf("       NanoVG Time: %.2f ms\n", getGraphAverage(&nvgGraph) * 1000.0f);
+
+	glfwTerminate();
+	return 0;
+}
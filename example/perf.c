@@ -184,3 +184,32 @@ void renderGraph(NVGcontext* vg, float x, float y, PerfGraph* fps)
 		nvgText(vg, x+w-3,y+3, str, NULL);
 	}
 }
+
+void renderFrameStats(NVGcontext* vg, float x, float y, NVGframeStats* stats)
+{
+	float w = 200, h = 87;
+	char str[64];
+
+	nvgBeginPath(vg);
+	nvgRect(vg, x,y, w,h);
+	nvgFillColor(vg, nvgRGBA(0,0,0,128));
+	nvgFill(vg);
+
+	nvgFontFace(vg, "sans");
+	nvgFontSize(vg, 12.0f);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(240,240,240,192));
+
+	sprintf(str, "Draws %d (%d merged)", stats->drawCalls, stats->mergedCalls);
+	nvgText(vg, x+3,y+3, str, NULL);
+	sprintf(str, "Tris fill %d stroke %d text %d", stats->fillTriangles, stats->strokeTriangles, stats->textTriangles);
+	nvgText(vg, x+3,y+17, str, NULL);
+	sprintf(str, "Upload verts %.1fk unif %.1fk tex %.1fk", stats->vertexBytes/1024.0f, stats->uniformBytes/1024.0f, stats->textureBytes/1024.0f);
+	nvgText(vg, x+3,y+31, str, NULL);
+	sprintf(str, "Filtered state changes %d", stats->filteredStateChanges);
+	nvgText(vg, x+3,y+45, str, NULL);
+	sprintf(str, "Flatten %.2f ms expand %.2f ms", stats->flattenTime * 1000.0f, stats->expandTime * 1000.0f);
+	nvgText(vg, x+3,y+59, str, NULL);
+	sprintf(str, "Flush %.2f ms", stats->flushTime * 1000.0f);
+	nvgText(vg, x+3,y+73, str, NULL);
+}
@@ -27,6 +27,8 @@ void updateGraph(PerfGraph* fps, float frameTime);
 void renderGraph(NVGcontext* vg, float x, float y, PerfGraph* fps);
 float getGraphAverage(PerfGraph* fps);
 
+void renderFrameStats(NVGcontext* vg, float x, float y, NVGframeStats* stats);
+
 #define GPU_QUERY_COUNT 5
 struct GPUtimer {
 	int supported;
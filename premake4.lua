@@ -1,6 +1,11 @@
 
 local action = _ACTION or ""
 
+newoption {
+	trigger = "with-vulkan",
+	description = "Also generate example_vk, needs the Vulkan SDK and glslangValidator"
+}
+
 solution "nanovg"
 	location ( "build" )
 	configurations { "Debug", "Release" }
@@ -13,6 +18,26 @@ solution "nanovg"
 		files { "src/*.c" }
 		targetdir("build")
 		defines { "_CRT_SECURE_NO_WARNINGS" } --,"FONS_USE_FREETYPE" } Uncomment to compile with FreeType support
+		-- defines { "FONS_USE_THREADS" } Uncomment to allow rasterizing glyphs and decoding images on worker threads, link with pthread on Linux and macOS
+		-- defines { "NVG_STATS_TIMING" } Uncomment to measure the CPU times in NVGframeStats
+		-- defines { "NVG_TRACE" } Uncomment to report trace zones to the callbacks set with nvgSetTraceCallbacks(), define it for the back-end too
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	-- The library with the CPU timings of NVGframeStats, for the benchmark.
+	project "nanovg_timing"
+		language "C"
+		kind "StaticLib"
+		includedirs { "src" }
+		files { "src/*.c" }
+		targetdir("build")
+		defines { "_CRT_SECURE_NO_WARNINGS", "NVG_STATS_TIMING" }
 
 		configuration "Debug"
 			defines { "DEBUG" }
@@ -169,6 +194,63 @@ solution "nanovg"
 			defines { "NDEBUG" }
 			flags { "Optimize", "ExtraWarnings"}
 
+	project "example_sw"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/example_sw.c" }
+		includedirs { "src", "example" }
+		targetdir("build")
+		links { "nanovg" }
+
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration { "windows" }
+			 defines { "_CRT_SECURE_NO_WARNINGS" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	if _OPTIONS["with-vulkan"] then
+	project "example_vk"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/example_vk.c", "example/demo.c", "example/perf.c" }
+		includedirs { "src", "example" }
+		targetdir("build")
+		links { "nanovg" }
+		-- The example loads the SPIR-V of the shaders from the build directory.
+		prebuildcommands {
+			"glslangValidator -V ../src/nanovg_vk.vert -o nanovg_vk.vert.spv",
+			"glslangValidator -V ../src/nanovg_vk.frag -o nanovg_vk.frag.spv"
+		}
+
+		configuration { "linux" }
+			 linkoptions { "`pkg-config --libs glfw3`" }
+			 links { "vulkan", "GL", "m" }
+
+		configuration { "windows" }
+			 links { "glfw3", "gdi32", "winmm", "user32", "vulkan-1", "opengl32", "kernel32" }
+			 defines { "_CRT_SECURE_NO_WARNINGS" }
+
+		configuration { "macosx" }
+			links { "glfw3", "vulkan" }
+			linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo", "-framework Carbon" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+	end
+
 	project "example_gles2"
 		kind "ConsoleApp"
 		language "C"
@@ -224,3 +306,32 @@ solution "nanovg"
 		configuration "Release"
 			defines { "NDEBUG" }
 			flags { "Optimize", "ExtraWarnings"}
+
+	project "bench"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/bench.c", "example/demo.c" }
+		includedirs { "src", "example" }
+		targetdir("build")
+		links { "nanovg_timing" }
+
+		configuration { "linux" }
+			 linkoptions { "`pkg-config --libs glfw3`" }
+			 links { "GL", "GLU", "m", "GLEW" }
+			 defines { "NANOVG_GLEW" }
+
+		configuration { "windows" }
+			 links { "glfw3", "gdi32", "winmm", "user32", "GLEW", "glu32","opengl32", "kernel32" }
+			 defines { "NANOVG_GLEW", "_CRT_SECURE_NO_WARNINGS" }
+
+		configuration { "macosx" }
+			links { "glfw3" }
+			linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo", "-framework Carbon" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
@@ -24,6 +24,11 @@
 enum FONSflags {
 	FONS_ZERO_TOPLEFT = 1,
 	FONS_ZERO_BOTTOMLEFT = 2,
+	// When the atlas is full, evict least recently used glyphs instead of failing, see fonsNewFrame().
+	FONS_EVICT_GLYPHS = 4,
+	// Rasterize glyphs as signed distance fields at FONS_SDF_SIZE, one glyph serves all sizes.
+	// Blur is ignored, it is expected to be applied by the renderer.
+	FONS_SDF_GLYPHS = 8,
 };
 
 enum FONSalign {
@@ -63,6 +68,10 @@ struct FONSparams {
 	void (*renderUpdate)(void* uptr, int* rect, const unsigned char* data);
 	void (*renderDraw)(void* uptr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
 	void (*renderDelete)(void* uptr);
+	// Optional allocator for the stash, fonts, glyphs, scratch and texture data, NULL uses realloc() and free().
+	void* (*reallocMem)(void* uptr, void* ptr, size_t size);
+	void (*freeMem)(void* uptr, void* ptr);
+	void* memUserPtr;
 };
 typedef struct FONSparams FONSparams;
 
@@ -100,6 +109,14 @@ void fonsGetAtlasSize(FONScontext* s, int* width, int* height);
 int fonsExpandAtlas(FONScontext* s, int width, int height);
 // Resets the whole stash.
 int fonsResetAtlas(FONScontext* stash, int width, int height);
+// Starts a new frame. With FONS_EVICT_GLYPHS, glyphs which have not been used since the start
+// of the frame can be evicted to make space for new ones.
+void fonsNewFrame(FONScontext* s);
+// Starts worker threads which rasterize new glyphs in the background. Until a glyph is ready,
+// its atlas area is empty. Requires FONS_USE_THREADS and stb_truetype, returns 0 if not supported.
+int fonsStartWorkers(FONScontext* s, int nthreads);
+// Waits until all queued glyphs are rasterized and copied to the atlas.
+void fonsWaitWorkers(FONScontext* s);
 
 // Add fonts
 int fonsAddFont(FONScontext* s, const char* name, const char* path, int fontIndex);
@@ -126,6 +143,8 @@ float fonsDrawText(FONScontext* s, float x, float y, const char* string, const c
 float fonsTextBounds(FONScontext* s, float x, float y, const char* string, const char* end, float* bounds);
 void fonsLineBounds(FONScontext* s, float y, float* miny, float* maxy);
 void fonsVertMetrics(FONScontext* s, float* ascender, float* descender, float* lineh);
+// Returns the widest glyph advance of the current font and its fallbacks at the current size.
+float fonsMaxAdvance(FONScontext* s);
 
 // Text iterator
 int fonsTextIterInit(FONScontext* stash, FONStextIter* iter, float x, float y, const char* str, const char* end, int bitmapOption);
@@ -145,6 +164,50 @@ void fonsDrawDebug(FONScontext* s, float x, float y);
 
 #define FONS_NOTUSED(v)  (void)sizeof(v)
 
+// Trace zones, compiled out unless the includer defines them.
+#ifndef FONS_TRACE_BEGIN
+#	define FONS_TRACE_BEGIN(name)
+#	define FONS_TRACE_END(name)
+#endif
+
+#if defined(FONS_USE_THREADS) && !defined(FONS_USE_FREETYPE)
+#	define FONS_ASYNC_GLYPHS 1
+#	ifdef _WIN32
+#		define WIN32_LEAN_AND_MEAN
+#		include <windows.h>
+typedef CRITICAL_SECTION fons__mutex;
+typedef CONDITION_VARIABLE fons__cond;
+typedef HANDLE fons__thread;
+#		define FONS_THREAD_FUNC DWORD WINAPI
+#		define fons__mutexInit(m) InitializeCriticalSection(m)
+#		define fons__mutexDestroy(m) DeleteCriticalSection(m)
+#		define fons__lock(m) EnterCriticalSection(m)
+#		define fons__unlock(m) LeaveCriticalSection(m)
+#		define fons__condInit(c) InitializeConditionVariable(c)
+#		define fons__condDestroy(c)
+#		define fons__condWait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#		define fons__condBroadcast(c) WakeAllConditionVariable(c)
+#		define fons__threadStart(t, fn, arg) ((*(t) = CreateThread(NULL, 0, fn, arg, 0, NULL)) != NULL)
+#		define fons__threadJoin(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#	else
+#		include <pthread.h>
+typedef pthread_mutex_t fons__mutex;
+typedef pthread_cond_t fons__cond;
+typedef pthread_t fons__thread;
+#		define FONS_THREAD_FUNC void*
+#		define fons__mutexInit(m) pthread_mutex_init(m, NULL)
+#		define fons__mutexDestroy(m) pthread_mutex_destroy(m)
+#		define fons__lock(m) pthread_mutex_lock(m)
+#		define fons__unlock(m) pthread_mutex_unlock(m)
+#		define fons__condInit(c) pthread_cond_init(c, NULL)
+#		define fons__condDestroy(c) pthread_cond_destroy(c)
+#		define fons__condWait(c, m) pthread_cond_wait(c, m)
+#		define fons__condBroadcast(c) pthread_cond_broadcast(c)
+#		define fons__threadStart(t, fn, arg) (pthread_create(t, NULL, fn, arg) == 0)
+#		define fons__threadJoin(t) pthread_join(t, NULL)
+#	endif
+#endif
+
 #ifdef FONS_USE_FREETYPE
 
 #include <ft2build.h>
@@ -192,6 +255,11 @@ void fons__tt_getFontVMetrics(FONSttFontImpl *font, int *ascent, int *descent, i
 	*lineGap = font->font->height - (*ascent - *descent);
 }
 
+int fons__tt_getFontMaxAdvance(FONSttFontImpl *font)
+{
+	return font->font->max_advance_width;
+}
+
 float fons__tt_getPixelHeightScale(FONSttFontImpl *font, float size)
 {
 	return size / font->font->units_per_EM;
@@ -245,6 +313,14 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	}
 }
 
+void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int glyph, int padding)
+{
+	// FreeType has no distance field rasterizer here, the coverage is used instead.
+	fons__tt_renderGlyphBitmap(font, &output[padding + padding * outStride], outWidth - padding*2, outHeight - padding*2,
+							   outStride, scale, scale, glyph);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	FT_Vector ftKerning;
@@ -298,6 +374,12 @@ void fons__tt_getFontVMetrics(FONSttFontImpl *font, int *ascent, int *descent, i
 	stbtt_GetFontVMetrics(&font->font, ascent, descent, lineGap);
 }
 
+int fons__tt_getFontMaxAdvance(FONSttFontImpl *font)
+{
+	// advanceWidthMax of the hhea table.
+	return ttUSHORT(font->font.data + font->font.hhea + 10);
+}
+
 float fons__tt_getPixelHeightScale(FONSttFontImpl *font, float size)
 {
 	return stbtt_ScaleForMappingEmToPixels(&font->font, size);
@@ -323,6 +405,20 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	stbtt_MakeGlyphBitmap(&font->font, output, outWidth, outHeight, outStride, scaleX, scaleY, glyph);
 }
 
+void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int glyph, int padding)
+{
+	int x, y, w, h, xoff, yoff;
+	unsigned char* sdf = stbtt_GetGlyphSDF(&font->font, scale, glyph, padding, 128, 128.0f / padding, &w, &h, &xoff, &yoff);
+	if (sdf == NULL) return;
+	if (w > outWidth) w = outWidth;
+	if (h > outHeight) h = outHeight;
+	for (y = 0; y < h; y++)
+		for (x = 0; x < w; x++)
+			output[y*outStride + x] = sdf[y*w + x];
+	stbtt_FreeSDF(sdf, font->font.userdata);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
@@ -354,6 +450,15 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 #ifndef FONS_MAX_FALLBACKS
 #	define FONS_MAX_FALLBACKS 20
 #endif
+#ifndef FONS_MAX_WORKERS
+#	define FONS_MAX_WORKERS 8
+#endif
+#ifndef FONS_SDF_SIZE
+#	define FONS_SDF_SIZE 32
+#endif
+#ifndef FONS_SDF_PADDING
+#	define FONS_SDF_PADDING 4
+#endif
 
 static unsigned int fons__hashint(unsigned int a)
 {
@@ -381,6 +486,8 @@ struct FONSglyph
 	unsigned int codepoint;
 	int index;
 	int next;
+	unsigned int lastUse;
+	unsigned char pending;
 	short size, blur;
 	short x0,y0,x1,y1;
 	short xadv,xoff,yoff;
@@ -397,6 +504,7 @@ struct FONSfont
 	float ascender;
 	float descender;
 	float lineh;
+	int maxadv;
 	FONSglyph* glyphs;
 	int cglyphs;
 	int nglyphs;
@@ -422,12 +530,31 @@ struct FONSatlasNode {
 };
 typedef struct FONSatlasNode FONSatlasNode;
 
+struct FONSatlasShelf {
+	short y, height;
+};
+typedef struct FONSatlasShelf FONSatlasShelf;
+
+struct FONSatlasSlot {
+	short x, y, width;
+};
+typedef struct FONSatlasSlot FONSatlasSlot;
+
 struct FONSatlas
 {
 	int width, height;
 	FONSatlasNode* nodes;
 	int nnodes;
 	int cnodes;
+	// Shelf packing is used instead of the skyline when glyphs can be evicted.
+	int shelfPacking;
+	FONSatlasShelf* shelves;
+	int nshelves;
+	int cshelves;
+	FONSatlasSlot* slots; // Free space on the shelves.
+	int nslots;
+	int cslots;
+	int top;
 };
 typedef struct FONSatlas FONSatlas;
 
@@ -449,10 +576,60 @@ struct FONScontext
 	int nscratch;
 	FONSstate states[FONS_MAX_STATES];
 	int nstates;
+	unsigned int frame;
+	unsigned int epoch;
+	struct FONSworkers* workers;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
 };
 
+#ifdef FONS_ASYNC_GLYPHS
+
+struct FONSglyphJob {
+	FONSttFontImpl font;	// Copy of the font, allocations go to the heap.
+	FONSfont* owner;
+	int glyph;
+	int index;
+	float scale;
+	int x, y, w, h, pad, blur, sdf;
+	unsigned int epoch;
+	unsigned char* bitmap;
+	struct FONSglyphJob* next;
+};
+typedef struct FONSglyphJob FONSglyphJob;
+
+struct FONSworkers {
+	fons__mutex lock;
+	fons__cond wake;
+	fons__cond idle;
+	fons__thread threads[FONS_MAX_WORKERS];
+	int nthreads;
+	FONSglyphJob* queue;
+	FONSglyphJob* queueTail;
+	FONSglyphJob* done;
+	int pending;
+	int quit;
+};
+typedef struct FONSworkers FONSworkers;
+
+#endif
+
+static void* fons__realloc(const FONSparams* params, void* ptr, size_t size)
+{
+	if (params->reallocMem != NULL)
+		return params->reallocMem(params->memUserPtr, ptr, size);
+	return realloc(ptr, size);
+}
+
+static void fons__free(const FONSparams* params, void* ptr)
+{
+	if (ptr == NULL) return;
+	if (params->freeMem != NULL)
+		params->freeMem(params->memUserPtr, ptr);
+	else
+		free(ptr);
+}
+
 #ifdef STB_TRUETYPE_IMPLEMENTATION
 
 static void* fons__tmpalloc(size_t size, void* up)
@@ -460,6 +637,10 @@ static void* fons__tmpalloc(size_t size, void* up)
 	unsigned char* ptr;
 	FONScontext* stash = (FONScontext*)up;
 
+	// Worker threads do not have a scratch buffer.
+	if (stash == NULL)
+		return malloc(size);
+
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
@@ -475,9 +656,8 @@ static void* fons__tmpalloc(size_t size, void* up)
 
 static void fons__tmpfree(void* ptr, void* up)
 {
-	(void)ptr;
-	(void)up;
-	// empty
+	if (up == NULL)
+		free(ptr);
 }
 
 #endif // STB_TRUETYPE_IMPLEMENTATION
@@ -527,6 +707,8 @@ static void fons__deleteAtlas(FONSatlas* atlas)
 {
 	if (atlas == NULL) return;
 	if (atlas->nodes != NULL) free(atlas->nodes);
+	if (atlas->shelves != NULL) free(atlas->shelves);
+	if (atlas->slots != NULL) free(atlas->slots);
 	free(atlas);
 }
 
@@ -591,11 +773,131 @@ static void fons__atlasRemoveNode(FONSatlas* atlas, int idx)
 	atlas->nnodes--;
 }
 
+// Shelf packer, glyphs are placed on rows of similar height, and the space of evicted glyphs
+// is returned to the shelf it came from.
+
+static int fons__atlasShelfFits(int shelfHeight, int h)
+{
+	// Round height up so that glyphs of similar size share shelves, and limit the wasted space.
+	int sh = (h + 3) & ~3;
+	return shelfHeight >= h && shelfHeight <= sh + sh/2;
+}
+
+static int fons__atlasShelfHeight(FONSatlas* atlas, int y)
+{
+	int lo = 0, hi = atlas->nshelves-1;
+	// Shelves are sorted by y.
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		FONSatlasShelf* shelf = &atlas->shelves[mid];
+		if (y < shelf->y)
+			hi = mid-1;
+		else if (y >= shelf->y + shelf->height)
+			lo = mid+1;
+		else
+			return shelf->height;
+	}
+	return 0;
+}
+
+static int fons__atlasFreeRect(FONSatlas* atlas, int x, int y, int w)
+{
+	int i = 0;
+	if (w <= 0) return 1;
+	// Merge with adjacent free space on the same shelf.
+	while (i < atlas->nslots) {
+		FONSatlasSlot* slot = &atlas->slots[i];
+		if (slot->y == y && (slot->x + slot->width == x || x + w == slot->x)) {
+			if (slot->x < x) x = slot->x;
+			w += slot->width;
+			atlas->slots[i] = atlas->slots[--atlas->nslots];
+			continue;
+		}
+		i++;
+	}
+	if (atlas->nslots+1 > atlas->cslots) {
+		atlas->cslots = atlas->cslots == 0 ? 8 : atlas->cslots * 2;
+		atlas->slots = (FONSatlasSlot*)realloc(atlas->slots, sizeof(FONSatlasSlot) * atlas->cslots);
+		if (atlas->slots == NULL)
+			return 0;
+	}
+	atlas->slots[atlas->nslots].x = (short)x;
+	atlas->slots[atlas->nslots].y = (short)y;
+	atlas->slots[atlas->nslots].width = (short)w;
+	atlas->nslots++;
+	return 1;
+}
+
+static int fons__atlasAddShelf(FONSatlas* atlas, int h)
+{
+	if (atlas->top + h > atlas->height)
+		return 0;
+	if (atlas->nshelves+1 > atlas->cshelves) {
+		atlas->cshelves = atlas->cshelves == 0 ? 8 : atlas->cshelves * 2;
+		atlas->shelves = (FONSatlasShelf*)realloc(atlas->shelves, sizeof(FONSatlasShelf) * atlas->cshelves);
+		if (atlas->shelves == NULL)
+			return 0;
+	}
+	atlas->shelves[atlas->nshelves].y = (short)atlas->top;
+	atlas->shelves[atlas->nshelves].height = (short)h;
+	atlas->nshelves++;
+	if (fons__atlasFreeRect(atlas, 0, atlas->top, atlas->width) == 0)
+		return 0;
+	atlas->top += h;
+	return 1;
+}
+
+static int fons__atlasAddShelfRect(FONSatlas* atlas, int rw, int rh, int* rx, int* ry)
+{
+	int i, besti = -1, bestWaste = 0;
+	FONSatlasSlot* slot;
+
+	// Find the free space with the least wasted height.
+	for (i = 0; i < atlas->nslots; i++) {
+		int sh, waste;
+		slot = &atlas->slots[i];
+		if (slot->width < rw) continue;
+		sh = fons__atlasShelfHeight(atlas, slot->y);
+		if (!fons__atlasShelfFits(sh, rh)) continue;
+		waste = sh - rh;
+		if (besti == -1 || waste < bestWaste || (waste == bestWaste && slot->width < atlas->slots[besti].width)) {
+			besti = i;
+			bestWaste = waste;
+		}
+	}
+
+	if (besti == -1) {
+		// Start a new shelf.
+		if (fons__atlasAddShelf(atlas, (rh + 3) & ~3) == 0)
+			return 0;
+		besti = atlas->nslots-1;
+	}
+
+	slot = &atlas->slots[besti];
+	*rx = slot->x;
+	*ry = slot->y;
+	slot->x = (short)(slot->x + rw);
+	slot->width = (short)(slot->width - rw);
+	if (slot->width == 0)
+		atlas->slots[besti] = atlas->slots[--atlas->nslots];
+
+	return 1;
+}
+
 static void fons__atlasExpand(FONSatlas* atlas, int w, int h)
 {
-	// Insert node for empty space
-	if (w > atlas->width)
-		fons__atlasInsertNode(atlas, atlas->nnodes, atlas->width, 0, w - atlas->width);
+	int i;
+	if (atlas->shelfPacking) {
+		// Extend the shelves.
+		if (w > atlas->width) {
+			for (i = 0; i < atlas->nshelves; i++)
+				fons__atlasFreeRect(atlas, atlas->width, atlas->shelves[i].y, w - atlas->width);
+		}
+	} else {
+		// Insert node for empty space
+		if (w > atlas->width)
+			fons__atlasInsertNode(atlas, atlas->nnodes, atlas->width, 0, w - atlas->width);
+	}
 	atlas->width = w;
 	atlas->height = h;
 }
@@ -605,6 +907,9 @@ static void fons__atlasReset(FONSatlas* atlas, int w, int h)
 	atlas->width = w;
 	atlas->height = h;
 	atlas->nnodes = 0;
+	atlas->nshelves = 0;
+	atlas->nslots = 0;
+	atlas->top = 0;
 
 	// Init root node.
 	atlas->nodes[0].x = 0;
@@ -676,6 +981,9 @@ static int fons__atlasAddRect(FONSatlas* atlas, int rw, int rh, int* rx, int* ry
 	int besth = atlas->height, bestw = atlas->width, besti = -1;
 	int bestx = -1, besty = -1, i;
 
+	if (atlas->shelfPacking)
+		return fons__atlasAddShelfRect(atlas, rw, rh, rx, ry);
+
 	// Bottom left fit heuristic.
 	for (i = 0; i < atlas->nnodes; i++) {
 		int y = fons__atlasRectFits(atlas, i, rw, rh);
@@ -729,14 +1037,14 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	FONScontext* stash = NULL;
 
 	// Allocate memory for the font stash.
-	stash = (FONScontext*)malloc(sizeof(FONScontext));
+	stash = (FONScontext*)fons__realloc(params, NULL, sizeof(FONScontext));
 	if (stash == NULL) goto error;
 	memset(stash, 0, sizeof(FONScontext));
 
 	stash->params = *params;
 
 	// Allocate scratch buffer.
-	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	stash->scratch = (unsigned char*)fons__realloc(&stash->params, NULL, FONS_SCRATCH_BUF_SIZE);
 	if (stash->scratch == NULL) goto error;
 
 	// Initialize implementation library
@@ -749,9 +1057,10 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 
 	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
 	if (stash->atlas == NULL) goto error;
+	stash->atlas->shelfPacking = (stash->params.flags & FONS_EVICT_GLYPHS) ? 1 : 0;
 
 	// Allocate space for fonts.
-	stash->fonts = (FONSfont**)malloc(sizeof(FONSfont*) * FONS_INIT_FONTS);
+	stash->fonts = (FONSfont**)fons__realloc(&stash->params, NULL, sizeof(FONSfont*) * FONS_INIT_FONTS);
 	if (stash->fonts == NULL) goto error;
 	memset(stash->fonts, 0, sizeof(FONSfont*) * FONS_INIT_FONTS);
 	stash->cfonts = FONS_INIT_FONTS;
@@ -760,7 +1069,7 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	// Create texture for the cache.
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
-	stash->texData = (unsigned char*)malloc(stash->params.width * stash->params.height);
+	stash->texData = (unsigned char*)fons__realloc(&stash->params, NULL, stash->params.width * stash->params.height);
 	if (stash->texData == NULL) goto error;
 	memset(stash->texData, 0, stash->params.width * stash->params.height);
 
@@ -871,12 +1180,13 @@ void fonsClearState(FONScontext* stash)
 	state->align = FONS_ALIGN_LEFT | FONS_ALIGN_BASELINE;
 }
 
-static void fons__freeFont(FONSfont* font)
+static void fons__freeFont(FONScontext* stash, FONSfont* font)
 {
 	if (font == NULL) return;
-	if (font->glyphs) free(font->glyphs);
+	fons__free(&stash->params, font->glyphs);
+	// Font data is owned by the caller's malloc().
 	if (font->freeData && font->data) free(font->data);
-	free(font);
+	fons__free(&stash->params, font);
 }
 
 static int fons__allocFont(FONScontext* stash)
@@ -884,15 +1194,15 @@ static int fons__allocFont(FONScontext* stash)
 	FONSfont* font = NULL;
 	if (stash->nfonts+1 > stash->cfonts) {
 		stash->cfonts = stash->cfonts == 0 ? 8 : stash->cfonts * 2;
-		stash->fonts = (FONSfont**)realloc(stash->fonts, sizeof(FONSfont*) * stash->cfonts);
+		stash->fonts = (FONSfont**)fons__realloc(&stash->params, stash->fonts, sizeof(FONSfont*) * stash->cfonts);
 		if (stash->fonts == NULL)
 			return -1;
 	}
-	font = (FONSfont*)malloc(sizeof(FONSfont));
+	font = (FONSfont*)fons__realloc(&stash->params, NULL, sizeof(FONSfont));
 	if (font == NULL) goto error;
 	memset(font, 0, sizeof(FONSfont));
 
-	font->glyphs = (FONSglyph*)malloc(sizeof(FONSglyph) * FONS_INIT_GLYPHS);
+	font->glyphs = (FONSglyph*)fons__realloc(&stash->params, NULL, sizeof(FONSglyph) * FONS_INIT_GLYPHS);
 	if (font->glyphs == NULL) goto error;
 	font->cglyphs = FONS_INIT_GLYPHS;
 	font->nglyphs = 0;
@@ -901,7 +1211,7 @@ static int fons__allocFont(FONScontext* stash)
 	return stash->nfonts-1;
 
 error:
-	fons__freeFont(font);
+	fons__freeFont(stash, font);
 
 	return FONS_INVALID;
 }
@@ -969,11 +1279,12 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	font->ascender = (float)ascent / (float)fh;
 	font->descender = (float)descent / (float)fh;
 	font->lineh = font->ascender - font->descender;
+	font->maxadv = fons__tt_getFontMaxAdvance(&font->font);
 
 	return idx;
 
 error:
-	fons__freeFont(font);
+	fons__freeFont(stash, font);
 	stash->nfonts--;
 	return FONS_INVALID;
 }
@@ -989,11 +1300,11 @@ int fonsGetFontByName(FONScontext* s, const char* name)
 }
 
 
-static FONSglyph* fons__allocGlyph(FONSfont* font)
+static FONSglyph* fons__allocGlyph(FONScontext* stash, FONSfont* font)
 {
 	if (font->nglyphs+1 > font->cglyphs) {
 		font->cglyphs = font->cglyphs == 0 ? 8 : font->cglyphs * 2;
-		font->glyphs = (FONSglyph*)realloc(font->glyphs, sizeof(FONSglyph) * font->cglyphs);
+		font->glyphs = (FONSglyph*)fons__realloc(&stash->params, font->glyphs, sizeof(FONSglyph) * font->cglyphs);
 		if (font->glyphs == NULL) return NULL;
 	}
 	font->nglyphs++;
@@ -1066,6 +1377,183 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
+// Evicts the least recently used glyph which is not used in the current frame, and whose shelf
+// can hold a glyph of height 'h'.
+static int fons__evictGlyph(FONScontext* stash, int h)
+{
+	FONSglyph* oldest = NULL;
+	int i, j;
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 < 0 || glyph->pending || glyph->lastUse == stash->frame) continue;
+			if (oldest != NULL && stash->frame - glyph->lastUse <= stash->frame - oldest->lastUse) continue;
+			if (!fons__atlasShelfFits(fons__atlasShelfHeight(stash->atlas, glyph->y0), h)) continue;
+			oldest = glyph;
+		}
+	}
+	if (oldest == NULL) return 0;
+
+	if (fons__atlasFreeRect(stash->atlas, oldest->x0, oldest->y0, oldest->x1 - oldest->x0) == 0)
+		return 0;
+	// The glyph stays in the cache, without bitmap.
+	oldest->x0 = oldest->y0 = oldest->x1 = oldest->y1 = -1;
+	return 1;
+}
+
+#ifdef FONS_ASYNC_GLYPHS
+
+static FONS_THREAD_FUNC fons__glyphWorker(void* arg)
+{
+	FONSworkers* workers = (FONSworkers*)arg;
+	FONSglyphJob* job;
+
+	fons__lock(&workers->lock);
+	for (;;) {
+		while (workers->queue == NULL && !workers->quit)
+			fons__condWait(&workers->wake, &workers->lock);
+		if (workers->quit)
+			break;
+		job = workers->queue;
+		workers->queue = job->next;
+		if (workers->queue == NULL)
+			workers->queueTail = NULL;
+		fons__unlock(&workers->lock);
+
+		FONS_TRACE_BEGIN("fons__glyphWorker");
+		// The bitmap is cleared, so the border and padding are empty.
+		job->bitmap = (unsigned char*)calloc(job->w * job->h, 1);
+		if (job->bitmap != NULL && job->sdf) {
+			fons__tt_renderGlyphSDF(&job->font, &job->bitmap[1 + job->w], job->w - 2, job->h - 2, job->w,
+									job->scale, job->glyph, job->pad - 1);
+		} else if (job->bitmap != NULL) {
+			fons__tt_renderGlyphBitmap(&job->font, &job->bitmap[job->pad + job->pad * job->w],
+									   job->w - job->pad*2, job->h - job->pad*2, job->w, job->scale, job->scale, job->glyph);
+			if (job->blur > 0)
+				fons__blur(NULL, job->bitmap, job->w, job->h, job->w, job->blur);
+		}
+		FONS_TRACE_END("fons__glyphWorker");
+
+		fons__lock(&workers->lock);
+		job->next = workers->done;
+		workers->done = job;
+		workers->pending--;
+		if (workers->pending == 0)
+			fons__condBroadcast(&workers->idle);
+	}
+	fons__unlock(&workers->lock);
+
+	return 0;
+}
+
+static int fons__queueGlyph(FONScontext* stash, FONSfont* owner, int index, FONSfont* renderFont,
+							int g, float scale, int pad, int blur)
+{
+	FONSworkers* workers = stash->workers;
+	FONSglyph* glyph = &owner->glyphs[index];
+	FONSglyphJob* job = (FONSglyphJob*)malloc(sizeof(FONSglyphJob));
+	if (job == NULL) return 0;
+
+	job->font = renderFont->font;
+	job->font.font.userdata = NULL;
+	job->owner = owner;
+	job->glyph = g;
+	job->index = index;
+	job->scale = scale;
+	job->x = glyph->x0;
+	job->y = glyph->y0;
+	job->w = glyph->x1 - glyph->x0;
+	job->h = glyph->y1 - glyph->y0;
+	job->pad = pad;
+	job->blur = blur;
+	job->sdf = (stash->params.flags & FONS_SDF_GLYPHS) != 0;
+	job->epoch = stash->epoch;
+	job->bitmap = NULL;
+	job->next = NULL;
+
+	fons__lock(&workers->lock);
+	if (workers->queueTail != NULL)
+		workers->queueTail->next = job;
+	else
+		workers->queue = job;
+	workers->queueTail = job;
+	workers->pending++;
+	fons__condBroadcast(&workers->wake);
+	fons__unlock(&workers->lock);
+
+	return 1;
+}
+
+// Copies the finished glyphs to the atlas.
+static void fons__collectGlyphs(FONScontext* stash)
+{
+	FONSworkers* workers = stash->workers;
+	FONSglyphJob* job;
+	int y;
+
+	if (workers == NULL) return;
+
+	fons__lock(&workers->lock);
+	job = workers->done;
+	workers->done = NULL;
+	fons__unlock(&workers->lock);
+
+	while (job != NULL) {
+		FONSglyphJob* next = job->next;
+		// Glyphs queued before the atlas was reset are gone.
+		if (job->epoch == stash->epoch && job->bitmap != NULL) {
+			unsigned char* dst = &stash->texData[job->x + job->y * stash->params.width];
+			for (y = 0; y < job->h; y++)
+				memcpy(&dst[y * stash->params.width], &job->bitmap[y * job->w], job->w);
+			job->owner->glyphs[job->index].pending = 0;
+			stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], job->x);
+			stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], job->y);
+			stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], job->x + job->w);
+			stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], job->y + job->h);
+		}
+		free(job->bitmap);
+		free(job);
+		job = next;
+	}
+}
+
+static void fons__stopWorkers(FONScontext* stash)
+{
+	FONSworkers* workers = stash->workers;
+	FONSglyphJob* job;
+	int i;
+
+	if (workers == NULL) return;
+
+	fons__lock(&workers->lock);
+	workers->quit = 1;
+	fons__condBroadcast(&workers->wake);
+	fons__unlock(&workers->lock);
+	for (i = 0; i < workers->nthreads; i++)
+		fons__threadJoin(workers->threads[i]);
+
+	while (workers->queue != NULL) {
+		job = workers->queue;
+		workers->queue = job->next;
+		free(job);
+	}
+	while (workers->done != NULL) {
+		job = workers->done;
+		workers->done = job->next;
+		free(job->bitmap);
+		free(job);
+	}
+
+	fons__condDestroy(&workers->wake);
+	fons__condDestroy(&workers->idle);
+	fons__mutexDestroy(&workers->lock);
+	free(workers);
+	stash->workers = NULL;
+}
+
+#endif // FONS_ASYNC_GLYPHS
+
 static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
 								 short isize, short iblur, int bitmapOption)
 {
@@ -1082,6 +1570,13 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	if (isize < 2) return NULL;
 	if (iblur > 20) iblur = 20;
 	pad = iblur+2;
+	if (stash->params.flags & FONS_SDF_GLYPHS) {
+		// One distance field glyph serves all sizes, the padding holds the outside distances.
+		isize = FONS_SDF_SIZE*10;
+		iblur = 0;
+		size = FONS_SDF_SIZE;
+		pad = FONS_SDF_PADDING+1;
+	}
 
 	// Reset allocator.
 	stash->nscratch = 0;
@@ -1093,6 +1588,8 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur) {
 			glyph = &font->glyphs[i];
 			if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL || (glyph->x0 >= 0 && glyph->y0 >= 0)) {
+			  if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED)
+				  glyph->lastUse = stash->frame;
 			  return glyph;
 			}
 			// At this point, glyph exists but the bitmap data is not yet created.
@@ -1102,6 +1599,8 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	}
 
 	// Create a new glyph or rasterize bitmap data for a cached glyph.
+	// Only this part is traced, the cache hits are too frequent.
+	FONS_TRACE_BEGIN("fons__getGlyph");
 	g = fons__tt_getGlyphIndex(&font->font, codepoint);
 	// Try to find the glyph in fallback fonts.
 	if (g == 0) {
@@ -1126,12 +1625,17 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED) {
 		// Find free spot for the rect in the atlas
 		added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+		while (added == 0 && (stash->params.flags & FONS_EVICT_GLYPHS) && fons__evictGlyph(stash, gh))
+			added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
 		if (added == 0 && stash->handleError != NULL) {
 			// Atlas is full, let the user to resize the atlas (or not), and try again.
 			stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
 			added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
 		}
-		if (added == 0) return NULL;
+		if (added == 0) {
+			FONS_TRACE_END("fons__getGlyph");
+			return NULL;
+		}
 	} else {
 		// Negative coordinate indicates there is no bitmap data created.
 		gx = -1;
@@ -1140,7 +1644,7 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 
 	// Init glyph.
 	if (glyph == NULL) {
-		glyph = fons__allocGlyph(font);
+		glyph = fons__allocGlyph(stash, font);
 		glyph->codepoint = codepoint;
 		glyph->size = isize;
 		glyph->blur = iblur;
@@ -1151,6 +1655,8 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		font->lut[h] = font->nglyphs-1;
 	}
 	glyph->index = g;
+	glyph->lastUse = stash->frame;
+	glyph->pending = 0;
 	glyph->x0 = (short)gx;
 	glyph->y0 = (short)gy;
 	glyph->x1 = (short)(glyph->x0+gw);
@@ -1160,12 +1666,33 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	glyph->yoff = (short)(y0 - pad);
 
 	if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL) {
+		FONS_TRACE_END("fons__getGlyph");
 		return glyph;
 	}
 
+	// Clear space left by evicted glyphs.
+	if (stash->atlas->shelfPacking) {
+		dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
+		for (y = 0; y < gh; y++)
+			memset(&dst[y*stash->params.width], 0, gw);
+	}
+
+#ifdef FONS_ASYNC_GLYPHS
+	// Let a worker rasterize the glyph, the empty area is drawn until it is ready.
+	if (stash->workers != NULL && fons__queueGlyph(stash, font, (int)(glyph - font->glyphs), renderFont, g, scale, pad, iblur)) {
+		glyph->pending = 1;
+		goto done;
+	}
+#endif
+
 	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
+	if (stash->params.flags & FONS_SDF_GLYPHS) {
+		dst = &stash->texData[(glyph->x0+1) + (glyph->y0+1) * stash->params.width];
+		fons__tt_renderGlyphSDF(&renderFont->font, dst, gw-2,gh-2, stash->params.width, scale, g, pad-1);
+	} else {
+		dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
+		fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
+	}
 
 	// Make sure there is one pixel empty border.
 	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
@@ -1195,20 +1722,67 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		fons__blur(stash, bdst, gw, gh, stash->params.width, iblur);
 	}
 
+#ifdef FONS_ASYNC_GLYPHS
+done:
+#endif
 	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
 	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
 	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
 	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
 
+	FONS_TRACE_END("fons__getGlyph");
 	return glyph;
 }
 
+static void fons__getQuadSDF(FONScontext* stash, FONSfont* font,
+							  int prevGlyphIndex, FONSglyph* glyph, short isize,
+							  float scale, float spacing, float* x, float* y, FONSquad* q)
+{
+	float gs = (float)isize / (float)glyph->size;
+	float xoff,yoff,x0,y0,x1,y1;
+
+	if (prevGlyphIndex != -1) {
+		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
+		*x += adv + spacing;
+	}
+
+	// The distance field is scaled to the requested size, positions are not snapped to pixels.
+	xoff = (glyph->xoff+1) * gs;
+	yoff = (glyph->yoff+1) * gs;
+	x0 = (float)(glyph->x0+1);
+	y0 = (float)(glyph->y0+1);
+	x1 = (float)(glyph->x1-1);
+	y1 = (float)(glyph->y1-1);
+
+	q->x0 = *x + xoff;
+	q->x1 = q->x0 + (x1 - x0) * gs;
+	if (stash->params.flags & FONS_ZERO_TOPLEFT) {
+		q->y0 = *y + yoff;
+		q->y1 = q->y0 + (y1 - y0) * gs;
+	} else {
+		q->y0 = *y - yoff;
+		q->y1 = q->y0 - (y1 - y0) * gs;
+	}
+
+	q->s0 = x0 * stash->itw;
+	q->t0 = y0 * stash->ith;
+	q->s1 = x1 * stash->itw;
+	q->t1 = y1 * stash->ith;
+
+	*x += glyph->xadv / 10.0f * gs;
+}
+
 static void fons__getQuad(FONScontext* stash, FONSfont* font,
-						   int prevGlyphIndex, FONSglyph* glyph,
+						   int prevGlyphIndex, FONSglyph* glyph, short isize,
 						   float scale, float spacing, float* x, float* y, FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
 
+	if (stash->params.flags & FONS_SDF_GLYPHS) {
+		fons__getQuadSDF(stash, font, prevGlyphIndex, glyph, isize, scale, spacing, x, y, q);
+		return;
+	}
+
 	if (prevGlyphIndex != -1) {
 		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
 		*x += (int)(adv + spacing + 0.5f);
@@ -1356,7 +1930,7 @@ float fonsDrawText(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1441,7 +2015,7 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
 		// If the iterator was initialized with FONS_GLYPH_BITMAP_OPTIONAL, then the UV coordinates of the quad will be invalid.
 		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 		break;
 	}
@@ -1538,7 +2112,16 @@ float fonsTextBounds(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_OPTIONAL);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
+			if (stash->params.flags & FONS_SDF_GLYPHS) {
+				// Leave out the distance field padding.
+				float inset = FONS_SDF_PADDING * (float)isize / (float)glyph->size;
+				float dy = (stash->params.flags & FONS_ZERO_TOPLEFT) ? inset : -inset;
+				q.x0 += inset;
+				q.x1 -= inset;
+				q.y0 += dy;
+				q.y1 -= dy;
+			}
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -1596,6 +2179,28 @@ void fonsVertMetrics(FONScontext* stash,
 		*lineh = font->lineh*isize/10.0f;
 }
 
+float fonsMaxAdvance(FONScontext* stash)
+{
+	FONSfont* font;
+	FONSstate* state = fons__getState(stash);
+	float size, adv;
+	int i;
+
+	if (stash == NULL) return 0;
+	if (state->font < 0 || state->font >= stash->nfonts) return 0;
+	font = stash->fonts[state->font];
+	if (font->data == NULL) return 0;
+	size = (float)(short)(state->size*10.0f) / 10.0f;
+
+	adv = font->maxadv * fons__tt_getPixelHeightScale(&font->font, size);
+	for (i = 0; i < font->nfallbacks; ++i) {
+		FONSfont* fallback = stash->fonts[font->fallbacks[i]];
+		float fadv = fallback->maxadv * fons__tt_getPixelHeightScale(&fallback->font, size);
+		if (fadv > adv) adv = fadv;
+	}
+	return adv;
+}
+
 void fonsLineBounds(FONScontext* stash, float y, float* miny, float* maxy)
 {
 	FONSfont* font;
@@ -1630,6 +2235,9 @@ const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* hei
 
 int fonsValidateTexture(FONScontext* stash, int* dirty)
 {
+#ifdef FONS_ASYNC_GLYPHS
+	fons__collectGlyphs(stash);
+#endif
 	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
 		dirty[0] = stash->dirtyRect[0];
 		dirty[1] = stash->dirtyRect[1];
@@ -1650,17 +2258,21 @@ void fonsDeleteInternal(FONScontext* stash)
 	int i;
 	if (stash == NULL) return;
 
+#ifdef FONS_ASYNC_GLYPHS
+	fons__stopWorkers(stash);
+#endif
+
 	if (stash->params.renderDelete)
 		stash->params.renderDelete(stash->params.userPtr);
 
 	for (i = 0; i < stash->nfonts; ++i)
-		fons__freeFont(stash->fonts[i]);
+		fons__freeFont(stash, stash->fonts[i]);
 
 	if (stash->atlas) fons__deleteAtlas(stash->atlas);
-	if (stash->fonts) free(stash->fonts);
-	if (stash->texData) free(stash->texData);
-	if (stash->scratch) free(stash->scratch);
-	free(stash);
+	fons__free(&stash->params, stash->fonts);
+	fons__free(&stash->params, stash->texData);
+	fons__free(&stash->params, stash->scratch);
+	fons__free(&stash->params, stash);
 	fons__tt_done(stash);
 }
 
@@ -1699,7 +2311,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 			return 0;
 	}
 	// Copy old texture data over.
-	data = (unsigned char*)malloc(width * height);
+	data = (unsigned char*)fons__realloc(&stash->params, NULL, width * height);
 	if (data == NULL)
 		return 0;
 	for (i = 0; i < stash->params.height; i++) {
@@ -1712,7 +2324,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 	if (height > stash->params.height)
 		memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
 
-	free(stash->texData);
+	fons__free(&stash->params, stash->texData);
 	stash->texData = data;
 
 	// Increase atlas size
@@ -1721,6 +2333,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 	// Add existing data as dirty.
 	for (i = 0; i < stash->atlas->nnodes; i++)
 		maxy = fons__maxi(maxy, stash->atlas->nodes[i].y);
+	maxy = fons__maxi(maxy, stash->atlas->top);
 	stash->dirtyRect[0] = 0;
 	stash->dirtyRect[1] = 0;
 	stash->dirtyRect[2] = stash->params.width;
@@ -1734,6 +2347,60 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 	return 1;
 }
 
+void fonsNewFrame(FONScontext* stash)
+{
+	if (stash == NULL) return;
+	stash->frame++;
+}
+
+int fonsStartWorkers(FONScontext* stash, int nthreads)
+{
+#ifdef FONS_ASYNC_GLYPHS
+	FONSworkers* workers;
+	if (stash == NULL || stash->workers != NULL) return 0;
+	if (nthreads < 1) return 0;
+	if (nthreads > FONS_MAX_WORKERS) nthreads = FONS_MAX_WORKERS;
+
+	workers = (FONSworkers*)malloc(sizeof(FONSworkers));
+	if (workers == NULL) return 0;
+	memset(workers, 0, sizeof(FONSworkers));
+	fons__mutexInit(&workers->lock);
+	fons__condInit(&workers->wake);
+	fons__condInit(&workers->idle);
+	stash->workers = workers;
+
+	for (workers->nthreads = 0; workers->nthreads < nthreads; workers->nthreads++) {
+		if (!fons__threadStart(&workers->threads[workers->nthreads], fons__glyphWorker, workers))
+			break;
+	}
+	if (workers->nthreads == 0) {
+		fons__stopWorkers(stash);
+		return 0;
+	}
+	return 1;
+#else
+	FONS_NOTUSED(stash);
+	FONS_NOTUSED(nthreads);
+	return 0;
+#endif
+}
+
+void fonsWaitWorkers(FONScontext* stash)
+{
+#ifdef FONS_ASYNC_GLYPHS
+	FONSworkers* workers;
+	if (stash == NULL || stash->workers == NULL) return;
+	workers = stash->workers;
+	fons__lock(&workers->lock);
+	while (workers->pending > 0)
+		fons__condWait(&workers->idle, &workers->lock);
+	fons__unlock(&workers->lock);
+	fons__collectGlyphs(stash);
+#else
+	FONS_NOTUSED(stash);
+#endif
+}
+
 int fonsResetAtlas(FONScontext* stash, int width, int height)
 {
 	int i, j;
@@ -1752,7 +2419,7 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	fons__atlasReset(stash->atlas, width, height);
 
 	// Clear texture data.
-	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
+	stash->texData = (unsigned char*)fons__realloc(&stash->params, stash->texData, width * height);
 	if (stash->texData == NULL) return 0;
 	memset(stash->texData, 0, width * height);
 
@@ -1762,7 +2429,8 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	stash->dirtyRect[2] = 0;
 	stash->dirtyRect[3] = 0;
 
-	// Reset cached glyphs
+	// Reset cached glyphs, glyphs still being rasterized are dropped.
+	stash->epoch++;
 	for (i = 0; i < stash->nfonts; i++) {
 		FONSfont* font = stash->fonts[i];
 		font->nglyphs = 0;
@@ -20,8 +20,25 @@
 #include <stdio.h>
 #include <math.h>
 #include <memory.h>
+#include <time.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// SIMD kernels are selected at compile time, define NVG_NO_SIMD to use the scalar code only.
+#if !defined(NVG_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NVG_SIMD 1
+#define NVG_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif !defined(NVG_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#define NVG_SIMD 1
+#define NVG_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
 
 #include "nanovg.h"
+#define FONS_TRACE_BEGIN(name) NVG_TRACE_BEGIN(name)
+#define FONS_TRACE_END(name) NVG_TRACE_END(name)
 #define FONTSTASH_IMPLEMENTATION
 #include "fontstash.h"
 #define STB_IMAGE_IMPLEMENTATION
@@ -42,8 +59,15 @@
 #define NVG_INIT_POINTS_SIZE 128
 #define NVG_INIT_PATHS_SIZE 16
 #define NVG_INIT_VERTS_SIZE 256
+#define NVG_MAX_BEZIER_SEGS 1024	// Most line segments a bezier is flattened to.
 #define NVG_MAX_STATES 32
 
+#define NVG_TEXT_CACHE_SIZE 256	// Number of cached text layouts, must be power of two.
+
+#define NVG_CACHED_PATH_SCALE_TOL 0.01f	// Max scale/skew deviation before cached path geometry is rebuilt.
+
+#define NVG_TRIANGULATE_MAX_VERTS 128	// Max fill vertices of a concave path which is triangulated instead of stenciled.
+
 #define NVG_KAPPA90 0.5522847493f	// Length proportional to radius of a cubic bezier handle for 90deg arcs.
 
 #define NVG_COUNTOF(arr) (sizeof(arr) / sizeof(0[arr]))
@@ -106,9 +130,239 @@ struct NVGpathCache {
 	int nverts;
 	int cverts;
 	float bounds[4];
+	int frame;	// The buffers are allocated from the frame arena.
 };
 typedef struct NVGpathCache NVGpathCache;
 
+struct NVGcachedGeometry {
+	NVGpath* paths;
+	int npaths;
+	int cpaths;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+	float bounds[4];
+	float xform[6];
+	float fringe;
+	float strokeWidth;
+	float miterLimit;
+	int lineJoin;
+	int lineCap;
+	int valid;
+};
+typedef struct NVGcachedGeometry NVGcachedGeometry;
+
+struct NVGcachedPath {
+	float* commands;
+	float* tcommands;
+	int ncommands;
+	NVGpathCache* cache;
+	float xform[6];
+	float tessTol;
+	int flattened;
+	NVGcachedGeometry fill;
+	NVGcachedGeometry stroke;
+	NVGpath* paths;
+	int cpaths;
+};
+
+enum NVGrecordedCallType {
+	NVG_RECORD_FILL = 0,
+	NVG_RECORD_STROKE = 1,
+	NVG_RECORD_TRIANGLES = 2,
+	NVG_RECORD_RECT = 3,
+	NVG_RECORD_QUADS = 4,
+};
+
+struct NVGrecordedCall {
+	int type;
+	NVGpaint paint;
+	NVGcompositeOperationState compositeOperation;
+	NVGscissor scissor;
+	float fringe;
+	float strokeWidth;
+	float bounds[4];	// Fill bounds, or x,y,w,h of a rect.
+	float radius;
+	int offset;	// First path, or first vertex for triangles and quads.
+	int count;
+};
+typedef struct NVGrecordedCall NVGrecordedCall;
+
+struct NVGcommandList {
+	NVGallocator allocator;
+	NVGrecordedCall* calls;
+	int ncalls;
+	int ccalls;
+	NVGpath* paths;
+	int* pathVerts;	// Fill and stroke vertex offset of each path.
+	int npaths;
+	int cpaths;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+};
+
+struct NVGrecorder {
+	NVGcommandList* list;
+	int ntextures;
+	int warned;
+};
+typedef struct NVGrecorder NVGrecorder;
+
+#define NVG_CAPTURE_VERSION 1
+
+enum NVGcaptureRecord {
+	NVG_CAPTURE_VIEWPORT = 1,
+	NVG_CAPTURE_CREATE_TEXTURE = 2,
+	NVG_CAPTURE_DELETE_TEXTURE = 3,
+	NVG_CAPTURE_UPDATE_TEXTURE = 4,
+	NVG_CAPTURE_FILL = 5,
+	NVG_CAPTURE_STROKE = 6,
+	NVG_CAPTURE_TRIANGLES = 7,
+	NVG_CAPTURE_QUADS = 8,
+	NVG_CAPTURE_RECT = 9,
+	NVG_CAPTURE_FLUSH = 10,
+};
+
+enum NVGcaptureState {
+	NVG_CAPTURE_IDLE = 0,
+	NVG_CAPTURE_ARMED = 1,
+	NVG_CAPTURE_ACTIVE = 2,
+};
+
+struct NVGcaptureImage {
+	int image;
+	int type;
+	int width, height;
+};
+typedef struct NVGcaptureImage NVGcaptureImage;
+
+struct NVGcapturer {
+	int state;
+	NVGparams params;	// The render back-end, while the frame is captured.
+	unsigned char* data;
+	int ndata;
+	int cdata;
+	int error;
+	NVGcaptureImage* images;	// Textures which have been written to the capture.
+	int nimages;
+	int cimages;
+};
+typedef struct NVGcapturer NVGcapturer;
+
+struct NVGcaptureTexture {
+	int id;		// Texture handle in the captured frame.
+	int image;
+	int type;
+	int width, height;
+	unsigned char* data;
+};
+typedef struct NVGcaptureTexture NVGcaptureTexture;
+
+struct NVGcaptureUpdate {
+	int texture;
+	int x, y, w, h;
+};
+typedef struct NVGcaptureUpdate NVGcaptureUpdate;
+
+struct NVGcapture {
+	NVGcontext* ctx;
+	NVGcommandList* list;
+	float width, height, devicePixelRatio;
+	NVGcaptureTexture* textures;
+	int ntextures;
+	int ctextures;
+	NVGcaptureUpdate* updates;
+	int nupdates;
+	int cupdates;
+};
+
+enum NVGtextCacheKind {
+	NVG_TEXTCACHE_BOUNDS = 1,
+	NVG_TEXTCACHE_BREAKLINES = 2,
+};
+
+struct NVGtextCacheKey {
+	int kind;
+	int fontId;
+	int align;
+	int maxRows;
+	int len;
+	unsigned int hash;
+	float size, scale, spacing, blur;
+	float width;	// Break row width.
+};
+typedef struct NVGtextCacheKey NVGtextCacheKey;
+
+struct NVGtextCacheRow {
+	int start, end, next;	// Offsets from the start of the string.
+	float width, minx, maxx;
+};
+typedef struct NVGtextCacheRow NVGtextCacheRow;
+
+struct NVGtextCacheEntry {
+	NVGtextCacheKey key;
+	char* text;
+	int ctext;
+	float advance, minx, maxx;
+	NVGtextCacheRow* rows;
+	int nrows;
+	int crows;
+};
+typedef struct NVGtextCacheEntry NVGtextCacheEntry;
+
+#define NVG_IMAGE_UPLOAD_BUDGET (4*1024*1024)	// Default bytes of decoded images uploaded per frame.
+#define NVG_IMAGE_WORKERS 2
+
+enum NVGimageJobState {
+	NVG_IMAGE_QUEUED,
+	NVG_IMAGE_DECODING,
+	NVG_IMAGE_DECODED,
+	NVG_IMAGE_FAILED,
+};
+
+struct NVGimageJob {
+	int state;
+	int image;	// Zero when the image was deleted before it was decoded.
+	int imageFlags;
+	int width, height;
+	char* filename;
+	unsigned char* mem;
+	int nmem;
+	unsigned char* pixels;
+	int uploadedRows;
+	struct NVGimageJob* next;
+};
+typedef struct NVGimageJob NVGimageJob;
+
+struct NVGimageLoader {
+	NVGimageJob* jobs;
+	int budget;
+	int* failed;	// Images which failed to decode, only used on the render thread.
+	int nfailed;
+	int cfailed;
+#ifdef FONS_ASYNC_GLYPHS
+	fons__mutex lock;
+	fons__cond wake;
+	fons__thread threads[NVG_IMAGE_WORKERS];
+	int nthreads;
+	int quit;
+#endif
+};
+typedef struct NVGimageLoader NVGimageLoader;
+
+// Font stash, font atlas images and image loader, shared by the contexts created with NVGparams.share.
+struct NVGfontShare {
+	int refs;
+	struct FONScontext* fs;
+	int images[NVG_MAX_FONTIMAGES];
+	int imageIdx;
+	NVGimageLoader* imageLoader;	// Images are shared too, any of the contexts uploads them.
+	int textGeneration;	// Incremented when fallback fonts change, the text caches of all contexts are stale then.
+	int frame;	// Most frames begun by one of the contexts, the font stash ages glyphs once per frame.
+};
+typedef struct NVGfontShare NVGfontShare;
+
 struct NVGcontext {
 	NVGparams params;
 	float* commands;
@@ -122,15 +376,64 @@ struct NVGcontext {
 	float distTol;
 	float fringeWidth;
 	float devicePxRatio;
-	struct FONScontext* fs;
-	int fontImages[NVG_MAX_FONTIMAGES];
-	int fontImageIdx;
+	struct FONScontext* fs;	// Same as fonts->fs.
+	NVGfontShare* fonts;
 	int drawCallCount;
 	int fillTriCount;
 	int strokeTriCount;
 	int textTriCount;
+	int culledCount;
+	float viewWidth, viewHeight;
+	double flattenTime;
+	double expandTime;
+	double textTime;
+	NVGframeStats frameStats;
+	NVGtextCacheEntry* textCache;
+	int textGeneration;	// Value of fonts->textGeneration when the text cache was valid.
+	int fontFrame;	// Frames begun by this context.
+	int offscreenFrame;	// The current frame was begun by nvgBeginOffscreenFrame().
+	float fastRect[5];	// Rect x,y,w,h and corner radius in view space, when it is the only shape of the path.
+	int fastRectCommands;	// Number of commands of the path when fastRect was set, zero if not set.
+	NVGarena* arena;
+	NVGcapturer* capture;
 };
 
+#define NVG_ARENA_ALIGN 16
+
+struct NVGarena {
+	NVGallocator allocator;
+	unsigned char* mem;
+	size_t size;
+	size_t used;		// Bytes used by the current frame.
+	size_t last;		// Offset of the last allocation, which can grow in place.
+	size_t overflow;	// Bytes of the current frame which did not fit, and were allocated from the heap.
+	size_t peak;		// Most bytes used by a frame.
+	unsigned char* heapBlocks;	// Heap allocations of the current frame, linked through their first bytes.
+};
+
+// The CPU timings of the frame statistics cost a clock read around each fill, stroke and text,
+// and are only measured when compiled with NVG_STATS_TIMING.
+#ifdef NVG_STATS_TIMING
+static double nvg__getTime(void)
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#elif defined(TIME_UTC)
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+#define nvg__statsTime() nvg__getTime()
+#else
+#define nvg__statsTime() 0.0
+#endif
+
 static float nvg__sqrtf(float a) { return sqrtf(a); }
 static float nvg__modf(float a, float b) { return fmodf(a, b); }
 static float nvg__sinf(float a) { return sinf(a); }
@@ -160,43 +463,218 @@ static float nvg__normalize(float *x, float* y)
 	return d;
 }
 
+// Four wide float vectors. The kernels use the same operations in the same order as the scalar
+// code (no estimates or fused multiply-adds), so both are identical within float rounding. The
+// compiler may contract the scalar code to fused multiply-adds, e.g. GCC on AArch64, build with
+// -ffp-contract=off when the results must be bit-identical.
+#if NVG_SIMD_SSE2
+typedef __m128 nvg__v4;
+#define nvg__v4load(p) _mm_loadu_ps(p)
+#define nvg__v4store(p, a) _mm_storeu_ps(p, a)
+#define nvg__v4set(x, y, z, w) _mm_setr_ps(x, y, z, w)
+#define nvg__v4splat(a) _mm_set1_ps(a)
+#define nvg__v4add(a, b) _mm_add_ps(a, b)
+#define nvg__v4sub(a, b) _mm_sub_ps(a, b)
+#define nvg__v4mul(a, b) _mm_mul_ps(a, b)
+#define nvg__v4div(a, b) _mm_div_ps(a, b)
+#define nvg__v4sqrt(a) _mm_sqrt_ps(a)
+#define nvg__v4neg(a) _mm_xor_ps(a, _mm_set1_ps(-0.0f))
+#define nvg__v4min(a, b) _mm_min_ps(a, b)
+#define nvg__v4max(a, b) _mm_max_ps(a, b)
+#define nvg__v4gt(a, b) _mm_cmpgt_ps(a, b)
+#define nvg__v4lt(a, b) _mm_cmplt_ps(a, b)
+#define nvg__v4select(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define nvg__v4mask(m) _mm_movemask_ps(m)
+#define nvg__v4xx(a) _mm_shuffle_ps(a, a, _MM_SHUFFLE(0,0,0,0))
+#define nvg__v4yy(a) _mm_shuffle_ps(a, a, _MM_SHUFFLE(1,1,1,1))
+#define nvg__v4lohi(a, b) _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,2,1,0))
+#elif NVG_SIMD_NEON
+typedef float32x4_t nvg__v4;
+#define nvg__v4load(p) vld1q_f32(p)
+#define nvg__v4store(p, a) vst1q_f32(p, a)
+#define nvg__v4splat(a) vdupq_n_f32(a)
+#define nvg__v4add(a, b) vaddq_f32(a, b)
+#define nvg__v4sub(a, b) vsubq_f32(a, b)
+#define nvg__v4mul(a, b) vmulq_f32(a, b)
+#define nvg__v4div(a, b) vdivq_f32(a, b)
+#define nvg__v4sqrt(a) vsqrtq_f32(a)
+#define nvg__v4neg(a) vnegq_f32(a)
+#define nvg__v4min(a, b) vbslq_f32(vcltq_f32(a, b), a, b)
+#define nvg__v4max(a, b) vbslq_f32(vcgtq_f32(a, b), a, b)
+#define nvg__v4gt(a, b) vreinterpretq_f32_u32(vcgtq_f32(a, b))
+#define nvg__v4lt(a, b) vreinterpretq_f32_u32(vcltq_f32(a, b))
+#define nvg__v4select(m, a, b) vbslq_f32(vreinterpretq_u32_f32(m), a, b)
+#define nvg__v4xx(a) vdupq_laneq_f32(a, 0)
+#define nvg__v4yy(a) vdupq_laneq_f32(a, 1)
+#define nvg__v4lohi(a, b) vcombine_f32(vget_low_f32(a), vget_high_f32(b))
+static nvg__v4 nvg__v4set(float x, float y, float z, float w)
+{
+	float v[4] = { x, y, z, w };
+	return vld1q_f32(v);
+}
+static int nvg__v4mask(nvg__v4 m)
+{
+	static const uint32_t bits[4] = { 1, 2, 4, 8 };
+	return (int)vaddvq_u32(vandq_u32(vreinterpretq_u32_f32(m), vld1q_u32(bits)));
+}
+#endif
+
+
+static void* nvg__realloc(const NVGallocator* alloc, void* ptr, size_t size)
+{
+	if (alloc->reallocMem != NULL)
+		return alloc->reallocMem(alloc->userPtr, ptr, size);
+	return realloc(ptr, size);
+}
+
+static void nvg__free(const NVGallocator* alloc, void* ptr)
+{
+	if (ptr == NULL) return;
+	if (alloc->freeMem != NULL)
+		alloc->freeMem(alloc->userPtr, ptr);
+	else
+		free(ptr);
+}
+
+static NVGarena* nvg__createArena(const NVGallocator* alloc)
+{
+	size_t header = (sizeof(NVGarena) + NVG_ARENA_ALIGN-1) & ~(size_t)(NVG_ARENA_ALIGN-1);
+	NVGarena* arena = (NVGarena*)nvg__realloc(alloc, NULL, header + alloc->frameArenaSize);
+	if (arena == NULL) return NULL;
+	memset(arena, 0, sizeof(NVGarena));
+	arena->allocator = *alloc;
+	arena->mem = (unsigned char*)arena + header;
+	arena->size = alloc->frameArenaSize;
+	return arena;
+}
+
+static void nvg__resetArena(NVGarena* arena)
+{
+	while (arena->heapBlocks != NULL) {
+		unsigned char* next = *(unsigned char**)arena->heapBlocks;
+		nvg__free(&arena->allocator, arena->heapBlocks);
+		arena->heapBlocks = next;
+	}
+	arena->used = 0;
+	arena->last = 0;
+	arena->overflow = 0;
+}
+
+static void nvg__deleteArena(NVGarena* arena)
+{
+	NVGallocator alloc;
+	if (arena == NULL) return;
+	nvg__resetArena(arena);
+	alloc = arena->allocator;
+	nvg__free(&alloc, arena);
+}
+
+void* nvgArenaRealloc(NVGarena* arena, void* ptr, size_t oldSize, size_t size)
+{
+	unsigned char* p = (unsigned char*)ptr;
+	size_t offset;
+
+	// Empty allocations would share the address of the next one, and could not grow in place.
+	if (size == 0) return NULL;
+
+	if (p != NULL && p == arena->mem + arena->last && arena->last + size <= arena->size) {
+		arena->used = arena->last + size;
+	} else {
+		offset = (arena->used + NVG_ARENA_ALIGN-1) & ~(size_t)(NVG_ARENA_ALIGN-1);
+		if (offset + size <= arena->size) {
+			p = arena->mem + offset;
+			arena->last = offset;
+			arena->used = offset + size;
+		} else {
+			unsigned char* block = (unsigned char*)nvg__realloc(&arena->allocator, NULL, NVG_ARENA_ALIGN + size);
+			if (block == NULL) return NULL;
+			*(unsigned char**)block = arena->heapBlocks;
+			arena->heapBlocks = block;
+			arena->overflow += size;
+			p = block + NVG_ARENA_ALIGN;
+		}
+		if (ptr != NULL)
+			memcpy(p, ptr, oldSize < size ? oldSize : size);
+	}
+
+	if (arena->used + arena->overflow > arena->peak)
+		arena->peak = arena->used + arena->overflow;
+	return p;
+}
+
+NVGarena* nvgInternalArena(NVGcontext* ctx)
+{
+	return ctx->arena;
+}
+
+// Resizes a buffer of the path cache, buffers of the frame come from the arena when there is one.
+static void* nvg__cacheRealloc(NVGcontext* ctx, NVGpathCache* c, void* ptr, size_t oldSize, size_t size)
+{
+	if (c->frame)
+		return nvgArenaRealloc(ctx->arena, ptr, oldSize, size);
+	return nvg__realloc(&ctx->params.allocator, ptr, size);
+}
 
-static void nvg__deletePathCache(NVGpathCache* c)
+static void nvg__deletePathCache(NVGcontext* ctx, NVGpathCache* c)
 {
 	if (c == NULL) return;
-	if (c->points != NULL) free(c->points);
-	if (c->paths != NULL) free(c->paths);
-	if (c->verts != NULL) free(c->verts);
-	free(c);
+	if (!c->frame) {
+		nvg__free(&ctx->params.allocator, c->points);
+		nvg__free(&ctx->params.allocator, c->paths);
+		nvg__free(&ctx->params.allocator, c->verts);
+	}
+	nvg__free(&ctx->params.allocator, c);
 }
 
-static NVGpathCache* nvg__allocPathCache(void)
+static NVGpathCache* nvg__allocPathCache(NVGcontext* ctx, int frame)
 {
-	NVGpathCache* c = (NVGpathCache*)malloc(sizeof(NVGpathCache));
+	NVGpathCache* c = (NVGpathCache*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGpathCache));
 	if (c == NULL) goto error;
 	memset(c, 0, sizeof(NVGpathCache));
+	c->frame = frame && ctx->arena != NULL;
 
-	c->points = (NVGpoint*)malloc(sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE);
+	c->points = (NVGpoint*)nvg__cacheRealloc(ctx, c, NULL, 0, sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE);
 	if (!c->points) goto error;
 	c->npoints = 0;
 	c->cpoints = NVG_INIT_POINTS_SIZE;
 
-	c->paths = (NVGpath*)malloc(sizeof(NVGpath)*NVG_INIT_PATHS_SIZE);
+	c->paths = (NVGpath*)nvg__cacheRealloc(ctx, c, NULL, 0, sizeof(NVGpath)*NVG_INIT_PATHS_SIZE);
 	if (!c->paths) goto error;
 	c->npaths = 0;
 	c->cpaths = NVG_INIT_PATHS_SIZE;
 
-	c->verts = (NVGvertex*)malloc(sizeof(NVGvertex)*NVG_INIT_VERTS_SIZE);
+	c->verts = (NVGvertex*)nvg__cacheRealloc(ctx, c, NULL, 0, sizeof(NVGvertex)*NVG_INIT_VERTS_SIZE);
 	if (!c->verts) goto error;
 	c->nverts = 0;
 	c->cverts = NVG_INIT_VERTS_SIZE;
 
 	return c;
 error:
-	nvg__deletePathCache(c);
+	nvg__deletePathCache(ctx, c);
 	return NULL;
 }
 
+// Allocates the buffers of the frame again from the reset arena, at the sizes earlier frames needed.
+static void nvg__allocFrameBuffers(NVGcontext* ctx)
+{
+	NVGpathCache* c = ctx->cache;
+
+	ctx->commands = (float*)nvgArenaRealloc(ctx->arena, NULL, 0, sizeof(float)*ctx->ccommands);
+	if (ctx->commands == NULL) ctx->ccommands = 0;
+	ctx->ncommands = 0;
+	ctx->fastRectCommands = 0;
+
+	c->points = (NVGpoint*)nvgArenaRealloc(ctx->arena, NULL, 0, sizeof(NVGpoint)*c->cpoints);
+	if (c->points == NULL) c->cpoints = 0;
+	c->paths = (NVGpath*)nvgArenaRealloc(ctx->arena, NULL, 0, sizeof(NVGpath)*c->cpaths);
+	if (c->paths == NULL) c->cpaths = 0;
+	c->verts = (NVGvertex*)nvgArenaRealloc(ctx->arena, NULL, 0, sizeof(NVGvertex)*c->cverts);
+	if (c->verts == NULL) c->cverts = 0;
+	c->npoints = 0;
+	c->npaths = 0;
+	c->nverts = 0;
+}
+
 static void nvg__setDevicePixelRatio(NVGcontext* ctx, float ratio)
 {
 	ctx->tessTol = 0.25f / ratio;
@@ -283,2007 +761,4602 @@ static NVGstate* nvg__getState(NVGcontext* ctx)
 	return &ctx->states[ctx->nstates-1];
 }
 
-NVGcontext* nvgCreateInternal(NVGparams* params)
-{
-	FONSparams fontParams;
-	NVGcontext* ctx = (NVGcontext*)malloc(sizeof(NVGcontext));
-	int i;
-	if (ctx == NULL) goto error;
-	memset(ctx, 0, sizeof(NVGcontext));
-
-	ctx->params = *params;
-	for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
-		ctx->fontImages[i] = 0;
-
-	ctx->commands = (float*)malloc(sizeof(float)*NVG_INIT_COMMANDS_SIZE);
-	if (!ctx->commands) goto error;
-	ctx->ncommands = 0;
-	ctx->ccommands = NVG_INIT_COMMANDS_SIZE;
-
-	ctx->cache = nvg__allocPathCache();
-	if (ctx->cache == NULL) goto error;
-
-	nvgSave(ctx);
-	nvgReset(ctx);
-
-	nvg__setDevicePixelRatio(ctx, 1.0f);
-
-	if (ctx->params.renderCreate(ctx->params.userPtr) == 0) goto error;
-
-	// Init font rendering
-	memset(&fontParams, 0, sizeof(fontParams));
-	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
-	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
-	fontParams.flags = FONS_ZERO_TOPLEFT;
-	fontParams.renderCreate = NULL;
-	fontParams.renderUpdate = NULL;
-	fontParams.renderDraw = NULL;
-	fontParams.renderDelete = NULL;
-	fontParams.userPtr = NULL;
-	ctx->fs = fonsCreateInternal(&fontParams);
-	if (ctx->fs == NULL) goto error;
-
-	// Create font texture
-	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, 0, NULL);
-	if (ctx->fontImages[0] == 0) goto error;
-	ctx->fontImageIdx = 0;
-
-	return ctx;
-
-error:
-	nvgDeleteInternal(ctx);
+int nvgTextureBytes(int type, int w, int h)
+{
+	int blocks = ((w+3)/4) * ((h+3)/4);
+	switch (type) {
+	case NVG_TEXTURE_ALPHA:
+		return w*h;
+	case NVG_TEXTURE_RGBA:
+		return w*h*4;
+	case NVG_TEXTURE_RGB565:
+	case NVG_TEXTURE_RGBA4444:
+	case NVG_TEXTURE_RGBA5551:
+		return w*h*2;
+	case NVG_TEXTURE_ETC1:
+	case NVG_TEXTURE_ETC2_RGB:
+	case NVG_TEXTURE_BC1:
+		return blocks*8;
+	case NVG_TEXTURE_ETC2_RGBA:
+	case NVG_TEXTURE_BC3:
+	case NVG_TEXTURE_ASTC_4x4:
+		return blocks*16;
+	}
 	return 0;
 }
 
-NVGparams* nvgInternalParams(NVGcontext* ctx)
+static int nvg__compressedTexture(int type)
 {
-    return &ctx->params;
+	return type >= NVG_TEXTURE_ETC2_RGB && type <= NVG_TEXTURE_ETC1;
 }
 
-void nvgDeleteInternal(NVGcontext* ctx)
+// Frame capture back-end, which writes the render calls to the capture and passes them on.
+static void nvg__capWrite(NVGcontext* ctx, const void* src, int n)
 {
-	int i;
-	if (ctx == NULL) return;
-	if (ctx->commands != NULL) free(ctx->commands);
-	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
-
-	if (ctx->fs)
-		fonsDeleteInternal(ctx->fs);
-
-	for (i = 0; i < NVG_MAX_FONTIMAGES; i++) {
-		if (ctx->fontImages[i] != 0) {
-			nvgDeleteImage(ctx, ctx->fontImages[i]);
-			ctx->fontImages[i] = 0;
+	NVGcapturer* cap = ctx->capture;
+	if (cap->error) return;
+	if (cap->ndata+n > cap->cdata) {
+		unsigned char* data;
+		int cdata = nvg__maxi(cap->ndata+n, 4096) + cap->cdata/2; // 1.5x Overallocate
+		data = (unsigned char*)nvg__realloc(&ctx->params.allocator, cap->data, cdata);
+		if (data == NULL) {
+			cap->error = 1;
+			return;
 		}
+		cap->data = data;
+		cap->cdata = cdata;
 	}
-
-	if (ctx->params.renderDelete != NULL)
-		ctx->params.renderDelete(ctx->params.userPtr);
-
-	free(ctx);
+	memcpy(&cap->data[cap->ndata], src, n);
+	cap->ndata += n;
 }
 
-void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float devicePixelRatio)
+// The stream is little endian, so that captures can be replayed on any machine.
+static void nvg__capInt(NVGcontext* ctx, int v)
 {
-/*	printf("Tris: draws:%d  fill:%d  stroke:%d  text:%d  TOT:%d\n",
-		ctx->drawCallCount, ctx->fillTriCount, ctx->strokeTriCount, ctx->textTriCount,
-		ctx->fillTriCount+ctx->strokeTriCount+ctx->textTriCount);*/
+	unsigned int u = (unsigned int)v;
+	unsigned char b[4];
+	b[0] = (unsigned char)(u & 0xff);
+	b[1] = (unsigned char)((u >> 8) & 0xff);
+	b[2] = (unsigned char)((u >> 16) & 0xff);
+	b[3] = (unsigned char)((u >> 24) & 0xff);
+	nvg__capWrite(ctx, b, 4);
+}
 
-	ctx->nstates = 0;
-	nvgSave(ctx);
-	nvgReset(ctx);
+static void nvg__capFloats(NVGcontext* ctx, const float* v, int n)
+{
+	int i;
+	for (i = 0; i < n; i++) {
+		unsigned int u;
+		memcpy(&u, &v[i], 4);
+		nvg__capInt(ctx, (int)u);
+	}
+}
 
-	nvg__setDevicePixelRatio(ctx, devicePixelRatio);
+static void nvg__capVerts(NVGcontext* ctx, const NVGvertex* verts, int nverts)
+{
+	int i;
+	nvg__capInt(ctx, nverts);
+	for (i = 0; i < nverts; i++)
+		nvg__capFloats(ctx, &verts[i].x, 4);
+}
 
-	ctx->params.renderViewport(ctx->params.userPtr, windowWidth, windowHeight, devicePixelRatio);
+// Starts a record, the size of the record is written by nvg__capEnd().
+static int nvg__capBegin(NVGcontext* ctx, int type)
+{
+	nvg__capInt(ctx, type);
+	nvg__capInt(ctx, 0);
+	return ctx->capture->ndata;
+}
 
-	ctx->drawCallCount = 0;
-	ctx->fillTriCount = 0;
-	ctx->strokeTriCount = 0;
-	ctx->textTriCount = 0;
+static void nvg__capEnd(NVGcontext* ctx, int start)
+{
+	NVGcapturer* cap = ctx->capture;
+	int size = cap->ndata - start;
+	if (cap->error) return;
+	cap->data[start-4] = (unsigned char)(size & 0xff);
+	cap->data[start-3] = (unsigned char)((size >> 8) & 0xff);
+	cap->data[start-2] = (unsigned char)((size >> 16) & 0xff);
+	cap->data[start-1] = (unsigned char)((size >> 24) & 0xff);
 }
 
-void nvgCancelFrame(NVGcontext* ctx)
+static NVGcaptureImage* nvg__capFindImage(NVGcapturer* cap, int image)
 {
-	ctx->params.renderCancel(ctx->params.userPtr);
+	int i;
+	for (i = 0; i < cap->nimages; i++)
+		if (cap->images[i].image == image)
+			return &cap->images[i];
+	return NULL;
 }
 
-void nvgEndFrame(NVGcontext* ctx)
+static void nvg__capTexture(NVGcontext* ctx, int image, int type, int w, int h, int imageFlags, const unsigned char* data)
 {
-	ctx->params.renderFlush(ctx->params.userPtr);
-	if (ctx->fontImageIdx != 0) {
-		int fontImage = ctx->fontImages[ctx->fontImageIdx];
-		int i, j, iw, ih;
-		// delete images that smaller than current one
-		if (fontImage == 0)
+	NVGcapturer* cap = ctx->capture;
+	NVGcaptureImage* img;
+	int start;
+	if (cap->nimages+1 > cap->cimages) {
+		NVGcaptureImage* images;
+		int cimages = nvg__maxi(cap->nimages+1, 16) + cap->cimages/2; // 1.5x Overallocate
+		images = (NVGcaptureImage*)nvg__realloc(&ctx->params.allocator, cap->images, sizeof(NVGcaptureImage)*cimages);
+		if (images == NULL) {
+			cap->error = 1;
 			return;
-		nvgImageSize(ctx, fontImage, &iw, &ih);
-		for (i = j = 0; i < ctx->fontImageIdx; i++) {
-			if (ctx->fontImages[i] != 0) {
-				int nw, nh;
-				nvgImageSize(ctx, ctx->fontImages[i], &nw, &nh);
-				if (nw < iw || nh < ih)
-					nvgDeleteImage(ctx, ctx->fontImages[i]);
-				else
-					ctx->fontImages[j++] = ctx->fontImages[i];
-			}
 		}
-		// make current font image to first
-		ctx->fontImages[j++] = ctx->fontImages[0];
-		ctx->fontImages[0] = fontImage;
-		ctx->fontImageIdx = 0;
-		// clear all images after j
-		for (i = j; i < NVG_MAX_FONTIMAGES; i++)
-			ctx->fontImages[i] = 0;
+		cap->images = images;
+		cap->cimages = cimages;
+	}
+	img = &cap->images[cap->nimages++];
+	img->image = image;
+	img->type = type;
+	img->width = w;
+	img->height = h;
+
+	start = nvg__capBegin(ctx, NVG_CAPTURE_CREATE_TEXTURE);
+	nvg__capInt(ctx, image);
+	nvg__capInt(ctx, type);
+	nvg__capInt(ctx, w);
+	nvg__capInt(ctx, h);
+	nvg__capInt(ctx, imageFlags);
+	nvg__capInt(ctx, data != NULL);
+	if (data != NULL)
+		nvg__capWrite(ctx, data, nvgTextureBytes(type, w, h));
+	nvg__capEnd(ctx, start);
+}
+
+// Textures which were created before the capture are written as blank textures when first used.
+static NVGcaptureImage* nvg__capImage(NVGcontext* ctx, int image)
+{
+	NVGcapturer* cap = ctx->capture;
+	NVGcaptureImage* img;
+	int i, w = 0, h = 0, type = NVG_TEXTURE_RGBA, flags = 0;
+	if (image == 0) return NULL;
+	img = nvg__capFindImage(cap, image);
+	if (img != NULL) return img;
+	if (cap->params.renderGetTextureSize(cap->params.userPtr, image, &w, &h) == 0) return NULL;
+	if (cap->params.renderGetTextureType != NULL) {
+		type = cap->params.renderGetTextureType(cap->params.userPtr, image);
+		if (type == 0) return NULL;
+	}
+	for (i = 0; i < NVG_MAX_FONTIMAGES; i++) {
+		if (ctx->fonts->images[i] == image) {
+			type = NVG_TEXTURE_ALPHA;
+			flags = cap->params.sdfText ? NVG_IMAGE_SDF : 0;
+		}
 	}
+	nvg__capTexture(ctx, image, type, w, h, flags, NULL);
+	return nvg__capFindImage(cap, image);
 }
 
-NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b)
+static void nvg__capPaint(NVGcontext* ctx, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe)
 {
-	return nvgRGBA(r,g,b,255);
+	nvg__capFloats(ctx, paint->xform, 6);
+	nvg__capFloats(ctx, paint->extent, 2);
+	nvg__capFloats(ctx, &paint->radius, 1);
+	nvg__capFloats(ctx, &paint->feather, 1);
+	nvg__capFloats(ctx, paint->innerColor.rgba, 4);
+	nvg__capFloats(ctx, paint->outerColor.rgba, 4);
+	nvg__capInt(ctx, paint->image);
+	nvg__capInt(ctx, compositeOperation.srcRGB);
+	nvg__capInt(ctx, compositeOperation.dstRGB);
+	nvg__capInt(ctx, compositeOperation.srcAlpha);
+	nvg__capInt(ctx, compositeOperation.dstAlpha);
+	nvg__capFloats(ctx, scissor->xform, 6);
+	nvg__capFloats(ctx, scissor->extent, 2);
+	nvg__capFloats(ctx, &fringe, 1);
 }
 
-NVGcolor nvgRGBf(float r, float g, float b)
+static void nvg__capPaths(NVGcontext* ctx, const NVGpath* paths, int npaths)
 {
-	return nvgRGBAf(r,g,b,1.0f);
+	int i;
+	nvg__capInt(ctx, npaths);
+	for (i = 0; i < npaths; i++) {
+		const NVGpath* path = &paths[i];
+		nvg__capInt(ctx, path->first);
+		nvg__capInt(ctx, path->count);
+		nvg__capInt(ctx, path->closed);
+		nvg__capInt(ctx, path->nbevel);
+		nvg__capInt(ctx, path->winding);
+		nvg__capInt(ctx, path->convex);
+		nvg__capInt(ctx, path->triangulated);
+		nvg__capVerts(ctx, path->fill, path->nfill);
+		nvg__capVerts(ctx, path->stroke, path->nstroke);
+	}
 }
 
-NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+static int nvg__capCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
 {
-	NVGcolor color;
-	// Use longer initialization to suppress warning.
-	color.r = r / 255.0f;
-	color.g = g / 255.0f;
-	color.b = b / 255.0f;
-	color.a = a / 255.0f;
-	return color;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	int image = cap->params.renderCreateTexture(cap->params.userPtr, type, w, h, imageFlags, data);
+	if (image != 0)
+		nvg__capTexture(ctx, image, type, w, h, imageFlags, data);
+	return image;
 }
 
-NVGcolor nvgRGBAf(float r, float g, float b, float a)
+static int nvg__capDeleteTexture(void* uptr, int image)
 {
-	NVGcolor color;
-	// Use longer initialization to suppress warning.
-	color.r = r;
-	color.g = g;
-	color.b = b;
-	color.a = a;
-	return color;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	NVGcaptureImage* img = nvg__capFindImage(cap, image);
+	int start;
+	if (img != NULL) {
+		*img = cap->images[--cap->nimages];
+		start = nvg__capBegin(ctx, NVG_CAPTURE_DELETE_TEXTURE);
+		nvg__capInt(ctx, image);
+		nvg__capEnd(ctx, start);
+	}
+	return cap->params.renderDeleteTexture(cap->params.userPtr, image);
+}
+
+static int nvg__capUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	NVGcaptureImage* img = nvg__capImage(ctx, image);
+	if (img != NULL && !nvg__compressedTexture(img->type) && x >= 0 && y >= 0 && w > 0 && h > 0 && x+w <= img->width && y+h <= img->height) {
+		// The data is the whole texture, only the updated area is captured.
+		int bpp = nvgTextureBytes(img->type, 1, 1);
+		int start = nvg__capBegin(ctx, NVG_CAPTURE_UPDATE_TEXTURE);
+		int i;
+		nvg__capInt(ctx, image);
+		nvg__capInt(ctx, x);
+		nvg__capInt(ctx, y);
+		nvg__capInt(ctx, w);
+		nvg__capInt(ctx, h);
+		for (i = 0; i < h; i++)
+			nvg__capWrite(ctx, &data[((y+i)*img->width + x)*bpp], w*bpp);
+		nvg__capEnd(ctx, start);
+	}
+	return cap->params.renderUpdateTexture(cap->params.userPtr, image, x, y, w, h, data);
 }
 
-NVGcolor nvgTransRGBA(NVGcolor c, unsigned char a)
+static int nvg__capGetTextureSize(void* uptr, int image, int* w, int* h)
 {
-	c.a = a / 255.0f;
-	return c;
+	NVGcapturer* cap = ((NVGcontext*)uptr)->capture;
+	return cap->params.renderGetTextureSize(cap->params.userPtr, image, w, h);
 }
 
-NVGcolor nvgTransRGBAf(NVGcolor c, float a)
+static int nvg__capGetTextureType(void* uptr, int image)
 {
-	c.a = a;
-	return c;
+	NVGcapturer* cap = ((NVGcontext*)uptr)->capture;
+	return cap->params.renderGetTextureType(cap->params.userPtr, image);
 }
 
-NVGcolor nvgLerpRGBA(NVGcolor c0, NVGcolor c1, float u)
+static void nvg__capViewport(void* uptr, float width, float height, float devicePixelRatio)
 {
-	int i;
-	float oneminu;
-	NVGcolor cint = {{{0}}};
-
-	u = nvg__clampf(u, 0.0f, 1.0f);
-	oneminu = 1.0f - u;
-	for( i = 0; i <4; i++ )
-	{
-		cint.rgba[i] = c0.rgba[i] * oneminu + c1.rgba[i] * u;
-	}
-
-	return cint;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	float viewport[3];
+	int start = nvg__capBegin(ctx, NVG_CAPTURE_VIEWPORT);
+	viewport[0] = width;
+	viewport[1] = height;
+	viewport[2] = devicePixelRatio;
+	nvg__capFloats(ctx, viewport, 3);
+	nvg__capEnd(ctx, start);
+	cap->params.renderViewport(cap->params.userPtr, width, height, devicePixelRatio);
 }
 
-NVGcolor nvgHSL(float h, float s, float l)
+static void nvg__capCancel(void* uptr)
 {
-	return nvgHSLA(h,s,l,255);
+	NVGcapturer* cap = ((NVGcontext*)uptr)->capture;
+	cap->params.renderCancel(cap->params.userPtr);
 }
 
-static float nvg__hue(float h, float m1, float m2)
+static void nvg__capFlush(void* uptr)
 {
-	if (h < 0) h += 1;
-	if (h > 1) h -= 1;
-	if (h < 1.0f/6.0f)
-		return m1 + (m2 - m1) * h * 6.0f;
-	else if (h < 3.0f/6.0f)
-		return m2;
-	else if (h < 4.0f/6.0f)
-		return m1 + (m2 - m1) * (2.0f/3.0f - h) * 6.0f;
-	return m1;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	nvg__capEnd(ctx, nvg__capBegin(ctx, NVG_CAPTURE_FLUSH));
+	cap->params.renderFlush(cap->params.userPtr);
 }
 
-NVGcolor nvgHSLA(float h, float s, float l, unsigned char a)
+static void nvg__capFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+						 const float* bounds, const NVGpath* paths, int npaths)
 {
-	float m1, m2;
-	NVGcolor col;
-	h = nvg__modf(h, 1.0f);
-	if (h < 0.0f) h += 1.0f;
-	s = nvg__clampf(s, 0.0f, 1.0f);
-	l = nvg__clampf(l, 0.0f, 1.0f);
-	m2 = l <= 0.5f ? (l * (1 + s)) : (l + s - l * s);
-	m1 = 2 * l - m2;
-	col.r = nvg__clampf(nvg__hue(h + 1.0f/3.0f, m1, m2), 0.0f, 1.0f);
-	col.g = nvg__clampf(nvg__hue(h, m1, m2), 0.0f, 1.0f);
-	col.b = nvg__clampf(nvg__hue(h - 1.0f/3.0f, m1, m2), 0.0f, 1.0f);
-	col.a = a/255.0f;
-	return col;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	int start;
+	nvg__capImage(ctx, paint->image);
+	start = nvg__capBegin(ctx, NVG_CAPTURE_FILL);
+	nvg__capPaint(ctx, paint, compositeOperation, scissor, fringe);
+	nvg__capFloats(ctx, bounds, 4);
+	nvg__capPaths(ctx, paths, npaths);
+	nvg__capEnd(ctx, start);
+	cap->params.renderFill(cap->params.userPtr, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
 }
 
-void nvgTransformIdentity(float* t)
+static void nvg__capStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+						   float strokeWidth, const NVGpath* paths, int npaths)
 {
-	t[0] = 1.0f; t[1] = 0.0f;
-	t[2] = 0.0f; t[3] = 1.0f;
-	t[4] = 0.0f; t[5] = 0.0f;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	int start;
+	nvg__capImage(ctx, paint->image);
+	start = nvg__capBegin(ctx, NVG_CAPTURE_STROKE);
+	nvg__capPaint(ctx, paint, compositeOperation, scissor, fringe);
+	nvg__capFloats(ctx, &strokeWidth, 1);
+	nvg__capPaths(ctx, paths, npaths);
+	nvg__capEnd(ctx, start);
+	cap->params.renderStroke(cap->params.userPtr, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
 }
 
-void nvgTransformTranslate(float* t, float tx, float ty)
+static void nvg__capTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							  const NVGvertex* verts, int nverts, float fringe)
 {
-	t[0] = 1.0f; t[1] = 0.0f;
-	t[2] = 0.0f; t[3] = 1.0f;
-	t[4] = tx; t[5] = ty;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	int start;
+	nvg__capImage(ctx, paint->image);
+	start = nvg__capBegin(ctx, NVG_CAPTURE_TRIANGLES);
+	nvg__capPaint(ctx, paint, compositeOperation, scissor, fringe);
+	nvg__capVerts(ctx, verts, nverts);
+	nvg__capEnd(ctx, start);
+	cap->params.renderTriangles(cap->params.userPtr, paint, compositeOperation, scissor, verts, nverts, fringe);
 }
 
-void nvgTransformScale(float* t, float sx, float sy)
+static void nvg__capQuads(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+						  const NVGvertex* verts, int nquads, float fringe)
 {
-	t[0] = sx; t[1] = 0.0f;
-	t[2] = 0.0f; t[3] = sy;
-	t[4] = 0.0f; t[5] = 0.0f;
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	int start;
+	nvg__capImage(ctx, paint->image);
+	start = nvg__capBegin(ctx, NVG_CAPTURE_QUADS);
+	nvg__capPaint(ctx, paint, compositeOperation, scissor, fringe);
+	nvg__capVerts(ctx, verts, nquads*2);
+	nvg__capEnd(ctx, start);
+	cap->params.renderQuads(cap->params.userPtr, paint, compositeOperation, scissor, verts, nquads, fringe);
 }
 
-void nvgTransformRotate(float* t, float a)
-{
-	float cs = nvg__cosf(a), sn = nvg__sinf(a);
-	t[0] = cs; t[1] = sn;
-	t[2] = -sn; t[3] = cs;
-	t[4] = 0.0f; t[5] = 0.0f;
+static void nvg__capRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+						 float fringe, const float* rect, float radius)
+{
+	NVGcontext* ctx = (NVGcontext*)uptr;
+	NVGcapturer* cap = ctx->capture;
+	int start;
+	nvg__capImage(ctx, paint->image);
+	start = nvg__capBegin(ctx, NVG_CAPTURE_RECT);
+	nvg__capPaint(ctx, paint, compositeOperation, scissor, fringe);
+	nvg__capFloats(ctx, rect, 4);
+	nvg__capFloats(ctx, &radius, 1);
+	nvg__capEnd(ctx, start);
+	cap->params.renderRect(cap->params.userPtr, paint, compositeOperation, scissor, fringe, rect, radius);
+}
+
+static void nvg__capFrameStats(void* uptr, NVGframeStats* stats)
+{
+	NVGcapturer* cap = ((NVGcontext*)uptr)->capture;
+	cap->params.renderFrameStats(cap->params.userPtr, stats);
+}
+
+// Routes the render calls through the capture until nvg__endCapture().
+static void nvg__beginCapture(NVGcontext* ctx)
+{
+	NVGcapturer* cap = ctx->capture;
+	static const unsigned char magic[4] = { 'N', 'V', 'G', 'C' };
+	int fontImage = ctx->fonts->images[ctx->fonts->imageIdx];
+
+	cap->state = NVG_CAPTURE_ACTIVE;
+	cap->params = ctx->params;
+	cap->ndata = 0;
+	cap->nimages = 0;
+	cap->error = 0;
+
+	ctx->params.userPtr = ctx;
+	ctx->params.renderCreateTexture = nvg__capCreateTexture;
+	ctx->params.renderDeleteTexture = nvg__capDeleteTexture;
+	ctx->params.renderUpdateTexture = nvg__capUpdateTexture;
+	ctx->params.renderGetTextureSize = nvg__capGetTextureSize;
+	ctx->params.renderViewport = nvg__capViewport;
+	ctx->params.renderCancel = nvg__capCancel;
+	ctx->params.renderFlush = nvg__capFlush;
+	ctx->params.renderFill = nvg__capFill;
+	ctx->params.renderStroke = nvg__capStroke;
+	ctx->params.renderTriangles = nvg__capTriangles;
+	if (cap->params.renderFrameStats != NULL) ctx->params.renderFrameStats = nvg__capFrameStats;
+	if (cap->params.renderQuads != NULL) ctx->params.renderQuads = nvg__capQuads;
+	if (cap->params.renderRect != NULL) ctx->params.renderRect = nvg__capRect;
+	if (cap->params.renderGetTextureType != NULL) ctx->params.renderGetTextureType = nvg__capGetTextureType;
+
+	nvg__capWrite(ctx, magic, 4);
+	nvg__capInt(ctx, NVG_CAPTURE_VERSION);
+
+	// The glyphs of earlier frames are only in the font atlas, capture its contents.
+	if (fontImage != 0) {
+		int w, h;
+		const unsigned char* data = fonsGetTextureData(ctx->fs, &w, &h);
+		nvg__capTexture(ctx, fontImage, NVG_TEXTURE_ALPHA, w, h, cap->params.sdfText ? NVG_IMAGE_SDF : 0, data);
+	}
 }
 
-void nvgTransformSkewX(float* t, float a)
+static void nvg__endCapture(NVGcontext* ctx, int keep)
 {
-	t[0] = 1.0f; t[1] = 0.0f;
-	t[2] = nvg__tanf(a); t[3] = 1.0f;
-	t[4] = 0.0f; t[5] = 0.0f;
+	NVGcapturer* cap = ctx->capture;
+	ctx->params = cap->params;
+	cap->state = NVG_CAPTURE_IDLE;
+	if (!keep || cap->error)
+		cap->ndata = 0;
 }
 
-void nvgTransformSkewY(float* t, float a)
+// Image loading
+
+static unsigned char* nvg__readFile(const NVGallocator* alloc, const char* filename, int* ndata)
 {
-	t[0] = 1.0f; t[1] = nvg__tanf(a);
-	t[2] = 0.0f; t[3] = 1.0f;
-	t[4] = 0.0f; t[5] = 0.0f;
+	FILE* fp = NULL;
+	unsigned char* data = NULL;
+	size_t readed;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) goto error;
+	fseek(fp, 0, SEEK_END);
+	*ndata = (int)ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (*ndata <= 0) goto error;
+	data = (unsigned char*)nvg__realloc(alloc, NULL, *ndata);
+	if (data == NULL) goto error;
+	readed = fread(data, 1, *ndata, fp);
+	fclose(fp);
+	fp = NULL;
+	if (readed != (size_t)*ndata) goto error;
+	return data;
+
+error:
+	nvg__free(alloc, data);
+	if (fp != NULL) fclose(fp);
+	return NULL;
 }
 
-void nvgTransformMultiply(float* t, const float* s)
+static const unsigned char nvg__ktxIdentifier[12] = { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+static unsigned int nvg__getLE32(const unsigned char* p)
 {
-	float t0 = t[0] * s[0] + t[1] * s[2];
-	float t2 = t[2] * s[0] + t[3] * s[2];
-	float t4 = t[4] * s[0] + t[5] * s[2] + s[4];
-	t[1] = t[0] * s[1] + t[1] * s[3];
-	t[3] = t[2] * s[1] + t[3] * s[3];
-	t[5] = t[4] * s[1] + t[5] * s[3] + s[5];
-	t[0] = t0;
-	t[2] = t2;
-	t[4] = t4;
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
 }
 
-void nvgTransformPremultiply(float* t, const float* s)
+static int nvg__isTextureFile(const unsigned char* data, int ndata)
 {
-	float s2[6];
-	memcpy(s2, s, sizeof(float)*6);
-	nvgTransformMultiply(s2, t);
-	memcpy(t, s2, sizeof(float)*6);
+	if (ndata >= 64 && memcmp(data, nvg__ktxIdentifier, 12) == 0) return 1;
+	if (ndata >= 128 && memcmp(data, "DDS ", 4) == 0) return 1;
+	return 0;
 }
 
-int nvgTransformInverse(float* inv, const float* t)
+static int nvg__ktxType(unsigned int glType, unsigned int glFormat, unsigned int glInternalFormat)
 {
-	double invdet, det = (double)t[0] * t[3] - (double)t[2] * t[1];
-	if (det > -1e-6 && det < 1e-6) {
-		nvgTransformIdentity(inv);
-		return 0;
+	if (glType == 0) {
+		switch (glInternalFormat) {
+		case 0x8d64: return NVG_TEXTURE_ETC1;
+		case 0x9274: return NVG_TEXTURE_ETC2_RGB;
+		case 0x9278: return NVG_TEXTURE_ETC2_RGBA;
+		case 0x83f0: return NVG_TEXTURE_BC1;
+		case 0x83f1: return NVG_TEXTURE_BC1;	// BC1 with punch-through alpha, decoded the same.
+		case 0x83f3: return NVG_TEXTURE_BC3;
+		case 0x93b0: return NVG_TEXTURE_ASTC_4x4;
+		}
+	} else if (glType == 0x1401 && glFormat == 0x1908) {	// GL_UNSIGNED_BYTE, GL_RGBA
+		return NVG_TEXTURE_RGBA;
+	} else if (glType == 0x8363 && glFormat == 0x1907) {	// GL_UNSIGNED_SHORT_5_6_5, GL_RGB
+		return NVG_TEXTURE_RGB565;
+	} else if (glType == 0x8033 && glFormat == 0x1908) {	// GL_UNSIGNED_SHORT_4_4_4_4, GL_RGBA
+		return NVG_TEXTURE_RGBA4444;
+	} else if (glType == 0x8034 && glFormat == 0x1908) {	// GL_UNSIGNED_SHORT_5_5_5_1, GL_RGBA
+		return NVG_TEXTURE_RGBA5551;
 	}
-	invdet = 1.0 / det;
-	inv[0] = (float)(t[3] * invdet);
-	inv[2] = (float)(-t[2] * invdet);
-	inv[4] = (float)(((double)t[2] * t[5] - (double)t[3] * t[4]) * invdet);
-	inv[1] = (float)(-t[1] * invdet);
-	inv[3] = (float)(t[0] * invdet);
-	inv[5] = (float)(((double)t[1] * t[4] - (double)t[0] * t[5]) * invdet);
-	return 1;
+	return 0;
 }
 
-void nvgTransformPoint(float* dx, float* dy, const float* t, float sx, float sy)
+static int nvg__ddsType(const unsigned char* pf, unsigned int dxgiFormat)
 {
-	*dx = sx*t[0] + sy*t[2] + t[4];
-	*dy = sx*t[1] + sy*t[3] + t[5];
-}
+	unsigned int flags = nvg__getLE32(&pf[4]);
+	unsigned int bits = nvg__getLE32(&pf[12]);
+	unsigned int r = nvg__getLE32(&pf[16]), g = nvg__getLE32(&pf[20]), b = nvg__getLE32(&pf[24]), a = nvg__getLE32(&pf[28]);
 
-float nvgDegToRad(float deg)
-{
-	return deg / 180.0f * NVG_PI;
+	if (flags & 0x4) {	// DDPF_FOURCC
+		if (memcmp(&pf[8], "DXT1", 4) == 0) return NVG_TEXTURE_BC1;
+		if (memcmp(&pf[8], "DXT5", 4) == 0) return NVG_TEXTURE_BC3;
+		if (memcmp(&pf[8], "DX10", 4) == 0) {
+			switch (dxgiFormat) {
+			case 28: return NVG_TEXTURE_RGBA;	// DXGI_FORMAT_R8G8B8A8_UNORM
+			case 71: return NVG_TEXTURE_BC1;	// DXGI_FORMAT_BC1_UNORM
+			case 77: return NVG_TEXTURE_BC3;	// DXGI_FORMAT_BC3_UNORM
+			case 85: return NVG_TEXTURE_RGB565;	// DXGI_FORMAT_B5G6R5_UNORM
+			}
+		}
+		return 0;
+	}
+	if ((flags & 0x40) == 0) return 0;	// DDPF_RGB
+	if ((flags & 0x1) == 0) a = 0;		// DDPF_ALPHAPIXELS
+	if (bits == 32 && r == 0xff && g == 0xff00 && b == 0xff0000 && a == 0xff000000) return NVG_TEXTURE_RGBA;
+	if (bits == 16 && r == 0xf800 && g == 0x07e0 && b == 0x001f && a == 0) return NVG_TEXTURE_RGB565;
+	if (bits == 16 && r == 0xf000 && g == 0x0f00 && b == 0x00f0 && a == 0x000f) return NVG_TEXTURE_RGBA4444;
+	if (bits == 16 && r == 0xf800 && g == 0x07c0 && b == 0x003e && a == 0x0001) return NVG_TEXTURE_RGBA5551;
+	return 0;
 }
 
-float nvgRadToDeg(float rad)
-{
-	return rad / NVG_PI * 180.0f;
-}
+// Creates the image from the first mip level of a KTX or DDS file, other mip levels are not used.
+static int nvg__createImageTextureFile(NVGcontext* ctx, int imageFlags, const unsigned char* data, int ndata)
+{
+	const unsigned char* pixels;
+	unsigned char* packed = NULL;
+	int type, w, h, size, stride, rowBytes, offset, i, image;
+
+	if (memcmp(data, nvg__ktxIdentifier, 12) == 0) {
+		// Only little endian 2D textures.
+		if (nvg__getLE32(&data[12]) != 0x04030201) return 0;
+		if (nvg__getLE32(&data[44]) > 1 || nvg__getLE32(&data[48]) != 0 || nvg__getLE32(&data[52]) != 1) return 0;
+		type = nvg__ktxType(nvg__getLE32(&data[16]), nvg__getLE32(&data[24]), nvg__getLE32(&data[28]));
+		w = (int)nvg__getLE32(&data[36]);
+		h = (int)nvg__getLE32(&data[40]);
+		if (nvg__getLE32(&data[60]) > (unsigned int)ndata - 68) return 0;
+		offset = 64 + (int)nvg__getLE32(&data[60]) + 4;
+		rowBytes = nvgTextureBytes(type, w, 1);
+		// Rows of uncompressed data are padded to four bytes.
+		stride = nvg__compressedTexture(type) ? rowBytes : (rowBytes + 3) & ~3;
+	} else {
+		unsigned int dxgiFormat = 0;
+		if (nvg__getLE32(&data[4]) != 124) return 0;
+		offset = 128;
+		if (memcmp(&data[84], "DX10", 4) == 0) {
+			if (ndata < 148) return 0;
+			dxgiFormat = nvg__getLE32(&data[128]);
+			offset = 148;
+		}
+		type = nvg__ddsType(&data[76], dxgiFormat);
+		h = (int)nvg__getLE32(&data[12]);
+		w = (int)nvg__getLE32(&data[16]);
+		rowBytes = nvgTextureBytes(type, w, 1);
+		stride = rowBytes;
+		// DDSD_PITCH
+		if (!nvg__compressedTexture(type) && (nvg__getLE32(&data[8]) & 0x8) && (int)nvg__getLE32(&data[20]) >= rowBytes)
+			stride = (int)nvg__getLE32(&data[20]);
+	}
 
-static void nvg__setPaintColor(NVGpaint* p, NVGcolor color)
-{
-	memset(p, 0, sizeof(*p));
-	nvgTransformIdentity(p->xform);
-	p->radius = 0.0f;
-	p->feather = 1.0f;
-	p->innerColor = color;
-	p->outerColor = color;
+	if (type == 0 || w <= 0 || h <= 0 || w > 16384 || h > 16384) return 0;
+	size = nvg__compressedTexture(type) ? nvgTextureBytes(type, w, h) : stride*(h-1) + rowBytes;
+	if (offset > ndata || size > ndata - offset) return 0;
+	pixels = &data[offset];
+
+	if (stride != rowBytes) {
+		packed = (unsigned char*)nvg__realloc(&ctx->params.allocator, NULL, rowBytes*h);
+		if (packed == NULL) return 0;
+		for (i = 0; i < h; i++)
+			memcpy(&packed[i*rowBytes], &pixels[i*stride], rowBytes);
+		pixels = packed;
+	}
+	image = nvgCreateImageFormat(ctx, type, w, h, imageFlags, pixels);
+	nvg__free(&ctx->params.allocator, packed);
+	return image;
 }
 
+// Decoding uses the worker threads of fontstash, without them one image is decoded per frame.
+#ifdef FONS_ASYNC_GLYPHS
+#define NVG_ASYNC_IMAGES 1
+#endif
 
-// State handling
-void nvgSave(NVGcontext* ctx)
+static void nvg__decodeImage(NVGimageJob* job)
 {
-	if (ctx->nstates >= NVG_MAX_STATES)
-		return;
-	if (ctx->nstates > 0)
-		memcpy(&ctx->states[ctx->nstates], &ctx->states[ctx->nstates-1], sizeof(NVGstate));
-	ctx->nstates++;
+	int w, h, n;
+	NVG_TRACE_BEGIN("nvg__decodeImage");
+	if (job->filename != NULL)
+		job->pixels = stbi_load(job->filename, &w, &h, &n, 4);
+	else
+		job->pixels = stbi_load_from_memory(job->mem, job->nmem, &w, &h, &n, 4);
+	// The texture was created from the size in the header.
+	if (job->pixels != NULL && (w != job->width || h != job->height)) {
+		stbi_image_free(job->pixels);
+		job->pixels = NULL;
+	}
+	NVG_TRACE_END("nvg__decodeImage");
 }
 
-void nvgRestore(NVGcontext* ctx)
+#ifdef NVG_ASYNC_IMAGES
+static FONS_THREAD_FUNC nvg__imageWorker(void* arg)
 {
-	if (ctx->nstates <= 1)
-		return;
-	ctx->nstates--;
-}
+	NVGimageLoader* loader = (NVGimageLoader*)arg;
+	NVGimageJob* job;
 
-void nvgReset(NVGcontext* ctx)
-{
-	NVGstate* state = nvg__getState(ctx);
-	memset(state, 0, sizeof(*state));
+	fons__lock(&loader->lock);
+	for (;;) {
+		for (job = loader->jobs; job != NULL && job->state != NVG_IMAGE_QUEUED; job = job->next);
+		if (loader->quit)
+			break;
+		if (job == NULL) {
+			fons__condWait(&loader->wake, &loader->lock);
+			continue;
+		}
+		job->state = NVG_IMAGE_DECODING;
+		fons__unlock(&loader->lock);
 
-	nvg__setPaintColor(&state->fill, nvgRGBA(255,255,255,255));
-	nvg__setPaintColor(&state->stroke, nvgRGBA(0,0,0,255));
-	state->compositeOperation = nvg__compositeOperationState(NVG_SOURCE_OVER);
-	state->shapeAntiAlias = 1;
-	state->strokeWidth = 1.0f;
-	state->miterLimit = 10.0f;
-	state->lineCap = NVG_BUTT;
-	state->lineJoin = NVG_MITER;
-	state->alpha = 1.0f;
-	nvgTransformIdentity(state->xform);
+		nvg__decodeImage(job);
 
-	state->scissor.extent[0] = -1.0f;
-	state->scissor.extent[1] = -1.0f;
+		fons__lock(&loader->lock);
+		job->state = job->pixels != NULL ? NVG_IMAGE_DECODED : NVG_IMAGE_FAILED;
+	}
+	fons__unlock(&loader->lock);
 
-	state->fontSize = 16.0f;
-	state->letterSpacing = 0.0f;
-	state->lineHeight = 1.0f;
-	state->fontBlur = 0.0f;
-	state->textAlign = NVG_ALIGN_LEFT | NVG_ALIGN_BASELINE;
-	state->fontId = 0;
+	return 0;
 }
+#endif
 
-// State setting
-void nvgShapeAntiAlias(NVGcontext* ctx, int enabled)
+static NVGimageLoader* nvg__imageLoader(NVGcontext* ctx)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->shapeAntiAlias = enabled;
-}
+	NVGimageLoader* loader = ctx->fonts->imageLoader;
+	if (loader != NULL) return loader;
 
-void nvgStrokeWidth(NVGcontext* ctx, float width)
-{
-	NVGstate* state = nvg__getState(ctx);
-	state->strokeWidth = width;
+	loader = (NVGimageLoader*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGimageLoader));
+	if (loader == NULL) return NULL;
+	memset(loader, 0, sizeof(NVGimageLoader));
+	loader->budget = NVG_IMAGE_UPLOAD_BUDGET;
+#ifdef NVG_ASYNC_IMAGES
+	fons__mutexInit(&loader->lock);
+	fons__condInit(&loader->wake);
+	while (loader->nthreads < NVG_IMAGE_WORKERS && fons__threadStart(&loader->threads[loader->nthreads], nvg__imageWorker, loader))
+		loader->nthreads++;
+#endif
+	ctx->fonts->imageLoader = loader;
+	return loader;
 }
 
-void nvgMiterLimit(NVGcontext* ctx, float limit)
+static void nvg__freeImageJob(NVGcontext* ctx, NVGimageJob* job)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->miterLimit = limit;
+	if (job->pixels != NULL) stbi_image_free(job->pixels);
+	nvg__free(&ctx->params.allocator, job->filename);
+	nvg__free(&ctx->params.allocator, job->mem);
+	nvg__free(&ctx->params.allocator, job);
 }
 
-void nvgLineCap(NVGcontext* ctx, int cap)
+static void nvg__deleteImageLoader(NVGcontext* ctx)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->lineCap = cap;
+	NVGimageLoader* loader = ctx->fonts->imageLoader;
+	NVGimageJob* job;
+	if (loader == NULL) return;
+#ifdef NVG_ASYNC_IMAGES
+	{
+		int i;
+		fons__lock(&loader->lock);
+		loader->quit = 1;
+		fons__condBroadcast(&loader->wake);
+		fons__unlock(&loader->lock);
+		for (i = 0; i < loader->nthreads; i++)
+			fons__threadJoin(loader->threads[i]);
+		fons__condDestroy(&loader->wake);
+		fons__mutexDestroy(&loader->lock);
+	}
+#endif
+	while (loader->jobs != NULL) {
+		job = loader->jobs;
+		loader->jobs = job->next;
+		nvg__freeImageJob(ctx, job);
+	}
+	nvg__free(&ctx->params.allocator, loader->failed);
+	nvg__free(&ctx->params.allocator, loader);
+	ctx->fonts->imageLoader = NULL;
 }
 
-void nvgLineJoin(NVGcontext* ctx, int join)
+static int nvg__imageJobState(NVGimageLoader* loader, NVGimageJob* job)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->lineJoin = join;
+	int state;
+#ifdef NVG_ASYNC_IMAGES
+	fons__lock(&loader->lock);
+#endif
+	state = job->state;
+#ifdef NVG_ASYNC_IMAGES
+	fons__unlock(&loader->lock);
+#else
+	NVG_NOTUSED(loader);
+#endif
+	return state;
 }
 
-void nvgGlobalAlpha(NVGcontext* ctx, float alpha)
+// The job list is only linked and unlinked on the render thread, the workers walk it with the lock held.
+static void nvg__unlinkImageJob(NVGimageLoader* loader, NVGimageJob* job)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->alpha = alpha;
+	NVGimageJob** prev;
+#ifdef NVG_ASYNC_IMAGES
+	fons__lock(&loader->lock);
+#endif
+	for (prev = &loader->jobs; *prev != NULL && *prev != job; prev = &(*prev)->next);
+	if (*prev != NULL) *prev = job->next;
+#ifdef NVG_ASYNC_IMAGES
+	fons__unlock(&loader->lock);
+#endif
 }
 
-void nvgTransform(NVGcontext* ctx, float a, float b, float c, float d, float e, float f)
+// Unlinks the job and returns 1, unless a worker is decoding it. Then the image is cleared,
+// and the job is freed once the worker is done with it. This is done under one lock, so that
+// a worker cannot start decoding the job in between.
+static int nvg__releaseImageJob(NVGimageLoader* loader, NVGimageJob* job)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float t[6] = { a, b, c, d, e, f };
-	nvgTransformPremultiply(state->xform, t);
+	NVGimageJob** prev;
+	int unlinked = 0;
+#ifdef NVG_ASYNC_IMAGES
+	fons__lock(&loader->lock);
+#endif
+	if (job->state != NVG_IMAGE_DECODING) {
+		for (prev = &loader->jobs; *prev != NULL && *prev != job; prev = &(*prev)->next);
+		if (*prev != NULL) *prev = job->next;
+		unlinked = 1;
+	} else {
+		job->image = 0;
+	}
+#ifdef NVG_ASYNC_IMAGES
+	fons__unlock(&loader->lock);
+#endif
+	return unlinked;
 }
 
-void nvgResetTransform(NVGcontext* ctx)
+static NVGimageJob* nvg__findImageJob(NVGcontext* ctx, int image)
 {
-	NVGstate* state = nvg__getState(ctx);
-	nvgTransformIdentity(state->xform);
+	NVGimageJob* job;
+	if (image == 0 || ctx->fonts->imageLoader == NULL) return NULL;
+	for (job = ctx->fonts->imageLoader->jobs; job != NULL; job = job->next) {
+		if (job->image == image)
+			return job;
+	}
+	return NULL;
 }
 
-void nvgTranslate(NVGcontext* ctx, float x, float y)
+static int nvg__findFailedImage(NVGcontext* ctx, int image)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float t[6];
-	nvgTransformTranslate(t, x,y);
-	nvgTransformPremultiply(state->xform, t);
+	NVGimageLoader* loader = ctx->fonts->imageLoader;
+	int i;
+	if (image == 0 || loader == NULL) return -1;
+	for (i = 0; i < loader->nfailed; i++) {
+		if (loader->failed[i] == image)
+			return i;
+	}
+	return -1;
 }
 
-void nvgRotate(NVGcontext* ctx, float angle)
+static void nvg__addFailedImage(NVGcontext* ctx, int image)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float t[6];
-	nvgTransformRotate(t, angle);
-	nvgTransformPremultiply(state->xform, t);
+	NVGimageLoader* loader = ctx->fonts->imageLoader;
+	if (loader->nfailed+1 > loader->cfailed) {
+		int* failed;
+		int cfailed = nvg__maxi(loader->nfailed+1, 16) + loader->cfailed/2; // 1.5x Overallocate
+		failed = (int*)nvg__realloc(&ctx->params.allocator, loader->failed, sizeof(int)*cfailed);
+		if (failed == NULL) return;
+		loader->failed = failed;
+		loader->cfailed = cfailed;
+	}
+	loader->failed[loader->nfailed++] = image;
 }
 
-void nvgSkewX(NVGcontext* ctx, float angle)
+// Images which are still loading or failed to decode are not drawn.
+static int nvg__imagePending(NVGcontext* ctx, int image)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float t[6];
-	nvgTransformSkewX(t, angle);
-	nvgTransformPremultiply(state->xform, t);
+	return nvg__findImageJob(ctx, image) != NULL || nvg__findFailedImage(ctx, image) != -1;
 }
 
-void nvgSkewY(NVGcontext* ctx, float angle)
+static void nvg__uploadImages(NVGcontext* ctx)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float t[6];
-	nvgTransformSkewY(t, angle);
-	nvgTransformPremultiply(state->xform, t);
+	NVGimageLoader* loader = ctx->fonts->imageLoader;
+	NVGimageJob* job;
+	NVGimageJob* next;
+	int budget, state;
+
+	if (loader == NULL || loader->jobs == NULL) return;
+
+#ifndef NVG_ASYNC_IMAGES
+	for (job = loader->jobs; job != NULL && job->state != NVG_IMAGE_QUEUED; job = job->next);
+	if (job != NULL) {
+		nvg__decodeImage(job);
+		job->state = job->pixels != NULL ? NVG_IMAGE_DECODED : NVG_IMAGE_FAILED;
+	}
+#endif
+
+	budget = loader->budget;
+	for (job = loader->jobs; job != NULL; job = next) {
+		next = job->next;
+		state = nvg__imageJobState(loader, job);
+		if (job->image == 0) {
+			// Deleted while decoding, the job is freed once the worker is done with it.
+			if (nvg__releaseImageJob(loader, job))
+				nvg__freeImageJob(ctx, job);
+		} else if (state == NVG_IMAGE_FAILED) {
+			// Keep only the handle, so that the list of pending jobs does not grow.
+			nvg__addFailedImage(ctx, job->image);
+			nvg__unlinkImageJob(loader, job);
+			nvg__freeImageJob(ctx, job);
+		} else if (state == NVG_IMAGE_DECODED && budget > 0) {
+			int stride = job->width * 4;
+			int rows = job->height - job->uploadedRows;
+			// Each update regenerates the mipmaps, so mipmapped images are uploaded at once.
+			if ((job->imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) == 0)
+				rows = nvg__mini(rows, nvg__maxi(1, budget / stride));
+			ctx->params.renderUpdateTexture(ctx->params.userPtr, job->image, 0, job->uploadedRows, job->width, rows, job->pixels);
+			job->uploadedRows += rows;
+			budget -= rows * stride;
+			if (job->uploadedRows >= job->height) {
+				nvg__unlinkImageJob(loader, job);
+				nvg__freeImageJob(ctx, job);
+			}
+		}
+	}
 }
 
-void nvgScale(NVGcontext* ctx, float x, float y)
+static int nvg__queueImage(NVGcontext* ctx, NVGimageJob* job)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float t[6];
-	nvgTransformScale(t, x,y);
-	nvgTransformPremultiply(state->xform, t);
-}
+	NVGimageLoader* loader = nvg__imageLoader(ctx);
+	NVGimageJob** tail;
 
-void nvgCurrentTransform(NVGcontext* ctx, float* xform)
-{
-	NVGstate* state = nvg__getState(ctx);
-	if (xform == NULL) return;
-	memcpy(xform, state->xform, sizeof(float)*6);
-}
+	if (loader == NULL) goto error;
+	job->image = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_RGBA, job->width, job->height, job->imageFlags, NULL);
+	if (job->image == 0) goto error;
 
-void nvgStrokeColor(NVGcontext* ctx, NVGcolor color)
-{
-	NVGstate* state = nvg__getState(ctx);
-	nvg__setPaintColor(&state->stroke, color);
-}
+	// Images are decoded in the order they were created.
+#ifdef NVG_ASYNC_IMAGES
+	fons__lock(&loader->lock);
+#endif
+	for (tail = &loader->jobs; *tail != NULL; tail = &(*tail)->next);
+	*tail = job;
+#ifdef NVG_ASYNC_IMAGES
+	fons__condBroadcast(&loader->wake);
+	fons__unlock(&loader->lock);
+#endif
+	return job->image;
 
-void nvgStrokePaint(NVGcontext* ctx, NVGpaint paint)
-{
-	NVGstate* state = nvg__getState(ctx);
-	state->stroke = paint;
-	nvgTransformMultiply(state->stroke.xform, state->xform);
+error:
+	nvg__freeImageJob(ctx, job);
+	return 0;
 }
 
-void nvgFillColor(NVGcontext* ctx, NVGcolor color)
+static NVGimageJob* nvg__allocImageJob(NVGcontext* ctx, int imageFlags, int w, int h)
 {
-	NVGstate* state = nvg__getState(ctx);
-	nvg__setPaintColor(&state->fill, color);
+	NVGimageJob* job = (NVGimageJob*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGimageJob));
+	if (job == NULL) return NULL;
+	memset(job, 0, sizeof(NVGimageJob));
+	job->state = NVG_IMAGE_QUEUED;
+	job->imageFlags = imageFlags;
+	job->width = w;
+	job->height = h;
+	return job;
 }
 
-void nvgFillPaint(NVGcontext* ctx, NVGpaint paint)
+NVGcontext* nvgCreateInternal(NVGparams* params)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->fill = paint;
-	nvgTransformMultiply(state->fill.xform, state->xform);
-}
+	FONSparams fontParams;
+	NVGcontext* ctx = (NVGcontext*)nvg__realloc(&params->allocator, NULL, sizeof(NVGcontext));
+	if (ctx == NULL) goto error;
+	memset(ctx, 0, sizeof(NVGcontext));
 
-int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags)
-{
-	int w, h, n, image;
-	unsigned char* img;
-	stbi_set_unpremultiply_on_load(1);
-	stbi_convert_iphone_png_to_rgb(1);
-	img = stbi_load(filename, &w, &h, &n, 4);
-	if (img == NULL) {
-//		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
-		return 0;
+	ctx->params = *params;
+
+	if (ctx->params.allocator.frameArenaSize > 0) {
+		ctx->arena = nvg__createArena(&ctx->params.allocator);
+		if (ctx->arena == NULL) goto error;
 	}
-	image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
-	stbi_image_free(img);
-	return image;
+
+	if (ctx->arena != NULL)
+		ctx->commands = (float*)nvgArenaRealloc(ctx->arena, NULL, 0, sizeof(float)*NVG_INIT_COMMANDS_SIZE);
+	else
+		ctx->commands = (float*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(float)*NVG_INIT_COMMANDS_SIZE);
+	if (!ctx->commands) goto error;
+	ctx->ncommands = 0;
+	ctx->ccommands = NVG_INIT_COMMANDS_SIZE;
+
+	ctx->cache = nvg__allocPathCache(ctx, 1);
+	if (ctx->cache == NULL) goto error;
+
+	ctx->textCache = (NVGtextCacheEntry*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGtextCacheEntry)*NVG_TEXT_CACHE_SIZE);
+	if (ctx->textCache == NULL) goto error;
+	memset(ctx->textCache, 0, sizeof(NVGtextCacheEntry)*NVG_TEXT_CACHE_SIZE);
+
+	nvgSave(ctx);
+	nvgReset(ctx);
+
+	nvg__setDevicePixelRatio(ctx, 1.0f);
+
+	if (ctx->params.renderCreate(ctx->params.userPtr) == 0) goto error;
+
+	if (params->share != NULL) {
+		// The font atlas is uploaded by all contexts, the back-end must share its textures.
+		if (nvgInternalParams(params->share)->sdfText != ctx->params.sdfText) goto error;
+		ctx->fonts = params->share->fonts;
+		ctx->fs = ctx->fonts->fs;
+		nvgAtomicAdd(&ctx->fonts->refs, 1);
+		return ctx;
+	}
+
+	ctx->fonts = (NVGfontShare*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGfontShare));
+	if (ctx->fonts == NULL) goto error;
+	memset(ctx->fonts, 0, sizeof(NVGfontShare));
+	ctx->fonts->refs = 1;
+
+	// Init font rendering
+	memset(&fontParams, 0, sizeof(fontParams));
+	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
+	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
+	fontParams.flags = FONS_ZERO_TOPLEFT | FONS_EVICT_GLYPHS;
+	if (ctx->params.sdfText)
+		fontParams.flags |= FONS_SDF_GLYPHS;
+	fontParams.renderCreate = NULL;
+	fontParams.renderUpdate = NULL;
+	fontParams.renderDraw = NULL;
+	fontParams.renderDelete = NULL;
+	fontParams.userPtr = NULL;
+	fontParams.reallocMem = ctx->params.allocator.reallocMem;
+	fontParams.freeMem = ctx->params.allocator.freeMem;
+	fontParams.memUserPtr = ctx->params.allocator.userPtr;
+	ctx->fs = ctx->fonts->fs = fonsCreateInternal(&fontParams);
+	if (ctx->fs == NULL) goto error;
+
+	// Create font texture
+	ctx->fonts->images[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, ctx->params.sdfText ? NVG_IMAGE_SDF : 0, NULL);
+	if (ctx->fonts->images[0] == 0) goto error;
+	ctx->fonts->imageIdx = 0;
+
+	return ctx;
+
+error:
+	nvgDeleteInternal(ctx);
+	return 0;
 }
 
-int nvgCreateImageMem(NVGcontext* ctx, int imageFlags, unsigned char* data, int ndata)
+#ifdef NVG_TRACE
+static NVGtraceCallbacks nvg__trace;
+
+void nvgTraceBegin(const char* name)
 {
-	int w, h, n, image;
-	unsigned char* img = stbi_load_from_memory(data, ndata, &w, &h, &n, 4);
-	if (img == NULL) {
-//		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
-		return 0;
-	}
-	image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
-	stbi_image_free(img);
-	return image;
+	if (nvg__trace.beginZone != NULL)
+		nvg__trace.beginZone(nvg__trace.userPtr, name);
 }
 
-int nvgCreateImageRGBA(NVGcontext* ctx, int w, int h, int imageFlags, const unsigned char* data)
+void nvgTraceEnd(const char* name)
 {
-	return ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_RGBA, w, h, imageFlags, data);
+	if (nvg__trace.endZone != NULL)
+		nvg__trace.endZone(nvg__trace.userPtr, name);
 }
 
-void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data)
+void nvgTraceGpuZone(const char* name, double begin, double end)
 {
-	int w, h;
-	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, &w, &h);
-	ctx->params.renderUpdateTexture(ctx->params.userPtr, image, 0,0, w,h, data);
+	if (nvg__trace.gpuZone != NULL)
+		nvg__trace.gpuZone(nvg__trace.userPtr, name, begin, end);
 }
+#endif
 
-void nvgImageSize(NVGcontext* ctx, int image, int* w, int* h)
+void nvgSetTraceCallbacks(const NVGtraceCallbacks* callbacks)
 {
-	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, w, h);
+#ifdef NVG_TRACE
+	if (callbacks != NULL)
+		nvg__trace = *callbacks;
+	else
+		memset(&nvg__trace, 0, sizeof(nvg__trace));
+#else
+	NVG_NOTUSED(callbacks);
+#endif
 }
 
-void nvgDeleteImage(NVGcontext* ctx, int image)
+int nvgAtomicAdd(int* value, int n)
 {
-	ctx->params.renderDeleteTexture(ctx->params.userPtr, image);
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd((volatile long*)value, n) + n;
+#elif defined(__GNUC__) || defined(__clang__)
+	return __sync_add_and_fetch(value, n);
+#else
+	// No atomics for this compiler, the count can only be changed from one thread.
+	*value += n;
+	return *value;
+#endif
 }
 
-NVGpaint nvgLinearGradient(NVGcontext* ctx,
-								  float sx, float sy, float ex, float ey,
-								  NVGcolor icol, NVGcolor ocol)
+NVGparams* nvgInternalParams(NVGcontext* ctx)
 {
-	NVGpaint p;
-	float dx, dy, d;
-	const float large = 1e5;
-	NVG_NOTUSED(ctx);
-	memset(&p, 0, sizeof(p));
+	if (ctx->capture != NULL && ctx->capture->state == NVG_CAPTURE_ACTIVE)
+		return &ctx->capture->params;
+	return &ctx->params;
+}
 
-	// Calculate transform aligned to the line
-	dx = ex - sx;
-	dy = ey - sy;
-	d = sqrtf(dx*dx + dy*dy);
-	if (d > 0.0001f) {
-		dx /= d;
-		dy /= d;
-	} else {
-		dx = 0;
-		dy = 1;
+void nvgDeleteInternal(NVGcontext* ctx)
+{
+	NVGallocator alloc;
+	int i;
+	if (ctx == NULL) return;
+	alloc = ctx->params.allocator;
+	if (ctx->capture != NULL) {
+		if (ctx->capture->state == NVG_CAPTURE_ACTIVE)
+			nvg__endCapture(ctx, 0);
+		nvg__free(&alloc, ctx->capture->data);
+		nvg__free(&alloc, ctx->capture->images);
+		nvg__free(&alloc, ctx->capture);
+	}
+	if (ctx->arena == NULL) nvg__free(&alloc, ctx->commands);
+	if (ctx->cache != NULL) nvg__deletePathCache(ctx, ctx->cache);
+	if (ctx->textCache != NULL) {
+		for (i = 0; i < NVG_TEXT_CACHE_SIZE; i++) {
+			nvg__free(&alloc, ctx->textCache[i].text);
+			nvg__free(&alloc, ctx->textCache[i].rows);
+		}
+		nvg__free(&alloc, ctx->textCache);
 	}
 
-	p.xform[0] = dy; p.xform[1] = -dx;
-	p.xform[2] = dx; p.xform[3] = dy;
-	p.xform[4] = sx - dx*large; p.xform[5] = sy - dy*large;
+	// The last context which shares the fonts and images deletes them.
+	if (ctx->fonts != NULL && nvgAtomicAdd(&ctx->fonts->refs, -1) == 0) {
+		nvg__deleteImageLoader(ctx);
+		if (ctx->fonts->fs)
+			fonsDeleteInternal(ctx->fonts->fs);
+		for (i = 0; i < NVG_MAX_FONTIMAGES; i++) {
+			if (ctx->fonts->images[i] != 0)
+				nvgDeleteImage(ctx, ctx->fonts->images[i]);
+		}
+		nvg__free(&alloc, ctx->fonts);
+	}
 
-	p.extent[0] = large;
-	p.extent[1] = large + d*0.5f;
+	if (ctx->params.renderDelete != NULL)
+		ctx->params.renderDelete(ctx->params.userPtr);
 
-	p.radius = 0.0f;
+	// The render back-end may have allocated from the arena until now.
+	nvg__deleteArena(ctx->arena);
+	nvg__free(&alloc, ctx);
+}
 
-	p.feather = nvg__maxf(1.0f, d);
+static void nvg__beginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float devicePixelRatio, int offscreen)
+{
+/*	printf("Tris: draws:%d  fill:%d  stroke:%d  text:%d  TOT:%d\n",
+		ctx->drawCallCount, ctx->fillTriCount, ctx->strokeTriCount, ctx->textTriCount,
+		ctx->fillTriCount+ctx->strokeTriCount+ctx->textTriCount);*/
 
-	p.innerColor = icol;
-	p.outerColor = ocol;
+	ctx->offscreenFrame = offscreen;
+	if (!offscreen && ctx->capture != NULL && ctx->capture->state == NVG_CAPTURE_ARMED)
+		nvg__beginCapture(ctx);
 
-	return p;
-}
+	ctx->nstates = 0;
+	nvgSave(ctx);
+	nvgReset(ctx);
 
-NVGpaint nvgRadialGradient(NVGcontext* ctx,
-								  float cx, float cy, float inr, float outr,
-								  NVGcolor icol, NVGcolor ocol)
-{
-	NVGpaint p;
-	float r = (inr+outr)*0.5f;
-	float f = (outr-inr);
-	NVG_NOTUSED(ctx);
-	memset(&p, 0, sizeof(p));
+	nvg__setDevicePixelRatio(ctx, devicePixelRatio);
 
-	nvgTransformIdentity(p.xform);
-	p.xform[4] = cx;
-	p.xform[5] = cy;
+	if (ctx->arena != NULL) {
+		nvg__resetArena(ctx->arena);
+		nvg__allocFrameBuffers(ctx);
+	}
 
-	p.extent[0] = r;
-	p.extent[1] = r;
+	ctx->params.renderViewport(ctx->params.userPtr, windowWidth, windowHeight, devicePixelRatio);
+	ctx->viewWidth = windowWidth;
+	ctx->viewHeight = windowHeight;
 
-	p.radius = r;
+	if (offscreen) {
+		if (ctx->params.renderOffscreenFrame != NULL)
+			ctx->params.renderOffscreenFrame(ctx->params.userPtr);
+	} else {
+		nvg__uploadImages(ctx);
 
-	p.feather = nvg__maxf(1.0f, f);
+		// Glyphs used in earlier frames can be evicted from the font atlas. Contexts sharing the fonts
+		// draw their frames one after the other, which counts as one frame of the font stash.
+		if (++ctx->fontFrame > ctx->fonts->frame) {
+			ctx->fonts->frame = ctx->fontFrame;
+			fonsNewFrame(ctx->fs);
+		}
+	}
 
-	p.innerColor = icol;
-	p.outerColor = ocol;
+	ctx->drawCallCount = 0;
+	ctx->fillTriCount = 0;
+	ctx->strokeTriCount = 0;
+	ctx->textTriCount = 0;
+	ctx->culledCount = 0;
+	ctx->flattenTime = 0;
+	ctx->expandTime = 0;
+	ctx->textTime = 0;
+}
 
-	return p;
+void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float devicePixelRatio)
+{
+	nvg__beginFrame(ctx, windowWidth, windowHeight, devicePixelRatio, 0);
 }
 
-NVGpaint nvgBoxGradient(NVGcontext* ctx,
-							   float x, float y, float w, float h, float r, float f,
-							   NVGcolor icol, NVGcolor ocol)
+void nvgBeginOffscreenFrame(NVGcontext* ctx, float width, float height, float devicePixelRatio)
 {
-	NVGpaint p;
-	NVG_NOTUSED(ctx);
-	memset(&p, 0, sizeof(p));
+	nvg__beginFrame(ctx, width, height, devicePixelRatio, 1);
+}
 
-	nvgTransformIdentity(p.xform);
-	p.xform[4] = x+w*0.5f;
-	p.xform[5] = y+h*0.5f;
+void nvgCancelFrame(NVGcontext* ctx)
+{
+	ctx->params.renderCancel(ctx->params.userPtr);
+	ctx->offscreenFrame = 0;
+	if (ctx->capture != NULL && ctx->capture->state == NVG_CAPTURE_ACTIVE)
+		nvg__endCapture(ctx, 0);
+}
 
-	p.extent[0] = w*0.5f;
-	p.extent[1] = h*0.5f;
+static void nvg__flushTextTexture(NVGcontext* ctx)
+{
+	int dirty[4];
 
-	p.radius = r;
+	if (fonsValidateTexture(ctx->fs, dirty)) {
+		int fontImage = ctx->fonts->images[ctx->fonts->imageIdx];
+		// Update texture
+		if (fontImage != 0) {
+			int iw, ih;
+			const unsigned char* data = fonsGetTextureData(ctx->fs, &iw, &ih);
+			int x = dirty[0];
+			int y = dirty[1];
+			int w = dirty[2] - dirty[0];
+			int h = dirty[3] - dirty[1];
+			ctx->params.renderUpdateTexture(ctx->params.userPtr, fontImage, x,y, w,h, data);
+		}
+	}
+}
 
-	p.feather = nvg__maxf(1.0f, f);
+void nvgEndFrame(NVGcontext* ctx)
+{
+	double t = nvg__statsTime();
+	// Upload all glyphs added during the frame at once.
+	nvg__flushTextTexture(ctx);
+	ctx->params.renderFlush(ctx->params.userPtr);
 
-	p.innerColor = icol;
-	p.outerColor = ocol;
+	// Offscreen frames keep the statistics of the last frame.
+	if (!ctx->offscreenFrame) {
+		memset(&ctx->frameStats, 0, sizeof(ctx->frameStats));
+		ctx->frameStats.drawCalls = ctx->drawCallCount;
+		ctx->frameStats.fillTriangles = ctx->fillTriCount;
+		ctx->frameStats.strokeTriangles = ctx->strokeTriCount;
+		ctx->frameStats.textTriangles = ctx->textTriCount;
+		ctx->frameStats.culledDraws = ctx->culledCount;
+		if (ctx->arena != NULL) {
+			ctx->frameStats.arenaBytes = (int)(ctx->arena->used + ctx->arena->overflow);
+			ctx->frameStats.arenaPeakBytes = (int)ctx->arena->peak;
+		}
+		ctx->frameStats.flattenTime = (float)ctx->flattenTime;
+		ctx->frameStats.expandTime = (float)ctx->expandTime;
+		ctx->frameStats.textTime = (float)ctx->textTime;
+		ctx->frameStats.flushTime = (float)(nvg__statsTime() - t);
+		if (ctx->params.renderFrameStats != NULL)
+			ctx->params.renderFrameStats(ctx->params.userPtr, &ctx->frameStats);
+		if (ctx->capture != NULL && ctx->capture->state == NVG_CAPTURE_ACTIVE)
+			nvg__endCapture(ctx, 1);
+	}
+	ctx->offscreenFrame = 0;
 
-	return p;
+	if (ctx->fonts->imageIdx != 0) {
+		int fontImage = ctx->fonts->images[ctx->fonts->imageIdx];
+		int i, j, iw, ih;
+		// delete images that smaller than current one
+		if (fontImage == 0)
+			return;
+		nvgImageSize(ctx, fontImage, &iw, &ih);
+		for (i = j = 0; i < ctx->fonts->imageIdx; i++) {
+			if (ctx->fonts->images[i] != 0) {
+				int nw, nh;
+				nvgImageSize(ctx, ctx->fonts->images[i], &nw, &nh);
+				if (nw < iw || nh < ih)
+					nvgDeleteImage(ctx, ctx->fonts->images[i]);
+				else
+					ctx->fonts->images[j++] = ctx->fonts->images[i];
+			}
+		}
+		// make current font image to first
+		ctx->fonts->images[j++] = ctx->fonts->images[0];
+		ctx->fonts->images[0] = fontImage;
+		ctx->fonts->imageIdx = 0;
+		// clear all images after j
+		for (i = j; i < NVG_MAX_FONTIMAGES; i++)
+			ctx->fonts->images[i] = 0;
+	}
 }
 
+void nvgFrameStats(NVGcontext* ctx, NVGframeStats* stats)
+{
+	*stats = ctx->frameStats;
+}
 
-NVGpaint nvgImagePattern(NVGcontext* ctx,
-								float cx, float cy, float w, float h, float angle,
-								int image, float alpha)
+NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b)
 {
-	NVGpaint p;
-	NVG_NOTUSED(ctx);
-	memset(&p, 0, sizeof(p));
+	return nvgRGBA(r,g,b,255);
+}
 
-	nvgTransformRotate(p.xform, angle);
-	p.xform[4] = cx;
-	p.xform[5] = cy;
-
-	p.extent[0] = w;
-	p.extent[1] = h;
-
-	p.image = image;
-
-	p.innerColor = p.outerColor = nvgRGBAf(1,1,1,alpha);
-
-	return p;
+NVGcolor nvgRGBf(float r, float g, float b)
+{
+	return nvgRGBAf(r,g,b,1.0f);
 }
 
-// Scissoring
-void nvgScissor(NVGcontext* ctx, float x, float y, float w, float h)
+NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
-	NVGstate* state = nvg__getState(ctx);
-
-	w = nvg__maxf(0.0f, w);
-	h = nvg__maxf(0.0f, h);
+	NVGcolor color;
+	// Use longer initialization to suppress warning.
+	color.r = r / 255.0f;
+	color.g = g / 255.0f;
+	color.b = b / 255.0f;
+	color.a = a / 255.0f;
+	return color;
+}
 
-	nvgTransformIdentity(state->scissor.xform);
-	state->scissor.xform[4] = x+w*0.5f;
-	state->scissor.xform[5] = y+h*0.5f;
-	nvgTransformMultiply(state->scissor.xform, state->xform);
+NVGcolor nvgRGBAf(float r, float g, float b, float a)
+{
+	NVGcolor color;
+	// Use longer initialization to suppress warning.
+	color.r = r;
+	color.g = g;
+	color.b = b;
+	color.a = a;
+	return color;
+}
 
-	state->scissor.extent[0] = w*0.5f;
-	state->scissor.extent[1] = h*0.5f;
+NVGcolor nvgTransRGBA(NVGcolor c, unsigned char a)
+{
+	c.a = a / 255.0f;
+	return c;
 }
 
-static void nvg__isectRects(float* dst,
-							float ax, float ay, float aw, float ah,
-							float bx, float by, float bw, float bh)
+NVGcolor nvgTransRGBAf(NVGcolor c, float a)
 {
-	float minx = nvg__maxf(ax, bx);
-	float miny = nvg__maxf(ay, by);
-	float maxx = nvg__minf(ax+aw, bx+bw);
-	float maxy = nvg__minf(ay+ah, by+bh);
-	dst[0] = minx;
-	dst[1] = miny;
-	dst[2] = nvg__maxf(0.0f, maxx - minx);
-	dst[3] = nvg__maxf(0.0f, maxy - miny);
+	c.a = a;
+	return c;
 }
 
-void nvgIntersectScissor(NVGcontext* ctx, float x, float y, float w, float h)
+NVGcolor nvgLerpRGBA(NVGcolor c0, NVGcolor c1, float u)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float pxform[6], invxorm[6];
-	float rect[4];
-	float ex, ey, tex, tey;
+	int i;
+	float oneminu;
+	NVGcolor cint = {{{0}}};
 
-	// If no previous scissor has been set, set the scissor as current scissor.
-	if (state->scissor.extent[0] < 0) {
-		nvgScissor(ctx, x, y, w, h);
-		return;
+	u = nvg__clampf(u, 0.0f, 1.0f);
+	oneminu = 1.0f - u;
+	for( i = 0; i <4; i++ )
+	{
+		cint.rgba[i] = c0.rgba[i] * oneminu + c1.rgba[i] * u;
 	}
 
-	// Transform the current scissor rect into current transform space.
-	// If there is difference in rotation, this will be approximation.
-	memcpy(pxform, state->scissor.xform, sizeof(float)*6);
-	ex = state->scissor.extent[0];
-	ey = state->scissor.extent[1];
-	nvgTransformInverse(invxorm, state->xform);
-	nvgTransformMultiply(pxform, invxorm);
-	tex = ex*nvg__absf(pxform[0]) + ey*nvg__absf(pxform[2]);
-	tey = ex*nvg__absf(pxform[1]) + ey*nvg__absf(pxform[3]);
-
-	// Intersect rects.
-	nvg__isectRects(rect, pxform[4]-tex,pxform[5]-tey,tex*2,tey*2, x,y,w,h);
-
-	nvgScissor(ctx, rect[0], rect[1], rect[2], rect[3]);
+	return cint;
 }
 
-void nvgResetScissor(NVGcontext* ctx)
+NVGcolor nvgHSL(float h, float s, float l)
 {
-	NVGstate* state = nvg__getState(ctx);
-	memset(state->scissor.xform, 0, sizeof(state->scissor.xform));
-	state->scissor.extent[0] = -1.0f;
-	state->scissor.extent[1] = -1.0f;
+	return nvgHSLA(h,s,l,255);
 }
 
-// Global composite operation.
-void nvgGlobalCompositeOperation(NVGcontext* ctx, int op)
+static float nvg__hue(float h, float m1, float m2)
 {
-	NVGstate* state = nvg__getState(ctx);
-	state->compositeOperation = nvg__compositeOperationState(op);
+	if (h < 0) h += 1;
+	if (h > 1) h -= 1;
+	if (h < 1.0f/6.0f)
+		return m1 + (m2 - m1) * h * 6.0f;
+	else if (h < 3.0f/6.0f)
+		return m2;
+	else if (h < 4.0f/6.0f)
+		return m1 + (m2 - m1) * (2.0f/3.0f - h) * 6.0f;
+	return m1;
 }
 
-void nvgGlobalCompositeBlendFunc(NVGcontext* ctx, int sfactor, int dfactor)
+NVGcolor nvgHSLA(float h, float s, float l, unsigned char a)
 {
-	nvgGlobalCompositeBlendFuncSeparate(ctx, sfactor, dfactor, sfactor, dfactor);
+	float m1, m2;
+	NVGcolor col;
+	h = nvg__modf(h, 1.0f);
+	if (h < 0.0f) h += 1.0f;
+	s = nvg__clampf(s, 0.0f, 1.0f);
+	l = nvg__clampf(l, 0.0f, 1.0f);
+	m2 = l <= 0.5f ? (l * (1 + s)) : (l + s - l * s);
+	m1 = 2 * l - m2;
+	col.r = nvg__clampf(nvg__hue(h + 1.0f/3.0f, m1, m2), 0.0f, 1.0f);
+	col.g = nvg__clampf(nvg__hue(h, m1, m2), 0.0f, 1.0f);
+	col.b = nvg__clampf(nvg__hue(h - 1.0f/3.0f, m1, m2), 0.0f, 1.0f);
+	col.a = a/255.0f;
+	return col;
 }
 
-void nvgGlobalCompositeBlendFuncSeparate(NVGcontext* ctx, int srcRGB, int dstRGB, int srcAlpha, int dstAlpha)
+void nvgTransformIdentity(float* t)
 {
-	NVGcompositeOperationState op;
-	op.srcRGB = srcRGB;
-	op.dstRGB = dstRGB;
-	op.srcAlpha = srcAlpha;
-	op.dstAlpha = dstAlpha;
-
-	NVGstate* state = nvg__getState(ctx);
-	state->compositeOperation = op;
+	t[0] = 1.0f; t[1] = 0.0f;
+	t[2] = 0.0f; t[3] = 1.0f;
+	t[4] = 0.0f; t[5] = 0.0f;
 }
 
-static int nvg__ptEquals(float x1, float y1, float x2, float y2, float tol)
+void nvgTransformTranslate(float* t, float tx, float ty)
 {
-	float dx = x2 - x1;
-	float dy = y2 - y1;
-	return dx*dx + dy*dy < tol*tol;
+	t[0] = 1.0f; t[1] = 0.0f;
+	t[2] = 0.0f; t[3] = 1.0f;
+	t[4] = tx; t[5] = ty;
 }
 
-static float nvg__distPtSeg(float x, float y, float px, float py, float qx, float qy)
+void nvgTransformScale(float* t, float sx, float sy)
 {
-	float pqx, pqy, dx, dy, d, t;
-	pqx = qx-px;
-	pqy = qy-py;
-	dx = x-px;
-	dy = y-py;
-	d = pqx*pqx + pqy*pqy;
-	t = pqx*dx + pqy*dy;
-	if (d > 0) t /= d;
-	if (t < 0) t = 0;
-	else if (t > 1) t = 1;
-	dx = px + t*pqx - x;
-	dy = py + t*pqy - y;
-	return dx*dx + dy*dy;
+	t[0] = sx; t[1] = 0.0f;
+	t[2] = 0.0f; t[3] = sy;
+	t[4] = 0.0f; t[5] = 0.0f;
 }
 
-static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
+void nvgTransformRotate(float* t, float a)
 {
-	NVGstate* state = nvg__getState(ctx);
-	int i;
-
-	if (ctx->ncommands+nvals > ctx->ccommands) {
-		float* commands;
-		int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
-		commands = (float*)realloc(ctx->commands, sizeof(float)*ccommands);
-		if (commands == NULL) return;
-		ctx->commands = commands;
-		ctx->ccommands = ccommands;
-	}
-
-	if ((int)vals[0] != NVG_CLOSE && (int)vals[0] != NVG_WINDING) {
-		ctx->commandx = vals[nvals-2];
-		ctx->commandy = vals[nvals-1];
-	}
-
-	// transform commands
-	i = 0;
-	while (i < nvals) {
-		int cmd = (int)vals[i];
-		switch (cmd) {
-		case NVG_MOVETO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
-			i += 3;
-			break;
-		case NVG_LINETO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
-			i += 3;
-			break;
-		case NVG_BEZIERTO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
-			nvgTransformPoint(&vals[i+3],&vals[i+4], state->xform, vals[i+3],vals[i+4]);
-			nvgTransformPoint(&vals[i+5],&vals[i+6], state->xform, vals[i+5],vals[i+6]);
-			i += 7;
-			break;
-		case NVG_CLOSE:
-			i++;
-			break;
-		case NVG_WINDING:
-			i += 2;
-			break;
-		default:
-			i++;
-		}
-	}
-
-	memcpy(&ctx->commands[ctx->ncommands], vals, nvals*sizeof(float));
-
-	ctx->ncommands += nvals;
+	float cs = nvg__cosf(a), sn = nvg__sinf(a);
+	t[0] = cs; t[1] = sn;
+	t[2] = -sn; t[3] = cs;
+	t[4] = 0.0f; t[5] = 0.0f;
 }
 
+void nvgTransformSkewX(float* t, float a)
+{
+	t[0] = 1.0f; t[1] = 0.0f;
+	t[2] = nvg__tanf(a); t[3] = 1.0f;
+	t[4] = 0.0f; t[5] = 0.0f;
+}
 
-static void nvg__clearPathCache(NVGcontext* ctx)
+void nvgTransformSkewY(float* t, float a)
 {
-	ctx->cache->npoints = 0;
-	ctx->cache->npaths = 0;
+	t[0] = 1.0f; t[1] = nvg__tanf(a);
+	t[2] = 0.0f; t[3] = 1.0f;
+	t[4] = 0.0f; t[5] = 0.0f;
 }
 
-static NVGpath* nvg__lastPath(NVGcontext* ctx)
+void nvgTransformMultiply(float* t, const float* s)
 {
-	if (ctx->cache->npaths > 0)
-		return &ctx->cache->paths[ctx->cache->npaths-1];
-	return NULL;
+	float t0 = t[0] * s[0] + t[1] * s[2];
+	float t2 = t[2] * s[0] + t[3] * s[2];
+	float t4 = t[4] * s[0] + t[5] * s[2] + s[4];
+	t[1] = t[0] * s[1] + t[1] * s[3];
+	t[3] = t[2] * s[1] + t[3] * s[3];
+	t[5] = t[4] * s[1] + t[5] * s[3] + s[5];
+	t[0] = t0;
+	t[2] = t2;
+	t[4] = t4;
 }
 
-static void nvg__addPath(NVGcontext* ctx)
+void nvgTransformPremultiply(float* t, const float* s)
 {
-	NVGpath* path;
-	if (ctx->cache->npaths+1 > ctx->cache->cpaths) {
-		NVGpath* paths;
-		int cpaths = ctx->cache->npaths+1 + ctx->cache->cpaths/2;
-		paths = (NVGpath*)realloc(ctx->cache->paths, sizeof(NVGpath)*cpaths);
-		if (paths == NULL) return;
-		ctx->cache->paths = paths;
-		ctx->cache->cpaths = cpaths;
-	}
-	path = &ctx->cache->paths[ctx->cache->npaths];
-	memset(path, 0, sizeof(*path));
-	path->first = ctx->cache->npoints;
-	path->winding = NVG_CCW;
+	float s2[6];
+	memcpy(s2, s, sizeof(float)*6);
+	nvgTransformMultiply(s2, t);
+	memcpy(t, s2, sizeof(float)*6);
+}
 
-	ctx->cache->npaths++;
+int nvgTransformInverse(float* inv, const float* t)
+{
+	double invdet, det = (double)t[0] * t[3] - (double)t[2] * t[1];
+	if (det > -1e-6 && det < 1e-6) {
+		nvgTransformIdentity(inv);
+		return 0;
+	}
+	invdet = 1.0 / det;
+	inv[0] = (float)(t[3] * invdet);
+	inv[2] = (float)(-t[2] * invdet);
+	inv[4] = (float)(((double)t[2] * t[5] - (double)t[3] * t[4]) * invdet);
+	inv[1] = (float)(-t[1] * invdet);
+	inv[3] = (float)(t[0] * invdet);
+	inv[5] = (float)(((double)t[1] * t[4] - (double)t[0] * t[5]) * invdet);
+	return 1;
 }
 
-static NVGpoint* nvg__lastPoint(NVGcontext* ctx)
+void nvgTransformPoint(float* dx, float* dy, const float* t, float sx, float sy)
 {
-	if (ctx->cache->npoints > 0)
-		return &ctx->cache->points[ctx->cache->npoints-1];
-	return NULL;
+	*dx = sx*t[0] + sy*t[2] + t[4];
+	*dy = sx*t[1] + sy*t[3] + t[5];
 }
 
-static void nvg__addPoint(NVGcontext* ctx, float x, float y, int flags)
+float nvgDegToRad(float deg)
 {
-	NVGpath* path = nvg__lastPath(ctx);
-	NVGpoint* pt;
-	if (path == NULL) return;
+	return deg / 180.0f * NVG_PI;
+}
 
-	if (path->count > 0 && ctx->cache->npoints > 0) {
-		pt = nvg__lastPoint(ctx);
-		if (nvg__ptEquals(pt->x,pt->y, x,y, ctx->distTol)) {
-			pt->flags |= flags;
-			return;
-		}
-	}
+float nvgRadToDeg(float rad)
+{
+	return rad / NVG_PI * 180.0f;
+}
 
-	if (ctx->cache->npoints+1 > ctx->cache->cpoints) {
-		NVGpoint* points;
-		int cpoints = ctx->cache->npoints+1 + ctx->cache->cpoints/2;
-		points = (NVGpoint*)realloc(ctx->cache->points, sizeof(NVGpoint)*cpoints);
-		if (points == NULL) return;
-		ctx->cache->points = points;
-		ctx->cache->cpoints = cpoints;
-	}
+static void nvg__setPaintColor(NVGpaint* p, NVGcolor color)
+{
+	memset(p, 0, sizeof(*p));
+	nvgTransformIdentity(p->xform);
+	p->radius = 0.0f;
+	p->feather = 1.0f;
+	p->innerColor = color;
+	p->outerColor = color;
+}
 
-	pt = &ctx->cache->points[ctx->cache->npoints];
-	memset(pt, 0, sizeof(*pt));
-	pt->x = x;
-	pt->y = y;
-	pt->flags = (unsigned char)flags;
 
-	ctx->cache->npoints++;
-	path->count++;
+// State handling
+void nvgSave(NVGcontext* ctx)
+{
+	if (ctx->nstates >= NVG_MAX_STATES)
+		return;
+	if (ctx->nstates > 0)
+		memcpy(&ctx->states[ctx->nstates], &ctx->states[ctx->nstates-1], sizeof(NVGstate));
+	ctx->nstates++;
 }
 
-static void nvg__closePath(NVGcontext* ctx)
+void nvgRestore(NVGcontext* ctx)
 {
-	NVGpath* path = nvg__lastPath(ctx);
-	if (path == NULL) return;
-	path->closed = 1;
+	if (ctx->nstates <= 1)
+		return;
+	ctx->nstates--;
 }
 
-static void nvg__pathWinding(NVGcontext* ctx, int winding)
+void nvgReset(NVGcontext* ctx)
 {
-	NVGpath* path = nvg__lastPath(ctx);
-	if (path == NULL) return;
-	path->winding = winding;
+	NVGstate* state = nvg__getState(ctx);
+	memset(state, 0, sizeof(*state));
+
+	nvg__setPaintColor(&state->fill, nvgRGBA(255,255,255,255));
+	nvg__setPaintColor(&state->stroke, nvgRGBA(0,0,0,255));
+	state->compositeOperation = nvg__compositeOperationState(NVG_SOURCE_OVER);
+	state->shapeAntiAlias = 1;
+	state->strokeWidth = 1.0f;
+	state->miterLimit = 10.0f;
+	state->lineCap = NVG_BUTT;
+	state->lineJoin = NVG_MITER;
+	state->alpha = 1.0f;
+	nvgTransformIdentity(state->xform);
+
+	state->scissor.extent[0] = -1.0f;
+	state->scissor.extent[1] = -1.0f;
+
+	state->fontSize = 16.0f;
+	state->letterSpacing = 0.0f;
+	state->lineHeight = 1.0f;
+	state->fontBlur = 0.0f;
+	state->textAlign = NVG_ALIGN_LEFT | NVG_ALIGN_BASELINE;
+	state->fontId = 0;
 }
 
-static float nvg__getAverageScale(float *t)
+// State setting
+void nvgShapeAntiAlias(NVGcontext* ctx, int enabled)
 {
-	float sx = sqrtf(t[0]*t[0] + t[2]*t[2]);
-	float sy = sqrtf(t[1]*t[1] + t[3]*t[3]);
-	return (sx + sy) * 0.5f;
+	NVGstate* state = nvg__getState(ctx);
+	state->shapeAntiAlias = enabled;
 }
 
-static NVGvertex* nvg__allocTempVerts(NVGcontext* ctx, int nverts)
+void nvgStrokeWidth(NVGcontext* ctx, float width)
 {
-	if (nverts > ctx->cache->cverts) {
-		NVGvertex* verts;
-		int cverts = (nverts + 0xff) & ~0xff; // Round up to prevent allocations when things change just slightly.
-		verts = (NVGvertex*)realloc(ctx->cache->verts, sizeof(NVGvertex)*cverts);
-		if (verts == NULL) return NULL;
-		ctx->cache->verts = verts;
-		ctx->cache->cverts = cverts;
-	}
+	NVGstate* state = nvg__getState(ctx);
+	state->strokeWidth = width;
+}
 
-	return ctx->cache->verts;
+void nvgMiterLimit(NVGcontext* ctx, float limit)
+{
+	NVGstate* state = nvg__getState(ctx);
+	state->miterLimit = limit;
 }
 
-static float nvg__triarea2(float ax, float ay, float bx, float by, float cx, float cy)
+void nvgLineCap(NVGcontext* ctx, int cap)
 {
-	float abx = bx - ax;
-	float aby = by - ay;
-	float acx = cx - ax;
-	float acy = cy - ay;
-	return acx*aby - abx*acy;
+	NVGstate* state = nvg__getState(ctx);
+	state->lineCap = cap;
 }
 
-static float nvg__polyArea(NVGpoint* pts, int npts)
+void nvgLineJoin(NVGcontext* ctx, int join)
 {
-	int i;
-	float area = 0;
-	for (i = 2; i < npts; i++) {
-		NVGpoint* a = &pts[0];
-		NVGpoint* b = &pts[i-1];
-		NVGpoint* c = &pts[i];
-		area += nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y);
-	}
-	return area * 0.5f;
+	NVGstate* state = nvg__getState(ctx);
+	state->lineJoin = join;
 }
 
-static void nvg__polyReverse(NVGpoint* pts, int npts)
+void nvgGlobalAlpha(NVGcontext* ctx, float alpha)
 {
-	NVGpoint tmp;
-	int i = 0, j = npts-1;
-	while (i < j) {
-		tmp = pts[i];
-		pts[i] = pts[j];
-		pts[j] = tmp;
-		i++;
-		j--;
-	}
+	NVGstate* state = nvg__getState(ctx);
+	state->alpha = alpha;
 }
 
+void nvgTransform(NVGcontext* ctx, float a, float b, float c, float d, float e, float f)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float t[6] = { a, b, c, d, e, f };
+	nvgTransformPremultiply(state->xform, t);
+}
 
-static void nvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
+void nvgResetTransform(NVGcontext* ctx)
 {
-	vtx->x = x;
-	vtx->y = y;
-	vtx->u = u;
-	vtx->v = v;
+	NVGstate* state = nvg__getState(ctx);
+	nvgTransformIdentity(state->xform);
 }
 
-static void nvg__tesselateBezier(NVGcontext* ctx,
-								 float x1, float y1, float x2, float y2,
-								 float x3, float y3, float x4, float y4,
-								 int level, int type)
+void nvgTranslate(NVGcontext* ctx, float x, float y)
 {
-	float x12,y12,x23,y23,x34,y34,x123,y123,x234,y234,x1234,y1234;
-	float dx,dy,d2,d3;
+	NVGstate* state = nvg__getState(ctx);
+	float t[6];
+	nvgTransformTranslate(t, x,y);
+	nvgTransformPremultiply(state->xform, t);
+}
 
-	if (level > 10) return;
+void nvgRotate(NVGcontext* ctx, float angle)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float t[6];
+	nvgTransformRotate(t, angle);
+	nvgTransformPremultiply(state->xform, t);
+}
 
-	x12 = (x1+x2)*0.5f;
-	y12 = (y1+y2)*0.5f;
-	x23 = (x2+x3)*0.5f;
-	y23 = (y2+y3)*0.5f;
-	x34 = (x3+x4)*0.5f;
-	y34 = (y3+y4)*0.5f;
-	x123 = (x12+x23)*0.5f;
-	y123 = (y12+y23)*0.5f;
+void nvgSkewX(NVGcontext* ctx, float angle)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float t[6];
+	nvgTransformSkewX(t, angle);
+	nvgTransformPremultiply(state->xform, t);
+}
 
-	dx = x4 - x1;
-	dy = y4 - y1;
-	d2 = nvg__absf(((x2 - x4) * dy - (y2 - y4) * dx));
-	d3 = nvg__absf(((x3 - x4) * dy - (y3 - y4) * dx));
+void nvgSkewY(NVGcontext* ctx, float angle)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float t[6];
+	nvgTransformSkewY(t, angle);
+	nvgTransformPremultiply(state->xform, t);
+}
 
-	if ((d2 + d3)*(d2 + d3) < ctx->tessTol * (dx*dx + dy*dy)) {
-		nvg__addPoint(ctx, x4, y4, type);
-		return;
-	}
+void nvgScale(NVGcontext* ctx, float x, float y)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float t[6];
+	nvgTransformScale(t, x,y);
+	nvgTransformPremultiply(state->xform, t);
+}
 
-/*	if (nvg__absf(x1+x3-x2-x2) + nvg__absf(y1+y3-y2-y2) + nvg__absf(x2+x4-x3-x3) + nvg__absf(y2+y4-y3-y3) < ctx->tessTol) {
-		nvg__addPoint(ctx, x4, y4, type);
-		return;
-	}*/
+void nvgCurrentTransform(NVGcontext* ctx, float* xform)
+{
+	NVGstate* state = nvg__getState(ctx);
+	if (xform == NULL) return;
+	memcpy(xform, state->xform, sizeof(float)*6);
+}
 
-	x234 = (x23+x34)*0.5f;
-	y234 = (y23+y34)*0.5f;
-	x1234 = (x123+x234)*0.5f;
-	y1234 = (y123+y234)*0.5f;
+void nvgStrokeColor(NVGcontext* ctx, NVGcolor color)
+{
+	NVGstate* state = nvg__getState(ctx);
+	nvg__setPaintColor(&state->stroke, color);
+}
 
-	nvg__tesselateBezier(ctx, x1,y1, x12,y12, x123,y123, x1234,y1234, level+1, 0);
-	nvg__tesselateBezier(ctx, x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, type);
+void nvgStrokePaint(NVGcontext* ctx, NVGpaint paint)
+{
+	NVGstate* state = nvg__getState(ctx);
+	state->stroke = paint;
+	nvgTransformMultiply(state->stroke.xform, state->xform);
 }
 
-static void nvg__flattenPaths(NVGcontext* ctx)
+void nvgFillColor(NVGcontext* ctx, NVGcolor color)
 {
-	NVGpathCache* cache = ctx->cache;
-//	NVGstate* state = nvg__getState(ctx);
-	NVGpoint* last;
+	NVGstate* state = nvg__getState(ctx);
+	nvg__setPaintColor(&state->fill, color);
+}
+
+void nvgFillPaint(NVGcontext* ctx, NVGpaint paint)
+{
+	NVGstate* state = nvg__getState(ctx);
+	state->fill = paint;
+	nvgTransformMultiply(state->fill.xform, state->xform);
+}
+
+int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags)
+{
+	int ndata, image;
+	unsigned char* data = nvg__readFile(&ctx->params.allocator, filename, &ndata);
+	if (data == NULL) return 0;
+	stbi_set_unpremultiply_on_load(1);
+	stbi_convert_iphone_png_to_rgb(1);
+	image = nvgCreateImageMem(ctx, imageFlags, data, ndata);
+	nvg__free(&ctx->params.allocator, data);
+	return image;
+}
+
+int nvgCreateImageMem(NVGcontext* ctx, int imageFlags, unsigned char* data, int ndata)
+{
+	int w, h, n, image;
+	unsigned char* img;
+	if (nvg__isTextureFile(data, ndata))
+		return nvg__createImageTextureFile(ctx, imageFlags, data, ndata);
+	img = stbi_load_from_memory(data, ndata, &w, &h, &n, 4);
+	if (img == NULL) {
+//		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
+		return 0;
+	}
+	image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
+	stbi_image_free(img);
+	return image;
+}
+
+int nvgCreateImageAsync(NVGcontext* ctx, const char* filename, int imageFlags)
+{
+	NVGimageJob* job;
+	int w, h, n, len;
+	stbi_set_unpremultiply_on_load(1);
+	stbi_convert_iphone_png_to_rgb(1);
+	// Only the header is read here, the texture is created empty and filled when the image is decoded.
+	// KTX and DDS files need no decoding, and are loaded right away.
+	if (!stbi_info(filename, &w, &h, &n))
+		return nvgCreateImage(ctx, filename, imageFlags);
+	job = nvg__allocImageJob(ctx, imageFlags, w, h);
+	if (job == NULL) return 0;
+	len = (int)strlen(filename);
+	job->filename = (char*)nvg__realloc(&ctx->params.allocator, NULL, len+1);
+	if (job->filename == NULL) {
+		nvg__freeImageJob(ctx, job);
+		return 0;
+	}
+	memcpy(job->filename, filename, len+1);
+	return nvg__queueImage(ctx, job);
+}
+
+int nvgCreateImageMemAsync(NVGcontext* ctx, int imageFlags, const unsigned char* data, int ndata)
+{
+	NVGimageJob* job;
+	int w, h, n;
+	stbi_set_unpremultiply_on_load(1);
+	stbi_convert_iphone_png_to_rgb(1);
+	if (nvg__isTextureFile(data, ndata))
+		return nvg__createImageTextureFile(ctx, imageFlags, data, ndata);
+	if (!stbi_info_from_memory(data, ndata, &w, &h, &n))
+		return 0;
+	job = nvg__allocImageJob(ctx, imageFlags, w, h);
+	if (job == NULL) return 0;
+	job->mem = (unsigned char*)nvg__realloc(&ctx->params.allocator, NULL, ndata);
+	if (job->mem == NULL) {
+		nvg__freeImageJob(ctx, job);
+		return 0;
+	}
+	memcpy(job->mem, data, ndata);
+	job->nmem = ndata;
+	return nvg__queueImage(ctx, job);
+}
+
+int nvgImageLoaded(NVGcontext* ctx, int image)
+{
+	NVGimageJob* job = nvg__findImageJob(ctx, image);
+	if (job == NULL) return nvg__findFailedImage(ctx, image) != -1 ? -1 : 1;
+	return nvg__imageJobState(ctx->fonts->imageLoader, job) == NVG_IMAGE_FAILED ? -1 : 0;
+}
+
+void nvgImageUploadBudget(NVGcontext* ctx, int bytes)
+{
+	NVGimageLoader* loader = nvg__imageLoader(ctx);
+	if (loader != NULL)
+		loader->budget = bytes;
+}
+
+int nvgCreateImageRGBA(NVGcontext* ctx, int w, int h, int imageFlags, const unsigned char* data)
+{
+	return ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_RGBA, w, h, imageFlags, data);
+}
+
+int nvgCreateImageFormat(NVGcontext* ctx, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	if (nvgTextureBytes(type, 1, 1) == 0) return 0;
+	// Compressed textures can not be created empty.
+	if (nvg__compressedTexture(type) && data == NULL) return 0;
+	return ctx->params.renderCreateTexture(ctx->params.userPtr, type, w, h, imageFlags, data);
+}
+
+void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data)
+{
+	int w, h;
+	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, &w, &h);
+	ctx->params.renderUpdateTexture(ctx->params.userPtr, image, 0,0, w,h, data);
+}
+
+void nvgImageSize(NVGcontext* ctx, int image, int* w, int* h)
+{
+	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, w, h);
+}
+
+void nvgDeleteImage(NVGcontext* ctx, int image)
+{
+	NVGimageLoader* loader = ctx->fonts->imageLoader;
+	NVGimageJob* job = nvg__findImageJob(ctx, image);
+	int failed = nvg__findFailedImage(ctx, image);
+	if (job != NULL && nvg__releaseImageJob(loader, job))
+		nvg__freeImageJob(ctx, job);
+	if (failed != -1)
+		loader->failed[failed] = loader->failed[--loader->nfailed];
+	ctx->params.renderDeleteTexture(ctx->params.userPtr, image);
+}
+
+NVGpaint nvgLinearGradient(NVGcontext* ctx,
+								  float sx, float sy, float ex, float ey,
+								  NVGcolor icol, NVGcolor ocol)
+{
+	NVGpaint p;
+	float dx, dy, d;
+	const float large = 1e5;
+	NVG_NOTUSED(ctx);
+	memset(&p, 0, sizeof(p));
+
+	// Calculate transform aligned to the line
+	dx = ex - sx;
+	dy = ey - sy;
+	d = sqrtf(dx*dx + dy*dy);
+	if (d > 0.0001f) {
+		dx /= d;
+		dy /= d;
+	} else {
+		dx = 0;
+		dy = 1;
+	}
+
+	p.xform[0] = dy; p.xform[1] = -dx;
+	p.xform[2] = dx; p.xform[3] = dy;
+	p.xform[4] = sx - dx*large; p.xform[5] = sy - dy*large;
+
+	p.extent[0] = large;
+	p.extent[1] = large + d*0.5f;
+
+	p.radius = 0.0f;
+
+	p.feather = nvg__maxf(1.0f, d);
+
+	p.innerColor = icol;
+	p.outerColor = ocol;
+
+	return p;
+}
+
+NVGpaint nvgRadialGradient(NVGcontext* ctx,
+								  float cx, float cy, float inr, float outr,
+								  NVGcolor icol, NVGcolor ocol)
+{
+	NVGpaint p;
+	float r = (inr+outr)*0.5f;
+	float f = (outr-inr);
+	NVG_NOTUSED(ctx);
+	memset(&p, 0, sizeof(p));
+
+	nvgTransformIdentity(p.xform);
+	p.xform[4] = cx;
+	p.xform[5] = cy;
+
+	p.extent[0] = r;
+	p.extent[1] = r;
+
+	p.radius = r;
+
+	p.feather = nvg__maxf(1.0f, f);
+
+	p.innerColor = icol;
+	p.outerColor = ocol;
+
+	return p;
+}
+
+NVGpaint nvgBoxGradient(NVGcontext* ctx,
+							   float x, float y, float w, float h, float r, float f,
+							   NVGcolor icol, NVGcolor ocol)
+{
+	NVGpaint p;
+	NVG_NOTUSED(ctx);
+	memset(&p, 0, sizeof(p));
+
+	nvgTransformIdentity(p.xform);
+	p.xform[4] = x+w*0.5f;
+	p.xform[5] = y+h*0.5f;
+
+	p.extent[0] = w*0.5f;
+	p.extent[1] = h*0.5f;
+
+	p.radius = r;
+
+	p.feather = nvg__maxf(1.0f, f);
+
+	p.innerColor = icol;
+	p.outerColor = ocol;
+
+	return p;
+}
+
+
+NVGpaint nvgImagePattern(NVGcontext* ctx,
+								float cx, float cy, float w, float h, float angle,
+								int image, float alpha)
+{
+	NVGpaint p;
+	NVG_NOTUSED(ctx);
+	memset(&p, 0, sizeof(p));
+
+	nvgTransformRotate(p.xform, angle);
+	p.xform[4] = cx;
+	p.xform[5] = cy;
+
+	p.extent[0] = w;
+	p.extent[1] = h;
+
+	p.image = image;
+
+	p.innerColor = p.outerColor = nvgRGBAf(1,1,1,alpha);
+
+	return p;
+}
+
+// Scissoring
+void nvgScissor(NVGcontext* ctx, float x, float y, float w, float h)
+{
+	NVGstate* state = nvg__getState(ctx);
+
+	w = nvg__maxf(0.0f, w);
+	h = nvg__maxf(0.0f, h);
+
+	nvgTransformIdentity(state->scissor.xform);
+	state->scissor.xform[4] = x+w*0.5f;
+	state->scissor.xform[5] = y+h*0.5f;
+	nvgTransformMultiply(state->scissor.xform, state->xform);
+
+	state->scissor.extent[0] = w*0.5f;
+	state->scissor.extent[1] = h*0.5f;
+}
+
+static void nvg__isectRects(float* dst,
+							float ax, float ay, float aw, float ah,
+							float bx, float by, float bw, float bh)
+{
+	float minx = nvg__maxf(ax, bx);
+	float miny = nvg__maxf(ay, by);
+	float maxx = nvg__minf(ax+aw, bx+bw);
+	float maxy = nvg__minf(ay+ah, by+bh);
+	dst[0] = minx;
+	dst[1] = miny;
+	dst[2] = nvg__maxf(0.0f, maxx - minx);
+	dst[3] = nvg__maxf(0.0f, maxy - miny);
+}
+
+void nvgIntersectScissor(NVGcontext* ctx, float x, float y, float w, float h)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float pxform[6], invxorm[6];
+	float rect[4];
+	float ex, ey, tex, tey;
+
+	// If no previous scissor has been set, set the scissor as current scissor.
+	if (state->scissor.extent[0] < 0) {
+		nvgScissor(ctx, x, y, w, h);
+		return;
+	}
+
+	// Transform the current scissor rect into current transform space.
+	// If there is difference in rotation, this will be approximation.
+	memcpy(pxform, state->scissor.xform, sizeof(float)*6);
+	ex = state->scissor.extent[0];
+	ey = state->scissor.extent[1];
+	nvgTransformInverse(invxorm, state->xform);
+	nvgTransformMultiply(pxform, invxorm);
+	tex = ex*nvg__absf(pxform[0]) + ey*nvg__absf(pxform[2]);
+	tey = ex*nvg__absf(pxform[1]) + ey*nvg__absf(pxform[3]);
+
+	// Intersect rects.
+	nvg__isectRects(rect, pxform[4]-tex,pxform[5]-tey,tex*2,tey*2, x,y,w,h);
+
+	nvgScissor(ctx, rect[0], rect[1], rect[2], rect[3]);
+}
+
+void nvgResetScissor(NVGcontext* ctx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	memset(state->scissor.xform, 0, sizeof(state->scissor.xform));
+	state->scissor.extent[0] = -1.0f;
+	state->scissor.extent[1] = -1.0f;
+}
+
+// Global composite operation.
+void nvgGlobalCompositeOperation(NVGcontext* ctx, int op)
+{
+	NVGstate* state = nvg__getState(ctx);
+	state->compositeOperation = nvg__compositeOperationState(op);
+}
+
+void nvgGlobalCompositeBlendFunc(NVGcontext* ctx, int sfactor, int dfactor)
+{
+	nvgGlobalCompositeBlendFuncSeparate(ctx, sfactor, dfactor, sfactor, dfactor);
+}
+
+void nvgGlobalCompositeBlendFuncSeparate(NVGcontext* ctx, int srcRGB, int dstRGB, int srcAlpha, int dstAlpha)
+{
+	NVGcompositeOperationState op;
+	op.srcRGB = srcRGB;
+	op.dstRGB = dstRGB;
+	op.srcAlpha = srcAlpha;
+	op.dstAlpha = dstAlpha;
+
+	NVGstate* state = nvg__getState(ctx);
+	state->compositeOperation = op;
+}
+
+static int nvg__ptEquals(float x1, float y1, float x2, float y2, float tol)
+{
+	float dx = x2 - x1;
+	float dy = y2 - y1;
+	return dx*dx + dy*dy < tol*tol;
+}
+
+static float nvg__distPtSeg(float x, float y, float px, float py, float qx, float qy)
+{
+	float pqx, pqy, dx, dy, d, t;
+	pqx = qx-px;
+	pqy = qy-py;
+	dx = x-px;
+	dy = y-py;
+	d = pqx*pqx + pqy*pqy;
+	t = pqx*dx + pqy*dy;
+	if (d > 0) t /= d;
+	if (t < 0) t = 0;
+	else if (t > 1) t = 1;
+	dx = px + t*pqx - x;
+	dy = py + t*pqy - y;
+	return dx*dx + dy*dy;
+}
+
+static void nvg__transformCommands(float* vals, int nvals, const float* xform)
+{
+	int i = 0;
+	while (i < nvals) {
+		int cmd = (int)vals[i];
+		switch (cmd) {
+		case NVG_MOVETO:
+			nvgTransformPoint(&vals[i+1],&vals[i+2], xform, vals[i+1],vals[i+2]);
+			i += 3;
+			break;
+		case NVG_LINETO:
+			nvgTransformPoint(&vals[i+1],&vals[i+2], xform, vals[i+1],vals[i+2]);
+			i += 3;
+			break;
+		case NVG_BEZIERTO:
+			nvgTransformPoint(&vals[i+1],&vals[i+2], xform, vals[i+1],vals[i+2]);
+			nvgTransformPoint(&vals[i+3],&vals[i+4], xform, vals[i+3],vals[i+4]);
+			nvgTransformPoint(&vals[i+5],&vals[i+6], xform, vals[i+5],vals[i+6]);
+			i += 7;
+			break;
+		case NVG_CLOSE:
+			i++;
+			break;
+		case NVG_WINDING:
+			i += 2;
+			break;
+		default:
+			i++;
+		}
+	}
+}
+
+static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
+{
+	NVGstate* state = nvg__getState(ctx);
+
+	if (ctx->ncommands+nvals > ctx->ccommands) {
+		float* commands;
+		int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
+		if (ctx->arena != NULL)
+			commands = (float*)nvgArenaRealloc(ctx->arena, ctx->commands, sizeof(float)*ctx->ncommands, sizeof(float)*ccommands);
+		else
+			commands = (float*)nvg__realloc(&ctx->params.allocator, ctx->commands, sizeof(float)*ccommands);
+		if (commands == NULL) return;
+		ctx->commands = commands;
+		ctx->ccommands = ccommands;
+	}
+
+	if ((int)vals[0] != NVG_CLOSE && (int)vals[0] != NVG_WINDING) {
+		ctx->commandx = vals[nvals-2];
+		ctx->commandy = vals[nvals-1];
+	}
+
+	// transform commands
+	nvg__transformCommands(vals, nvals, state->xform);
+
+	memcpy(&ctx->commands[ctx->ncommands], vals, nvals*sizeof(float));
+
+	ctx->ncommands += nvals;
+}
+
+
+static void nvg__clearPathCache(NVGcontext* ctx)
+{
+	ctx->cache->npoints = 0;
+	ctx->cache->npaths = 0;
+}
+
+static NVGpath* nvg__lastPath(NVGcontext* ctx)
+{
+	if (ctx->cache->npaths > 0)
+		return &ctx->cache->paths[ctx->cache->npaths-1];
+	return NULL;
+}
+
+static void nvg__addPath(NVGcontext* ctx)
+{
+	NVGpath* path;
+	if (ctx->cache->npaths+1 > ctx->cache->cpaths) {
+		NVGpath* paths;
+		int cpaths = ctx->cache->npaths+1 + ctx->cache->cpaths/2;
+		paths = (NVGpath*)nvg__cacheRealloc(ctx, ctx->cache, ctx->cache->paths, sizeof(NVGpath)*ctx->cache->npaths, sizeof(NVGpath)*cpaths);
+		if (paths == NULL) return;
+		ctx->cache->paths = paths;
+		ctx->cache->cpaths = cpaths;
+	}
+	path = &ctx->cache->paths[ctx->cache->npaths];
+	memset(path, 0, sizeof(*path));
+	path->first = ctx->cache->npoints;
+	path->winding = NVG_CCW;
+
+	ctx->cache->npaths++;
+}
+
+static NVGpoint* nvg__lastPoint(NVGcontext* ctx)
+{
+	if (ctx->cache->npoints > 0)
+		return &ctx->cache->points[ctx->cache->npoints-1];
+	return NULL;
+}
+
+static void nvg__addPoint(NVGcontext* ctx, float x, float y, int flags)
+{
+	NVGpath* path = nvg__lastPath(ctx);
+	NVGpoint* pt;
+	if (path == NULL) return;
+
+	if (path->count > 0 && ctx->cache->npoints > 0) {
+		pt = nvg__lastPoint(ctx);
+		if (nvg__ptEquals(pt->x,pt->y, x,y, ctx->distTol)) {
+			pt->flags |= flags;
+			return;
+		}
+	}
+
+	if (ctx->cache->npoints+1 > ctx->cache->cpoints) {
+		NVGpoint* points;
+		int cpoints = ctx->cache->npoints+1 + ctx->cache->cpoints/2;
+		points = (NVGpoint*)nvg__cacheRealloc(ctx, ctx->cache, ctx->cache->points, sizeof(NVGpoint)*ctx->cache->npoints, sizeof(NVGpoint)*cpoints);
+		if (points == NULL) return;
+		ctx->cache->points = points;
+		ctx->cache->cpoints = cpoints;
+	}
+
+	pt = &ctx->cache->points[ctx->cache->npoints];
+	memset(pt, 0, sizeof(*pt));
+	pt->x = x;
+	pt->y = y;
+	pt->flags = (unsigned char)flags;
+
+	ctx->cache->npoints++;
+	path->count++;
+}
+
+static void nvg__closePath(NVGcontext* ctx)
+{
+	NVGpath* path = nvg__lastPath(ctx);
+	if (path == NULL) return;
+	path->closed = 1;
+}
+
+static void nvg__pathWinding(NVGcontext* ctx, int winding)
+{
+	NVGpath* path = nvg__lastPath(ctx);
+	if (path == NULL) return;
+	path->winding = winding;
+}
+
+static float nvg__getAverageScale(float *t)
+{
+	float sx = sqrtf(t[0]*t[0] + t[2]*t[2]);
+	float sy = sqrtf(t[1]*t[1] + t[3]*t[3]);
+	return (sx + sy) * 0.5f;
+}
+
+static NVGvertex* nvg__allocTempVerts(NVGcontext* ctx, int nverts)
+{
+	if (nverts > ctx->cache->cverts) {
+		NVGvertex* verts;
+		int cverts = (nverts + 0xff) & ~0xff; // Round up to prevent allocations when things change just slightly.
+		verts = (NVGvertex*)nvg__cacheRealloc(ctx, ctx->cache, ctx->cache->verts, 0, sizeof(NVGvertex)*cverts);
+		if (verts == NULL) return NULL;
+		ctx->cache->verts = verts;
+		ctx->cache->cverts = cverts;
+	}
+
+	return ctx->cache->verts;
+}
+
+static float nvg__triarea2(float ax, float ay, float bx, float by, float cx, float cy)
+{
+	float abx = bx - ax;
+	float aby = by - ay;
+	float acx = cx - ax;
+	float acy = cy - ay;
+	return acx*aby - abx*acy;
+}
+
+static float nvg__polyArea(NVGpoint* pts, int npts)
+{
+	int i;
+	float area = 0;
+	for (i = 2; i < npts; i++) {
+		NVGpoint* a = &pts[0];
+		NVGpoint* b = &pts[i-1];
+		NVGpoint* c = &pts[i];
+		area += nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y);
+	}
+	return area * 0.5f;
+}
+
+static void nvg__polyReverse(NVGpoint* pts, int npts)
+{
+	NVGpoint tmp;
+	int i = 0, j = npts-1;
+	while (i < j) {
+		tmp = pts[i];
+		pts[i] = pts[j];
+		pts[j] = tmp;
+		i++;
+		j--;
+	}
+}
+
+
+static void nvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
+{
+	vtx->x = x;
+	vtx->y = y;
+	vtx->u = u;
+	vtx->v = v;
+}
+
+// Flattens a cubic bezier into the fewest uniform segments which stay within tessTol of the curve.
+// The count follows from the second differences of the control points (Wang's formula), so the
+// points are evaluated in a loop instead of subdividing recursively. The path is already in view
+// space, so the count adapts to the transform scale of the curve.
+static void nvg__tesselateBezier(NVGcontext* ctx,
+								 float x1, float y1, float x2, float y2,
+								 float x3, float y3, float x4, float y4,
+								 int type)
+{
+	float ddx0 = x1 - 2.0f*x2 + x3, ddy0 = y1 - 2.0f*y2 + y3;
+	float ddx1 = x2 - 2.0f*x3 + x4, ddy1 = y2 - 2.0f*y3 + y4;
+	float dd = nvg__maxf(ddx0*ddx0 + ddy0*ddy0, ddx1*ddx1 + ddy1*ddy1);
+	float segs = nvg__sqrtf(nvg__sqrtf(dd) * 0.75f / ctx->tessTol);
+	float ax, ay, bx, by, cx, cy, t, dt;
+	int i, n;
+
+	n = segs < (float)NVG_MAX_BEZIER_SEGS ? nvg__maxi(1, (int)ceilf(segs)) : NVG_MAX_BEZIER_SEGS;
+
+	// Power basis of the curve.
+	cx = 3.0f*(x2 - x1);
+	cy = 3.0f*(y2 - y1);
+	bx = 3.0f*(x3 - x2) - cx;
+	by = 3.0f*(y3 - y2) - cy;
+	ax = x4 - x1 - cx - bx;
+	ay = y4 - y1 - cy - by;
+
+	dt = 1.0f / (float)n;
+	for (i = 1; i < n; i++) {
+		t = (float)i * dt;
+		nvg__addPoint(ctx, ((ax*t + bx)*t + cx)*t + x1, ((ay*t + by)*t + cy)*t + y1, 0);
+	}
+	nvg__addPoint(ctx, x4, y4, type);
+}
+
+#if NVG_SIMD
+// Calculates direction and length of four segments, each ending at the next point.
+static void nvg__calculateSegments4(NVGpoint* pts)
+{
+	float dx[4], dy[4], len[4];
+	int i;
+	nvg__v4 vdx = nvg__v4sub(nvg__v4set(pts[1].x, pts[2].x, pts[3].x, pts[4].x), nvg__v4set(pts[0].x, pts[1].x, pts[2].x, pts[3].x));
+	nvg__v4 vdy = nvg__v4sub(nvg__v4set(pts[1].y, pts[2].y, pts[3].y, pts[4].y), nvg__v4set(pts[0].y, pts[1].y, pts[2].y, pts[3].y));
+	nvg__v4 d = nvg__v4sqrt(nvg__v4add(nvg__v4mul(vdx, vdx), nvg__v4mul(vdy, vdy)));
+	nvg__v4 valid = nvg__v4gt(d, nvg__v4splat(1e-6f));
+	nvg__v4 id = nvg__v4div(nvg__v4splat(1.0f), d);
+	nvg__v4store(dx, nvg__v4select(valid, nvg__v4mul(vdx, id), vdx));
+	nvg__v4store(dy, nvg__v4select(valid, nvg__v4mul(vdy, id), vdy));
+	nvg__v4store(len, d);
+	for (i = 0; i < 4; i++) {
+		pts[i].dx = dx[i];
+		pts[i].dy = dy[i];
+		pts[i].len = len[i];
+	}
+}
+#endif
+
+static void nvg__flattenPaths(NVGcontext* ctx)
+{
+	NVGpathCache* cache = ctx->cache;
+//	NVGstate* state = nvg__getState(ctx);
+	NVGpoint* last;
 	NVGpoint* p0;
 	NVGpoint* p1;
 	NVGpoint* pts;
 	NVGpath* path;
 	int i, j;
-	float* cp1;
-	float* cp2;
-	float* p;
-	float area;
+	float* cp1;
+	float* cp2;
+	float* p;
+	float area;
+
+	if (cache->npaths > 0)
+		return;
+
+	NVG_TRACE_BEGIN("nvg__flattenPaths");
+
+	// Flatten
+	i = 0;
+	while (i < ctx->ncommands) {
+		int cmd = (int)ctx->commands[i];
+		switch (cmd) {
+		case NVG_MOVETO:
+			nvg__addPath(ctx);
+			p = &ctx->commands[i+1];
+			nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
+			i += 3;
+			break;
+		case NVG_LINETO:
+			p = &ctx->commands[i+1];
+			nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
+			i += 3;
+			break;
+		case NVG_BEZIERTO:
+			last = nvg__lastPoint(ctx);
+			if (last != NULL) {
+				cp1 = &ctx->commands[i+1];
+				cp2 = &ctx->commands[i+3];
+				p = &ctx->commands[i+5];
+				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], NVG_PT_CORNER);
+			}
+			i += 7;
+			break;
+		case NVG_CLOSE:
+			nvg__closePath(ctx);
+			i++;
+			break;
+		case NVG_WINDING:
+			nvg__pathWinding(ctx, (int)ctx->commands[i+1]);
+			i += 2;
+			break;
+		default:
+			i++;
+		}
+	}
+
+	cache->bounds[0] = cache->bounds[1] = 1e6f;
+	cache->bounds[2] = cache->bounds[3] = -1e6f;
+
+	// Calculate the direction and length of line segments.
+	for (j = 0; j < cache->npaths; j++) {
+		path = &cache->paths[j];
+		pts = &cache->points[path->first];
+
+		// If the first and last points are the same, remove the last, mark as closed path.
+		p0 = &pts[path->count-1];
+		p1 = &pts[0];
+		if (nvg__ptEquals(p0->x,p0->y, p1->x,p1->y, ctx->distTol)) {
+			path->count--;
+			p0 = &pts[path->count-1];
+			path->closed = 1;
+		}
+
+		// Enforce winding.
+		if (path->count > 2) {
+			area = nvg__polyArea(pts, path->count);
+			if (path->winding == NVG_CCW && area < 0.0f)
+				nvg__polyReverse(pts, path->count);
+			if (path->winding == NVG_CW && area > 0.0f)
+				nvg__polyReverse(pts, path->count);
+		}
+
+		i = 0;
+#if NVG_SIMD
+		for (; i+4 < path->count; i += 4)
+			nvg__calculateSegments4(&pts[i]);
+#endif
+		for (; i < path->count; i++) {
+			// Calculate segment direction and length
+			p0 = &pts[i];
+			p1 = &pts[i+1 < path->count ? i+1 : 0];
+			p0->dx = p1->x - p0->x;
+			p0->dy = p1->y - p0->y;
+			p0->len = nvg__normalize(&p0->dx, &p0->dy);
+		}
+
+		// Update bounds
+		for (i = 0; i < path->count; i++) {
+			cache->bounds[0] = nvg__minf(cache->bounds[0], pts[i].x);
+			cache->bounds[1] = nvg__minf(cache->bounds[1], pts[i].y);
+			cache->bounds[2] = nvg__maxf(cache->bounds[2], pts[i].x);
+			cache->bounds[3] = nvg__maxf(cache->bounds[3], pts[i].y);
+		}
+	}
+
+	NVG_TRACE_END("nvg__flattenPaths");
+}
+
+static int nvg__curveDivs(float r, float arc, float tol)
+{
+	float da = acosf(r / (r + tol)) * 2.0f;
+	return nvg__maxi(2, (int)ceilf(arc / da));
+}
+
+static void nvg__chooseBevel(int bevel, NVGpoint* p0, NVGpoint* p1, float w,
+							float* x0, float* y0, float* x1, float* y1)
+{
+	if (bevel) {
+		*x0 = p1->x + p0->dy * w;
+		*y0 = p1->y - p0->dx * w;
+		*x1 = p1->x + p1->dy * w;
+		*y1 = p1->y - p1->dx * w;
+	} else {
+		*x0 = p1->x + p1->dmx * w;
+		*y0 = p1->y + p1->dmy * w;
+		*x1 = p1->x + p1->dmx * w;
+		*y1 = p1->y + p1->dmy * w;
+	}
+}
+
+static NVGvertex* nvg__roundJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
+								 float lw, float rw, float lu, float ru, int ncap,
+								 float fringe)
+{
+	int i, n;
+	float dlx0 = p0->dy;
+	float dly0 = -p0->dx;
+	float dlx1 = p1->dy;
+	float dly1 = -p1->dx;
+	NVG_NOTUSED(fringe);
+
+	if (p1->flags & NVG_PT_LEFT) {
+		float lx0,ly0,lx1,ly1,a0,a1;
+		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, lw, &lx0,&ly0, &lx1,&ly1);
+		a0 = atan2f(-dly0, -dlx0);
+		a1 = atan2f(-dly1, -dlx1);
+		if (a1 > a0) a1 -= NVG_PI*2;
+
+		nvg__vset(dst, lx0, ly0, lu,1); dst++;
+		nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+
+		n = nvg__clampi((int)ceilf(((a0 - a1) / NVG_PI) * ncap), 2, ncap);
+		for (i = 0; i < n; i++) {
+			float u = i/(float)(n-1);
+			float a = a0 + u*(a1-a0);
+			float rx = p1->x + cosf(a) * rw;
+			float ry = p1->y + sinf(a) * rw;
+			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+			nvg__vset(dst, rx, ry, ru,1); dst++;
+		}
+
+		nvg__vset(dst, lx1, ly1, lu,1); dst++;
+		nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
+
+	} else {
+		float rx0,ry0,rx1,ry1,a0,a1;
+		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, -rw, &rx0,&ry0, &rx1,&ry1);
+		a0 = atan2f(dly0, dlx0);
+		a1 = atan2f(dly1, dlx1);
+		if (a1 < a0) a1 += NVG_PI*2;
+
+		nvg__vset(dst, p1->x + dlx0*rw, p1->y + dly0*rw, lu,1); dst++;
+		nvg__vset(dst, rx0, ry0, ru,1); dst++;
+
+		n = nvg__clampi((int)ceilf(((a1 - a0) / NVG_PI) * ncap), 2, ncap);
+		for (i = 0; i < n; i++) {
+			float u = i/(float)(n-1);
+			float a = a0 + u*(a1-a0);
+			float lx = p1->x + cosf(a) * lw;
+			float ly = p1->y + sinf(a) * lw;
+			nvg__vset(dst, lx, ly, lu,1); dst++;
+			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+		}
+
+		nvg__vset(dst, p1->x + dlx1*rw, p1->y + dly1*rw, lu,1); dst++;
+		nvg__vset(dst, rx1, ry1, ru,1); dst++;
+
+	}
+	return dst;
+}
+
+static NVGvertex* nvg__bevelJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
+										float lw, float rw, float lu, float ru, float fringe)
+{
+	float rx0,ry0,rx1,ry1;
+	float lx0,ly0,lx1,ly1;
+	float dlx0 = p0->dy;
+	float dly0 = -p0->dx;
+	float dlx1 = p1->dy;
+	float dly1 = -p1->dx;
+	NVG_NOTUSED(fringe);
+
+	if (p1->flags & NVG_PT_LEFT) {
+		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, lw, &lx0,&ly0, &lx1,&ly1);
+
+		nvg__vset(dst, lx0, ly0, lu,1); dst++;
+		nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+
+		if (p1->flags & NVG_PT_BEVEL) {
+			nvg__vset(dst, lx0, ly0, lu,1); dst++;
+			nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+
+			nvg__vset(dst, lx1, ly1, lu,1); dst++;
+			nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
+		} else {
+			rx0 = p1->x - p1->dmx * rw;
+			ry0 = p1->y - p1->dmy * rw;
+
+			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+			nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+
+			nvg__vset(dst, rx0, ry0, ru,1); dst++;
+			nvg__vset(dst, rx0, ry0, ru,1); dst++;
+
+			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+			nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
+		}
+
+		nvg__vset(dst, lx1, ly1, lu,1); dst++;
+		nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
+
+	} else {
+		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, -rw, &rx0,&ry0, &rx1,&ry1);
+
+		nvg__vset(dst, p1->x + dlx0*lw, p1->y + dly0*lw, lu,1); dst++;
+		nvg__vset(dst, rx0, ry0, ru,1); dst++;
+
+		if (p1->flags & NVG_PT_BEVEL) {
+			nvg__vset(dst, p1->x + dlx0*lw, p1->y + dly0*lw, lu,1); dst++;
+			nvg__vset(dst, rx0, ry0, ru,1); dst++;
+
+			nvg__vset(dst, p1->x + dlx1*lw, p1->y + dly1*lw, lu,1); dst++;
+			nvg__vset(dst, rx1, ry1, ru,1); dst++;
+		} else {
+			lx0 = p1->x + p1->dmx * lw;
+			ly0 = p1->y + p1->dmy * lw;
+
+			nvg__vset(dst, p1->x + dlx0*lw, p1->y + dly0*lw, lu,1); dst++;
+			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+
+			nvg__vset(dst, lx0, ly0, lu,1); dst++;
+			nvg__vset(dst, lx0, ly0, lu,1); dst++;
+
+			nvg__vset(dst, p1->x + dlx1*lw, p1->y + dly1*lw, lu,1); dst++;
+			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+		}
+
+		nvg__vset(dst, p1->x + dlx1*lw, p1->y + dly1*lw, lu,1); dst++;
+		nvg__vset(dst, rx1, ry1, ru,1); dst++;
+	}
+
+	return dst;
+}
+
+static NVGvertex* nvg__buttCapStart(NVGvertex* dst, NVGpoint* p,
+									float dx, float dy, float w, float d,
+									float aa, float u0, float u1)
+{
+	float px = p->x - dx*d;
+	float py = p->y - dy*d;
+	float dlx = dy;
+	float dly = -dx;
+	nvg__vset(dst, px + dlx*w - dx*aa, py + dly*w - dy*aa, u0,0); dst++;
+	nvg__vset(dst, px - dlx*w - dx*aa, py - dly*w - dy*aa, u1,0); dst++;
+	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
+	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
+	return dst;
+}
+
+static NVGvertex* nvg__buttCapEnd(NVGvertex* dst, NVGpoint* p,
+								  float dx, float dy, float w, float d,
+								  float aa, float u0, float u1)
+{
+	float px = p->x + dx*d;
+	float py = p->y + dy*d;
+	float dlx = dy;
+	float dly = -dx;
+	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
+	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
+	nvg__vset(dst, px + dlx*w + dx*aa, py + dly*w + dy*aa, u0,0); dst++;
+	nvg__vset(dst, px - dlx*w + dx*aa, py - dly*w + dy*aa, u1,0); dst++;
+	return dst;
+}
+
+
+static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
+									 float dx, float dy, float w, int ncap,
+									 float aa, float u0, float u1)
+{
+	int i;
+	float px = p->x;
+	float py = p->y;
+	float dlx = dy;
+	float dly = -dx;
+	NVG_NOTUSED(aa);
+	for (i = 0; i < ncap; i++) {
+		float a = i/(float)(ncap-1)*NVG_PI;
+		float ax = cosf(a) * w, ay = sinf(a) * w;
+		nvg__vset(dst, px - dlx*ax - dx*ay, py - dly*ax - dy*ay, u0,1); dst++;
+		nvg__vset(dst, px, py, 0.5f,1); dst++;
+	}
+	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
+	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
+	return dst;
+}
+
+static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
+								   float dx, float dy, float w, int ncap,
+								   float aa, float u0, float u1)
+{
+	int i;
+	float px = p->x;
+	float py = p->y;
+	float dlx = dy;
+	float dly = -dx;
+	NVG_NOTUSED(aa);
+	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
+	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
+	for (i = 0; i < ncap; i++) {
+		float a = i/(float)(ncap-1)*NVG_PI;
+		float ax = cosf(a) * w, ay = sinf(a) * w;
+		nvg__vset(dst, px, py, 0.5f,1); dst++;
+		nvg__vset(dst, px - dlx*ax + dx*ay, py - dly*ax + dy*ay, u0,1); dst++;
+	}
+	return dst;
+}
+
+
+#if NVG_SIMD
+// Calculates extrusions and join flags of four points, each preceded by the previous point.
+static void nvg__calculateJoins4(NVGpoint* pts, float iw, int lineJoin, float miterLimit, int* nleft, int* nbevel)
+{
+	float dmx[4], dmy[4];
+	int left, inner, miter, i;
+	nvg__v4 half = nvg__v4splat(0.5f);
+	nvg__v4 one = nvg__v4splat(1.0f);
+	nvg__v4 dx0 = nvg__v4set(pts[-1].dx, pts[0].dx, pts[1].dx, pts[2].dx);
+	nvg__v4 dy0 = nvg__v4set(pts[-1].dy, pts[0].dy, pts[1].dy, pts[2].dy);
+	nvg__v4 len0 = nvg__v4set(pts[-1].len, pts[0].len, pts[1].len, pts[2].len);
+	nvg__v4 dx1 = nvg__v4set(pts[0].dx, pts[1].dx, pts[2].dx, pts[3].dx);
+	nvg__v4 dy1 = nvg__v4set(pts[0].dy, pts[1].dy, pts[2].dy, pts[3].dy);
+	nvg__v4 len1 = nvg__v4set(pts[0].len, pts[1].len, pts[2].len, pts[3].len);
+	nvg__v4 vdmx, vdmy, dmr2, valid, scale, cross, limit, ml;
+
+	// Calculate extrusions
+	vdmx = nvg__v4mul(nvg__v4add(dy0, dy1), half);
+	vdmy = nvg__v4mul(nvg__v4add(nvg__v4neg(dx0), nvg__v4neg(dx1)), half);
+	dmr2 = nvg__v4add(nvg__v4mul(vdmx, vdmx), nvg__v4mul(vdmy, vdmy));
+	valid = nvg__v4gt(dmr2, nvg__v4splat(0.000001f));
+	scale = nvg__v4min(nvg__v4div(one, dmr2), nvg__v4splat(600.0f));
+	nvg__v4store(dmx, nvg__v4select(valid, nvg__v4mul(vdmx, scale), vdmx));
+	nvg__v4store(dmy, nvg__v4select(valid, nvg__v4mul(vdmy, scale), vdmy));
+
+	cross = nvg__v4sub(nvg__v4mul(dx1, dy0), nvg__v4mul(dx0, dy1));
+	left = nvg__v4mask(nvg__v4gt(cross, nvg__v4splat(0.0f)));
+	limit = nvg__v4max(nvg__v4splat(1.01f), nvg__v4mul(nvg__v4min(len0, len1), nvg__v4splat(iw)));
+	inner = nvg__v4mask(nvg__v4lt(nvg__v4mul(nvg__v4mul(dmr2, limit), limit), one));
+	ml = nvg__v4splat(miterLimit);
+	miter = nvg__v4mask(nvg__v4lt(nvg__v4mul(nvg__v4mul(dmr2, ml), ml), one));
+
+	for (i = 0; i < 4; i++) {
+		NVGpoint* p1 = &pts[i];
+		p1->dmx = dmx[i];
+		p1->dmy = dmy[i];
+		p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+		if (left & (1 << i)) {
+			(*nleft)++;
+			p1->flags |= NVG_PT_LEFT;
+		}
+		if (inner & (1 << i))
+			p1->flags |= NVG_PR_INNERBEVEL;
+		if (p1->flags & NVG_PT_CORNER) {
+			if ((miter & (1 << i)) || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND)
+				p1->flags |= NVG_PT_BEVEL;
+		}
+		if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+			(*nbevel)++;
+	}
+}
+#endif
+
+static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
+{
+	NVGpathCache* cache = ctx->cache;
+	int i, j;
+	float iw = 0.0f;
+
+	if (w > 0.0f) iw = 1.0f / w;
+
+	// Calculate which joins needs extra vertices to append, and gather vertex count.
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		NVGpoint* pts = &cache->points[path->first];
+		NVGpoint* p0 = &pts[path->count-1];
+		NVGpoint* p1 = &pts[0];
+		int nleft = 0;
+
+		path->nbevel = 0;
+
+		for (j = 0; j < path->count; j++) {
+			float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
+#if NVG_SIMD
+			// All but the first point have the previous point before them.
+			if (j > 0 && j+4 <= path->count) {
+				nvg__calculateJoins4(p1, iw, lineJoin, miterLimit, &nleft, &path->nbevel);
+				p1 += 4;
+				p0 = p1-1;
+				j += 3;
+				continue;
+			}
+#endif
+			dlx0 = p0->dy;
+			dly0 = -p0->dx;
+			dlx1 = p1->dy;
+			dly1 = -p1->dx;
+			// Calculate extrusions
+			p1->dmx = (dlx0 + dlx1) * 0.5f;
+			p1->dmy = (dly0 + dly1) * 0.5f;
+			dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
+			if (dmr2 > 0.000001f) {
+				float scale = 1.0f / dmr2;
+				if (scale > 600.0f) {
+					scale = 600.0f;
+				}
+				p1->dmx *= scale;
+				p1->dmy *= scale;
+			}
+
+			// Clear flags, but keep the corner.
+			p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+
+			// Keep track of left turns.
+			cross = p1->dx * p0->dy - p0->dx * p1->dy;
+			if (cross > 0.0f) {
+				nleft++;
+				p1->flags |= NVG_PT_LEFT;
+			}
+
+			// Calculate if we should use bevel or miter for inner join.
+			limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
+			if ((dmr2 * limit*limit) < 1.0f)
+				p1->flags |= NVG_PR_INNERBEVEL;
+
+			// Check to see if the corner needs to be beveled.
+			if (p1->flags & NVG_PT_CORNER) {
+				if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
+					p1->flags |= NVG_PT_BEVEL;
+				}
+			}
+
+			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+				path->nbevel++;
+
+			p0 = p1++;
+		}
+
+		path->convex = (nleft == path->count) ? 1 : 0;
+	}
+}
+
+
+static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap, int lineJoin, float miterLimit)
+{
+	NVGpathCache* cache = ctx->cache;
+	NVGvertex* verts;
+	NVGvertex* dst;
+	int cverts, i, j;
+	float aa = fringe;//ctx->fringeWidth;
+	float u0 = 0.0f, u1 = 1.0f;
+	int ncap = nvg__curveDivs(w, NVG_PI, ctx->tessTol);	// Calculate divisions per half circle.
+
+	w += aa * 0.5f;
+
+	// Disable the gradient used for antialiasing when antialiasing is not used.
+	if (aa == 0.0f) {
+		u0 = 0.5f;
+		u1 = 0.5f;
+	}
+
+	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+
+	// Calculate max vertex usage.
+	cverts = 0;
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		int loop = (path->closed == 0) ? 0 : 1;
+		if (lineJoin == NVG_ROUND)
+			cverts += (path->count + path->nbevel*(ncap+2) + 1) * 2; // plus one for loop
+		else
+			cverts += (path->count + path->nbevel*5 + 1) * 2; // plus one for loop
+		if (loop == 0) {
+			// space for caps
+			if (lineCap == NVG_ROUND) {
+				cverts += (ncap*2 + 2)*2;
+			} else {
+				cverts += (3+3)*2;
+			}
+		}
+	}
+
+	verts = nvg__allocTempVerts(ctx, cverts);
+	if (verts == NULL) return 0;
+
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		NVGpoint* pts = &cache->points[path->first];
+		NVGpoint* p0;
+		NVGpoint* p1;
+		int s, e, loop;
+		float dx, dy;
+
+		path->fill = 0;
+		path->nfill = 0;
+
+		// Calculate fringe or stroke
+		loop = (path->closed == 0) ? 0 : 1;
+		dst = verts;
+		path->stroke = dst;
+
+		if (loop) {
+			// Looping
+			p0 = &pts[path->count-1];
+			p1 = &pts[0];
+			s = 0;
+			e = path->count;
+		} else {
+			// Add cap
+			p0 = &pts[0];
+			p1 = &pts[1];
+			s = 1;
+			e = path->count-1;
+		}
+
+		if (loop == 0) {
+			// Add cap
+			dx = p1->x - p0->x;
+			dy = p1->y - p0->y;
+			nvg__normalize(&dx, &dy);
+			if (lineCap == NVG_BUTT)
+				dst = nvg__buttCapStart(dst, p0, dx, dy, w, -aa*0.5f, aa, u0, u1);
+			else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
+				dst = nvg__buttCapStart(dst, p0, dx, dy, w, w-aa, aa, u0, u1);
+			else if (lineCap == NVG_ROUND)
+				dst = nvg__roundCapStart(dst, p0, dx, dy, w, ncap, aa, u0, u1);
+		}
+
+		for (j = s; j < e; ++j) {
+			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
+				if (lineJoin == NVG_ROUND) {
+					dst = nvg__roundJoin(dst, p0, p1, w, w, u0, u1, ncap, aa);
+				} else {
+					dst = nvg__bevelJoin(dst, p0, p1, w, w, u0, u1, aa);
+				}
+			} else {
+				nvg__vset(dst, p1->x + (p1->dmx * w), p1->y + (p1->dmy * w), u0,1); dst++;
+				nvg__vset(dst, p1->x - (p1->dmx * w), p1->y - (p1->dmy * w), u1,1); dst++;
+			}
+			p0 = p1++;
+		}
 
-	if (cache->npaths > 0)
-		return;
+		if (loop) {
+			// Loop it
+			nvg__vset(dst, verts[0].x, verts[0].y, u0,1); dst++;
+			nvg__vset(dst, verts[1].x, verts[1].y, u1,1); dst++;
+		} else {
+			// Add cap
+			dx = p1->x - p0->x;
+			dy = p1->y - p0->y;
+			nvg__normalize(&dx, &dy);
+			if (lineCap == NVG_BUTT)
+				dst = nvg__buttCapEnd(dst, p1, dx, dy, w, -aa*0.5f, aa, u0, u1);
+			else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
+				dst = nvg__buttCapEnd(dst, p1, dx, dy, w, w-aa, aa, u0, u1);
+			else if (lineCap == NVG_ROUND)
+				dst = nvg__roundCapEnd(dst, p1, dx, dy, w, ncap, aa, u0, u1);
+		}
 
-	// Flatten
-	i = 0;
-	while (i < ctx->ncommands) {
-		int cmd = (int)ctx->commands[i];
-		switch (cmd) {
-		case NVG_MOVETO:
-			nvg__addPath(ctx);
-			p = &ctx->commands[i+1];
-			nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
-			i += 3;
-			break;
-		case NVG_LINETO:
-			p = &ctx->commands[i+1];
-			nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
-			i += 3;
-			break;
-		case NVG_BEZIERTO:
-			last = nvg__lastPoint(ctx);
-			if (last != NULL) {
-				cp1 = &ctx->commands[i+1];
-				cp2 = &ctx->commands[i+3];
-				p = &ctx->commands[i+5];
-				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], 0, NVG_PT_CORNER);
+		path->nstroke = (int)(dst - verts);
+
+		verts = dst;
+	}
+
+	return 1;
+}
+
+// Returns true if segments p0-p1 and p2-p3 cross each other.
+static int nvg__segmentsCross(const NVGvertex* p0, const NVGvertex* p1, const NVGvertex* p2, const NVGvertex* p3)
+{
+	float d0, d1, d2, d3;
+	if (nvg__maxf(p0->x, p1->x) < nvg__minf(p2->x, p3->x) || nvg__maxf(p2->x, p3->x) < nvg__minf(p0->x, p1->x) ||
+		nvg__maxf(p0->y, p1->y) < nvg__minf(p2->y, p3->y) || nvg__maxf(p2->y, p3->y) < nvg__minf(p0->y, p1->y))
+		return 0;
+	d0 = nvg__triarea2(p0->x,p0->y, p1->x,p1->y, p2->x,p2->y);
+	d1 = nvg__triarea2(p0->x,p0->y, p1->x,p1->y, p3->x,p3->y);
+	d2 = nvg__triarea2(p2->x,p2->y, p3->x,p3->y, p0->x,p0->y);
+	d3 = nvg__triarea2(p2->x,p2->y, p3->x,p3->y, p1->x,p1->y);
+	return d0*d1 < 0.0f && d2*d3 < 0.0f;
+}
+
+// Triangulates a simple polygon by ear clipping. The triangles are wound like convex fills,
+// so they can be drawn the same way. Returns the number of triangles written to dst, or 0 if
+// the polygon is too large, self-intersecting or degenerate, in which case it needs the stencil.
+static int nvg__triangulate(const NVGvertex* pts, int npts, NVGvertex* dst)
+{
+	int prev[NVG_TRIANGULATE_MAX_VERTS], next[NVG_TRIANGULATE_MAX_VERTS];
+	int i, j, n, v, stall, ntris = 0;
+	float area = 0.0f;
+
+	if (npts < 3 || npts > NVG_TRIANGULATE_MAX_VERTS) return 0;
+
+	for (i = 0; i < npts; i++) {
+		for (j = i+2; j < npts; j++) {
+			if (i == 0 && j == npts-1) continue;	// Adjacent through the loop.
+			if (nvg__segmentsCross(&pts[i], &pts[i+1], &pts[j], &pts[(j+1) % npts]))
+				return 0;
+		}
+	}
+
+	for (i = 2; i < npts; i++)
+		area += nvg__triarea2(pts[0].x,pts[0].y, pts[i-1].x,pts[i-1].y, pts[i].x,pts[i].y);
+	if (area == 0.0f) return 0;
+
+	// Walk the polygon in the winding of convex fills.
+	for (i = 0; i < npts; i++) {
+		next[i] = area > 0.0f ? (i+1) % npts : (i+npts-1) % npts;
+		prev[next[i]] = i;
+	}
+
+	n = npts;
+	v = 0;
+	stall = 0;
+	while (n > 2) {
+		const NVGvertex* a = &pts[prev[v]];
+		const NVGvertex* b = &pts[v];
+		const NVGvertex* c = &pts[next[v]];
+		float ear = nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y);
+		int empty = ear > 0.0f;
+
+		// An ear must be convex, and not contain any of the other vertices.
+		for (j = next[next[v]]; empty && j != prev[v]; j = next[j]) {
+			const NVGvertex* p = &pts[j];
+			if (nvg__triarea2(a->x,a->y, b->x,b->y, p->x,p->y) >= 0.0f &&
+				nvg__triarea2(b->x,b->y, c->x,c->y, p->x,p->y) >= 0.0f &&
+				nvg__triarea2(c->x,c->y, a->x,a->y, p->x,p->y) >= 0.0f)
+				empty = 0;
+		}
+
+		if (empty || ear == 0.0f) {
+			// Clip the ear, collinear vertices are dropped without a triangle.
+			if (empty) {
+				*dst++ = *a;
+				*dst++ = *b;
+				*dst++ = *c;
+				ntris++;
 			}
-			i += 7;
-			break;
-		case NVG_CLOSE:
-			nvg__closePath(ctx);
-			i++;
-			break;
-		case NVG_WINDING:
-			nvg__pathWinding(ctx, (int)ctx->commands[i+1]);
-			i += 2;
-			break;
-		default:
-			i++;
+			next[prev[v]] = next[v];
+			prev[next[v]] = prev[v];
+			v = next[v];
+			n--;
+			stall = 0;
+		} else {
+			v = next[v];
+			if (++stall > n) return 0;
+		}
+	}
+
+	return ntris;
+}
+
+static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
+{
+	NVGpathCache* cache = ctx->cache;
+	NVGvertex* verts;
+	NVGvertex* dst;
+	int cverts, convex, triangulate, i, j;
+	float aa = ctx->fringeWidth;
+	int fringe = w > 0.0f;
+
+	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+
+	convex = cache->npaths == 1 && cache->paths[0].convex;
+	// A single concave path can be triangulated, so that it is drawn like a convex path without stencil.
+	triangulate = ctx->params.triangulateFills && cache->npaths == 1 && !convex;
+
+	// Calculate max vertex usage.
+	cverts = 0;
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		cverts += path->count + path->nbevel + 1;
+		if (triangulate)
+			cverts += (path->count + path->nbevel) * 3;
+		if (fringe)
+			cverts += (path->count + path->nbevel*5 + 1) * 2; // plus one for loop
+	}
+
+	verts = nvg__allocTempVerts(ctx, cverts);
+	if (verts == NULL) return 0;
+
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		NVGpoint* pts = &cache->points[path->first];
+		NVGpoint* p0;
+		NVGpoint* p1;
+		float rw, lw, woff;
+		float ru, lu;
+
+		// Calculate shape vertices.
+		woff = 0.5f*aa;
+		dst = verts;
+		path->fill = dst;
+
+		if (fringe) {
+			// Looping
+			p0 = &pts[path->count-1];
+			p1 = &pts[0];
+			for (j = 0; j < path->count; ++j) {
+				if (p1->flags & NVG_PT_BEVEL) {
+					float dlx0 = p0->dy;
+					float dly0 = -p0->dx;
+					float dlx1 = p1->dy;
+					float dly1 = -p1->dx;
+					if (p1->flags & NVG_PT_LEFT) {
+						float lx = p1->x + p1->dmx * woff;
+						float ly = p1->y + p1->dmy * woff;
+						nvg__vset(dst, lx, ly, 0.5f,1); dst++;
+					} else {
+						float lx0 = p1->x + dlx0 * woff;
+						float ly0 = p1->y + dly0 * woff;
+						float lx1 = p1->x + dlx1 * woff;
+						float ly1 = p1->y + dly1 * woff;
+						nvg__vset(dst, lx0, ly0, 0.5f,1); dst++;
+						nvg__vset(dst, lx1, ly1, 0.5f,1); dst++;
+					}
+				} else {
+					nvg__vset(dst, p1->x + (p1->dmx * woff), p1->y + (p1->dmy * woff), 0.5f,1); dst++;
+				}
+				p0 = p1++;
+			}
+		} else {
+			for (j = 0; j < path->count; ++j) {
+				nvg__vset(dst, pts[j].x, pts[j].y, 0.5f,1);
+				dst++;
+			}
+		}
+
+		path->nfill = (int)(dst - verts);
+		verts = dst;
+
+		path->triangulated = 0;
+		if (triangulate) {
+			int ntris = nvg__triangulate(path->fill, path->nfill, verts);
+			if (ntris > 0) {
+				path->fill = verts;
+				path->nfill = ntris*3;
+				path->triangulated = 1;
+				verts += ntris*3;
+				convex = 1;
+			}
+		}
+
+		// Calculate fringe
+		if (fringe) {
+			lw = w + woff;
+			rw = w - woff;
+			lu = 0;
+			ru = 1;
+			dst = verts;
+			path->stroke = dst;
+
+			// Create only half a fringe for convex shapes so that
+			// the shape can be rendered without stenciling.
+			if (convex) {
+				lw = woff;	// This should generate the same vertex as fill inset above.
+				lu = 0.5f;	// Set outline fade at middle.
+			}
+
+			// Looping
+			p0 = &pts[path->count-1];
+			p1 = &pts[0];
+
+			for (j = 0; j < path->count; ++j) {
+				if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
+					dst = nvg__bevelJoin(dst, p0, p1, lw, rw, lu, ru, ctx->fringeWidth);
+				} else {
+					nvg__vset(dst, p1->x + (p1->dmx * lw), p1->y + (p1->dmy * lw), lu,1); dst++;
+					nvg__vset(dst, p1->x - (p1->dmx * rw), p1->y - (p1->dmy * rw), ru,1); dst++;
+				}
+				p0 = p1++;
+			}
+
+			// Loop it
+			nvg__vset(dst, verts[0].x, verts[0].y, lu,1); dst++;
+			nvg__vset(dst, verts[1].x, verts[1].y, ru,1); dst++;
+
+			path->nstroke = (int)(dst - verts);
+			verts = dst;
+		} else {
+			path->stroke = NULL;
+			path->nstroke = 0;
 		}
 	}
 
-	cache->bounds[0] = cache->bounds[1] = 1e6f;
-	cache->bounds[2] = cache->bounds[3] = -1e6f;
+	return 1;
+}
+
+
+// Draw
+void nvgBeginPath(NVGcontext* ctx)
+{
+	ctx->ncommands = 0;
+	ctx->fastRectCommands = 0;
+	nvg__clearPathCache(ctx);
+}
+
+void nvgMoveTo(NVGcontext* ctx, float x, float y)
+{
+	float vals[] = { NVG_MOVETO, x, y };
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+}
+
+void nvgLineTo(NVGcontext* ctx, float x, float y)
+{
+	float vals[] = { NVG_LINETO, x, y };
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+}
+
+void nvgBezierTo(NVGcontext* ctx, float c1x, float c1y, float c2x, float c2y, float x, float y)
+{
+	float vals[] = { NVG_BEZIERTO, c1x, c1y, c2x, c2y, x, y };
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+}
+
+void nvgQuadTo(NVGcontext* ctx, float cx, float cy, float x, float y)
+{
+    float x0 = ctx->commandx;
+    float y0 = ctx->commandy;
+    float vals[] = { NVG_BEZIERTO,
+        x0 + 2.0f/3.0f*(cx - x0), y0 + 2.0f/3.0f*(cy - y0),
+        x + 2.0f/3.0f*(cx - x), y + 2.0f/3.0f*(cy - y),
+        x, y };
+    nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+}
+
+void nvgArcTo(NVGcontext* ctx, float x1, float y1, float x2, float y2, float radius)
+{
+	float x0 = ctx->commandx;
+	float y0 = ctx->commandy;
+	float dx0,dy0, dx1,dy1, a, d, cx,cy, a0,a1;
+	int dir;
+
+	if (ctx->ncommands == 0) {
+		return;
+	}
+
+	// Handle degenerate cases.
+	if (nvg__ptEquals(x0,y0, x1,y1, ctx->distTol) ||
+		nvg__ptEquals(x1,y1, x2,y2, ctx->distTol) ||
+		nvg__distPtSeg(x1,y1, x0,y0, x2,y2) < ctx->distTol*ctx->distTol ||
+		radius < ctx->distTol) {
+		nvgLineTo(ctx, x1,y1);
+		return;
+	}
 
-	// Calculate the direction and length of line segments.
-	for (j = 0; j < cache->npaths; j++) {
-		path = &cache->paths[j];
-		pts = &cache->points[path->first];
+	// Calculate tangential circle to lines (x0,y0)-(x1,y1) and (x1,y1)-(x2,y2).
+	dx0 = x0-x1;
+	dy0 = y0-y1;
+	dx1 = x2-x1;
+	dy1 = y2-y1;
+	nvg__normalize(&dx0,&dy0);
+	nvg__normalize(&dx1,&dy1);
+	a = nvg__acosf(dx0*dx1 + dy0*dy1);
+	d = radius / nvg__tanf(a/2.0f);
 
-		// If the first and last points are the same, remove the last, mark as closed path.
-		p0 = &pts[path->count-1];
-		p1 = &pts[0];
-		if (nvg__ptEquals(p0->x,p0->y, p1->x,p1->y, ctx->distTol)) {
-			path->count--;
-			p0 = &pts[path->count-1];
-			path->closed = 1;
-		}
+//	printf("a=%f° d=%f\n", a/NVG_PI*180.0f, d);
 
-		// Enforce winding.
-		if (path->count > 2) {
-			area = nvg__polyArea(pts, path->count);
-			if (path->winding == NVG_CCW && area < 0.0f)
-				nvg__polyReverse(pts, path->count);
-			if (path->winding == NVG_CW && area > 0.0f)
-				nvg__polyReverse(pts, path->count);
-		}
+	if (d > 10000.0f) {
+		nvgLineTo(ctx, x1,y1);
+		return;
+	}
 
-		for(i = 0; i < path->count; i++) {
-			// Calculate segment direction and length
-			p0->dx = p1->x - p0->x;
-			p0->dy = p1->y - p0->y;
-			p0->len = nvg__normalize(&p0->dx, &p0->dy);
-			// Update bounds
-			cache->bounds[0] = nvg__minf(cache->bounds[0], p0->x);
-			cache->bounds[1] = nvg__minf(cache->bounds[1], p0->y);
-			cache->bounds[2] = nvg__maxf(cache->bounds[2], p0->x);
-			cache->bounds[3] = nvg__maxf(cache->bounds[3], p0->y);
-			// Advance
-			p0 = p1++;
-		}
+	if (nvg__cross(dx0,dy0, dx1,dy1) > 0.0f) {
+		cx = x1 + dx0*d + dy0*radius;
+		cy = y1 + dy0*d + -dx0*radius;
+		a0 = nvg__atan2f(dx0, -dy0);
+		a1 = nvg__atan2f(-dx1, dy1);
+		dir = NVG_CW;
+//		printf("CW c=(%f, %f) a0=%f° a1=%f°\n", cx, cy, a0/NVG_PI*180.0f, a1/NVG_PI*180.0f);
+	} else {
+		cx = x1 + dx0*d + -dy0*radius;
+		cy = y1 + dy0*d + dx0*radius;
+		a0 = nvg__atan2f(-dx0, dy0);
+		a1 = nvg__atan2f(dx1, -dy1);
+		dir = NVG_CCW;
+//		printf("CCW c=(%f, %f) a0=%f° a1=%f°\n", cx, cy, a0/NVG_PI*180.0f, a1/NVG_PI*180.0f);
 	}
+
+	nvgArc(ctx, cx, cy, radius, a0, a1, dir);
 }
 
-static int nvg__curveDivs(float r, float arc, float tol)
+void nvgClosePath(NVGcontext* ctx)
 {
-	float da = acosf(r / (r + tol)) * 2.0f;
-	return nvg__maxi(2, (int)ceilf(arc / da));
+	float vals[] = { NVG_CLOSE };
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
 }
 
-static void nvg__chooseBevel(int bevel, NVGpoint* p0, NVGpoint* p1, float w,
-							float* x0, float* y0, float* x1, float* y1)
+void nvgPathWinding(NVGcontext* ctx, int dir)
 {
-	if (bevel) {
-		*x0 = p1->x + p0->dy * w;
-		*y0 = p1->y - p0->dx * w;
-		*x1 = p1->x + p1->dy * w;
-		*y1 = p1->y - p1->dx * w;
-	} else {
-		*x0 = p1->x + p1->dmx * w;
-		*y0 = p1->y + p1->dmy * w;
-		*x1 = p1->x + p1->dmx * w;
-		*y1 = p1->y + p1->dmy * w;
-	}
+	float vals[] = { NVG_WINDING, (float)dir };
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
 }
 
-static NVGvertex* nvg__roundJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
-								 float lw, float rw, float lu, float ru, int ncap,
-								 float fringe)
+void nvgArc(NVGcontext* ctx, float cx, float cy, float r, float a0, float a1, int dir)
 {
-	int i, n;
-	float dlx0 = p0->dy;
-	float dly0 = -p0->dx;
-	float dlx1 = p1->dy;
-	float dly1 = -p1->dx;
-	NVG_NOTUSED(fringe);
-
-	if (p1->flags & NVG_PT_LEFT) {
-		float lx0,ly0,lx1,ly1,a0,a1;
-		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, lw, &lx0,&ly0, &lx1,&ly1);
-		a0 = atan2f(-dly0, -dlx0);
-		a1 = atan2f(-dly1, -dlx1);
-		if (a1 > a0) a1 -= NVG_PI*2;
-
-		nvg__vset(dst, lx0, ly0, lu,1); dst++;
-		nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+	float a = 0, da = 0, hda = 0, kappa = 0;
+	float dx = 0, dy = 0, x = 0, y = 0, tanx = 0, tany = 0;
+	float px = 0, py = 0, ptanx = 0, ptany = 0;
+	float vals[3 + 5*7 + 100];
+	int i, ndivs, nvals;
+	int move = ctx->ncommands > 0 ? NVG_LINETO : NVG_MOVETO;
 
-		n = nvg__clampi((int)ceilf(((a0 - a1) / NVG_PI) * ncap), 2, ncap);
-		for (i = 0; i < n; i++) {
-			float u = i/(float)(n-1);
-			float a = a0 + u*(a1-a0);
-			float rx = p1->x + cosf(a) * rw;
-			float ry = p1->y + sinf(a) * rw;
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
-			nvg__vset(dst, rx, ry, ru,1); dst++;
+	// Clamp angles
+	da = a1 - a0;
+	if (dir == NVG_CW) {
+		if (nvg__absf(da) >= NVG_PI*2) {
+			da = NVG_PI*2;
+		} else {
+			while (da < 0.0f) da += NVG_PI*2;
 		}
-
-		nvg__vset(dst, lx1, ly1, lu,1); dst++;
-		nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
-
 	} else {
-		float rx0,ry0,rx1,ry1,a0,a1;
-		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, -rw, &rx0,&ry0, &rx1,&ry1);
-		a0 = atan2f(dly0, dlx0);
-		a1 = atan2f(dly1, dlx1);
-		if (a1 < a0) a1 += NVG_PI*2;
+		if (nvg__absf(da) >= NVG_PI*2) {
+			da = -NVG_PI*2;
+		} else {
+			while (da > 0.0f) da -= NVG_PI*2;
+		}
+	}
 
-		nvg__vset(dst, p1->x + dlx0*rw, p1->y + dly0*rw, lu,1); dst++;
-		nvg__vset(dst, rx0, ry0, ru,1); dst++;
+	// Split arc into max 90 degree segments.
+	ndivs = nvg__maxi(1, nvg__mini((int)(nvg__absf(da) / (NVG_PI*0.5f) + 0.5f), 5));
+	hda = (da / (float)ndivs) / 2.0f;
+	kappa = nvg__absf(4.0f / 3.0f * (1.0f - nvg__cosf(hda)) / nvg__sinf(hda));
 
-		n = nvg__clampi((int)ceilf(((a1 - a0) / NVG_PI) * ncap), 2, ncap);
-		for (i = 0; i < n; i++) {
-			float u = i/(float)(n-1);
-			float a = a0 + u*(a1-a0);
-			float lx = p1->x + cosf(a) * lw;
-			float ly = p1->y + sinf(a) * lw;
-			nvg__vset(dst, lx, ly, lu,1); dst++;
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
-		}
+	if (dir == NVG_CCW)
+		kappa = -kappa;
 
-		nvg__vset(dst, p1->x + dlx1*rw, p1->y + dly1*rw, lu,1); dst++;
-		nvg__vset(dst, rx1, ry1, ru,1); dst++;
+	nvals = 0;
+	for (i = 0; i <= ndivs; i++) {
+		a = a0 + da * (i/(float)ndivs);
+		dx = nvg__cosf(a);
+		dy = nvg__sinf(a);
+		x = cx + dx*r;
+		y = cy + dy*r;
+		tanx = -dy*r*kappa;
+		tany = dx*r*kappa;
 
+		if (i == 0) {
+			vals[nvals++] = (float)move;
+			vals[nvals++] = x;
+			vals[nvals++] = y;
+		} else {
+			vals[nvals++] = NVG_BEZIERTO;
+			vals[nvals++] = px+ptanx;
+			vals[nvals++] = py+ptany;
+			vals[nvals++] = x-tanx;
+			vals[nvals++] = y-tany;
+			vals[nvals++] = x;
+			vals[nvals++] = y;
+		}
+		px = x;
+		py = y;
+		ptanx = tanx;
+		ptany = tany;
 	}
-	return dst;
+
+	nvg__appendCommands(ctx, vals, nvals);
 }
 
-static NVGvertex* nvg__bevelJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
-										float lw, float rw, float lu, float ru, float fringe)
+// Remembers a rect which was added to an empty path, so that nvgFill() can pass it to renderRect
+// instead of tessellating it. Only rects which stay axis aligned with round corners qualify.
+static void nvg__setFastRect(NVGcontext* ctx, float x, float y, float w, float h, float r)
 {
-	float rx0,ry0,rx1,ry1;
-	float lx0,ly0,lx1,ly1;
-	float dlx0 = p0->dy;
-	float dly0 = -p0->dx;
-	float dlx1 = p1->dy;
-	float dly1 = -p1->dx;
-	NVG_NOTUSED(fringe);
-
-	if (p1->flags & NVG_PT_LEFT) {
-		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, lw, &lx0,&ly0, &lx1,&ly1);
-
-		nvg__vset(dst, lx0, ly0, lu,1); dst++;
-		nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+	float* t = nvg__getState(ctx)->xform;
+	float x0, y0, x1, y1;
 
-		if (p1->flags & NVG_PT_BEVEL) {
-			nvg__vset(dst, lx0, ly0, lu,1); dst++;
-			nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+	if (ctx->params.renderRect == NULL) return;
+	if (t[1] != 0.0f || t[2] != 0.0f) return;
+	if (r > 0.0f && nvg__absf(t[0]) != nvg__absf(t[3])) return;
 
-			nvg__vset(dst, lx1, ly1, lu,1); dst++;
-			nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
-		} else {
-			rx0 = p1->x - p1->dmx * rw;
-			ry0 = p1->y - p1->dmy * rw;
+	nvgTransformPoint(&x0, &y0, t, x, y);
+	nvgTransformPoint(&x1, &y1, t, x+w, y+h);
+	ctx->fastRect[0] = nvg__minf(x0, x1);
+	ctx->fastRect[1] = nvg__minf(y0, y1);
+	ctx->fastRect[2] = nvg__absf(x1 - x0);
+	ctx->fastRect[3] = nvg__absf(y1 - y0);
+	ctx->fastRect[4] = r * nvg__absf(t[0]);
+	if (ctx->fastRect[2] <= 0.0f || ctx->fastRect[3] <= 0.0f) return;
 
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
-			nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
+	ctx->fastRectCommands = ctx->ncommands;
+}
 
-			nvg__vset(dst, rx0, ry0, ru,1); dst++;
-			nvg__vset(dst, rx0, ry0, ru,1); dst++;
+void nvgRect(NVGcontext* ctx, float x, float y, float w, float h)
+{
+	int empty = ctx->ncommands == 0;
+	float vals[] = {
+		NVG_MOVETO, x,y,
+		NVG_LINETO, x,y+h,
+		NVG_LINETO, x+w,y+h,
+		NVG_LINETO, x+w,y,
+		NVG_CLOSE
+	};
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	if (empty)
+		nvg__setFastRect(ctx, x, y, w, h, 0.0f);
+}
 
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
-			nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
-		}
+void nvgRoundedRect(NVGcontext* ctx, float x, float y, float w, float h, float r)
+{
+	nvgRoundedRectVarying(ctx, x, y, w, h, r, r, r, r);
+}
 
-		nvg__vset(dst, lx1, ly1, lu,1); dst++;
-		nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
+void nvgRoundedRectVarying(NVGcontext* ctx, float x, float y, float w, float h, float radTopLeft, float radTopRight, float radBottomRight, float radBottomLeft)
+{
+	if(radTopLeft < 0.1f && radTopRight < 0.1f && radBottomRight < 0.1f && radBottomLeft < 0.1f) {
+		nvgRect(ctx, x, y, w, h);
+		return;
+	} else {
+		int empty = ctx->ncommands == 0;
+		float halfw = nvg__absf(w)*0.5f;
+		float halfh = nvg__absf(h)*0.5f;
+		float rxBL = nvg__minf(radBottomLeft, halfw) * nvg__signf(w), ryBL = nvg__minf(radBottomLeft, halfh) * nvg__signf(h);
+		float rxBR = nvg__minf(radBottomRight, halfw) * nvg__signf(w), ryBR = nvg__minf(radBottomRight, halfh) * nvg__signf(h);
+		float rxTR = nvg__minf(radTopRight, halfw) * nvg__signf(w), ryTR = nvg__minf(radTopRight, halfh) * nvg__signf(h);
+		float rxTL = nvg__minf(radTopLeft, halfw) * nvg__signf(w), ryTL = nvg__minf(radTopLeft, halfh) * nvg__signf(h);
+		float vals[] = {
+			NVG_MOVETO, x, y + ryTL,
+			NVG_LINETO, x, y + h - ryBL,
+			NVG_BEZIERTO, x, y + h - ryBL*(1 - NVG_KAPPA90), x + rxBL*(1 - NVG_KAPPA90), y + h, x + rxBL, y + h,
+			NVG_LINETO, x + w - rxBR, y + h,
+			NVG_BEZIERTO, x + w - rxBR*(1 - NVG_KAPPA90), y + h, x + w, y + h - ryBR*(1 - NVG_KAPPA90), x + w, y + h - ryBR,
+			NVG_LINETO, x + w, y + ryTR,
+			NVG_BEZIERTO, x + w, y + ryTR*(1 - NVG_KAPPA90), x + w - rxTR*(1 - NVG_KAPPA90), y, x + w - rxTR, y,
+			NVG_LINETO, x + rxTL, y,
+			NVG_BEZIERTO, x + rxTL*(1 - NVG_KAPPA90), y, x, y + ryTL*(1 - NVG_KAPPA90), x, y + ryTL,
+			NVG_CLOSE
+		};
+		nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+		// The shader draws circular corners of one size, which is what 4 equal, unclamped radii give.
+		if (empty && radTopLeft == radTopRight && radTopLeft == radBottomRight && radTopLeft == radBottomLeft &&
+			radTopLeft <= nvg__minf(halfw, halfh))
+			nvg__setFastRect(ctx, x, y, w, h, radTopLeft);
+	}
+}
 
-	} else {
-		nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, -rw, &rx0,&ry0, &rx1,&ry1);
+void nvgEllipse(NVGcontext* ctx, float cx, float cy, float rx, float ry)
+{
+	float vals[] = {
+		NVG_MOVETO, cx-rx, cy,
+		NVG_BEZIERTO, cx-rx, cy+ry*NVG_KAPPA90, cx-rx*NVG_KAPPA90, cy+ry, cx, cy+ry,
+		NVG_BEZIERTO, cx+rx*NVG_KAPPA90, cy+ry, cx+rx, cy+ry*NVG_KAPPA90, cx+rx, cy,
+		NVG_BEZIERTO, cx+rx, cy-ry*NVG_KAPPA90, cx+rx*NVG_KAPPA90, cy-ry, cx, cy-ry,
+		NVG_BEZIERTO, cx-rx*NVG_KAPPA90, cy-ry, cx-rx, cy-ry*NVG_KAPPA90, cx-rx, cy,
+		NVG_CLOSE
+	};
+	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+}
 
-		nvg__vset(dst, p1->x + dlx0*lw, p1->y + dly0*lw, lu,1); dst++;
-		nvg__vset(dst, rx0, ry0, ru,1); dst++;
+void nvgCircle(NVGcontext* ctx, float cx, float cy, float r)
+{
+	nvgEllipse(ctx, cx,cy, r,r);
+}
 
-		if (p1->flags & NVG_PT_BEVEL) {
-			nvg__vset(dst, p1->x + dlx0*lw, p1->y + dly0*lw, lu,1); dst++;
-			nvg__vset(dst, rx0, ry0, ru,1); dst++;
+void nvgDebugDumpPathCache(NVGcontext* ctx)
+{
+	const NVGpath* path;
+	int i, j;
 
-			nvg__vset(dst, p1->x + dlx1*lw, p1->y + dly1*lw, lu,1); dst++;
-			nvg__vset(dst, rx1, ry1, ru,1); dst++;
-		} else {
-			lx0 = p1->x + p1->dmx * lw;
-			ly0 = p1->y + p1->dmy * lw;
+	printf("Dumping %d cached paths\n", ctx->cache->npaths);
+	for (i = 0; i < ctx->cache->npaths; i++) {
+		path = &ctx->cache->paths[i];
+		printf(" - Path %d\n", i);
+		if (path->nfill) {
+			printf("   - fill: %d\n", path->nfill);
+			for (j = 0; j < path->nfill; j++)
+				printf("%f\t%f\n", path->fill[j].x, path->fill[j].y);
+		}
+		if (path->nstroke) {
+			printf("   - stroke: %d\n", path->nstroke);
+			for (j = 0; j < path->nstroke; j++)
+				printf("%f\t%f\n", path->stroke[j].x, path->stroke[j].y);
+		}
+	}
+}
 
-			nvg__vset(dst, p1->x + dlx0*lw, p1->y + dly0*lw, lu,1); dst++;
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+// Calculates the bounds of the points in the command stream. Bezier segments are within
+// the bounds of their control points, so the bounds contain the flattened path.
+static int nvg__commandBounds(NVGcontext* ctx, float* bounds)
+{
+	int i = 0, npts = 0, j, n;
+	float* p;
 
-			nvg__vset(dst, lx0, ly0, lu,1); dst++;
-			nvg__vset(dst, lx0, ly0, lu,1); dst++;
+	bounds[0] = bounds[1] = 1e6f;
+	bounds[2] = bounds[3] = -1e6f;
 
-			nvg__vset(dst, p1->x + dlx1*lw, p1->y + dly1*lw, lu,1); dst++;
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+	while (i < ctx->ncommands) {
+		int cmd = (int)ctx->commands[i];
+		switch (cmd) {
+		case NVG_MOVETO:
+		case NVG_LINETO:
+		case NVG_BEZIERTO:
+			n = cmd == NVG_BEZIERTO ? 3 : 1;
+			p = &ctx->commands[i+1];
+			for (j = 0; j < n; j++) {
+				bounds[0] = nvg__minf(bounds[0], p[j*2]);
+				bounds[1] = nvg__minf(bounds[1], p[j*2+1]);
+				bounds[2] = nvg__maxf(bounds[2], p[j*2]);
+				bounds[3] = nvg__maxf(bounds[3], p[j*2+1]);
+			}
+			npts += n;
+			i += 1 + n*2;
+			break;
+		case NVG_CLOSE:
+			i++;
+			break;
+		case NVG_WINDING:
+			i += 2;
+			break;
+		default:
+			i++;
 		}
-
-		nvg__vset(dst, p1->x + dlx1*lw, p1->y + dly1*lw, lu,1); dst++;
-		nvg__vset(dst, rx1, ry1, ru,1); dst++;
 	}
 
-	return dst;
+	return npts;
 }
 
-static NVGvertex* nvg__buttCapStart(NVGvertex* dst, NVGpoint* p,
-									float dx, float dy, float w, float d,
-									float aa, float u0, float u1)
+// Returns the view space rect that draws are clipped to, the viewport and the bounds of the current scissor.
+static void nvg__clipRect(NVGcontext* ctx, float* clip)
 {
-	float px = p->x - dx*d;
-	float py = p->y - dy*d;
-	float dlx = dy;
-	float dly = -dx;
-	nvg__vset(dst, px + dlx*w - dx*aa, py + dly*w - dy*aa, u0,0); dst++;
-	nvg__vset(dst, px - dlx*w - dx*aa, py - dly*w - dy*aa, u1,0); dst++;
-	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
-	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
-	return dst;
-}
+	NVGscissor* scissor = &nvg__getState(ctx)->scissor;
 
-static NVGvertex* nvg__buttCapEnd(NVGvertex* dst, NVGpoint* p,
-								  float dx, float dy, float w, float d,
-								  float aa, float u0, float u1)
-{
-	float px = p->x + dx*d;
-	float py = p->y + dy*d;
-	float dlx = dy;
-	float dly = -dx;
-	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
-	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
-	nvg__vset(dst, px + dlx*w + dx*aa, py + dly*w + dy*aa, u0,0); dst++;
-	nvg__vset(dst, px - dlx*w + dx*aa, py - dly*w + dy*aa, u1,0); dst++;
-	return dst;
+	clip[0] = 0.0f;
+	clip[1] = 0.0f;
+	clip[2] = ctx->viewWidth;
+	clip[3] = ctx->viewHeight;
+	if (scissor->extent[0] >= 0.0f) {
+		// Bounds of the transformed scissor rect, the scissor edge is soft over half a pixel.
+		float* t = scissor->xform;
+		float ex = nvg__absf(t[0])*scissor->extent[0] + nvg__absf(t[2])*scissor->extent[1] + ctx->fringeWidth;
+		float ey = nvg__absf(t[1])*scissor->extent[0] + nvg__absf(t[3])*scissor->extent[1] + ctx->fringeWidth;
+		clip[0] = nvg__maxf(clip[0], t[4] - ex);
+		clip[1] = nvg__maxf(clip[1], t[5] - ey);
+		clip[2] = nvg__minf(clip[2], t[4] + ex);
+		clip[3] = nvg__minf(clip[3], t[5] + ey);
+	}
 }
 
-
-static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
-									 float dx, float dy, float w, int ncap,
-									 float aa, float u0, float u1)
+// Returns 1 and counts the draw as culled if the view space bounds, grown by pad,
+// are outside of the viewport or the current scissor.
+static int nvg__cullBounds(NVGcontext* ctx, const float* bounds, float pad)
 {
-	int i;
-	float px = p->x;
-	float py = p->y;
-	float dlx = dy;
-	float dly = -dx;
-	NVG_NOTUSED(aa);
-	for (i = 0; i < ncap; i++) {
-		float a = i/(float)(ncap-1)*NVG_PI;
-		float ax = cosf(a) * w, ay = sinf(a) * w;
-		nvg__vset(dst, px - dlx*ax - dx*ay, py - dly*ax - dy*ay, u0,1); dst++;
-		nvg__vset(dst, px, py, 0.5f,1); dst++;
+	float clip[4];
+
+	nvg__clipRect(ctx, clip);
+	if (bounds[2] + pad < clip[0] || bounds[0] - pad > clip[2] || bounds[3] + pad < clip[1] || bounds[1] - pad > clip[3]) {
+		ctx->culledCount++;
+		return 1;
 	}
-	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
-	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
-	return dst;
+	return 0;
 }
 
-static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
-								   float dx, float dy, float w, int ncap,
-								   float aa, float u0, float u1)
+void nvgFill(NVGcontext* ctx)
 {
+	NVGstate* state = nvg__getState(ctx);
+	const NVGpath* path;
+	NVGpaint fillPaint = state->fill;
+	float bounds[4];
+	double t0, t1;
 	int i;
-	float px = p->x;
-	float py = p->y;
-	float dlx = dy;
-	float dly = -dx;
-	NVG_NOTUSED(aa);
-	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
-	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
-	for (i = 0; i < ncap; i++) {
-		float a = i/(float)(ncap-1)*NVG_PI;
-		float ax = cosf(a) * w, ay = sinf(a) * w;
-		nvg__vset(dst, px, py, 0.5f,1); dst++;
-		nvg__vset(dst, px - dlx*ax + dx*ay, py - dly*ax + dy*ay, u0,1); dst++;
+
+	if (nvg__imagePending(ctx, fillPaint.image)) return;
+
+	NVG_TRACE_BEGIN("nvgFill");
+
+	// Apply global alpha
+	fillPaint.innerColor.a *= state->alpha;
+	fillPaint.outerColor.a *= state->alpha;
+
+	if (ctx->fastRectCommands > 0 && ctx->fastRectCommands == ctx->ncommands) {
+		float fringe = ctx->params.edgeAntiAlias && state->shapeAntiAlias ? ctx->fringeWidth : 0.0f;
+		bounds[0] = ctx->fastRect[0];
+		bounds[1] = ctx->fastRect[1];
+		bounds[2] = ctx->fastRect[0] + ctx->fastRect[2];
+		bounds[3] = ctx->fastRect[1] + ctx->fastRect[3];
+		if (!nvg__cullBounds(ctx, bounds, fringe)) {
+			ctx->params.renderRect(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, fringe,
+								   ctx->fastRect, ctx->fastRect[4]);
+			ctx->fillTriCount += 2;
+			ctx->drawCallCount++;
+		}
+		NVG_TRACE_END("nvgFill");
+		return;
 	}
-	return dst;
-}
 
+	if (nvg__commandBounds(ctx, bounds) == 0 || nvg__cullBounds(ctx, bounds, ctx->fringeWidth)) {
+		NVG_TRACE_END("nvgFill");
+		return;
+	}
 
-static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
-{
-	NVGpathCache* cache = ctx->cache;
-	int i, j;
-	float iw = 0.0f;
+	t0 = nvg__statsTime();
+	nvg__flattenPaths(ctx);
+	t1 = nvg__statsTime();
+	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
+		nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
+	else
+		nvg__expandFill(ctx, 0.0f, NVG_MITER, 2.4f);
+	ctx->flattenTime += t1 - t0;
+	ctx->expandTime += nvg__statsTime() - t1;
 
-	if (w > 0.0f) iw = 1.0f / w;
+	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
 
-	// Calculate which joins needs extra vertices to append, and gather vertex count.
-	for (i = 0; i < cache->npaths; i++) {
-		NVGpath* path = &cache->paths[i];
-		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0 = &pts[path->count-1];
-		NVGpoint* p1 = &pts[0];
-		int nleft = 0;
+	// Count triangles
+	for (i = 0; i < ctx->cache->npaths; i++) {
+		path = &ctx->cache->paths[i];
+		ctx->fillTriCount += path->triangulated ? path->nfill/3 : path->nfill-2;
+		ctx->fillTriCount += path->nstroke-2;
+		ctx->drawCallCount += 2;
+	}
 
-		path->nbevel = 0;
+	NVG_TRACE_END("nvgFill");
+}
 
-		for (j = 0; j < path->count; j++) {
-			float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
-			dlx0 = p0->dy;
-			dly0 = -p0->dx;
-			dlx1 = p1->dy;
-			dly1 = -p1->dx;
-			// Calculate extrusions
-			p1->dmx = (dlx0 + dlx1) * 0.5f;
-			p1->dmy = (dly0 + dly1) * 0.5f;
-			dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
-			if (dmr2 > 0.000001f) {
-				float scale = 1.0f / dmr2;
-				if (scale > 600.0f) {
-					scale = 600.0f;
-				}
-				p1->dmx *= scale;
-				p1->dmy *= scale;
-			}
+void nvgStroke(NVGcontext* ctx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float scale = nvg__getAverageScale(state->xform);
+	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
+	NVGpaint strokePaint = state->stroke;
+	const NVGpath* path;
+	float bounds[4], pad;
+	double t0, t1;
+	int i;
 
-			// Clear flags, but keep the corner.
-			p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+	if (nvg__imagePending(ctx, strokePaint.image)) return;
 
-			// Keep track of left turns.
-			cross = p1->dx * p0->dy - p0->dx * p1->dy;
-			if (cross > 0.0f) {
-				nleft++;
-				p1->flags |= NVG_PT_LEFT;
-			}
+	NVG_TRACE_BEGIN("nvgStroke");
 
-			// Calculate if we should use bevel or miter for inner join.
-			limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
-			if ((dmr2 * limit*limit) < 1.0f)
-				p1->flags |= NVG_PR_INNERBEVEL;
+	if (strokeWidth < ctx->fringeWidth) {
+		// If the stroke width is less than pixel size, use alpha to emulate coverage.
+		// Since coverage is area, scale by alpha*alpha.
+		float alpha = nvg__clampf(strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
+		strokePaint.innerColor.a *= alpha*alpha;
+		strokePaint.outerColor.a *= alpha*alpha;
+		strokeWidth = ctx->fringeWidth;
+	}
 
-			// Check to see if the corner needs to be beveled.
-			if (p1->flags & NVG_PT_CORNER) {
-				if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
-					p1->flags |= NVG_PT_BEVEL;
-				}
-			}
+	// Apply global alpha
+	strokePaint.innerColor.a *= state->alpha;
+	strokePaint.outerColor.a *= state->alpha;
+
+	// Square caps and bevels reach out at most sqrt(2) half widths on either axis, miters up to the limit.
+	pad = strokeWidth*0.5f * nvg__maxf(state->lineJoin == NVG_MITER ? state->miterLimit : 1.0f, 1.4143f) + ctx->fringeWidth;
+	if (nvg__commandBounds(ctx, bounds) == 0 || nvg__cullBounds(ctx, bounds, pad)) {
+		NVG_TRACE_END("nvgStroke");
+		return;
+	}
 
-			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
-				path->nbevel++;
+	t0 = nvg__statsTime();
+	nvg__flattenPaths(ctx);
+	t1 = nvg__statsTime();
 
-			p0 = p1++;
-		}
+	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
+		nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, state->lineCap, state->lineJoin, state->miterLimit);
+	else
+		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
+	ctx->flattenTime += t1 - t0;
+	ctx->expandTime += nvg__statsTime() - t1;
 
-		path->convex = (nleft == path->count) ? 1 : 0;
+	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
+
+	// Count triangles
+	for (i = 0; i < ctx->cache->npaths; i++) {
+		path = &ctx->cache->paths[i];
+		ctx->strokeTriCount += path->nstroke-2;
+		ctx->drawCallCount++;
 	}
-}
 
+	NVG_TRACE_END("nvgStroke");
+}
 
-static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap, int lineJoin, float miterLimit)
+static int nvg__storeCachedGeometry(NVGcontext* ctx, NVGcachedGeometry* geom, NVGpathCache* cache, const float* xform)
 {
-	NVGpathCache* cache = ctx->cache;
-	NVGvertex* verts;
-	NVGvertex* dst;
-	int cverts, i, j;
-	float aa = fringe;//ctx->fringeWidth;
-	float u0 = 0.0f, u1 = 1.0f;
-	int ncap = nvg__curveDivs(w, NVG_PI, ctx->tessTol);	// Calculate divisions per half circle.
+	int i, nverts = 0;
 
-	w += aa * 0.5f;
+	for (i = 0; i < cache->npaths; i++)
+		nverts += cache->paths[i].nfill + cache->paths[i].nstroke;
 
-	// Disable the gradient used for antialiasing when antialiasing is not used.
-	if (aa == 0.0f) {
-		u0 = 0.5f;
-		u1 = 0.5f;
+	if (cache->npaths > geom->cpaths) {
+		NVGpath* paths;
+		int cpaths = cache->npaths + geom->cpaths/2;
+		paths = (NVGpath*)nvg__realloc(&ctx->params.allocator, geom->paths, sizeof(NVGpath)*cpaths);
+		if (paths == NULL) return 0;
+		geom->paths = paths;
+		geom->cpaths = cpaths;
+	}
+	if (nverts > geom->cverts) {
+		NVGvertex* verts;
+		int cverts = nverts + geom->cverts/2;
+		verts = (NVGvertex*)nvg__realloc(&ctx->params.allocator, geom->verts, sizeof(NVGvertex)*cverts);
+		if (verts == NULL) return 0;
+		geom->verts = verts;
+		geom->cverts = cverts;
 	}
 
-	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
-
-	// Calculate max vertex usage.
-	cverts = 0;
+	// Copy the expanded vertices, and rebase the path pointers to the copy.
+	geom->nverts = 0;
 	for (i = 0; i < cache->npaths; i++) {
-		NVGpath* path = &cache->paths[i];
-		int loop = (path->closed == 0) ? 0 : 1;
-		if (lineJoin == NVG_ROUND)
-			cverts += (path->count + path->nbevel*(ncap+2) + 1) * 2; // plus one for loop
-		else
-			cverts += (path->count + path->nbevel*5 + 1) * 2; // plus one for loop
-		if (loop == 0) {
-			// space for caps
-			if (lineCap == NVG_ROUND) {
-				cverts += (ncap*2 + 2)*2;
-			} else {
-				cverts += (3+3)*2;
-			}
+		NVGpath* path = &geom->paths[i];
+		*path = cache->paths[i];
+		if (path->nfill > 0) {
+			memcpy(&geom->verts[geom->nverts], path->fill, sizeof(NVGvertex)*path->nfill);
+			path->fill = &geom->verts[geom->nverts];
+			geom->nverts += path->nfill;
+		} else {
+			path->fill = NULL;
+		}
+		if (path->nstroke > 0) {
+			memcpy(&geom->verts[geom->nverts], path->stroke, sizeof(NVGvertex)*path->nstroke);
+			path->stroke = &geom->verts[geom->nverts];
+			geom->nverts += path->nstroke;
+		} else {
+			path->stroke = NULL;
 		}
 	}
+	geom->npaths = cache->npaths;
+	memcpy(geom->bounds, cache->bounds, sizeof(float)*4);
+	memcpy(geom->xform, xform, sizeof(float)*6);
 
-	verts = nvg__allocTempVerts(ctx, cverts);
-	if (verts == NULL) return 0;
+	return 1;
+}
 
-	for (i = 0; i < cache->npaths; i++) {
-		NVGpath* path = &cache->paths[i];
-		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0;
-		NVGpoint* p1;
-		int s, e, loop;
-		float dx, dy;
+static void nvg__tesselateCachedPath(NVGcontext* ctx, NVGcachedPath* cp, NVGcachedGeometry* geom, const float* xform,
+									 int stroke, float w, float fringe, int lineCap, int lineJoin, float miterLimit)
+{
+	NVGpathCache* cache = ctx->cache;
+	float* commands = ctx->commands;
+	int ncommands = ctx->ncommands;
+	double t0, t1;
+
+	// Temporarily swap in the cached path, so that the regular path functions can be used.
+	ctx->cache = cp->cache;
+	t0 = nvg__statsTime();
+	if (!cp->flattened || cp->tessTol != ctx->tessTol || memcmp(cp->xform, xform, sizeof(float)*6) != 0) {
+		memcpy(cp->tcommands, cp->commands, sizeof(float)*cp->ncommands);
+		nvg__transformCommands(cp->tcommands, cp->ncommands, xform);
+		ctx->commands = cp->tcommands;
+		ctx->ncommands = cp->ncommands;
+		nvg__clearPathCache(ctx);
+		nvg__flattenPaths(ctx);
+		memcpy(cp->xform, xform, sizeof(float)*6);
+		cp->tessTol = ctx->tessTol;
+		cp->flattened = 1;
+	}
+	t1 = nvg__statsTime();
 
-		path->fill = 0;
-		path->nfill = 0;
+	if (stroke)
+		nvg__expandStroke(ctx, w, fringe, lineCap, lineJoin, miterLimit);
+	else
+		nvg__expandFill(ctx, fringe, NVG_MITER, 2.4f);
+	ctx->flattenTime += t1 - t0;
+	ctx->expandTime += nvg__statsTime() - t1;
 
-		// Calculate fringe or stroke
-		loop = (path->closed == 0) ? 0 : 1;
-		dst = verts;
-		path->stroke = dst;
+	geom->valid = nvg__storeCachedGeometry(ctx, geom, ctx->cache, xform);
 
-		if (loop) {
-			// Looping
-			p0 = &pts[path->count-1];
-			p1 = &pts[0];
-			s = 0;
-			e = path->count;
-		} else {
-			// Add cap
-			p0 = &pts[0];
-			p1 = &pts[1];
-			s = 1;
-			e = path->count-1;
-		}
+	ctx->cache = cache;
+	ctx->commands = commands;
+	ctx->ncommands = ncommands;
+}
 
-		if (loop == 0) {
-			// Add cap
-			dx = p1->x - p0->x;
-			dy = p1->y - p0->y;
-			nvg__normalize(&dx, &dy);
-			if (lineCap == NVG_BUTT)
-				dst = nvg__buttCapStart(dst, p0, dx, dy, w, -aa*0.5f, aa, u0, u1);
-			else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
-				dst = nvg__buttCapStart(dst, p0, dx, dy, w, w-aa, aa, u0, u1);
-			else if (lineCap == NVG_ROUND)
-				dst = nvg__roundCapStart(dst, p0, dx, dy, w, ncap, aa, u0, u1);
-		}
+// Calculates transform from the space the geometry was tesselated in to the current space,
+// returns 1 if the geometry can be reused with it.
+static int nvg__cachedGeometryReusable(NVGcontext* ctx, NVGcachedPath* cp, NVGcachedGeometry* geom, const float* xform, float* t)
+{
+	float sx, sy, skew;
 
-		for (j = s; j < e; ++j) {
-			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
-				if (lineJoin == NVG_ROUND) {
-					dst = nvg__roundJoin(dst, p0, p1, w, w, u0, u1, ncap, aa);
-				} else {
-					dst = nvg__bevelJoin(dst, p0, p1, w, w, u0, u1, aa);
-				}
-			} else {
-				nvg__vset(dst, p1->x + (p1->dmx * w), p1->y + (p1->dmy * w), u0,1); dst++;
-				nvg__vset(dst, p1->x - (p1->dmx * w), p1->y - (p1->dmy * w), u1,1); dst++;
-			}
-			p0 = p1++;
-		}
+	if (!geom->valid || !cp->flattened || cp->tessTol != ctx->tessTol)
+		return 0;
+	if (memcmp(geom->xform, xform, sizeof(float)*6) == 0) {
+		nvgTransformIdentity(t);
+		return 1;
+	}
+	if (!nvgTransformInverse(t, geom->xform))
+		return 0;
+	nvgTransformMultiply(t, xform);
+
+	// Rotation and translation do not change the tesselation, scale and skew change AA fringe and curve subdivision.
+	sx = nvg__sqrtf(t[0]*t[0] + t[1]*t[1]);
+	sy = nvg__sqrtf(t[2]*t[2] + t[3]*t[3]);
+	skew = t[0]*t[2] + t[1]*t[3];
+	return nvg__absf(sx - 1.0f) <= NVG_CACHED_PATH_SCALE_TOL
+		&& nvg__absf(sy - 1.0f) <= NVG_CACHED_PATH_SCALE_TOL
+		&& nvg__absf(skew) <= NVG_CACHED_PATH_SCALE_TOL;
+}
+
+static void nvg__transformVerts(NVGvertex* dst, const NVGvertex* src, int nverts, const float* t)
+{
+	int i = 0;
+#if NVG_SIMD
+	nvg__v4 t0 = nvg__v4set(t[0], t[1], 0.0f, 0.0f);
+	nvg__v4 t1 = nvg__v4set(t[2], t[3], 0.0f, 0.0f);
+	nvg__v4 t2 = nvg__v4set(t[4], t[5], 0.0f, 0.0f);
+	for (; i < nverts; i++) {
+		nvg__v4 v = nvg__v4load(&src[i].x);
+		nvg__v4 r = nvg__v4add(nvg__v4add(nvg__v4mul(nvg__v4xx(v), t0), nvg__v4mul(nvg__v4yy(v), t1)), t2);
+		// Keep the texture coordinates.
+		nvg__v4store(&dst[i].x, nvg__v4lohi(r, v));
+	}
+#endif
+	for (; i < nverts; i++) {
+		nvgTransformPoint(&dst[i].x, &dst[i].y, t, src[i].x, src[i].y);
+		dst[i].u = src[i].u;
+		dst[i].v = src[i].v;
+	}
+}
 
-		if (loop) {
-			// Loop it
-			nvg__vset(dst, verts[0].x, verts[0].y, u0,1); dst++;
-			nvg__vset(dst, verts[1].x, verts[1].y, u1,1); dst++;
-		} else {
-			// Add cap
-			dx = p1->x - p0->x;
-			dy = p1->y - p0->y;
-			nvg__normalize(&dx, &dy);
-			if (lineCap == NVG_BUTT)
-				dst = nvg__buttCapEnd(dst, p1, dx, dy, w, -aa*0.5f, aa, u0, u1);
-			else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
-				dst = nvg__buttCapEnd(dst, p1, dx, dy, w, w-aa, aa, u0, u1);
-			else if (lineCap == NVG_ROUND)
-				dst = nvg__roundCapEnd(dst, p1, dx, dy, w, ncap, aa, u0, u1);
-		}
+static const NVGpath* nvg__transformCachedGeometry(NVGcontext* ctx, NVGcachedPath* cp, NVGcachedGeometry* geom, const float* t, float* bounds)
+{
+	NVGvertex* verts;
+	float x, y;
+	int i;
 
-		path->nstroke = (int)(dst - verts);
+	if (t[0] == 1.0f && t[1] == 0.0f && t[2] == 0.0f && t[3] == 1.0f && t[4] == 0.0f && t[5] == 0.0f) {
+		memcpy(bounds, geom->bounds, sizeof(float)*4);
+		return geom->paths;
+	}
 
-		verts = dst;
+	if (geom->npaths > cp->cpaths) {
+		NVGpath* paths;
+		int cpaths = geom->npaths + cp->cpaths/2;
+		paths = (NVGpath*)nvg__realloc(&ctx->params.allocator, cp->paths, sizeof(NVGpath)*cpaths);
+		if (paths == NULL) return NULL;
+		cp->paths = paths;
+		cp->cpaths = cpaths;
+	}
+	verts = nvg__allocTempVerts(ctx, geom->nverts);
+	if (verts == NULL) return NULL;
+
+	nvg__transformVerts(verts, geom->verts, geom->nverts, t);
+	for (i = 0; i < geom->npaths; i++) {
+		NVGpath* path = &cp->paths[i];
+		*path = geom->paths[i];
+		if (path->fill != NULL)
+			path->fill = verts + (geom->paths[i].fill - geom->verts);
+		if (path->stroke != NULL)
+			path->stroke = verts + (geom->paths[i].stroke - geom->verts);
 	}
 
-	return 1;
+	bounds[0] = bounds[1] = 1e6f;
+	bounds[2] = bounds[3] = -1e6f;
+	for (i = 0; i < 4; i++) {
+		nvgTransformPoint(&x, &y, t, geom->bounds[(i & 1) ? 2 : 0], geom->bounds[(i & 2) ? 3 : 1]);
+		bounds[0] = nvg__minf(bounds[0], x);
+		bounds[1] = nvg__minf(bounds[1], y);
+		bounds[2] = nvg__maxf(bounds[2], x);
+		bounds[3] = nvg__maxf(bounds[3], y);
+	}
+
+	return cp->paths;
 }
 
-static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
+NVGcachedPath* nvgCreateCachedPath(NVGcontext* ctx)
 {
-	NVGpathCache* cache = ctx->cache;
-	NVGvertex* verts;
-	NVGvertex* dst;
-	int cverts, convex, i, j;
-	float aa = ctx->fringeWidth;
-	int fringe = w > 0.0f;
+	NVGstate* state = nvg__getState(ctx);
+	NVGcachedPath* cp;
+	float inv[6];
 
-	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+	cp = (NVGcachedPath*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGcachedPath));
+	if (cp == NULL) goto error;
+	memset(cp, 0, sizeof(NVGcachedPath));
 
-	// Calculate max vertex usage.
-	cverts = 0;
-	for (i = 0; i < cache->npaths; i++) {
-		NVGpath* path = &cache->paths[i];
-		cverts += path->count + path->nbevel + 1;
-		if (fringe)
-			cverts += (path->count + path->nbevel*5 + 1) * 2; // plus one for loop
-	}
+	cp->commands = (float*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(float)*nvg__maxi(ctx->ncommands, 1));
+	if (cp->commands == NULL) goto error;
+	cp->tcommands = (float*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(float)*nvg__maxi(ctx->ncommands, 1));
+	if (cp->tcommands == NULL) goto error;
+	cp->cache = nvg__allocPathCache(ctx, 0);
+	if (cp->cache == NULL) goto error;
 
-	verts = nvg__allocTempVerts(ctx, cverts);
-	if (verts == NULL) return 0;
+	// The path is stored in local space, it is transformed by the current transform when drawn.
+	memcpy(cp->commands, ctx->commands, sizeof(float)*ctx->ncommands);
+	cp->ncommands = ctx->ncommands;
+	nvgTransformInverse(inv, state->xform);
+	nvg__transformCommands(cp->commands, cp->ncommands, inv);
 
-	convex = cache->npaths == 1 && cache->paths[0].convex;
+	return cp;
 
-	for (i = 0; i < cache->npaths; i++) {
-		NVGpath* path = &cache->paths[i];
-		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0;
-		NVGpoint* p1;
-		float rw, lw, woff;
-		float ru, lu;
+error:
+	nvgDeleteCachedPath(ctx, cp);
+	return NULL;
+}
 
-		// Calculate shape vertices.
-		woff = 0.5f*aa;
-		dst = verts;
-		path->fill = dst;
+void nvgDeleteCachedPath(NVGcontext* ctx, NVGcachedPath* cp)
+{
+	NVGallocator* alloc = &ctx->params.allocator;
+	if (cp == NULL) return;
+	if (cp->cache != NULL) nvg__deletePathCache(ctx, cp->cache);
+	nvg__free(alloc, cp->commands);
+	nvg__free(alloc, cp->tcommands);
+	nvg__free(alloc, cp->fill.paths);
+	nvg__free(alloc, cp->fill.verts);
+	nvg__free(alloc, cp->stroke.paths);
+	nvg__free(alloc, cp->stroke.verts);
+	nvg__free(alloc, cp->paths);
+	nvg__free(alloc, cp);
+}
 
-		if (fringe) {
-			// Looping
-			p0 = &pts[path->count-1];
-			p1 = &pts[0];
-			for (j = 0; j < path->count; ++j) {
-				if (p1->flags & NVG_PT_BEVEL) {
-					float dlx0 = p0->dy;
-					float dly0 = -p0->dx;
-					float dlx1 = p1->dy;
-					float dly1 = -p1->dx;
-					if (p1->flags & NVG_PT_LEFT) {
-						float lx = p1->x + p1->dmx * woff;
-						float ly = p1->y + p1->dmy * woff;
-						nvg__vset(dst, lx, ly, 0.5f,1); dst++;
-					} else {
-						float lx0 = p1->x + dlx0 * woff;
-						float ly0 = p1->y + dly0 * woff;
-						float lx1 = p1->x + dlx1 * woff;
-						float ly1 = p1->y + dly1 * woff;
-						nvg__vset(dst, lx0, ly0, 0.5f,1); dst++;
-						nvg__vset(dst, lx1, ly1, 0.5f,1); dst++;
-					}
-				} else {
-					nvg__vset(dst, p1->x + (p1->dmx * woff), p1->y + (p1->dmy * woff), 0.5f,1); dst++;
-				}
-				p0 = p1++;
-			}
-		} else {
-			for (j = 0; j < path->count; ++j) {
-				nvg__vset(dst, pts[j].x, pts[j].y, 0.5f,1);
-				dst++;
-			}
-		}
+void nvgFillCachedPath(NVGcontext* ctx, NVGcachedPath* cp)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGcachedGeometry* geom = &cp->fill;
+	NVGpaint fillPaint = state->fill;
+	const NVGpath* paths;
+	const NVGpath* path;
+	float fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	float t[6], bounds[4];
+	int i;
 
-		path->nfill = (int)(dst - verts);
-		verts = dst;
+	if (nvg__imagePending(ctx, fillPaint.image)) return;
 
-		// Calculate fringe
-		if (fringe) {
-			lw = w + woff;
-			rw = w - woff;
-			lu = 0;
-			ru = 1;
-			dst = verts;
-			path->stroke = dst;
+	if (geom->fringe != fringe || !nvg__cachedGeometryReusable(ctx, cp, geom, state->xform, t)) {
+		nvg__tesselateCachedPath(ctx, cp, geom, state->xform, 0, 0.0f, fringe, 0, 0, 0.0f);
+		if (!geom->valid) return;
+		geom->fringe = fringe;
+		nvgTransformIdentity(t);
+	}
+
+	paths = nvg__transformCachedGeometry(ctx, cp, geom, t, bounds);
+	if (paths == NULL) return;
+
+	// Apply global alpha
+	fillPaint.innerColor.a *= state->alpha;
+	fillPaint.outerColor.a *= state->alpha;
+
+	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+						   bounds, paths, geom->npaths);
+
+	// Count triangles
+	for (i = 0; i < geom->npaths; i++) {
+		path = &paths[i];
+		ctx->fillTriCount += path->triangulated ? path->nfill/3 : path->nfill-2;
+		ctx->fillTriCount += path->nstroke-2;
+		ctx->drawCallCount += 2;
+	}
+}
+
+void nvgStrokeCachedPath(NVGcontext* ctx, NVGcachedPath* cp)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGcachedGeometry* geom = &cp->stroke;
+	float scale = nvg__getAverageScale(state->xform);
+	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
+	float fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	NVGpaint strokePaint = state->stroke;
+	const NVGpath* paths;
+	const NVGpath* path;
+	float t[6], bounds[4];
+	int i;
 
-			// Create only half a fringe for convex shapes so that
-			// the shape can be rendered without stenciling.
-			if (convex) {
-				lw = woff;	// This should generate the same vertex as fill inset above.
-				lu = 0.5f;	// Set outline fade at middle.
-			}
+	if (nvg__imagePending(ctx, strokePaint.image)) return;
 
-			// Looping
-			p0 = &pts[path->count-1];
-			p1 = &pts[0];
+	if (strokeWidth < ctx->fringeWidth) {
+		// If the stroke width is less than pixel size, use alpha to emulate coverage.
+		// Since coverage is area, scale by alpha*alpha.
+		float alpha = nvg__clampf(strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
+		strokePaint.innerColor.a *= alpha*alpha;
+		strokePaint.outerColor.a *= alpha*alpha;
+		strokeWidth = ctx->fringeWidth;
+	}
 
-			for (j = 0; j < path->count; ++j) {
-				if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
-					dst = nvg__bevelJoin(dst, p0, p1, lw, rw, lu, ru, ctx->fringeWidth);
-				} else {
-					nvg__vset(dst, p1->x + (p1->dmx * lw), p1->y + (p1->dmy * lw), lu,1); dst++;
-					nvg__vset(dst, p1->x - (p1->dmx * rw), p1->y - (p1->dmy * rw), ru,1); dst++;
-				}
-				p0 = p1++;
-			}
+	// Apply global alpha
+	strokePaint.innerColor.a *= state->alpha;
+	strokePaint.outerColor.a *= state->alpha;
 
-			// Loop it
-			nvg__vset(dst, verts[0].x, verts[0].y, lu,1); dst++;
-			nvg__vset(dst, verts[1].x, verts[1].y, ru,1); dst++;
+	if (geom->fringe != fringe || geom->strokeWidth != state->strokeWidth || geom->lineCap != state->lineCap ||
+		geom->lineJoin != state->lineJoin || geom->miterLimit != state->miterLimit ||
+		!nvg__cachedGeometryReusable(ctx, cp, geom, state->xform, t)) {
+		nvg__tesselateCachedPath(ctx, cp, geom, state->xform, 1, strokeWidth*0.5f, fringe,
+								 state->lineCap, state->lineJoin, state->miterLimit);
+		if (!geom->valid) return;
+		geom->fringe = fringe;
+		geom->strokeWidth = state->strokeWidth;
+		geom->lineCap = state->lineCap;
+		geom->lineJoin = state->lineJoin;
+		geom->miterLimit = state->miterLimit;
+		nvgTransformIdentity(t);
+	}
 
-			path->nstroke = (int)(dst - verts);
-			verts = dst;
-		} else {
-			path->stroke = NULL;
-			path->nstroke = 0;
-		}
+	paths = nvg__transformCachedGeometry(ctx, cp, geom, t, bounds);
+	if (paths == NULL) return;
+
+	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+							 strokeWidth, paths, geom->npaths);
+
+	// Count triangles
+	for (i = 0; i < geom->npaths; i++) {
+		path = &paths[i];
+		ctx->strokeTriCount += path->nstroke-2;
+		ctx->drawCallCount++;
 	}
+}
 
+// Recording back-end
+static int nvg__recorderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
 	return 1;
 }
 
-
-// Draw
-void nvgBeginPath(NVGcontext* ctx)
+static int nvg__recorderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
 {
-	ctx->ncommands = 0;
-	nvg__clearPathCache(ctx);
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	NVG_NOTUSED(type); NVG_NOTUSED(w); NVG_NOTUSED(h); NVG_NOTUSED(imageFlags); NVG_NOTUSED(data);
+	// Negative handles mark the textures which exist only in the recording context.
+	return -(++rec->ntextures);
 }
 
-void nvgMoveTo(NVGcontext* ctx, float x, float y)
+static int nvg__recorderDeleteTexture(void* uptr, int image)
 {
-	float vals[] = { NVG_MOVETO, x, y };
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image);
+	return 1;
 }
 
-void nvgLineTo(NVGcontext* ctx, float x, float y)
+static int nvg__recorderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
 {
-	float vals[] = { NVG_LINETO, x, y };
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image); NVG_NOTUSED(x); NVG_NOTUSED(y); NVG_NOTUSED(w); NVG_NOTUSED(h); NVG_NOTUSED(data);
+	return 1;
 }
 
-void nvgBezierTo(NVGcontext* ctx, float c1x, float c1y, float c2x, float c2y, float x, float y)
+static int nvg__recorderGetTextureSize(void* uptr, int image, int* w, int* h)
 {
-	float vals[] = { NVG_BEZIERTO, c1x, c1y, c2x, c2y, x, y };
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image); NVG_NOTUSED(w); NVG_NOTUSED(h);
+	return 0;
 }
 
-void nvgQuadTo(NVGcontext* ctx, float cx, float cy, float x, float y)
+static void nvg__clearCommandList(NVGcommandList* list)
 {
-    float x0 = ctx->commandx;
-    float y0 = ctx->commandy;
-    float vals[] = { NVG_BEZIERTO,
-        x0 + 2.0f/3.0f*(cx - x0), y0 + 2.0f/3.0f*(cy - y0),
-        x + 2.0f/3.0f*(cx - x), y + 2.0f/3.0f*(cy - y),
-        x, y };
-    nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	list->ncalls = 0;
+	list->npaths = 0;
+	list->nverts = 0;
 }
 
-void nvgArcTo(NVGcontext* ctx, float x1, float y1, float x2, float y2, float radius)
+static void nvg__recorderViewport(void* uptr, float width, float height, float devicePixelRatio)
 {
-	float x0 = ctx->commandx;
-	float y0 = ctx->commandy;
-	float dx0,dy0, dx1,dy1, a, d, cx,cy, a0,a1;
-	int dir;
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	NVG_NOTUSED(width); NVG_NOTUSED(height); NVG_NOTUSED(devicePixelRatio);
+	if (rec->list != NULL)
+		nvg__clearCommandList(rec->list);
+}
 
-	if (ctx->ncommands == 0) {
-		return;
-	}
+static void nvg__recorderCancel(void* uptr)
+{
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	if (rec->list != NULL)
+		nvg__clearCommandList(rec->list);
+}
 
-	// Handle degenerate cases.
-	if (nvg__ptEquals(x0,y0, x1,y1, ctx->distTol) ||
-		nvg__ptEquals(x1,y1, x2,y2, ctx->distTol) ||
-		nvg__distPtSeg(x1,y1, x0,y0, x2,y2) < ctx->distTol*ctx->distTol ||
-		radius < ctx->distTol) {
-		nvgLineTo(ctx, x1,y1);
-		return;
+// Resolves the path vertex pointers, once the vertex array does not move anymore.
+static void nvg__resolveCommandList(NVGcommandList* list)
+{
+	int i;
+	for (i = 0; i < list->npaths; i++) {
+		NVGpath* path = &list->paths[i];
+		path->fill = path->nfill > 0 ? &list->verts[list->pathVerts[i*2+0]] : NULL;
+		path->stroke = path->nstroke > 0 ? &list->verts[list->pathVerts[i*2+1]] : NULL;
 	}
+}
 
-	// Calculate tangential circle to lines (x0,y0)-(x1,y1) and (x1,y1)-(x2,y2).
-	dx0 = x0-x1;
-	dy0 = y0-y1;
-	dx1 = x2-x1;
-	dy1 = y2-y1;
-	nvg__normalize(&dx0,&dy0);
-	nvg__normalize(&dx1,&dy1);
-	a = nvg__acosf(dx0*dx1 + dy0*dy1);
-	d = radius / nvg__tanf(a/2.0f);
+static void nvg__recorderFlush(void* uptr)
+{
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	if (rec->list == NULL) return;
+	nvg__resolveCommandList(rec->list);
+}
 
-//	printf("a=%f° d=%f\n", a/NVG_PI*180.0f, d);
+// Returns true if the call is not recorded. Text and images of the recording context use its own
+// textures, which do not exist in the rendering context.
+static int nvg__recorderSkip(NVGrecorder* rec, NVGpaint* paint)
+{
+	if (rec->list == NULL) return 1;
+	if (paint->image >= 0) return 0;
+#ifdef DEBUG
+	if (!rec->warned)
+		printf("Text and images of a recording context are not recorded.\n");
+#endif
+	rec->warned = 1;
+	return 1;
+}
 
-	if (d > 10000.0f) {
-		nvgLineTo(ctx, x1,y1);
-		return;
+static NVGrecordedCall* nvg__recordCall(NVGcommandList* list, int type, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+										NVGscissor* scissor, float fringe)
+{
+	NVGrecordedCall* call;
+	if (paint->image < 0) return NULL;
+	if (list->ncalls+1 > list->ccalls) {
+		NVGrecordedCall* calls;
+		int ccalls = nvg__maxi(list->ncalls+1, 128) + list->ccalls/2; // 1.5x Overallocate
+		calls = (NVGrecordedCall*)nvg__realloc(&list->allocator, list->calls, sizeof(NVGrecordedCall)*ccalls);
+		if (calls == NULL) return NULL;
+		list->calls = calls;
+		list->ccalls = ccalls;
 	}
-
-	if (nvg__cross(dx0,dy0, dx1,dy1) > 0.0f) {
-		cx = x1 + dx0*d + dy0*radius;
-		cy = y1 + dy0*d + -dx0*radius;
-		a0 = nvg__atan2f(dx0, -dy0);
-		a1 = nvg__atan2f(-dx1, dy1);
-		dir = NVG_CW;
-//		printf("CW c=(%f, %f) a0=%f° a1=%f°\n", cx, cy, a0/NVG_PI*180.0f, a1/NVG_PI*180.0f);
-	} else {
-		cx = x1 + dx0*d + -dy0*radius;
-		cy = y1 + dy0*d + dx0*radius;
-		a0 = nvg__atan2f(-dx0, dy0);
-		a1 = nvg__atan2f(dx1, -dy1);
-		dir = NVG_CCW;
-//		printf("CCW c=(%f, %f) a0=%f° a1=%f°\n", cx, cy, a0/NVG_PI*180.0f, a1/NVG_PI*180.0f);
+	call = &list->calls[list->ncalls];
+	memset(call, 0, sizeof(*call));
+	call->type = type;
+	call->paint = *paint;
+	call->compositeOperation = compositeOperation;
+	call->scissor = *scissor;
+	call->fringe = fringe;
+	return call;
+}
+
+static int nvg__recordVerts(NVGcommandList* list, const NVGvertex* verts, int nverts)
+{
+	int offset;
+	if (list->nverts+nverts > list->cverts) {
+		NVGvertex* dst;
+		int cverts = nvg__maxi(list->nverts+nverts, 4096) + list->cverts/2; // 1.5x Overallocate
+		dst = (NVGvertex*)nvg__realloc(&list->allocator, list->verts, sizeof(NVGvertex)*cverts);
+		if (dst == NULL) return -1;
+		list->verts = dst;
+		list->cverts = cverts;
+	}
+	offset = list->nverts;
+	if (nverts > 0)
+		memcpy(&list->verts[offset], verts, sizeof(NVGvertex)*nverts);
+	list->nverts += nverts;
+	return offset;
+}
+
+static int nvg__recordPaths(NVGcommandList* list, const NVGpath* paths, int npaths)
+{
+	int i, offset, nverts = list->nverts;
+	if (list->npaths+npaths > list->cpaths) {
+		NVGpath* dst;
+		int* pathVerts;
+		int cpaths = nvg__maxi(list->npaths+npaths, 128) + list->cpaths/2; // 1.5x Overallocate
+		dst = (NVGpath*)nvg__realloc(&list->allocator, list->paths, sizeof(NVGpath)*cpaths);
+		if (dst == NULL) return -1;
+		list->paths = dst;
+		pathVerts = (int*)nvg__realloc(&list->allocator, list->pathVerts, sizeof(int)*2*cpaths);
+		if (pathVerts == NULL) return -1;
+		list->pathVerts = pathVerts;
+		list->cpaths = cpaths;
+	}
+	offset = list->npaths;
+	for (i = 0; i < npaths; i++) {
+		int fill = nvg__recordVerts(list, paths[i].fill, paths[i].nfill);
+		int stroke = nvg__recordVerts(list, paths[i].stroke, paths[i].nstroke);
+		if (fill == -1 || stroke == -1) {
+			list->nverts = nverts;
+			return -1;
+		}
+		list->paths[offset+i] = paths[i];
+		list->pathVerts[(offset+i)*2+0] = fill;
+		list->pathVerts[(offset+i)*2+1] = stroke;
 	}
+	list->npaths += npaths;
+	return offset;
+}
 
-	nvgArc(ctx, cx, cy, radius, a0, a1, dir);
+static void nvg__recorderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							  const float* bounds, const NVGpath* paths, int npaths)
+{
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	NVGrecordedCall* call;
+	if (nvg__recorderSkip(rec, paint)) return;
+	call = nvg__recordCall(rec->list, NVG_RECORD_FILL, paint, compositeOperation, scissor, fringe);
+	if (call == NULL) return;
+	memcpy(call->bounds, bounds, sizeof(float)*4);
+	call->offset = nvg__recordPaths(rec->list, paths, npaths);
+	if (call->offset == -1) return;
+	call->count = npaths;
+	rec->list->ncalls++;
 }
 
-void nvgClosePath(NVGcontext* ctx)
+static void nvg__recorderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+								float strokeWidth, const NVGpath* paths, int npaths)
 {
-	float vals[] = { NVG_CLOSE };
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	NVGrecordedCall* call;
+	if (nvg__recorderSkip(rec, paint)) return;
+	call = nvg__recordCall(rec->list, NVG_RECORD_STROKE, paint, compositeOperation, scissor, fringe);
+	if (call == NULL) return;
+	call->strokeWidth = strokeWidth;
+	call->offset = nvg__recordPaths(rec->list, paths, npaths);
+	if (call->offset == -1) return;
+	call->count = npaths;
+	rec->list->ncalls++;
 }
 
-void nvgPathWinding(NVGcontext* ctx, int dir)
+static void nvg__recorderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts, float fringe)
 {
-	float vals[] = { NVG_WINDING, (float)dir };
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVGrecorder* rec = (NVGrecorder*)uptr;
+	NVGrecordedCall* call;
+	if (nvg__recorderSkip(rec, paint)) return;
+	call = nvg__recordCall(rec->list, NVG_RECORD_TRIANGLES, paint, compositeOperation, scissor, fringe);
+	if (call == NULL) return;
+	call->offset = nvg__recordVerts(rec->list, verts, nverts);
+	if (call->offset == -1) return;
+	call->count = nverts;
+	rec->list->ncalls++;
 }
 
-void nvgArc(NVGcontext* ctx, float cx, float cy, float r, float a0, float a1, int dir)
+static void nvg__recorderDelete(void* uptr)
 {
-	float a = 0, da = 0, hda = 0, kappa = 0;
-	float dx = 0, dy = 0, x = 0, y = 0, tanx = 0, tany = 0;
-	float px = 0, py = 0, ptanx = 0, ptany = 0;
-	float vals[3 + 5*7 + 100];
-	int i, ndivs, nvals;
-	int move = ctx->ncommands > 0 ? NVG_LINETO : NVG_MOVETO;
+	free(uptr);
+}
 
-	// Clamp angles
-	da = a1 - a0;
-	if (dir == NVG_CW) {
-		if (nvg__absf(da) >= NVG_PI*2) {
-			da = NVG_PI*2;
-		} else {
-			while (da < 0.0f) da += NVG_PI*2;
-		}
-	} else {
-		if (nvg__absf(da) >= NVG_PI*2) {
-			da = -NVG_PI*2;
-		} else {
-			while (da > 0.0f) da -= NVG_PI*2;
-		}
-	}
+NVGcontext* nvgCreateRecordingContext(int edgeAntiAlias)
+{
+	NVGparams params;
+	NVGcontext* ctx = NULL;
+	NVGrecorder* rec = (NVGrecorder*)malloc(sizeof(NVGrecorder));
+	if (rec == NULL) goto error;
+	memset(rec, 0, sizeof(NVGrecorder));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = nvg__recorderCreate;
+	params.renderCreateTexture = nvg__recorderCreateTexture;
+	params.renderDeleteTexture = nvg__recorderDeleteTexture;
+	params.renderUpdateTexture = nvg__recorderUpdateTexture;
+	params.renderGetTextureSize = nvg__recorderGetTextureSize;
+	params.renderViewport = nvg__recorderViewport;
+	params.renderCancel = nvg__recorderCancel;
+	params.renderFlush = nvg__recorderFlush;
+	params.renderFill = nvg__recorderFill;
+	params.renderStroke = nvg__recorderStroke;
+	params.renderTriangles = nvg__recorderTriangles;
+	params.renderDelete = nvg__recorderDelete;
+	params.userPtr = rec;
+	params.edgeAntiAlias = edgeAntiAlias;
+
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
 
-	// Split arc into max 90 degree segments.
-	ndivs = nvg__maxi(1, nvg__mini((int)(nvg__absf(da) / (NVG_PI*0.5f) + 0.5f), 5));
-	hda = (da / (float)ndivs) / 2.0f;
-	kappa = nvg__absf(4.0f / 3.0f * (1.0f - nvg__cosf(hda)) / nvg__sinf(hda));
+	return ctx;
 
-	if (dir == NVG_CCW)
-		kappa = -kappa;
+error:
+	// 'rec' is freed by nvgDeleteInternal.
+	if (ctx != NULL) nvgDeleteInternal(ctx);
+	return NULL;
+}
 
-	nvals = 0;
-	for (i = 0; i <= ndivs; i++) {
-		a = a0 + da * (i/(float)ndivs);
-		dx = nvg__cosf(a);
-		dy = nvg__sinf(a);
-		x = cx + dx*r;
-		y = cy + dy*r;
-		tanx = -dy*r*kappa;
-		tany = dx*r*kappa;
+void nvgDeleteRecordingContext(NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
 
-		if (i == 0) {
-			vals[nvals++] = (float)move;
-			vals[nvals++] = x;
-			vals[nvals++] = y;
-		} else {
-			vals[nvals++] = NVG_BEZIERTO;
-			vals[nvals++] = px+ptanx;
-			vals[nvals++] = py+ptany;
-			vals[nvals++] = x-tanx;
-			vals[nvals++] = y-tany;
-			vals[nvals++] = x;
-			vals[nvals++] = y;
-		}
-		px = x;
-		py = y;
-		ptanx = tanx;
-		ptany = tany;
+// Creates a command list whose memory comes from the allocator, NULL to use the heap.
+static NVGcommandList* nvg__createCommandList(const NVGallocator* alloc)
+{
+	NVGallocator heap;
+	NVGcommandList* list;
+	if (alloc == NULL) {
+		memset(&heap, 0, sizeof(heap));
+		alloc = &heap;
 	}
+	list = (NVGcommandList*)nvg__realloc(alloc, NULL, sizeof(NVGcommandList));
+	if (list == NULL) return NULL;
+	memset(list, 0, sizeof(NVGcommandList));
+	list->allocator = *alloc;
+	list->allocator.frameArenaSize = 0;
+	return list;
+}
 
-	nvg__appendCommands(ctx, vals, nvals);
+NVGcommandList* nvgCreateCommandList(void)
+{
+	return nvg__createCommandList(NULL);
 }
 
-void nvgRect(NVGcontext* ctx, float x, float y, float w, float h)
+void nvgDeleteCommandList(NVGcommandList* list)
 {
-	float vals[] = {
-		NVG_MOVETO, x,y,
-		NVG_LINETO, x,y+h,
-		NVG_LINETO, x+w,y+h,
-		NVG_LINETO, x+w,y,
-		NVG_CLOSE
-	};
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVGallocator alloc;
+	if (list == NULL) return;
+	alloc = list->allocator;
+	nvg__free(&alloc, list->calls);
+	nvg__free(&alloc, list->paths);
+	nvg__free(&alloc, list->pathVerts);
+	nvg__free(&alloc, list->verts);
+	nvg__free(&alloc, list);
 }
 
-void nvgRoundedRect(NVGcontext* ctx, float x, float y, float w, float h, float r)
+void nvgRecordCommandList(NVGcontext* ctx, NVGcommandList* list)
 {
-	nvgRoundedRectVarying(ctx, x, y, w, h, r, r, r, r);
+	NVGrecorder* rec = (NVGrecorder*)nvgInternalParams(ctx)->userPtr;
+	if (ctx->params.renderCreate != nvg__recorderCreate) return;
+	rec->list = list;
 }
 
-void nvgRoundedRectVarying(NVGcontext* ctx, float x, float y, float w, float h, float radTopLeft, float radTopRight, float radBottomRight, float radBottomLeft)
+// Fills a recorded rect as a path, for back-ends which do not draw rects.
+static void nvg__fillRecordedRect(NVGcontext* ctx, NVGrecordedCall* call)
 {
-	if(radTopLeft < 0.1f && radTopRight < 0.1f && radBottomRight < 0.1f && radBottomLeft < 0.1f) {
-		nvgRect(ctx, x, y, w, h);
-		return;
-	} else {
-		float halfw = nvg__absf(w)*0.5f;
-		float halfh = nvg__absf(h)*0.5f;
-		float rxBL = nvg__minf(radBottomLeft, halfw) * nvg__signf(w), ryBL = nvg__minf(radBottomLeft, halfh) * nvg__signf(h);
-		float rxBR = nvg__minf(radBottomRight, halfw) * nvg__signf(w), ryBR = nvg__minf(radBottomRight, halfh) * nvg__signf(h);
-		float rxTR = nvg__minf(radTopRight, halfw) * nvg__signf(w), ryTR = nvg__minf(radTopRight, halfh) * nvg__signf(h);
-		float rxTL = nvg__minf(radTopLeft, halfw) * nvg__signf(w), ryTL = nvg__minf(radTopLeft, halfh) * nvg__signf(h);
-		float vals[] = {
-			NVG_MOVETO, x, y + ryTL,
-			NVG_LINETO, x, y + h - ryBL,
-			NVG_BEZIERTO, x, y + h - ryBL*(1 - NVG_KAPPA90), x + rxBL*(1 - NVG_KAPPA90), y + h, x + rxBL, y + h,
-			NVG_LINETO, x + w - rxBR, y + h,
-			NVG_BEZIERTO, x + w - rxBR*(1 - NVG_KAPPA90), y + h, x + w, y + h - ryBR*(1 - NVG_KAPPA90), x + w, y + h - ryBR,
-			NVG_LINETO, x + w, y + ryTR,
-			NVG_BEZIERTO, x + w, y + ryTR*(1 - NVG_KAPPA90), x + w - rxTR*(1 - NVG_KAPPA90), y, x + w - rxTR, y,
-			NVG_LINETO, x + rxTL, y,
-			NVG_BEZIERTO, x + rxTL*(1 - NVG_KAPPA90), y, x, y + ryTL*(1 - NVG_KAPPA90), x, y + ryTL,
-			NVG_CLOSE
-		};
-		nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	NVGstate* state;
+	if (ctx->nstates >= NVG_MAX_STATES) return;
+	nvgSave(ctx);
+	nvgReset(ctx);
+	state = nvg__getState(ctx);
+	state->fill = call->paint;
+	state->compositeOperation = call->compositeOperation;
+	state->scissor = call->scissor;
+	state->shapeAntiAlias = call->fringe > 0.0f;
+	nvgBeginPath(ctx);
+	nvgRoundedRect(ctx, call->bounds[0], call->bounds[1], call->bounds[2], call->bounds[3], call->radius);
+	nvgFill(ctx);
+	nvgRestore(ctx);
+}
+
+// Draws recorded quads as triangles, for back-ends which do not draw quads.
+static void nvg__drawRecordedQuads(NVGcontext* ctx, NVGrecordedCall* call, const NVGvertex* quads)
+{
+	NVGvertex* verts = nvg__allocTempVerts(ctx, call->count*6);
+	NVGvertex* vtx = verts;
+	int i;
+	if (verts == NULL) return;
+	for (i = 0; i < call->count; i++) {
+		const NVGvertex* v0 = &quads[i*2];
+		const NVGvertex* v1 = &quads[i*2+1];
+		nvg__vset(&vtx[0], v0->x, v0->y, v0->u, v0->v);
+		nvg__vset(&vtx[1], v1->x, v1->y, v1->u, v1->v);
+		nvg__vset(&vtx[2], v1->x, v0->y, v1->u, v0->v);
+		nvg__vset(&vtx[3], v0->x, v0->y, v0->u, v0->v);
+		nvg__vset(&vtx[4], v0->x, v1->y, v0->u, v1->v);
+		nvg__vset(&vtx[5], v1->x, v1->y, v1->u, v1->v);
+		vtx += 6;
+	}
+	ctx->params.renderTriangles(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor,
+								verts, call->count*6, call->fringe);
+}
+
+void nvgSubmitCommandList(NVGcontext* ctx, NVGcommandList* list)
+{
+	int i, j;
+	for (i = 0; i < list->ncalls; i++) {
+		NVGrecordedCall* call = &list->calls[i];
+		const NVGpath* paths = call->type == NVG_RECORD_FILL || call->type == NVG_RECORD_STROKE ? &list->paths[call->offset] : NULL;
+		if (nvg__imagePending(ctx, call->paint.image)) continue;
+		if (call->type == NVG_RECORD_FILL) {
+			ctx->params.renderFill(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor, call->fringe,
+								   call->bounds, paths, call->count);
+			for (j = 0; j < call->count; j++) {
+				ctx->fillTriCount += paths[j].triangulated ? paths[j].nfill/3 : paths[j].nfill-2;
+				ctx->fillTriCount += paths[j].nstroke-2;
+				ctx->drawCallCount += 2;
+			}
+		} else if (call->type == NVG_RECORD_STROKE) {
+			ctx->params.renderStroke(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor, call->fringe,
+									 call->strokeWidth, paths, call->count);
+			for (j = 0; j < call->count; j++) {
+				ctx->strokeTriCount += paths[j].nstroke-2;
+				ctx->drawCallCount++;
+			}
+		} else if (call->type == NVG_RECORD_TRIANGLES) {
+			ctx->params.renderTriangles(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor,
+										&list->verts[call->offset], call->count, call->fringe);
+			ctx->textTriCount += call->count/3;
+			ctx->drawCallCount++;
+		} else if (call->type == NVG_RECORD_QUADS) {
+			if (ctx->params.renderQuads != NULL)
+				ctx->params.renderQuads(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor,
+										&list->verts[call->offset], call->count, call->fringe);
+			else
+				nvg__drawRecordedQuads(ctx, call, &list->verts[call->offset]);
+			ctx->textTriCount += call->count*2;
+			ctx->drawCallCount++;
+		} else if (call->type == NVG_RECORD_RECT) {
+			if (ctx->params.renderRect != NULL) {
+				ctx->params.renderRect(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor, call->fringe,
+									   call->bounds, call->radius);
+				ctx->fillTriCount += 2;
+				ctx->drawCallCount++;
+			} else {
+				nvg__fillRecordedRect(ctx, call);
+			}
+		}
 	}
 }
 
-void nvgEllipse(NVGcontext* ctx, float cx, float cy, float rx, float ry)
+// Frame capture
+void nvgCaptureFrame(NVGcontext* ctx)
 {
-	float vals[] = {
-		NVG_MOVETO, cx-rx, cy,
-		NVG_BEZIERTO, cx-rx, cy+ry*NVG_KAPPA90, cx-rx*NVG_KAPPA90, cy+ry, cx, cy+ry,
-		NVG_BEZIERTO, cx+rx*NVG_KAPPA90, cy+ry, cx+rx, cy+ry*NVG_KAPPA90, cx+rx, cy,
-		NVG_BEZIERTO, cx+rx, cy-ry*NVG_KAPPA90, cx+rx*NVG_KAPPA90, cy-ry, cx, cy-ry,
-		NVG_BEZIERTO, cx-rx*NVG_KAPPA90, cy-ry, cx-rx, cy-ry*NVG_KAPPA90, cx-rx, cy,
-		NVG_CLOSE
-	};
-	nvg__appendCommands(ctx, vals, NVG_COUNTOF(vals));
+	if (ctx->capture == NULL) {
+		ctx->capture = (NVGcapturer*)nvg__realloc(&ctx->params.allocator, NULL, sizeof(NVGcapturer));
+		if (ctx->capture == NULL) return;
+		memset(ctx->capture, 0, sizeof(NVGcapturer));
+	}
+	if (ctx->capture->state == NVG_CAPTURE_IDLE)
+		ctx->capture->state = NVG_CAPTURE_ARMED;
 }
 
-void nvgCircle(NVGcontext* ctx, float cx, float cy, float r)
+const unsigned char* nvgCaptureData(NVGcontext* ctx, int* ndata)
 {
-	nvgEllipse(ctx, cx,cy, r,r);
+	NVGcapturer* cap = ctx->capture;
+	*ndata = 0;
+	if (cap == NULL || cap->state != NVG_CAPTURE_IDLE || cap->ndata == 0)
+		return NULL;
+	*ndata = cap->ndata;
+	return cap->data;
 }
 
-void nvgDebugDumpPathCache(NVGcontext* ctx)
+int nvgSaveCapture(NVGcontext* ctx, const char* filename)
 {
-	const NVGpath* path;
-	int i, j;
+	int ndata;
+	const unsigned char* data = nvgCaptureData(ctx, &ndata);
+	FILE* fp;
+	size_t written;
+	if (data == NULL) return 0;
+	fp = fopen(filename, "wb");
+	if (fp == NULL) return 0;
+	written = fwrite(data, 1, ndata, fp);
+	if (fclose(fp) != 0) return 0;
+	return written == (size_t)ndata;
+}
 
-	printf("Dumping %d cached paths\n", ctx->cache->npaths);
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		printf(" - Path %d\n", i);
-		if (path->nfill) {
-			printf("   - fill: %d\n", path->nfill);
-			for (j = 0; j < path->nfill; j++)
-				printf("%f\t%f\n", path->fill[j].x, path->fill[j].y);
-		}
-		if (path->nstroke) {
-			printf("   - stroke: %d\n", path->nstroke);
-			for (j = 0; j < path->nstroke; j++)
-				printf("%f\t%f\n", path->stroke[j].x, path->stroke[j].y);
-		}
+struct NVGcaptureLoader {
+	const NVGallocator* allocator;
+	const unsigned char* data;
+	int ndata;
+	int pos;
+	int error;
+	NVGpath* paths;
+	int* pathVerts;
+	int cpaths;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+};
+typedef struct NVGcaptureLoader NVGcaptureLoader;
+
+static const unsigned char* nvg__readBytes(NVGcaptureLoader* ld, int n)
+{
+	const unsigned char* p;
+	if (ld->error || n < 0 || n > ld->ndata - ld->pos) {
+		ld->error = 1;
+		return NULL;
 	}
+	p = &ld->data[ld->pos];
+	ld->pos += n;
+	return p;
 }
 
-void nvgFill(NVGcontext* ctx)
+static int nvg__readInt(NVGcaptureLoader* ld)
 {
-	NVGstate* state = nvg__getState(ctx);
-	const NVGpath* path;
-	NVGpaint fillPaint = state->fill;
-	int i;
-
-	nvg__flattenPaths(ctx);
-	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-		nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
-	else
-		nvg__expandFill(ctx, 0.0f, NVG_MITER, 2.4f);
+	const unsigned char* b = nvg__readBytes(ld, 4);
+	if (b == NULL) return 0;
+	return (int)((unsigned int)b[0] | ((unsigned int)b[1] << 8) | ((unsigned int)b[2] << 16) | ((unsigned int)b[3] << 24));
+}
 
-	// Apply global alpha
-	fillPaint.innerColor.a *= state->alpha;
-	fillPaint.outerColor.a *= state->alpha;
+static void nvg__readFloats(NVGcaptureLoader* ld, float* v, int n)
+{
+	int i;
+	for (i = 0; i < n; i++) {
+		unsigned int u = (unsigned int)nvg__readInt(ld);
+		memcpy(&v[i], &u, 4);
+	}
+}
 
-	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
+// Reads vertices to the end of the temporary vertex array, returns offset of the first vertex.
+static int nvg__readVerts(NVGcaptureLoader* ld, int* nverts)
+{
+	int i, n = nvg__readInt(ld), offset = ld->nverts;
+	if (n < 0 || n > (ld->ndata - ld->pos) / 16) {
+		ld->error = 1;
+		return -1;
+	}
+	if (ld->nverts+n > ld->cverts) {
+		NVGvertex* verts;
+		int cverts = nvg__maxi(ld->nverts+n, 4096) + ld->cverts/2; // 1.5x Overallocate
+		verts = (NVGvertex*)nvg__realloc(ld->allocator, ld->verts, sizeof(NVGvertex)*cverts);
+		if (verts == NULL) {
+			ld->error = 1;
+			return -1;
+		}
+		ld->verts = verts;
+		ld->cverts = cverts;
+	}
+	for (i = 0; i < n; i++)
+		nvg__readFloats(ld, &ld->verts[offset+i].x, 4);
+	ld->nverts += n;
+	*nverts = n;
+	return offset;
+}
 
-	// Count triangles
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		ctx->fillTriCount += path->nfill-2;
-		ctx->fillTriCount += path->nstroke-2;
-		ctx->drawCallCount += 2;
+// Reads paths to the temporary path array, returns number of paths or -1 on error.
+static int nvg__readPaths(NVGcaptureLoader* ld)
+{
+	int i, npaths = nvg__readInt(ld);
+	if (npaths < 0 || npaths > (ld->ndata - ld->pos) / 36) {
+		ld->error = 1;
+		return -1;
+	}
+	if (npaths > ld->cpaths) {
+		NVGpath* paths;
+		int* pathVerts;
+		int cpaths = nvg__maxi(npaths, 128) + ld->cpaths/2; // 1.5x Overallocate
+		paths = (NVGpath*)nvg__realloc(ld->allocator, ld->paths, sizeof(NVGpath)*cpaths);
+		if (paths == NULL) goto error;
+		ld->paths = paths;
+		pathVerts = (int*)nvg__realloc(ld->allocator, ld->pathVerts, sizeof(int)*2*cpaths);
+		if (pathVerts == NULL) goto error;
+		ld->pathVerts = pathVerts;
+		ld->cpaths = cpaths;
+	}
+	ld->nverts = 0;
+	for (i = 0; i < npaths; i++) {
+		NVGpath* path = &ld->paths[i];
+		memset(path, 0, sizeof(NVGpath));
+		path->first = nvg__readInt(ld);
+		path->count = nvg__readInt(ld);
+		path->closed = (unsigned char)nvg__readInt(ld);
+		path->nbevel = nvg__readInt(ld);
+		path->winding = nvg__readInt(ld);
+		path->convex = nvg__readInt(ld);
+		path->triangulated = nvg__readInt(ld);
+		ld->pathVerts[i*2+0] = nvg__readVerts(ld, &path->nfill);
+		ld->pathVerts[i*2+1] = nvg__readVerts(ld, &path->nstroke);
+		if (ld->error) return -1;
 	}
+	// The vertex array does not move anymore.
+	for (i = 0; i < npaths; i++) {
+		ld->paths[i].fill = &ld->verts[ld->pathVerts[i*2+0]];
+		ld->paths[i].stroke = &ld->verts[ld->pathVerts[i*2+1]];
+	}
+	return npaths;
+
+error:
+	ld->error = 1;
+	return -1;
 }
 
-void nvgStroke(NVGcontext* ctx)
+static int nvg__findCaptureTexture(NVGcapture* cap, int id)
 {
-	NVGstate* state = nvg__getState(ctx);
-	float scale = nvg__getAverageScale(state->xform);
-	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
-	NVGpaint strokePaint = state->stroke;
-	const NVGpath* path;
 	int i;
+	// Search from the end, the handle of a deleted texture can be reused.
+	for (i = cap->ntextures-1; i >= 0; i--)
+		if (cap->textures[i].id == id)
+			return i;
+	return -1;
+}
 
+static NVGrecordedCall* nvg__readCall(NVGcaptureLoader* ld, NVGcapture* cap, int type)
+{
+	NVGpaint paint;
+	NVGcompositeOperationState op;
+	NVGscissor scissor;
+	float fringe;
+	int tex;
+
+	nvg__readFloats(ld, paint.xform, 6);
+	nvg__readFloats(ld, paint.extent, 2);
+	nvg__readFloats(ld, &paint.radius, 1);
+	nvg__readFloats(ld, &paint.feather, 1);
+	nvg__readFloats(ld, paint.innerColor.rgba, 4);
+	nvg__readFloats(ld, paint.outerColor.rgba, 4);
+	paint.image = nvg__readInt(ld);
+	op.srcRGB = nvg__readInt(ld);
+	op.dstRGB = nvg__readInt(ld);
+	op.srcAlpha = nvg__readInt(ld);
+	op.dstAlpha = nvg__readInt(ld);
+	nvg__readFloats(ld, scissor.xform, 6);
+	nvg__readFloats(ld, scissor.extent, 2);
+	nvg__readFloats(ld, &fringe, 1);
+	if (ld->error) return NULL;
+
+	tex = paint.image != 0 ? nvg__findCaptureTexture(cap, paint.image) : -1;
+	paint.image = tex != -1 ? cap->textures[tex].image : 0;
+	return nvg__recordCall(cap->list, type, &paint, op, &scissor, fringe);
+}
+
+static int nvg__readTexture(NVGcaptureLoader* ld, NVGcapture* cap)
+{
+	NVGparams* params = &cap->ctx->params;
+	NVGcaptureTexture* tex;
+	int id = nvg__readInt(ld);
+	int type = nvg__readInt(ld);
+	int w = nvg__readInt(ld);
+	int h = nvg__readInt(ld);
+	int imageFlags = nvg__readInt(ld);
+	int hasData = nvg__readInt(ld);
+	int size;
+	if (ld->error || nvgTextureBytes(type, 1, 1) == 0 || w <= 0 || h <= 0 || w > 16384 || h > 16384)
+		return 0;
+	size = nvgTextureBytes(type, w, h);
+
+	if (cap->ntextures+1 > cap->ctextures) {
+		NVGcaptureTexture* textures;
+		int ctextures = nvg__maxi(cap->ntextures+1, 16) + cap->ctextures/2; // 1.5x Overallocate
+		textures = (NVGcaptureTexture*)nvg__realloc(ld->allocator, cap->textures, sizeof(NVGcaptureTexture)*ctextures);
+		if (textures == NULL) return 0;
+		cap->textures = textures;
+		cap->ctextures = ctextures;
+	}
+	tex = &cap->textures[cap->ntextures];
+	memset(tex, 0, sizeof(*tex));
+	tex->id = id;
+	tex->type = type;
+	tex->width = w;
+	tex->height = h;
+	// The replay uploads from this copy, which holds the texture contents at the end of the frame.
+	tex->data = (unsigned char*)nvg__realloc(ld->allocator, NULL, size);
+	if (tex->data == NULL) return 0;
+	cap->ntextures++;
+	if (hasData) {
+		const unsigned char* data = nvg__readBytes(ld, size);
+		if (data == NULL) return 0;
+		memcpy(tex->data, data, size);
+	} else {
+		memset(tex->data, 0, size);
+	}
+	tex->image = params->renderCreateTexture(params->userPtr, type, w, h, imageFlags, tex->data);
+	return tex->image != 0;
+}
+
+static int nvg__readUpdate(NVGcaptureLoader* ld, NVGcapture* cap)
+{
+	NVGcaptureTexture* tex;
+	NVGcaptureUpdate* update;
+	int i, bpp, t = nvg__findCaptureTexture(cap, nvg__readInt(ld));
+	int x = nvg__readInt(ld);
+	int y = nvg__readInt(ld);
+	int w = nvg__readInt(ld);
+	int h = nvg__readInt(ld);
+	if (ld->error || t == -1) return 0;
+	tex = &cap->textures[t];
+	if (x < 0 || y < 0 || w <= 0 || h <= 0 || x > tex->width - w || y > tex->height - h || nvg__compressedTexture(tex->type))
+		return 0;
+	bpp = nvgTextureBytes(tex->type, 1, 1);
+	for (i = 0; i < h; i++) {
+		const unsigned char* row = nvg__readBytes(ld, w*bpp);
+		if (row == NULL) return 0;
+		memcpy(&tex->data[((y+i)*tex->width + x)*bpp], row, w*bpp);
+	}
 
-	if (strokeWidth < ctx->fringeWidth) {
-		// If the stroke width is less than pixel size, use alpha to emulate coverage.
-		// Since coverage is area, scale by alpha*alpha.
-		float alpha = nvg__clampf(strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
-		strokePaint.innerColor.a *= alpha*alpha;
-		strokePaint.outerColor.a *= alpha*alpha;
-		strokeWidth = ctx->fringeWidth;
+	if (cap->nupdates+1 > cap->cupdates) {
+		NVGcaptureUpdate* updates;
+		int cupdates = nvg__maxi(cap->nupdates+1, 16) + cap->cupdates/2; // 1.5x Overallocate
+		updates = (NVGcaptureUpdate*)nvg__realloc(ld->allocator, cap->updates, sizeof(NVGcaptureUpdate)*cupdates);
+		if (updates == NULL) return 0;
+		cap->updates = updates;
+		cap->cupdates = cupdates;
 	}
+	update = &cap->updates[cap->nupdates++];
+	update->texture = t;
+	update->x = x;
+	update->y = y;
+	update->w = w;
+	update->h = h;
+	return 1;
+}
 
-	// Apply global alpha
-	strokePaint.innerColor.a *= state->alpha;
-	strokePaint.outerColor.a *= state->alpha;
+static int nvg__readRecord(NVGcaptureLoader* ld, NVGcapture* cap, int type)
+{
+	NVGcommandList* list = cap->list;
+	NVGrecordedCall* call;
+	float viewport[3];
+	int n;
+
+	switch (type) {
+	case NVG_CAPTURE_VIEWPORT:
+		nvg__readFloats(ld, viewport, 3);
+		cap->width = viewport[0];
+		cap->height = viewport[1];
+		cap->devicePixelRatio = viewport[2];
+		return !ld->error;
+	case NVG_CAPTURE_CREATE_TEXTURE:
+		return nvg__readTexture(ld, cap);
+	case NVG_CAPTURE_DELETE_TEXTURE:
+		// The textures live as long as the capture.
+		return 1;
+	case NVG_CAPTURE_UPDATE_TEXTURE:
+		return nvg__readUpdate(ld, cap);
+	case NVG_CAPTURE_FILL:
+	case NVG_CAPTURE_STROKE:
+		call = nvg__readCall(ld, cap, type == NVG_CAPTURE_FILL ? NVG_RECORD_FILL : NVG_RECORD_STROKE);
+		if (call == NULL) return 0;
+		if (type == NVG_CAPTURE_FILL)
+			nvg__readFloats(ld, call->bounds, 4);
+		else
+			nvg__readFloats(ld, &call->strokeWidth, 1);
+		n = nvg__readPaths(ld);
+		if (n == -1) return 0;
+		call->offset = nvg__recordPaths(list, ld->paths, n);
+		if (call->offset == -1) return 0;
+		call->count = n;
+		list->ncalls++;
+		return 1;
+	case NVG_CAPTURE_TRIANGLES:
+	case NVG_CAPTURE_QUADS:
+		call = nvg__readCall(ld, cap, type == NVG_CAPTURE_TRIANGLES ? NVG_RECORD_TRIANGLES : NVG_RECORD_QUADS);
+		if (call == NULL) return 0;
+		ld->nverts = 0;
+		if (nvg__readVerts(ld, &n) == -1) return 0;
+		call->offset = nvg__recordVerts(list, ld->verts, n);
+		if (call->offset == -1) return 0;
+		// Quads are stored as two corner vertices.
+		call->count = type == NVG_CAPTURE_QUADS ? n/2 : n;
+		list->ncalls++;
+		return 1;
+	case NVG_CAPTURE_RECT:
+		call = nvg__readCall(ld, cap, NVG_RECORD_RECT);
+		if (call == NULL) return 0;
+		nvg__readFloats(ld, call->bounds, 4);
+		nvg__readFloats(ld, &call->radius, 1);
+		if (ld->error) return 0;
+		list->ncalls++;
+		return 1;
+	default:
+		// Skip records added by later versions.
+		return 1;
+	}
+}
 
-	nvg__flattenPaths(ctx);
+NVGcapture* nvgLoadCapture(NVGcontext* ctx, const unsigned char* data, int ndata)
+{
+	NVGcaptureLoader ld;
+	NVGcapture* cap = NULL;
+	const unsigned char* magic;
+
+	memset(&ld, 0, sizeof(ld));
+	ld.allocator = &ctx->params.allocator;
+	ld.data = data;
+	ld.ndata = ndata;
+
+	cap = (NVGcapture*)nvg__realloc(ld.allocator, NULL, sizeof(NVGcapture));
+	if (cap == NULL) goto error;
+	memset(cap, 0, sizeof(NVGcapture));
+	cap->ctx = ctx;
+	cap->list = nvg__createCommandList(ld.allocator);
+	if (cap->list == NULL) goto error;
+
+	magic = nvg__readBytes(&ld, 4);
+	if (magic == NULL || memcmp(magic, "NVGC", 4) != 0) goto error;
+	if (nvg__readInt(&ld) != NVG_CAPTURE_VERSION) goto error;
+
+	while (ld.pos < ndata) {
+		int type = nvg__readInt(&ld);
+		int size = nvg__readInt(&ld);
+		int end;
+		if (ld.error || size < 0 || size > ndata - ld.pos) goto error;
+		if (type == NVG_CAPTURE_FLUSH) break;
+		// Each record is read within its own size.
+		end = ld.pos + size;
+		ld.ndata = end;
+		if (!nvg__readRecord(&ld, cap, type) || ld.error) goto error;
+		ld.pos = end;
+		ld.ndata = ndata;
+	}
 
-	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-		nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, state->lineCap, state->lineJoin, state->miterLimit);
-	else
-		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
+	nvg__resolveCommandList(cap->list);
+	nvg__free(ld.allocator, ld.paths);
+	nvg__free(ld.allocator, ld.pathVerts);
+	nvg__free(ld.allocator, ld.verts);
+	return cap;
 
-	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
+error:
+	nvg__free(ld.allocator, ld.paths);
+	nvg__free(ld.allocator, ld.pathVerts);
+	nvg__free(ld.allocator, ld.verts);
+	nvgDeleteCapture(cap);
+	return NULL;
+}
 
-	// Count triangles
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		ctx->strokeTriCount += path->nstroke-2;
-		ctx->drawCallCount++;
+NVGcapture* nvgLoadCaptureFile(NVGcontext* ctx, const char* filename)
+{
+	NVGcapture* cap;
+	int ndata;
+	unsigned char* data = nvg__readFile(&ctx->params.allocator, filename, &ndata);
+	if (data == NULL) return NULL;
+	cap = nvgLoadCapture(ctx, data, ndata);
+	nvg__free(&ctx->params.allocator, data);
+	return cap;
+}
+
+void nvgCaptureViewport(NVGcapture* cap, float* windowWidth, float* windowHeight, float* devicePixelRatio)
+{
+	if (windowWidth != NULL) *windowWidth = cap->width;
+	if (windowHeight != NULL) *windowHeight = cap->height;
+	if (devicePixelRatio != NULL) *devicePixelRatio = cap->devicePixelRatio;
+}
+
+void nvgReplayCapture(NVGcontext* ctx, NVGcapture* cap)
+{
+	int i;
+	if (cap->ctx != ctx) return;
+	// The back-ends draw when the frame is flushed, after all the uploads of the frame.
+	for (i = 0; i < cap->nupdates; i++) {
+		NVGcaptureUpdate* update = &cap->updates[i];
+		NVGcaptureTexture* tex = &cap->textures[update->texture];
+		ctx->params.renderUpdateTexture(ctx->params.userPtr, tex->image, update->x, update->y, update->w, update->h, tex->data);
 	}
+	nvgSubmitCommandList(ctx, cap->list);
+}
+
+void nvgDeleteCapture(NVGcapture* cap)
+{
+	const NVGallocator* alloc;
+	int i;
+	if (cap == NULL) return;
+	alloc = &cap->ctx->params.allocator;
+	for (i = 0; i < cap->ntextures; i++) {
+		if (cap->textures[i].image != 0)
+			nvgDeleteImage(cap->ctx, cap->textures[i].image);
+		nvg__free(alloc, cap->textures[i].data);
+	}
+	nvg__free(alloc, cap->textures);
+	nvg__free(alloc, cap->updates);
+	nvgDeleteCommandList(cap->list);
+	nvg__free(alloc, cap);
 }
 
 // Add fonts
@@ -2313,10 +5386,11 @@ int nvgFindFont(NVGcontext* ctx, const char* name)
 	return fonsGetFontByName(ctx->fs, name);
 }
 
-
 int nvgAddFallbackFontId(NVGcontext* ctx, int baseFont, int fallbackFont)
 {
 	if(baseFont == -1 || fallbackFont == -1) return 0;
+	// Fallback fonts change the glyphs, and the layout of the text in every context sharing the fonts.
+	ctx->fonts->textGeneration++;
 	return fonsAddFallbackFont(ctx->fs, baseFont, fallbackFont);
 }
 
@@ -2327,6 +5401,7 @@ int nvgAddFallbackFont(NVGcontext* ctx, const char* baseFont, const char* fallba
 
 void nvgResetFallbackFontsId(NVGcontext* ctx, int baseFont)
 {
+	ctx->fonts->textGeneration++;
 	fonsResetFallbackFont(ctx->fs, baseFont);
 }
 
@@ -2335,6 +5410,11 @@ void nvgResetFallbackFonts(NVGcontext* ctx, const char* baseFont)
 	nvgResetFallbackFontsId(ctx, nvgFindFont(ctx, baseFont));
 }
 
+int nvgTextWorkerThreads(NVGcontext* ctx, int nthreads)
+{
+	return fonsStartWorkers(ctx->fs, nthreads);
+}
+
 // State setting
 void nvgFontSize(NVGcontext* ctx, float size)
 {
@@ -2388,65 +5468,133 @@ static float nvg__getFontScale(NVGstate* state)
 	return nvg__minf(nvg__quantize(nvg__getAverageScale(state->xform), 0.01f), 4.0f);
 }
 
-static void nvg__flushTextTexture(NVGcontext* ctx)
-{
-	int dirty[4];
-
-	if (fonsValidateTexture(ctx->fs, dirty)) {
-		int fontImage = ctx->fontImages[ctx->fontImageIdx];
-		// Update texture
-		if (fontImage != 0) {
-			int iw, ih;
-			const unsigned char* data = fonsGetTextureData(ctx->fs, &iw, &ih);
-			int x = dirty[0];
-			int y = dirty[1];
-			int w = dirty[2] - dirty[0];
-			int h = dirty[3] - dirty[1];
-			ctx->params.renderUpdateTexture(ctx->params.userPtr, fontImage, x,y, w,h, data);
-		}
-	}
-}
-
 static int nvg__allocTextAtlas(NVGcontext* ctx)
 {
 	int iw, ih;
 	nvg__flushTextTexture(ctx);
-	if (ctx->fontImageIdx >= NVG_MAX_FONTIMAGES-1)
+	if (ctx->fonts->imageIdx >= NVG_MAX_FONTIMAGES-1)
 		return 0;
 	// if next fontImage already have a texture
-	if (ctx->fontImages[ctx->fontImageIdx+1] != 0)
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx+1], &iw, &ih);
+	if (ctx->fonts->images[ctx->fonts->imageIdx+1] != 0)
+		nvgImageSize(ctx, ctx->fonts->images[ctx->fonts->imageIdx+1], &iw, &ih);
 	else { // calculate the new font image size and create it.
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
+		nvgImageSize(ctx, ctx->fonts->images[ctx->fonts->imageIdx], &iw, &ih);
 		if (iw > ih)
 			ih *= 2;
 		else
 			iw *= 2;
 		if (iw > NVG_MAX_FONTIMAGE_SIZE || ih > NVG_MAX_FONTIMAGE_SIZE)
 			iw = ih = NVG_MAX_FONTIMAGE_SIZE;
-		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
+		ctx->fonts->images[ctx->fonts->imageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, ctx->params.sdfText ? NVG_IMAGE_SDF : 0, NULL);
 	}
-	++ctx->fontImageIdx;
+	++ctx->fonts->imageIdx;
 	fonsResetAtlas(ctx->fs, iw, ih);
 	return 1;
 }
 
-static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts)
+static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts, int quads)
 {
 	NVGstate* state = nvg__getState(ctx);
 	NVGpaint paint = state->fill;
 
 	// Render triangles.
-	paint.image = ctx->fontImages[ctx->fontImageIdx];
+	paint.image = ctx->fonts->images[ctx->fonts->imageIdx];
 
 	// Apply global alpha
 	paint.innerColor.a *= state->alpha;
 	paint.outerColor.a *= state->alpha;
 
-	ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts, ctx->fringeWidth);
+	if (ctx->params.sdfText) {
+		// Radius converts the sampled distance to device pixels, feather is the width of the edge.
+		float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+		paint.radius = 255.0f / 128.0f * FONS_SDF_PADDING * state->fontSize * scale / FONS_SDF_SIZE;
+		paint.feather = 1.0f + state->fontBlur * scale;
+	}
+
+	if (quads) {
+		ctx->params.renderQuads(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts/2, ctx->fringeWidth);
+		ctx->textTriCount += nverts;
+	} else {
+		ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts, ctx->fringeWidth);
+		ctx->textTriCount += nverts/3;
+	}
 
 	ctx->drawCallCount++;
-	ctx->textTriCount += nverts/3;
+}
+
+// Returns the view space bounds of the text box b, grown by how far glyphs can reach out of it.
+static void nvg__textViewBounds(NVGstate* state, const float* b, float* bounds)
+{
+	// The height is from the line bounds, and glyphs like accents can reach out of it.
+	float pad = state->fontSize*0.5f + state->fontBlur;
+	float c[8];
+	int i;
+
+	nvgTransformPoint(&c[0],&c[1], state->xform, b[0]-pad, b[1]-pad);
+	nvgTransformPoint(&c[2],&c[3], state->xform, b[2]+pad, b[1]-pad);
+	nvgTransformPoint(&c[4],&c[5], state->xform, b[2]+pad, b[3]+pad);
+	nvgTransformPoint(&c[6],&c[7], state->xform, b[0]-pad, b[3]+pad);
+	bounds[0] = bounds[2] = c[0];
+	bounds[1] = bounds[3] = c[1];
+	for (i = 1; i < 4; i++) {
+		bounds[0] = nvg__minf(bounds[0], c[i*2]);
+		bounds[1] = nvg__minf(bounds[1], c[i*2+1]);
+		bounds[2] = nvg__maxf(bounds[2], c[i*2]);
+		bounds[3] = nvg__maxf(bounds[3], c[i*2+1]);
+	}
+}
+
+// Returns 1 if the text is outside of the viewport or scissor, and sets nextx to what nvgText() returns.
+static int nvg__cullText(NVGcontext* ctx, float x, float y, const char* string, const char* end, float* nextx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+	int halign = state->textAlign & (NVG_ALIGN_LEFT | NVG_ALIGN_CENTER | NVG_ALIGN_RIGHT);
+	float b[4], bounds[4], clip[4], adv, width;
+
+	// Test a conservative box first, every byte is at most one glyph of the widest advance, plus
+	// the rounding of bitmap glyph advances to whole pixels. The text is only measured when the
+	// box crosses the clip edge, or for the advance to return if it is culled.
+	fonsSetSize(ctx->fs, state->fontSize*scale);
+	fonsSetAlign(ctx->fs, state->textAlign);
+	fonsSetFont(ctx->fs, state->fontId);
+	fonsLineBounds(ctx->fs, y*scale, &b[1], &b[3]);
+	adv = fonsMaxAdvance(ctx->fs) + nvg__maxf(state->letterSpacing*scale, 0.0f) + 1.0f;
+	width = (float)(end - string) * adv / scale;
+	b[1] /= scale;
+	b[3] /= scale;
+	if (halign & NVG_ALIGN_RIGHT) {
+		b[0] = x - width;
+		b[2] = x;
+	} else if (halign & NVG_ALIGN_CENTER) {
+		b[0] = x - width*0.5f;
+		b[2] = x + width*0.5f;
+	} else {
+		b[0] = x;
+		b[2] = x + width;
+	}
+	nvg__textViewBounds(state, b, bounds);
+
+	if (!nvg__cullBounds(ctx, bounds, 0.0f)) {
+		nvg__clipRect(ctx, clip);
+		if (bounds[0] >= clip[0] && bounds[1] >= clip[1] && bounds[2] <= clip[2] && bounds[3] <= clip[3])
+			return 0;
+		nvgTextBounds(ctx, x, y, string, end, b);
+		nvg__textViewBounds(state, b, bounds);
+		if (!nvg__cullBounds(ctx, bounds, 0.0f))
+			return 0;
+	}
+
+	if (halign & NVG_ALIGN_RIGHT) {
+		*nextx = x;
+	} else {
+		width = nvgTextBounds(ctx, x, y, string, end, NULL);
+		if (halign & NVG_ALIGN_CENTER)
+			*nextx = x + width*0.5f;
+		else
+			*nextx = x + width;
+	}
+	return 1;
 }
 
 float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
@@ -2457,14 +5605,29 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	NVGvertex* verts;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
+	float nextx;
 	int cverts = 0;
 	int nverts = 0;
+	int quads;
+	double t0;
 
 	if (end == NULL)
 		end = string + strlen(string);
 
 	if (state->fontId == FONS_INVALID) return x;
 
+	NVG_TRACE_BEGIN("nvgText");
+
+	if (nvg__cullText(ctx, x, y, string, end, &nextx)) {
+		NVG_TRACE_END("nvgText");
+		return nextx;
+	}
+
+	t0 = nvg__statsTime();
+
+	// Glyphs stay axis aligned when there is no rotation or skew, and can be drawn as quads.
+	quads = ctx->params.renderQuads != NULL && state->xform[1] == 0.0f && state->xform[2] == 0.0f;
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
@@ -2473,7 +5636,10 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 
 	cverts = nvg__maxi(2, (int)(end - string)) * 6; // conservative estimate.
 	verts = nvg__allocTempVerts(ctx, cverts);
-	if (verts == NULL) return x;
+	if (verts == NULL) {
+		NVG_TRACE_END("nvgText");
+		return x;
+	}
 
 	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_REQUIRED);
 	prevIter = iter;
@@ -2481,7 +5647,7 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 		float c[4*2];
 		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
 			if (nverts != 0) {
-				nvg__renderText(ctx, verts, nverts);
+				nvg__renderText(ctx, verts, nverts, quads);
 				nverts = 0;
 			}
 			if (!nvg__allocTextAtlas(ctx))
@@ -2492,6 +5658,16 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 				break;
 		}
 		prevIter = iter;
+		if (quads) {
+			// Opposite corners are enough for axis aligned quads.
+			nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale, q.y0*invscale);
+			nvgTransformPoint(&c[4],&c[5], state->xform, q.x1*invscale, q.y1*invscale);
+			if (nverts+2 <= cverts) {
+				nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0); nverts++;
+				nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1); nverts++;
+			}
+			continue;
+		}
 		// Transform corners.
 		nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale, q.y0*invscale);
 		nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale, q.y0*invscale);
@@ -2508,11 +5684,12 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 		}
 	}
 
-	// TODO: add back-end bit to do this just once per frame.
-	nvg__flushTextTexture(ctx);
+	ctx->textTime += nvg__statsTime() - t0;
 
-	nvg__renderText(ctx, verts, nverts);
+	// The font atlas is uploaded once in nvgEndFrame() before the calls are rendered.
+	nvg__renderText(ctx, verts, nverts, quads);
 
+	NVG_TRACE_END("nvgText");
 	return iter.nextx / scale;
 }
 
@@ -2599,7 +5776,79 @@ enum NVGcodepointType {
 	NVG_CJK_CHAR,
 };
 
-int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows)
+static unsigned int nvg__hashBytes(unsigned int h, const void* data, int n)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	int i;
+	for (i = 0; i < n; i++) {
+		h ^= p[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// Builds the key of a text layout from the string and the font state, and returns the cache slot for it.
+// The cache is emptied first when the fallback fonts were changed by any of the contexts sharing the fonts.
+static NVGtextCacheEntry* nvg__textCacheSlot(NVGcontext* ctx, NVGtextCacheKey* key, int kind, const char* string, const char* end,
+											 float width, int maxRows)
+{
+	NVGstate* state = nvg__getState(ctx);
+	unsigned int h;
+	int i;
+
+	if (ctx->textGeneration != ctx->fonts->textGeneration) {
+		for (i = 0; i < NVG_TEXT_CACHE_SIZE; i++)
+			ctx->textCache[i].key.kind = 0;
+		ctx->textGeneration = ctx->fonts->textGeneration;
+	}
+
+	memset(key, 0, sizeof(*key));
+	key->kind = kind;
+	key->fontId = state->fontId;
+	key->align = state->textAlign;
+	key->maxRows = maxRows;
+	key->len = (int)(end - string);
+	key->size = state->fontSize;
+	key->scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+	key->spacing = state->letterSpacing;
+	key->blur = state->fontBlur;
+	key->width = width;
+	key->hash = nvg__hashBytes(2166136261u, string, key->len);
+
+	h = nvg__hashBytes(key->hash, key, sizeof(*key));
+	return &ctx->textCache[h & (NVG_TEXT_CACHE_SIZE-1)];
+}
+
+static int nvg__textCacheHit(NVGtextCacheEntry* entry, const NVGtextCacheKey* key, const char* string)
+{
+	if (memcmp(&entry->key, key, sizeof(*key)) != 0) return 0;
+	return key->len == 0 || memcmp(entry->text, string, key->len) == 0;
+}
+
+static int nvg__textCacheStore(const NVGallocator* alloc, NVGtextCacheEntry* entry, const NVGtextCacheKey* key, const char* string, int nrows)
+{
+	entry->key.kind = 0;
+	if (key->len > entry->ctext) {
+		int ctext = nvg__maxi(key->len, 32) + entry->ctext/2; // 1.5x Overallocate
+		char* text = (char*)nvg__realloc(alloc, entry->text, ctext);
+		if (text == NULL) return 0;
+		entry->text = text;
+		entry->ctext = ctext;
+	}
+	if (nrows > entry->crows) {
+		int crows = nvg__maxi(nrows, 2) + entry->crows/2; // 1.5x Overallocate
+		NVGtextCacheRow* rows = (NVGtextCacheRow*)nvg__realloc(alloc, entry->rows, sizeof(NVGtextCacheRow)*crows);
+		if (rows == NULL) return 0;
+		entry->rows = rows;
+		entry->crows = crows;
+	}
+	memcpy(entry->text, string, key->len);
+	entry->nrows = nrows;
+	entry->key = *key;
+	return 1;
+}
+
+static int nvg__textBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows)
 {
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
@@ -2805,23 +6054,112 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 	return nrows;
 }
 
+int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGtextCacheKey key;
+	NVGtextCacheEntry* entry;
+	int i, nrows;
+
+	if (maxRows == 0) return 0;
+	if (state->fontId == FONS_INVALID) return 0;
+
+	if (end == NULL)
+		end = string + strlen(string);
+
+	entry = nvg__textCacheSlot(ctx, &key, NVG_TEXTCACHE_BREAKLINES, string, end, breakRowWidth, maxRows);
+	if (nvg__textCacheHit(entry, &key, string)) {
+		for (i = 0; i < entry->nrows; i++) {
+			rows[i].start = string + entry->rows[i].start;
+			rows[i].end = string + entry->rows[i].end;
+			rows[i].next = string + entry->rows[i].next;
+			rows[i].width = entry->rows[i].width;
+			rows[i].minx = entry->rows[i].minx;
+			rows[i].maxx = entry->rows[i].maxx;
+		}
+		return entry->nrows;
+	}
+
+	nrows = nvg__textBreakLines(ctx, string, end, breakRowWidth, rows, maxRows);
+
+	if (nvg__textCacheStore(&ctx->params.allocator, entry, &key, string, nrows)) {
+		for (i = 0; i < nrows; i++) {
+			entry->rows[i].start = (int)(rows[i].start - string);
+			entry->rows[i].end = (int)(rows[i].end - string);
+			entry->rows[i].next = (int)(rows[i].next - string);
+			entry->rows[i].width = rows[i].width;
+			entry->rows[i].minx = rows[i].minx;
+			entry->rows[i].maxx = rows[i].maxx;
+		}
+	}
+
+	return nrows;
+}
+
+// Returns the start position x of a text line as moved by the horizontal alignment in fonsTextBounds().
+static float nvg__textAlignStart(int align, float x, float advance)
+{
+	if (align & NVG_ALIGN_LEFT)
+		return x;
+	if (align & NVG_ALIGN_RIGHT)
+		return x - advance;
+	if (align & NVG_ALIGN_CENTER)
+		return x - advance * 0.5f;
+	return x;
+}
+
 float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const char* end, float* bounds)
 {
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	float width;
+	float width, ix, fx, lx, start;
+	float tbounds[4];
+	NVGtextCacheKey key;
+	NVGtextCacheEntry* entry;
 
 	if (state->fontId == FONS_INVALID) return 0;
 
+	if (end == NULL)
+		end = string + strlen(string);
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
-	width = fonsTextBounds(ctx->fs, x*scale, y*scale, string, end, bounds);
+	// Bitmap glyphs snap to whole pixels and distance field glyphs are not snapped, so the layout is
+	// cached for one start position lx inside the pixel and moved to the fractional start position fx.
+	ix = floorf(x*scale);
+	fx = x*scale - ix;
+	lx = ctx->params.sdfText ? 0.0f : 0.5f;
+	entry = nvg__textCacheSlot(ctx, &key, NVG_TEXTCACHE_BOUNDS, string, end, 0.0f, 0);
+	if (!nvg__textCacheHit(entry, &key, string)) {
+		width = fonsTextBounds(ctx->fs, lx, y*scale, string, end, tbounds);
+		if (nvg__textCacheStore(&ctx->params.allocator, entry, &key, string, 0)) {
+			entry->advance = width;
+			entry->minx = tbounds[0];
+			entry->maxx = tbounds[2];
+		}
+	} else {
+		width = entry->advance;
+		tbounds[0] = entry->minx;
+		tbounds[2] = entry->maxx;
+	}
+	if (ctx->params.sdfText) {
+		tbounds[0] += fx;
+		tbounds[2] += fx;
+	} else {
+		// Bitmap glyph edges are on whole pixels, only the start position bound follows fx.
+		start = nvg__textAlignStart(state->textAlign, lx, width);
+		if (tbounds[0] == start) tbounds[0] = nvg__textAlignStart(state->textAlign, fx, width);
+		if (tbounds[2] == start) tbounds[2] = nvg__textAlignStart(state->textAlign, fx, width);
+	}
+
 	if (bounds != NULL) {
+		bounds[0] = ix + tbounds[0];
+		bounds[2] = ix + tbounds[2];
 		// Use line bounds for height.
 		fonsLineBounds(ctx->fs, y*scale, &bounds[1], &bounds[3]);
 		bounds[0] *= invscale;
@@ -19,6 +19,8 @@
 #ifndef NANOVG_H
 #define NANOVG_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,6 +33,9 @@ extern "C" {
 #endif
 
 typedef struct NVGcontext NVGcontext;
+typedef struct NVGcachedPath NVGcachedPath;
+typedef struct NVGcommandList NVGcommandList;
+typedef struct NVGcapture NVGcapture;
 
 struct NVGcolor {
 	union {
@@ -142,8 +147,43 @@ enum NVGimageFlags {
 	NVG_IMAGE_FLIPY				= 1<<3,		// Flips (inverses) image in Y direction when rendered.
 	NVG_IMAGE_PREMULTIPLIED		= 1<<4,		// Image data has premultiplied alpha.
 	NVG_IMAGE_NEAREST			= 1<<5,		// Image interpolation is Nearest instead Linear
+	NVG_IMAGE_SDF				= 1<<6,		// Alpha image holds signed distance field glyphs, used for font atlases.
 };
 
+// The CPU times are only measured when nanovg is compiled with NVG_STATS_TIMING, otherwise they are 0.
+struct NVGframeStats {
+	int drawCalls;			// Number of draw calls.
+	int fillTriangles;		// Number of triangles used by fills.
+	int strokeTriangles;	// Number of triangles used by strokes.
+	int textTriangles;		// Number of triangles used by text.
+	int culledDraws;		// Number of fills, strokes and texts skipped, because they were outside of the viewport or scissor.
+	int arenaBytes;			// Bytes the frame allocated from the frame arena, including what did not fit and went to the heap.
+	int arenaPeakBytes;		// Most bytes any frame has allocated from the frame arena.
+	int mergedCalls;		// Number of calls the render back-end merged into preceding calls.
+	int vertexBytes;		// Bytes of vertex data uploaded by the render back-end.
+	int uniformBytes;		// Bytes of uniform data uploaded by the render back-end.
+	int textureBytes;		// Bytes of texture data uploaded by texture updates, e.g. new font glyphs.
+	int filteredStateChanges;	// Number of redundant render state changes skipped by the render back-end.
+	float flattenTime;		// CPU time spent flattening paths, in seconds.
+	float expandTime;		// CPU time spent expanding fills and strokes into vertices, in seconds.
+	float textTime;			// CPU time spent laying out text into glyph quads, in seconds.
+	float flushTime;		// CPU time spent flushing the frame to the render back-end, in seconds.
+};
+typedef struct NVGframeStats NVGframeStats;
+
+// Memory callbacks, which a context and its render back-end use instead of realloc() and free().
+// When frameArenaSize is set, the buffers which are only needed during a frame, like path
+// points, vertices and draw calls, come from a linear arena which is reset in nvgBeginFrame().
+// Paths can then not be kept over nvgBeginFrame(). The buffers are allocated at the sizes
+// of the previous frame, see arenaPeakBytes in NVGframeStats for sizing the arena.
+struct NVGallocator {
+	void* (*reallocMem)(void* userPtr, void* ptr, size_t size);	// Like realloc(), NULL to use realloc().
+	void (*freeMem)(void* userPtr, void* ptr);	// Like free(), NULL to use free().
+	void* userPtr;
+	size_t frameArenaSize;	// Size of the frame arena in bytes, 0 to grow the buffers on the heap.
+};
+typedef struct NVGallocator NVGallocator;
+
 // Begin drawing a new frame
 // Calls to nanovg drawing API should be wrapped in nvgBeginFrame() & nvgEndFrame()
 // nvgBeginFrame() defines the size of the window to render to in relation currently
@@ -154,12 +194,37 @@ enum NVGimageFlags {
 // devicePixelRatio to: frameBufferWidth / windowWidth.
 void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float devicePixelRatio);
 
+// Begins a frame which renders into an offscreen target, like the frame buffer of a layer, before or after
+// the frames of the context. It is ended with nvgEndFrame(). It is always drawn in full, and is not part of
+// frame captures and frame statistics. It does not upload loaded images or age the glyphs of the font atlas.
+void nvgBeginOffscreenFrame(NVGcontext* ctx, float width, float height, float devicePixelRatio);
+
 // Cancels drawing the current frame.
 void nvgCancelFrame(NVGcontext* ctx);
 
 // Ends drawing flushing remaining render state.
 void nvgEndFrame(NVGcontext* ctx);
 
+// Returns statistics of the last frame ended with nvgEndFrame().
+void nvgFrameStats(NVGcontext* ctx, NVGframeStats* stats);
+
+// Trace callbacks, e.g. for forwarding the zones to Tracy or Perfetto. When nanovg is compiled
+// with NVG_TRACE defined, filling and stroking paths, flattening, text layout, glyph rasterization
+// and the back-end flush are reported as named zones. The names are string literals. The GL3
+// back-end also measures each flush with GPU timestamp queries, and reports the GPU times a few
+// frames later when the results are available. Without NVG_TRACE the zones compile to nothing.
+struct NVGtraceCallbacks {
+	void (*beginZone)(void* userPtr, const char* name);
+	void (*endZone)(void* userPtr, const char* name);
+	void (*gpuZone)(void* userPtr, const char* name, double begin, double end);	// Optional, GPU clock in seconds.
+	void* userPtr;
+};
+typedef struct NVGtraceCallbacks NVGtraceCallbacks;
+
+// Sets the trace callbacks of all contexts, or NULL to stop tracing. Zones can begin and end on
+// any thread which uses a context. Does nothing unless compiled with NVG_TRACE.
+void nvgSetTraceCallbacks(const NVGtraceCallbacks* callbacks);
+
 //
 // Composite operation
 //
@@ -365,6 +430,7 @@ float nvgRadToDeg(float rad);
 //
 // NanoVG allows you to load jpg, png, psd, tga, pic and gif files to be used for rendering.
 // In addition you can upload your own image. The image loading is provided by stb_image.
+// KTX and DDS files are uploaded as they are, in the compressed or 16-bit formats of NVGtexture.
 // The parameter imageFlags is combination of flags defined in NVGimageFlags.
 
 // Creates image by loading it from the disk from specified file name.
@@ -375,10 +441,30 @@ int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags);
 // Returns handle to the image.
 int nvgCreateImageMem(NVGcontext* ctx, int imageFlags, unsigned char* data, int ndata);
 
+// Creates image by loading it from the disk in the background, only the size is read before returning.
+// The image is not drawn until it is decoded and uploaded during nvgBeginFrame().
+// Returns handle to the image.
+int nvgCreateImageAsync(NVGcontext* ctx, const char* filename, int imageFlags);
+
+// Creates image by decoding a copy of the specified chunk of memory in the background.
+// Returns handle to the image.
+int nvgCreateImageMemAsync(NVGcontext* ctx, int imageFlags, const unsigned char* data, int ndata);
+
+// Returns 1 if the image is ready to be drawn, 0 if it is still loading and -1 if it failed to decode.
+int nvgImageLoaded(NVGcontext* ctx, int image);
+
+// Sets how many bytes of decoded images are uploaded to textures per frame, larger images are uploaded in strips.
+// Contexts which share images also share the loader, each of their frames uploads up to the budget.
+void nvgImageUploadBudget(NVGcontext* ctx, int bytes);
+
 // Creates image from specified image data.
 // Returns handle to the image.
 int nvgCreateImageRGBA(NVGcontext* ctx, int w, int h, int imageFlags, const unsigned char* data);
 
+// Creates image from data in one of the formats of NVGtexture, see nvgTextureBytes() for the size of the data.
+// Compressed images can not be updated and do not get mipmaps. Returns 0 if the back-end does not support the format.
+int nvgCreateImageFormat(NVGcontext* ctx, int type, int w, int h, int imageFlags, const unsigned char* data);
+
 // Updates image data specified by image handle.
 void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data);
 
@@ -508,6 +594,104 @@ void nvgFill(NVGcontext* ctx);
 // Fills the current path with current stroke style.
 void nvgStroke(NVGcontext* ctx);
 
+//
+// Cached Paths
+//
+// Static shapes, like icons and gauges, can be recorded into a cached path, which keeps the
+// tesselated geometry of the shape between frames. A cached path is created from the current
+// path and is stored relative to the current transform. When drawn, the cached path uses the
+// current transform, paint, scissor and stroke style.
+//
+// The tesselation is reused as long as the current transform differs from the one the geometry
+// was built with only by translation and rotation. Changing the scale, device pixel ratio,
+// anti-aliasing or stroke style rebuilds the geometry.
+
+// Creates cached path from the current path. Returns NULL on failure.
+NVGcachedPath* nvgCreateCachedPath(NVGcontext* ctx);
+
+// Deletes cached path.
+void nvgDeleteCachedPath(NVGcontext* ctx, NVGcachedPath* path);
+
+// Fills the cached path with current fill style.
+void nvgFillCachedPath(NVGcontext* ctx, NVGcachedPath* path);
+
+// Strokes the cached path with current stroke style.
+void nvgStrokeCachedPath(NVGcontext* ctx, NVGcachedPath* path);
+
+//
+// Command Lists
+//
+// Drawing can be recorded into a command list using a recording context, and submitted later
+// to a rendering context. Recording contexts do not use the renderer, so they can be used on
+// worker threads to spread the path tesselation over several cores. Each recording context
+// and command list must only be used by one thread at a time.
+//
+// The recorded geometry is in device pixels, so the recording context should use the same
+// window size, device pixel ratio and anti-aliasing flag as the rendering context.
+// Images created using the rendering context can be used in the recorded paints. Text and
+// images created using the recording context are not recorded: nvgText() and nvgTextBox() draw
+// nothing into the list, and fills with such images are dropped. Draw text with the rendering
+// context after submitting the list. Debug builds print a warning the first time.
+
+// Creates recording context. Set edgeAntiAlias to 1 if the rendering context uses NVG_ANTIALIAS. Returns NULL on failure.
+NVGcontext* nvgCreateRecordingContext(int edgeAntiAlias);
+
+// Deletes recording context.
+void nvgDeleteRecordingContext(NVGcontext* ctx);
+
+// Creates empty command list. Returns NULL on failure.
+NVGcommandList* nvgCreateCommandList(void);
+
+// Deletes command list.
+void nvgDeleteCommandList(NVGcommandList* list);
+
+// Sets the command list where the recording context records to, or NULL to stop recording.
+// The list is cleared in nvgBeginFrame() and is complete after nvgEndFrame().
+void nvgRecordCommandList(NVGcontext* ctx, NVGcommandList* list);
+
+// Submits the recorded drawing to the rendering context. Must be called between nvgBeginFrame() and
+// nvgEndFrame(). The data is copied, so the list can be submitted again or re-recorded after the call.
+void nvgSubmitCommandList(NVGcontext* ctx, NVGcommandList* list);
+
+//
+// Frame Capture
+//
+// The render back-end calls of a frame can be captured into a compact binary stream, saved
+// to a file, and replayed later on any context, e.g. to reproduce a performance problem offline
+// or to benchmark real frames. The stream holds the tesselated geometry, paints, scissors, texture
+// uploads and the font atlas, so the replay does not need the fonts or the application.
+//
+// Textures created before the capture, other than the font atlas, are captured as blank
+// textures of the same size. Back-end specific functions can be called as usual during the
+// captured frame, as long as they access the back-end through nvgInternalParams().
+
+// Captures the next frame, from nvgBeginFrame() to nvgEndFrame(). nvgCancelFrame() discards the capture.
+void nvgCaptureFrame(NVGcontext* ctx);
+
+// Returns the last captured frame and its size in bytes, or NULL if there is none.
+// The data is valid until the next capture starts, or the context is deleted.
+const unsigned char* nvgCaptureData(NVGcontext* ctx, int* ndata);
+
+// Writes the last captured frame to a file. Returns 1 on success.
+int nvgSaveCapture(NVGcontext* ctx, const char* filename);
+
+// Loads captured frame for replaying on the specified context. The textures of the capture are
+// created on the context. The data is not used after the call. Returns NULL if the data is not a valid capture.
+NVGcapture* nvgLoadCapture(NVGcontext* ctx, const unsigned char* data, int ndata);
+
+// Loads captured frame from a file. Returns NULL on failure.
+NVGcapture* nvgLoadCaptureFile(NVGcontext* ctx, const char* filename);
+
+// Returns the viewport of the captured frame.
+void nvgCaptureViewport(NVGcapture* cap, float* windowWidth, float* windowHeight, float* devicePixelRatio);
+
+// Replays the captured frame on the context it was loaded for. Must be called between
+// nvgBeginFrame() and nvgEndFrame(). The captured texture uploads are repeated on each replay.
+void nvgReplayCapture(NVGcontext* ctx, NVGcapture* cap);
+
+// Deletes captured frame and its textures.
+void nvgDeleteCapture(NVGcapture* cap);
+
 
 //
 // Text
@@ -571,6 +755,10 @@ void nvgResetFallbackFontsId(NVGcontext* ctx, int baseFont);
 // Resets fallback fonts by name.
 void nvgResetFallbackFonts(NVGcontext* ctx, const char* baseFont);
 
+// Rasterizes new glyphs on worker threads, a new glyph is drawn empty until it is ready.
+// Requires building with FONS_USE_THREADS. Returns 0 if not supported.
+int nvgTextWorkerThreads(NVGcontext* ctx, int nthreads);
+
 // Sets the font size of current text style.
 void nvgFontSize(NVGcontext* ctx, float size);
 
@@ -630,8 +818,22 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 enum NVGtexture {
 	NVG_TEXTURE_ALPHA = 0x01,
 	NVG_TEXTURE_RGBA = 0x02,
+	// 16-bit formats, each pixel is an unsigned short in native byte order.
+	NVG_TEXTURE_RGB565 = 0x03,
+	NVG_TEXTURE_RGBA4444 = 0x04,
+	NVG_TEXTURE_RGBA5551 = 0x05,
+	// Block compressed formats, the data is a sequence of 4x4 pixel blocks.
+	NVG_TEXTURE_ETC2_RGB = 0x06,
+	NVG_TEXTURE_ETC2_RGBA = 0x07,
+	NVG_TEXTURE_BC1 = 0x08,
+	NVG_TEXTURE_BC3 = 0x09,
+	NVG_TEXTURE_ASTC_4x4 = 0x0a,
+	NVG_TEXTURE_ETC1 = 0x0b,	// Uploaded as ETC2 where ETC1 is not supported, ETC1 data is valid ETC2.
 };
 
+// Returns the size in bytes of tightly packed texture data of the given type, or 0 if the type is not known.
+int nvgTextureBytes(int type, int w, int h);
+
 struct NVGscissor {
 	float xform[6];
 	float extent[2];
@@ -654,12 +856,16 @@ struct NVGpath {
 	int nstroke;
 	int winding;
 	int convex;
+	int triangulated;	// Fill vertices are a triangle list of a concave path, which is drawn like a convex fill.
 };
 typedef struct NVGpath NVGpath;
 
 struct NVGparams {
 	void* userPtr;
+	NVGallocator allocator;	// Optional, used for all memory of the context.
 	int edgeAntiAlias;
+	int sdfText;	// Text is drawn from signed distance field glyphs, font atlases are created with NVG_IMAGE_SDF.
+	int triangulateFills;	// Single simple concave fill paths are triangulated, see NVGpath.triangulated.
 	int (*renderCreate)(void* uptr);
 	int (*renderCreateTexture)(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data);
 	int (*renderDeleteTexture)(void* uptr, int image);
@@ -672,6 +878,20 @@ struct NVGparams {
 	void (*renderStroke)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths);
 	void (*renderTriangles)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, const NVGvertex* verts, int nverts, float fringe);
 	void (*renderDelete)(void* uptr);
+	void (*renderFrameStats)(void* uptr, NVGframeStats* stats);	// Optional, adds back-end statistics of the last flushed frame.
+	// Optional, renders axis aligned textured quads. Each quad is given as two vertices at the opposite transformed corners.
+	void (*renderQuads)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, const NVGvertex* verts, int nquads, float fringe);
+	// Optional, fills an axis aligned rect with rounded corners, rect is x,y,w,h in view space. The edge is anti-aliased over fringe, hard when zero.
+	void (*renderRect)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, const float* rect, float radius);
+	// Optional, returns the NVG_TEXTURE_* type of the image, or 0 if it does not exist. Frame captures take images
+	// created before the capture for RGBA without it.
+	int (*renderGetTextureType)(void* uptr, int image);
+	// Optional, called after renderViewport in frames begun by nvgBeginOffscreenFrame(). The back-end must draw
+	// the frame in full and keep its damage tracking state for the other frames.
+	void (*renderOffscreenFrame)(void* uptr);
+	// Optional, context whose font stash and font atlas images are shared. The back-end must share its textures
+	// with the back-end of that context, so that image handles are the same, and use the same allocator.
+	NVGcontext* share;
 };
 typedef struct NVGparams NVGparams;
 
@@ -681,9 +901,37 @@ void nvgDeleteInternal(NVGcontext* ctx);
 
 NVGparams* nvgInternalParams(NVGcontext* ctx);
 
+// Adds n to the value atomically and returns the new value, for reference counts of shared resources.
+int nvgAtomicAdd(int* value, int n);
+
+// Linear allocator for the buffers of a frame, shared by the context and its render back-end.
+// All allocations are released when nvgBeginFrame() resets the arena, which happens before
+// renderViewport is called, so the back-end can allocate its buffers again there.
+typedef struct NVGarena NVGarena;
+
+// Returns the frame arena of the context, or NULL if it was created without one.
+NVGarena* nvgInternalArena(NVGcontext* ctx);
+
+// Resizes an allocation of the arena like realloc(), keeping oldSize bytes of it. The last
+// allocation grows in place. Memory which does not fit into the arena comes from the heap,
+// and is freed when the arena is reset.
+void* nvgArenaRealloc(NVGarena* arena, void* ptr, size_t oldSize, size_t size);
+
 // Debug function to dump cached path data.
 void nvgDebugDumpPathCache(NVGcontext* ctx);
 
+// Trace zones, which render back-ends can use too when compiled with NVG_TRACE.
+#ifdef NVG_TRACE
+void nvgTraceBegin(const char* name);
+void nvgTraceEnd(const char* name);
+void nvgTraceGpuZone(const char* name, double begin, double end);
+#define NVG_TRACE_BEGIN(name) nvgTraceBegin(name)
+#define NVG_TRACE_END(name) nvgTraceEnd(name)
+#else
+#define NVG_TRACE_BEGIN(name)
+#define NVG_TRACE_END(name)
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -32,6 +32,32 @@ enum NVGcreateFlags {
 	NVG_STENCIL_STROKES	= 1<<1,
 	// Flag indicating that additional debug checks are done.
 	NVG_DEBUG 			= 1<<2,
+	// Flag indicating that vertex and uniform data is written directly to mapped, triple buffered
+	// GPU buffers instead of being copied and re-specified each frame. Supported on GL3 and GLES3.
+	NVG_RING_BUFFERS	= 1<<3,
+	// Flag indicating that text is drawn from signed distance field glyphs, so that one glyph
+	// serves all font sizes. Looks smoother when text is scaled, but small text is not hinted.
+	NVG_SDF_TEXT		= 1<<4,
+	// Flag indicating that single, simple concave fill paths are triangulated and drawn like convex
+	// fills, which avoids the stencil passes. Self-intersecting and multi-path fills still use the stencil.
+	NVG_TRIANGULATE_FILLS	= 1<<5,
+	// Flag indicating that the renderer compares the draw calls with the previous frame, and only
+	// redraws the regions which changed. The previous frame must be kept in the framebuffer, see
+	// nvglDamageRects(). Ignored together with NVG_RING_BUFFERS, which can not read the vertex data back.
+	NVG_DAMAGE_REGIONS	= 1<<6,
+	// Flag indicating that RGBA texture updates are copied to a pixel buffer object first, so the
+	// driver can transfer them without stalling. Only used with GL3 and GLES3.
+	NVG_PBO_UPLOADS		= 1<<7,
+	// Flag indicating that small RGBA images which do not repeat or use mipmaps are packed into shared
+	// atlas textures, so that drawing them does not rebind textures. nvglImageHandle() returns the atlas.
+	NVG_ATLAS_IMAGES	= 1<<8,
+	// Flag indicating that the texture coordinates of the vertices are uploaded as normalized 16-bit
+	// integers, which makes the vertices 12 bytes instead of 16. Saves bandwidth on mobile GPUs.
+	NVG_COMPACT_VERTICES	= 1<<9,
+	// Flag indicating that fills and strokes are drawn as indexed triangle lists, so that all paths of
+	// a call go out in one glDrawElements() and consecutive strokes can be merged. GLES2 needs
+	// OES_element_index_uint, the flag is ignored without it.
+	NVG_INDEXED_GEOMETRY	= 1<<10,
 };
 
 #if defined NANOVG_GL2_IMPLEMENTATION
@@ -41,59 +67,97 @@ enum NVGcreateFlags {
 #  define NANOVG_GL3 1
 #  define NANOVG_GL_IMPLEMENTATION 1
 #  define NANOVG_GL_USE_UNIFORMBUFFER 1
+#  define NANOVG_GL_USE_RING_BUFFER 1
+#  define NANOVG_GL_USE_INSTANCING 1
 #elif defined NANOVG_GLES2_IMPLEMENTATION
 #  define NANOVG_GLES2 1
 #  define NANOVG_GL_IMPLEMENTATION 1
 #elif defined NANOVG_GLES3_IMPLEMENTATION
 #  define NANOVG_GLES3 1
 #  define NANOVG_GL_IMPLEMENTATION 1
+#  define NANOVG_GL_USE_RING_BUFFER 1
+#  define NANOVG_GL_USE_INSTANCING 1
 #endif
 
 #define NANOVG_GL_USE_STATE_FILTER (1)
 
+// With NVG_TRACE, the GPU time of each flush is measured with timestamp queries, which need GL 3.3.
+#if defined(NVG_TRACE) && defined(NANOVG_GL3) && defined(GL_TIMESTAMP)
+#  define NANOVG_GL_TRACE_GPU 1
+#endif
+
 // Creates NanoVG contexts for different OpenGL (ES) versions.
 // Flags should be combination of the create flags above.
+// The Alloc variants take the allocator, and optional frame arena, of the context and the renderer.
+// The Shared variants create a context which shares the font stash, font atlas and images of another
+// context, and its allocator. The GL contexts must share objects, and the frames of the NanoVG contexts
+// must not overlap, e.g. by drawing the windows one after the other. The resources are released with
+// the last context which uses them.
 
 #if defined NANOVG_GL2
 
 NVGcontext* nvgCreateGL2(int flags);
+NVGcontext* nvgCreateGL2Alloc(int flags, const NVGallocator* allocator);
+NVGcontext* nvgCreateGL2Shared(int flags, NVGcontext* share);
 void nvgDeleteGL2(NVGcontext* ctx);
 
 int nvglCreateImageFromHandleGL2(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGL2(NVGcontext* ctx, int image);
+int nvglDamageRectsGL2(NVGcontext* ctx, int* rects, int maxRects);
+void nvglImageChangedGL2(NVGcontext* ctx, int image);
 
 #endif
 
 #if defined NANOVG_GL3
 
 NVGcontext* nvgCreateGL3(int flags);
+NVGcontext* nvgCreateGL3Alloc(int flags, const NVGallocator* allocator);
+NVGcontext* nvgCreateGL3Shared(int flags, NVGcontext* share);
 void nvgDeleteGL3(NVGcontext* ctx);
 
 int nvglCreateImageFromHandleGL3(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGL3(NVGcontext* ctx, int image);
+int nvglDamageRectsGL3(NVGcontext* ctx, int* rects, int maxRects);
+void nvglImageChangedGL3(NVGcontext* ctx, int image);
 
 #endif
 
 #if defined NANOVG_GLES2
 
 NVGcontext* nvgCreateGLES2(int flags);
+NVGcontext* nvgCreateGLES2Alloc(int flags, const NVGallocator* allocator);
+NVGcontext* nvgCreateGLES2Shared(int flags, NVGcontext* share);
 void nvgDeleteGLES2(NVGcontext* ctx);
 
 int nvglCreateImageFromHandleGLES2(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGLES2(NVGcontext* ctx, int image);
+int nvglDamageRectsGLES2(NVGcontext* ctx, int* rects, int maxRects);
+void nvglImageChangedGLES2(NVGcontext* ctx, int image);
 
 #endif
 
 #if defined NANOVG_GLES3
 
 NVGcontext* nvgCreateGLES3(int flags);
+NVGcontext* nvgCreateGLES3Alloc(int flags, const NVGallocator* allocator);
+NVGcontext* nvgCreateGLES3Shared(int flags, NVGcontext* share);
 void nvgDeleteGLES3(NVGcontext* ctx);
 
 int nvglCreateImageFromHandleGLES3(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
 GLuint nvglImageHandleGLES3(NVGcontext* ctx, int image);
+int nvglDamageRectsGLES3(NVGcontext* ctx, int* rects, int maxRects);
+void nvglImageChangedGLES3(NVGcontext* ctx, int image);
 
 #endif
 
+// With NVG_DAMAGE_REGIONS, nvglDamageRects() returns the regions which change in the current frame
+// as x,y,width,height in framebuffer pixels, with the origin at the bottom left like glScissor().
+// Call it after drawing and before nvgEndFrame(), clear the framebuffer only inside the regions
+// and pass them on, e.g. to eglSetDamageRegionKHR(). nvgEndFrame() then draws only the calls which
+// touch the regions. Returns 0 when nothing changed, and the whole viewport without the flag.
+// The content of images is tracked through nvgUpdateImage(), call nvglImageChanged() when an
+// image is changed otherwise, e.g. rendered to.
+
 // These are additional flags on top of NVGimageFlags.
 enum NVGimageFlagsGL {
 	NVG_IMAGE_NODELETE			= 1<<16,	// Do not delete GL texture handle.
@@ -111,6 +175,35 @@ enum NVGimageFlagsGL {
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+
+// Texture formats which older headers may not define.
+#ifndef GL_UNSIGNED_SHORT_5_6_5
+#define GL_UNSIGNED_SHORT_5_6_5 0x8363
+#endif
+#ifndef GL_UNSIGNED_SHORT_4_4_4_4
+#define GL_UNSIGNED_SHORT_4_4_4_4 0x8033
+#endif
+#ifndef GL_UNSIGNED_SHORT_5_5_5_1
+#define GL_UNSIGNED_SHORT_5_5_5_1 0x8034
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83f1
+#endif
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8d64
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83f3
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93b0
+#endif
 #include "nanovg.h"
 
 enum GLNVGuniformLoc {
@@ -124,7 +217,9 @@ enum GLNVGshaderType {
 	NSVG_SHADER_FILLGRAD,
 	NSVG_SHADER_FILLIMG,
 	NSVG_SHADER_SIMPLE,
-	NSVG_SHADER_IMG
+	NSVG_SHADER_IMG,
+	NSVG_SHADER_SDF,
+	NSVG_SHADER_FILLIMG_ATLAS
 };
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
@@ -147,9 +242,27 @@ struct GLNVGtexture {
 	int width, height;
 	int type;
 	int flags;
+	int generation;	// Incremented when the content changes, for damage tracking.
+	int atlas;		// Texture of the atlas the image is packed into, or zero.
+	int atlasX, atlasY;
 };
 typedef struct GLNVGtexture GLNVGtexture;
 
+#define GLNVG_ATLAS_SIZE 1024
+#define GLNVG_ATLAS_MAX_IMAGE 64	// Largest width and height of an image packed into an atlas.
+
+// Images are packed on shelves, the space of deleted images is reused for new images that fit in it.
+struct GLNVGatlas {
+	int image;
+	int flags;		// Filtering of the atlas texture.
+	int shelfX, shelfY, shelfH;
+	int count;		// Number of images in the atlas.
+	int* freeRects;	// x, y, w, h of the unused rects left by deleted images.
+	int nfreeRects;
+	int cfreeRects;
+};
+typedef struct GLNVGatlas GLNVGatlas;
+
 struct GLNVGblend
 {
 	GLenum srcRGB;
@@ -165,6 +278,8 @@ enum GLNVGcallType {
 	GLNVG_CONVEXFILL,
 	GLNVG_STROKE,
 	GLNVG_TRIANGLES,
+	GLNVG_QUADS,
+	GLNVG_RECT,
 };
 
 struct GLNVGcall {
@@ -174,6 +289,9 @@ struct GLNVGcall {
 	int pathCount;
 	int triangleOffset;
 	int triangleCount;
+	int indexOffset;		// With NVG_INDEXED_GEOMETRY, the fill indices are followed by the stroke indices.
+	int fillIndexCount;
+	int strokeIndexCount;
 	int uniformOffset;
 	GLNVGblend blendFunc;
 };
@@ -182,11 +300,23 @@ typedef struct GLNVGcall GLNVGcall;
 struct GLNVGpath {
 	int fillOffset;
 	int fillCount;
+	int fillTriangles;
 	int strokeOffset;
 	int strokeCount;
 };
 typedef struct GLNVGpath GLNVGpath;
 
+#define GLNVG_MAX_DAMAGE_RECTS 8
+#define GLNVG_GPU_QUERY_COUNT 5
+
+// Content hash and bounds of a draw call, which are compared with the previous frame.
+struct GLNVGcallInfo {
+	unsigned int hash;
+	float bounds[4];
+	int pixels[4];	// Bounds snapped outwards to framebuffer pixels.
+};
+typedef struct GLNVGcallInfo GLNVGcallInfo;
+
 struct GLNVGfragUniforms {
 	#if NANOVG_GL_USE_UNIFORMBUFFER
 		float scissorMat[12]; // matrices are actually 3 vec4s
@@ -202,10 +332,13 @@ struct GLNVGfragUniforms {
 		float strokeThr;
 		int texType;
 		int type;
+		float shapeExt[2];
+		float shapeRadius;
+		float shapeFringe;
 	#else
 		// note: after modifying layout or size of uniform array,
 		// don't forget to also update the fragment shader source!
-		#define NANOVG_GL_UNIFORMARRAY_SIZE 11
+		#define NANOVG_GL_UNIFORMARRAY_SIZE 12
 		union {
 			struct {
 				float scissorMat[12]; // matrices are actually 3 vec4s
@@ -221,6 +354,9 @@ struct GLNVGfragUniforms {
 				float strokeThr;
 				float texType;
 				float type;
+				float shapeExt[2];
+				float shapeRadius;
+				float shapeFringe;
 			};
 			float uniformArray[NANOVG_GL_UNIFORMARRAY_SIZE][4];
 		};
@@ -228,24 +364,73 @@ struct GLNVGfragUniforms {
 };
 typedef struct GLNVGfragUniforms GLNVGfragUniforms;
 
-struct GLNVGcontext {
-	GLNVGshader shader;
+// Vertex layout used with NVG_COMPACT_VERTICES, the texture coordinates are normalized to [0,1].
+struct GLNVGcompactVertex {
+	float x, y;
+	unsigned short u, v;
+};
+typedef struct GLNVGcompactVertex GLNVGcompactVertex;
+
+#if NANOVG_GL_USE_RING_BUFFER
+#define GLNVG_RING_SEGMENTS 3
+
+// Streaming buffer split into per frame segments. The segment of the current frame is mapped
+// while the frame is built, and fenced after it has been drawn.
+struct GLNVGring {
+	GLuint buf;
+	GLsync fences[GLNVG_RING_SEGMENTS];
+	int itemSize;
+	int count;			// Number of items per segment.
+	int seg;			// Segment used by the current frame.
+	int copied;			// Number of items copied to the segment when the buffer was grown.
+	unsigned char* ptr;	// Mapped segment, or NULL.
+};
+typedef struct GLNVGring GLNVGring;
+#endif
+
+// Textures and image atlases, shared by the contexts created with nvgCreateGL3Shared() and the other variants.
+struct GLNVGtextureSet {
+	int refs;
 	GLNVGtexture* textures;
-	float view[2];
 	int ntextures;
 	int ctextures;
 	int textureId;
+	GLNVGatlas* atlases;
+	int natlases;
+	int catlases;
+};
+typedef struct GLNVGtextureSet GLNVGtextureSet;
+
+struct GLNVGcontext {
+	GLNVGshader shader;
+	GLNVGshader rectShader;
+#if NANOVG_GL_USE_INSTANCING
+	GLNVGshader quadShader;
+	int instancedQuads;
+#endif
+	GLNVGtextureSet* texSet;
+	float view[2];
 	GLuint vertBuf;
+	GLuint indexBuf;
 #if defined NANOVG_GL3
 	GLuint vertArr;
 #endif
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	GLuint fragBuf;
+#endif
+#if NANOVG_GL_USE_RING_BUFFER
+	GLuint uploadBuf;
+	GLNVGring vertRing;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	GLNVGring fragRing;
+#endif
 #endif
 	int fragSize;
 	int flags;
+	NVGallocator allocator;
+	NVGarena* arena;
 
-	// Per frame buffers
+	// Per frame buffers, allocated from the frame arena of the context when there is one.
 	GLNVGcall* calls;
 	int ccalls;
 	int ncalls;
@@ -255,10 +440,40 @@ struct GLNVGcontext {
 	struct NVGvertex* verts;
 	int cverts;
 	int nverts;
+	GLuint* indices;
+	int cindices;
+	int nindices;
 	unsigned char* uniforms;
 	int cuniforms;
 	int nuniforms;
 
+	// Uniforms of the last mergeable call, and the index of the call.
+	GLNVGfragUniforms lastFrag;
+	int lastFragCall;
+
+	// Back-end statistics of the current frame.
+	NVGframeStats stats;
+
+	// Damage tracking, the call infos of the current and the previous frame.
+	GLNVGcallInfo* callInfos;
+	int ccallInfos;
+	GLNVGcallInfo* prevCallInfos;
+	int cprevCallInfos;
+	int nprevCallInfos;
+	float prevView[2];	// Zero when there is no previous frame to compare with.
+	float prevPxRatio;
+	float devicePxRatio;
+	int damage[GLNVG_MAX_DAMAGE_RECTS][4];	// In framebuffer pixels, with the origin at the top left.
+	int ndamage;	// Number of damage rects, -1 when not computed for the current frame.
+	int offscreen;	// The current frame renders offscreen, it is drawn in full and not compared with the other frames.
+
+#if NANOVG_GL_TRACE_GPU
+	// Begin and end timestamps of the last flushes, read back when the results are available.
+	int gpuTimer;
+	GLuint queries[GLNVG_GPU_QUERY_COUNT*2];
+	int queryCur, queryRet;
+#endif
+
 	// cached state
 	#if NANOVG_GL_USE_STATE_FILTER
 	GLuint boundTexture;
@@ -274,6 +489,45 @@ struct GLNVGcontext {
 typedef struct GLNVGcontext GLNVGcontext;
 
 static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
+static int glnvg__mini(int a, int b) { return a < b ? a : b; }
+static float glnvg__minf(float a, float b) { return a < b ? a : b; }
+static float glnvg__maxf(float a, float b) { return a > b ? a : b; }
+
+static int glnvg__vertSize(GLNVGcontext* gl)
+{
+	return (gl->flags & NVG_COMPACT_VERTICES) ? (int)sizeof(GLNVGcompactVertex) : (int)sizeof(NVGvertex);
+}
+
+#if NANOVG_GL_USE_RING_BUFFER
+// Returns 1 if the vertices are written directly to the mapped ring, compact vertices are packed into it at flush.
+static int glnvg__mappedVerts(GLNVGcontext* gl)
+{
+	return (gl->flags & NVG_RING_BUFFERS) && (gl->flags & NVG_COMPACT_VERTICES) == 0;
+}
+#endif
+
+static void* glnvg__realloc(GLNVGcontext* gl, void* ptr, size_t size)
+{
+	if (gl->allocator.reallocMem != NULL)
+		return gl->allocator.reallocMem(gl->allocator.userPtr, ptr, size);
+	return realloc(ptr, size);
+}
+
+static void glnvg__free(GLNVGcontext* gl, void* ptr)
+{
+	if (ptr == NULL) return;
+	if (gl->allocator.freeMem != NULL)
+		gl->allocator.freeMem(gl->allocator.userPtr, ptr);
+	else
+		free(ptr);
+}
+
+static void* glnvg__frameRealloc(GLNVGcontext* gl, void* ptr, size_t oldSize, size_t size)
+{
+	if (gl->arena != NULL)
+		return nvgArenaRealloc(gl->arena, ptr, oldSize, size);
+	return glnvg__realloc(gl, ptr, size);
+}
 
 #ifdef NANOVG_GLES2
 static unsigned int glnvg__nearestPow2(unsigned int num)
@@ -289,12 +543,74 @@ static unsigned int glnvg__nearestPow2(unsigned int num)
 }
 #endif
 
+// Returns 1 for compressed types, which have no format or pixel type, 0 for other types and -1 if the type is not known.
+static int glnvg__textureFormat(int type, GLenum* internalFormat, GLenum* format, GLenum* pixelType)
+{
+	*format = GL_RGBA;
+	*pixelType = GL_UNSIGNED_BYTE;
+	switch (type) {
+	case NVG_TEXTURE_ALPHA:
+#if defined(NANOVG_GLES2) || defined (NANOVG_GL2)
+		*internalFormat = *format = GL_LUMINANCE;
+#elif defined(NANOVG_GLES3)
+		*internalFormat = GL_R8;
+		*format = GL_RED;
+#else
+		*internalFormat = *format = GL_RED;
+#endif
+		return 0;
+	case NVG_TEXTURE_RGBA:
+		*internalFormat = GL_RGBA;
+		return 0;
+	// GLES picks the 16-bit internal format from the pixel type, desktop GL needs it to be sized.
+	case NVG_TEXTURE_RGB565:
+		*format = GL_RGB;
+		*pixelType = GL_UNSIGNED_SHORT_5_6_5;
+#if defined(NANOVG_GL2) || defined(NANOVG_GL3)
+		*internalFormat = GL_RGB5;
+#else
+		*internalFormat = GL_RGB;
+#endif
+		return 0;
+	case NVG_TEXTURE_RGBA4444:
+		*pixelType = GL_UNSIGNED_SHORT_4_4_4_4;
+#if defined(NANOVG_GL2) || defined(NANOVG_GL3)
+		*internalFormat = GL_RGBA4;
+#else
+		*internalFormat = GL_RGBA;
+#endif
+		return 0;
+	case NVG_TEXTURE_RGBA5551:
+		*pixelType = GL_UNSIGNED_SHORT_5_5_5_1;
+#if defined(NANOVG_GL2) || defined(NANOVG_GL3)
+		*internalFormat = GL_RGB5_A1;
+#else
+		*internalFormat = GL_RGBA;
+#endif
+		return 0;
+	case NVG_TEXTURE_ETC2_RGB: *internalFormat = GL_COMPRESSED_RGB8_ETC2; return 1;
+	case NVG_TEXTURE_ETC2_RGBA: *internalFormat = GL_COMPRESSED_RGBA8_ETC2_EAC; return 1;
+	// DDS and most encoders write BC1 blocks which can use the transparent black of the RGBA variant.
+	case NVG_TEXTURE_BC1: *internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; return 1;
+	case NVG_TEXTURE_BC3: *internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; return 1;
+	case NVG_TEXTURE_ASTC_4x4: *internalFormat = GL_COMPRESSED_RGBA_ASTC_4x4_KHR; return 1;
+#if defined(NANOVG_GLES2)
+	case NVG_TEXTURE_ETC1: *internalFormat = GL_ETC1_RGB8_OES; return 1;
+#else
+	case NVG_TEXTURE_ETC1: *internalFormat = GL_COMPRESSED_RGB8_ETC2; return 1;
+#endif
+	}
+	return -1;
+}
+
 static void glnvg__bindTexture(GLNVGcontext* gl, GLuint tex)
 {
 #if NANOVG_GL_USE_STATE_FILTER
 	if (gl->boundTexture != tex) {
 		gl->boundTexture = tex;
 		glBindTexture(GL_TEXTURE_2D, tex);
+	} else {
+		gl->stats.filteredStateChanges++;
 	}
 #else
 	glBindTexture(GL_TEXTURE_2D, tex);
@@ -307,6 +623,8 @@ static void glnvg__stencilMask(GLNVGcontext* gl, GLuint mask)
 	if (gl->stencilMask != mask) {
 		gl->stencilMask = mask;
 		glStencilMask(mask);
+	} else {
+		gl->stats.filteredStateChanges++;
 	}
 #else
 	glStencilMask(mask);
@@ -324,6 +642,8 @@ static void glnvg__stencilFunc(GLNVGcontext* gl, GLenum func, GLint ref, GLuint
 		gl->stencilFuncRef = ref;
 		gl->stencilFuncMask = mask;
 		glStencilFunc(func, ref, mask);
+	} else {
+		gl->stats.filteredStateChanges++;
 	}
 #else
 	glStencilFunc(func, ref, mask);
@@ -339,6 +659,8 @@ static void glnvg__blendFuncSeparate(GLNVGcontext* gl, const GLNVGblend* blend)
 
 		gl->blendFunc = *blend;
 		glBlendFuncSeparate(blend->srcRGB, blend->dstRGB, blend->srcAlpha,blend->dstAlpha);
+	} else {
+		gl->stats.filteredStateChanges++;
 	}
 #else
 	glBlendFuncSeparate(blend->srcRGB, blend->dstRGB, blend->srcAlpha,blend->dstAlpha);
@@ -350,26 +672,26 @@ static GLNVGtexture* glnvg__allocTexture(GLNVGcontext* gl)
 	GLNVGtexture* tex = NULL;
 	int i;
 
-	for (i = 0; i < gl->ntextures; i++) {
-		if (gl->textures[i].id == 0) {
-			tex = &gl->textures[i];
+	for (i = 0; i < gl->texSet->ntextures; i++) {
+		if (gl->texSet->textures[i].id == 0) {
+			tex = &gl->texSet->textures[i];
 			break;
 		}
 	}
 	if (tex == NULL) {
-		if (gl->ntextures+1 > gl->ctextures) {
+		if (gl->texSet->ntextures+1 > gl->texSet->ctextures) {
 			GLNVGtexture* textures;
-			int ctextures = glnvg__maxi(gl->ntextures+1, 4) +  gl->ctextures/2; // 1.5x Overallocate
-			textures = (GLNVGtexture*)realloc(gl->textures, sizeof(GLNVGtexture)*ctextures);
+			int ctextures = glnvg__maxi(gl->texSet->ntextures+1, 4) +  gl->texSet->ctextures/2; // 1.5x Overallocate
+			textures = (GLNVGtexture*)glnvg__realloc(gl, gl->texSet->textures, sizeof(GLNVGtexture)*ctextures);
 			if (textures == NULL) return NULL;
-			gl->textures = textures;
-			gl->ctextures = ctextures;
+			gl->texSet->textures = textures;
+			gl->texSet->ctextures = ctextures;
 		}
-		tex = &gl->textures[gl->ntextures++];
+		tex = &gl->texSet->textures[gl->texSet->ntextures++];
 	}
 
 	memset(tex, 0, sizeof(*tex));
-	tex->id = ++gl->textureId;
+	tex->id = ++gl->texSet->textureId;
 
 	return tex;
 }
@@ -377,20 +699,60 @@ static GLNVGtexture* glnvg__allocTexture(GLNVGcontext* gl)
 static GLNVGtexture* glnvg__findTexture(GLNVGcontext* gl, int id)
 {
 	int i;
-	for (i = 0; i < gl->ntextures; i++)
-		if (gl->textures[i].id == id)
-			return &gl->textures[i];
+	for (i = 0; i < gl->texSet->ntextures; i++)
+		if (gl->texSet->textures[i].id == id)
+			return &gl->texSet->textures[i];
 	return NULL;
 }
 
+// Adds a rect to the unused rects of the atlas, the space is lost until the atlas is empty if it can not be stored.
+static void glnvg__atlasFreeRect(GLNVGcontext* gl, GLNVGatlas* atlas, int x, int y, int w, int h)
+{
+	int* r;
+	if (w <= 0 || h <= 0) return;
+	if (atlas->nfreeRects+1 > atlas->cfreeRects) {
+		int* rects;
+		int crects = glnvg__maxi(atlas->nfreeRects+1, 16) + atlas->cfreeRects/2; // 1.5x Overallocate
+		rects = (int*)glnvg__realloc(gl, atlas->freeRects, sizeof(int)*4*crects);
+		if (rects == NULL) return;
+		atlas->freeRects = rects;
+		atlas->cfreeRects = crects;
+	}
+	r = &atlas->freeRects[atlas->nfreeRects*4];
+	r[0] = x;
+	r[1] = y;
+	r[2] = w;
+	r[3] = h;
+	atlas->nfreeRects++;
+}
+
+static void glnvg__releaseAtlasImage(GLNVGcontext* gl, GLNVGtexture* tex)
+{
+	int i;
+	for (i = 0; i < gl->texSet->natlases; i++) {
+		GLNVGatlas* atlas = &gl->texSet->atlases[i];
+		if (atlas->image != tex->atlas) continue;
+		if (--atlas->count == 0) {
+			atlas->shelfX = atlas->shelfY = atlas->shelfH = 0;
+			atlas->nfreeRects = 0;
+		} else {
+			glnvg__atlasFreeRect(gl, atlas, tex->atlasX, tex->atlasY, tex->width+1, tex->height+1);
+		}
+		break;
+	}
+}
+
 static int glnvg__deleteTexture(GLNVGcontext* gl, int id)
 {
 	int i;
-	for (i = 0; i < gl->ntextures; i++) {
-		if (gl->textures[i].id == id) {
-			if (gl->textures[i].tex != 0 && (gl->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
-				glDeleteTextures(1, &gl->textures[i].tex);
-			memset(&gl->textures[i], 0, sizeof(gl->textures[i]));
+	for (i = 0; i < gl->texSet->ntextures; i++) {
+		if (gl->texSet->textures[i].id == id) {
+			// Images in an atlas share its texture, and are created with NVG_IMAGE_NODELETE.
+			if (gl->texSet->textures[i].atlas != 0)
+				glnvg__releaseAtlasImage(gl, &gl->texSet->textures[i]);
+			if (gl->texSet->textures[i].tex != 0 && (gl->texSet->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
+				glDeleteTextures(1, &gl->texSet->textures[i].tex);
+			memset(&gl->texSet->textures[i], 0, sizeof(gl->texSet->textures[i]));
 			return 1;
 		}
 	}
@@ -428,6 +790,108 @@ static void glnvg__checkError(GLNVGcontext* gl, const char* str)
 	}
 }
 
+#if NANOVG_GL_USE_RING_BUFFER
+static int glnvg__ringOffset(GLNVGring* ring)
+{
+	return ring->seg * ring->count * ring->itemSize;
+}
+
+static int glnvg__mapRing(GLNVGring* ring)
+{
+	GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+	GLsync fence = ring->fences[ring->seg];
+
+	// Wait until the GPU is done with the frame that used this segment last.
+	if (fence != NULL) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fence);
+		ring->fences[ring->seg] = NULL;
+	}
+
+	if (ring->copied == 0)
+		access |= GL_MAP_INVALIDATE_RANGE_BIT;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buf);
+	ring->ptr = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, glnvg__ringOffset(ring), ring->count * ring->itemSize, access);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	return ring->ptr != NULL;
+}
+
+static void glnvg__unmapRing(GLNVGring* ring, int n)
+{
+	if (ring->ptr == NULL) return;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buf);
+	if (n > ring->copied)
+		glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, ring->copied * ring->itemSize, (n - ring->copied) * ring->itemSize);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	ring->ptr = NULL;
+}
+
+static void glnvg__deleteRing(GLNVGring* ring)
+{
+	int i;
+	glnvg__unmapRing(ring, 0);
+	for (i = 0; i < GLNVG_RING_SEGMENTS; i++) {
+		if (ring->fences[i] != NULL)
+			glDeleteSync(ring->fences[i]);
+		ring->fences[i] = NULL;
+	}
+	if (ring->buf != 0)
+		glDeleteBuffers(1, &ring->buf);
+	ring->buf = 0;
+}
+
+static int glnvg__growRing(GLNVGring* ring, int n, int count)
+{
+	GLNVGring old = *ring;
+	int i;
+
+	glnvg__unmapRing(&old, n);
+
+	glGenBuffers(1, &ring->buf);
+	if (ring->buf == 0) return 0;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buf);
+	glBufferData(GL_COPY_WRITE_BUFFER, GLNVG_RING_SEGMENTS * count * ring->itemSize, NULL, GL_STREAM_DRAW);
+	// Move the data written so far this frame to the new buffer.
+	if (n > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, old.buf);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, glnvg__ringOffset(&old), 0, n * ring->itemSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// The old buffer is released by GL once pending draws are done with it.
+	old.ptr = NULL;
+	glnvg__deleteRing(&old);
+	for (i = 0; i < GLNVG_RING_SEGMENTS; i++)
+		ring->fences[i] = NULL;
+	ring->count = count;
+	ring->seg = 0;
+	ring->copied = n;
+
+	return glnvg__mapRing(ring);
+}
+
+// Makes sure that the current segment is mapped and has space for n more items.
+static int glnvg__reserveRing(GLNVGring* ring, int nitems, int n, int minCount)
+{
+	if (nitems + n > ring->count)
+		return glnvg__growRing(ring, nitems, glnvg__maxi(nitems + n, minCount) + ring->count/2); // 1.5x Overallocate
+	if (ring->ptr == NULL)
+		return glnvg__mapRing(ring);
+	return 1;
+}
+
+// Fences the current segment after it has been drawn, and moves to the next one.
+static void glnvg__fenceRing(GLNVGring* ring)
+{
+	ring->fences[ring->seg] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ring->seg = (ring->seg + 1) % GLNVG_RING_SEGMENTS;
+	ring->copied = 0;
+}
+#endif
+
 static int glnvg__createShader(GLNVGshader* shader, const char* name, const char* header, const char* opts, const char* vshader, const char* fshader)
 {
 	GLint status;
@@ -465,6 +929,10 @@ static int glnvg__createShader(GLNVGshader* shader, const char* name, const char
 
 	glBindAttribLocation(prog, 0, "vertex");
 	glBindAttribLocation(prog, 1, "tcoord");
+	glBindAttribLocation(prog, 2, "quadPos0");
+	glBindAttribLocation(prog, 3, "quadCoord0");
+	glBindAttribLocation(prog, 4, "quadPos1");
+	glBindAttribLocation(prog, 5, "quadCoord1");
 
 	glLinkProgram(prog);
 	glGetProgramiv(prog, GL_LINK_STATUS, &status);
@@ -528,7 +996,7 @@ static int glnvg__renderCreate(void* uptr)
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	"#define USE_UNIFORMBUFFER 1\n"
 #else
-	"#define UNIFORMARRAY_SIZE 11\n"
+	"#define UNIFORMARRAY_SIZE 12\n"
 #endif
 	"\n";
 
@@ -552,10 +1020,32 @@ static int glnvg__renderCreate(void* uptr)
 		"	gl_Position = vec4(2.0*vertex.x/viewSize.x - 1.0, 1.0 - 2.0*vertex.y/viewSize.y, 0, 1);\n"
 		"}\n";
 
+#if NANOVG_GL_USE_INSTANCING
+	// Each instance is an axis aligned quad, given by the position and texture coordinate of the
+	// opposite corners. The quad is expanded to two triangles based on the vertex index.
+	static const char* quadVertShader =
+		"	uniform vec2 viewSize;\n"
+		"	in vec2 quadPos0;\n"
+		"	in vec2 quadCoord0;\n"
+		"	in vec2 quadPos1;\n"
+		"	in vec2 quadCoord1;\n"
+		"	out vec2 ftcoord;\n"
+		"	out vec2 fpos;\n"
+		"void main(void) {\n"
+		"	int i = gl_VertexID;\n"
+		"	vec2 sel = vec2((i == 1 || i == 2 || i == 5) ? 1.0 : 0.0, (i == 1 || i == 4 || i == 5) ? 1.0 : 0.0);\n"
+		"	vec2 vertex = mix(quadPos0, quadPos1, sel);\n"
+		"	ftcoord = mix(quadCoord0, quadCoord1, sel);\n"
+		"	fpos = vertex;\n"
+		"	gl_Position = vec4(2.0*vertex.x/viewSize.x - 1.0, 1.0 - 2.0*vertex.y/viewSize.y, 0, 1);\n"
+		"}\n";
+#endif
+
 	static const char* fillFragShader =
 		"#ifdef GL_ES\n"
 		"#if defined(GL_FRAGMENT_PRECISION_HIGH) || defined(NANOVG_GL3)\n"
 		" precision highp float;\n"
+		" precision highp sampler2D;\n"
 		"#else\n"
 		" precision mediump float;\n"
 		"#endif\n"
@@ -576,6 +1066,9 @@ static int glnvg__renderCreate(void* uptr)
 		"		float strokeThr;\n"
 		"		int texType;\n"
 		"		int type;\n"
+		"		vec2 shapeExt;\n"
+		"		float shapeRadius;\n"
+		"		float shapeFringe;\n"
 		"	};\n"
 		"#else\n" // NANOVG_GL3 && !USE_UNIFORMBUFFER
 		"	uniform vec4 frag[UNIFORMARRAY_SIZE];\n"
@@ -604,6 +1097,9 @@ static int glnvg__renderCreate(void* uptr)
 		"	#define strokeThr frag[10].y\n"
 		"	#define texType int(frag[10].z)\n"
 		"	#define type int(frag[10].w)\n"
+		"	#define shapeExt frag[11].xy\n"
+		"	#define shapeRadius frag[11].z\n"
+		"	#define shapeFringe frag[11].w\n"
 		"#endif\n"
 		"\n"
 		"float sdroundrect(vec2 pt, vec2 ext, float rad) {\n"
@@ -618,6 +1114,13 @@ static int glnvg__renderCreate(void* uptr)
 		"	sc = vec2(0.5,0.5) - sc * scissorScale;\n"
 		"	return clamp(sc.x,0.0,1.0) * clamp(sc.y,0.0,1.0);\n"
 		"}\n"
+		"#ifdef SHAPE_RECT\n"
+		"// Rounded rect drawn as a quad, tc goes from 0 to 1 over the rect and the outer half of the fringe.\n"
+		"float rectMask(vec2 tc) {\n"
+		"	float d = sdroundrect((tc*2.0-1.0) * (shapeExt + 0.5*shapeFringe), shapeExt, shapeRadius);\n"
+		"	return shapeFringe > 0.0 ? clamp(0.5 - d / shapeFringe, 0.0, 1.0) : step(d, 0.0);\n"
+		"}\n"
+		"#endif\n"
 		"#ifdef EDGE_AA\n"
 		"// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.\n"
 		"float strokeMask() {\n"
@@ -628,7 +1131,9 @@ static int glnvg__renderCreate(void* uptr)
 		"void main(void) {\n"
 		"   vec4 result;\n"
 		"	float scissor = scissorMask(fpos);\n"
-		"#ifdef EDGE_AA\n"
+		"#if defined(SHAPE_RECT)\n"
+		"	float strokeAlpha = rectMask(ftcoord);\n"
+		"#elif defined(EDGE_AA)\n"
 		"	float strokeAlpha = strokeMask();\n"
 		"	if (strokeAlpha < strokeThr) discard;\n"
 		"#else\n"
@@ -642,9 +1147,11 @@ static int glnvg__renderCreate(void* uptr)
 		"		// Combine alpha\n"
 		"		color *= strokeAlpha * scissor;\n"
 		"		result = color;\n"
-		"	} else if (type == 1) {		// Image\n"
+		"	} else if (type == 1 || type == 5) {		// Image\n"
 		"		// Calculate color fron texture\n"
 		"		vec2 pt = (paintMat * vec3(fpos,1.0)).xy / extent;\n"
+		"		// Image in an atlas, clamp to its edge texels and offset to its rect in outerCol.\n"
+		"		if (type == 5) pt = outerCol.xy + clamp(pt, vec2(radius,feather), vec2(1.0-radius,1.0-feather)) * outerCol.zw;\n"
 		"#ifdef NANOVG_GL3\n"
 		"		vec4 color = texture(tex, pt);\n"
 		"#else\n"
@@ -669,6 +1176,14 @@ static int glnvg__renderCreate(void* uptr)
 		"		if (texType == 2) color = vec4(color.x);"
 		"		color *= scissor;\n"
 		"		result = color * innerCol;\n"
+		"	} else if (type == 4) {		// Distance field text\n"
+		"#ifdef NANOVG_GL3\n"
+		"		float dist = texture(tex, ftcoord).x;\n"
+		"#else\n"
+		"		float dist = texture2D(tex, ftcoord).x;\n"
+		"#endif\n"
+		"		float alpha = clamp((dist - 0.5) * radius / feather + 0.5, 0.0, 1.0);\n"
+		"		result = innerCol * (alpha * scissor);\n"
 		"	}\n"
 		"#ifdef NANOVG_GL3\n"
 		"	outColor = result;\n"
@@ -690,24 +1205,82 @@ static int glnvg__renderCreate(void* uptr)
 	glnvg__checkError(gl, "uniform locations");
 	glnvg__getUniforms(&gl->shader);
 
+	// Rects get their own program, so that other fills don't pay for the branch.
+	if (glnvg__createShader(&gl->rectShader, "rect", shaderHeader, (gl->flags & NVG_ANTIALIAS) ? "#define EDGE_AA 1\n#define SHAPE_RECT 1\n" : "#define SHAPE_RECT 1\n", fillVertShader, fillFragShader) == 0)
+		return 0;
+	glnvg__getUniforms(&gl->rectShader);
+
+#if NANOVG_GL_USE_INSTANCING
+	// Instanced arrays are core since GL 3.3 and GLES 3.0.
+#if defined NANOVG_GL3
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		gl->instancedQuads = major > 3 || (major == 3 && minor >= 3);
+	}
+#else
+	gl->instancedQuads = 1;
+#endif
+	if (gl->instancedQuads) {
+		if (glnvg__createShader(&gl->quadShader, "quad", shaderHeader, (gl->flags & NVG_ANTIALIAS) ? "#define EDGE_AA 1\n" : NULL, quadVertShader, fillFragShader) == 0)
+			return 0;
+		glnvg__getUniforms(&gl->quadShader);
+	}
+#endif
+
 	// Create dynamic vertex array
 #if defined NANOVG_GL3
 	glGenVertexArrays(1, &gl->vertArr);
 #endif
 	glGenBuffers(1, &gl->vertBuf);
 
+#if defined NANOVG_GLES2
+	// 32-bit indices are an extension on GLES2.
+	{
+		const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+		if (ext == NULL || strstr(ext, "GL_OES_element_index_uint") == NULL)
+			gl->flags &= ~NVG_INDEXED_GEOMETRY;
+	}
+#endif
+	if (gl->flags & NVG_INDEXED_GEOMETRY)
+		glGenBuffers(1, &gl->indexBuf);
+
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	// Create UBOs
 	glUniformBlockBinding(gl->shader.prog, gl->shader.loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
+	glUniformBlockBinding(gl->rectShader.prog, gl->rectShader.loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
+#if NANOVG_GL_USE_INSTANCING
+	if (gl->instancedQuads)
+		glUniformBlockBinding(gl->quadShader.prog, gl->quadShader.loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
+#endif
 	glGenBuffers(1, &gl->fragBuf);
 	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
 #endif
 	gl->fragSize = sizeof(GLNVGfragUniforms) + align - sizeof(GLNVGfragUniforms) % align;
 
+#if NANOVG_GL_USE_RING_BUFFER
+	gl->vertRing.itemSize = glnvg__vertSize(gl);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	gl->fragRing.itemSize = gl->fragSize;
+#endif
+#endif
+
 	// Some platforms does not allow to have samples to unset textures.
 	// Create empty one which is bound when there's no texture specified.
 	gl->dummyTex = glnvg__renderCreateTexture(gl, NVG_TEXTURE_ALPHA, 1, 1, 0, NULL);
 
+#if NANOVG_GL_TRACE_GPU
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		gl->gpuTimer = major > 3 || (major == 3 && minor >= 3);
+		if (gl->gpuTimer)
+			glGenQueries(GLNVG_GPU_QUERY_COUNT*2, gl->queries);
+	}
+#endif
+
 	glnvg__checkError(gl, "create done");
 
 	glFinish();
@@ -715,11 +1288,117 @@ static int glnvg__renderCreate(void* uptr)
 	return 1;
 }
 
+static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data);
+
+static int glnvg__atlasAddRect(GLNVGcontext* gl, GLNVGatlas* atlas, int w, int h, int* x, int* y)
+{
+	int i, best = -1;
+
+	// Use the smallest unused rect that fits, and keep the space right of and below the image.
+	for (i = 0; i < atlas->nfreeRects; i++) {
+		int* r = &atlas->freeRects[i*4];
+		if (r[2] >= w && r[3] >= h && (best == -1 || r[2]*r[3] < atlas->freeRects[best*4+2]*atlas->freeRects[best*4+3]))
+			best = i;
+	}
+	if (best != -1) {
+		int r[4];
+		memcpy(r, &atlas->freeRects[best*4], sizeof(r));
+		atlas->nfreeRects--;
+		memmove(&atlas->freeRects[best*4], &atlas->freeRects[atlas->nfreeRects*4], sizeof(int)*4);
+		*x = r[0];
+		*y = r[1];
+		glnvg__atlasFreeRect(gl, atlas, r[0] + w, r[1], r[2] - w, h);
+		glnvg__atlasFreeRect(gl, atlas, r[0], r[1] + h, r[2], r[3] - h);
+		return 1;
+	}
+
+	if (atlas->shelfX + w > GLNVG_ATLAS_SIZE) {
+		atlas->shelfX = 0;
+		atlas->shelfY += atlas->shelfH;
+		atlas->shelfH = 0;
+	}
+	if (atlas->shelfY + h > GLNVG_ATLAS_SIZE)
+		return 0;
+	*x = atlas->shelfX;
+	*y = atlas->shelfY;
+	atlas->shelfX += w;
+	atlas->shelfH = glnvg__maxi(atlas->shelfH, h);
+	return 1;
+}
+
+// Packs the image into an atlas with the same filtering, returns zero if it should get its own texture.
+static int glnvg__createAtlasImage(GLNVGcontext* gl, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	GLNVGatlas* atlas = NULL;
+	GLNVGtexture* tex;
+	GLNVGtexture* atlasTex;
+	int i, x = 0, y = 0;
+	int flags = imageFlags & NVG_IMAGE_NEAREST;
+
+	// Images created without data are usually render targets, which need their own texture.
+	if ((gl->flags & NVG_ATLAS_IMAGES) == 0 || type != NVG_TEXTURE_RGBA || data == NULL) return 0;
+	if (w > GLNVG_ATLAS_MAX_IMAGE || h > GLNVG_ATLAS_MAX_IMAGE) return 0;
+	if (imageFlags & (NVG_IMAGE_GENERATE_MIPMAPS | NVG_IMAGE_REPEATX | NVG_IMAGE_REPEATY | NVG_IMAGE_NODELETE)) return 0;
+
+	// Leave a texel between the images, so that rounding never samples a neighbour.
+	for (i = 0; i < gl->texSet->natlases; i++) {
+		if (gl->texSet->atlases[i].flags == flags && glnvg__atlasAddRect(gl, &gl->texSet->atlases[i], w+1, h+1, &x, &y)) {
+			atlas = &gl->texSet->atlases[i];
+			break;
+		}
+	}
+	if (atlas == NULL) {
+		if (gl->texSet->natlases+1 > gl->texSet->catlases) {
+			GLNVGatlas* atlases;
+			int catlases = glnvg__maxi(gl->texSet->natlases+1, 4) + gl->texSet->catlases/2; // 1.5x Overallocate
+			atlases = (GLNVGatlas*)glnvg__realloc(gl, gl->texSet->atlases, sizeof(GLNVGatlas)*catlases);
+			if (atlases == NULL) return 0;
+			gl->texSet->atlases = atlases;
+			gl->texSet->catlases = catlases;
+		}
+		atlas = &gl->texSet->atlases[gl->texSet->natlases];
+		memset(atlas, 0, sizeof(*atlas));
+		atlas->flags = flags;
+		atlas->image = glnvg__renderCreateTexture(gl, NVG_TEXTURE_RGBA, GLNVG_ATLAS_SIZE, GLNVG_ATLAS_SIZE, flags, NULL);
+		if (atlas->image == 0) return 0;
+		gl->texSet->natlases++;
+		glnvg__atlasAddRect(gl, atlas, w+1, h+1, &x, &y);
+	}
+
+	tex = glnvg__allocTexture(gl);
+	if (tex == NULL) return 0;
+	atlasTex = glnvg__findTexture(gl, atlas->image);
+	if (atlasTex == NULL) return 0;
+	tex->tex = atlasTex->tex;
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+	tex->flags = imageFlags | NVG_IMAGE_NODELETE;
+	tex->atlas = atlas->image;
+	tex->atlasX = x;
+	tex->atlasY = y;
+	atlas->count++;
+
+	glnvg__renderUpdateTexture(gl, tex->id, 0,0, w,h, data);
+
+	return tex->id;
+}
+
 static int glnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
-	GLNVGtexture* tex = glnvg__allocTexture(gl);
+	GLNVGtexture* tex;
+	GLenum internalFormat, format, pixelType;
+	int compressed = glnvg__textureFormat(type, &internalFormat, &format, &pixelType);
+	int image;
 
+	if (compressed == -1) return 0;
+	// Mipmaps can not be generated for compressed textures.
+	if (compressed)
+		imageFlags &= ~NVG_IMAGE_GENERATE_MIPMAPS;
+	image = glnvg__createAtlasImage(gl, type, w, h, imageFlags, data);
+	if (image != 0) return image;
+	tex = glnvg__allocTexture(gl);
 	if (tex == NULL) return 0;
 
 #ifdef NANOVG_GLES2
@@ -759,16 +1438,19 @@ static int glnvg__renderCreateTexture(void* uptr, int type, int w, int h, int im
 	}
 #endif
 
-	if (type == NVG_TEXTURE_RGBA)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-	else
-#if defined(NANOVG_GLES2) || defined (NANOVG_GL2)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, w, h, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
-#elif defined(NANOVG_GLES3)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, data);
-#else
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, data);
-#endif
+	if (compressed) {
+		// Errors from earlier calls would be taken as the format not being supported.
+		while (glGetError() != GL_NO_ERROR);
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, nvgTextureBytes(type, w, h), data);
+		// Compressed formats the driver does not support are only reported as errors.
+		if (glGetError() != GL_NO_ERROR) {
+			glnvg__bindTexture(gl, 0);
+			glnvg__deleteTexture(gl, tex->id);
+			return 0;
+		}
+	} else {
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, pixelType, data);
+	}
 
 	if (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) {
 		if (imageFlags & NVG_IMAGE_NEAREST) {
@@ -827,14 +1509,62 @@ static int glnvg__renderDeleteTexture(void* uptr, int image)
 	return glnvg__deleteTexture(gl, image);
 }
 
+#if NANOVG_GL_USE_RING_BUFFER
+// Copies the rectangle to a pixel buffer and updates the texture from it, the copy is tightly packed.
+static int glnvg__uploadPixelBuffer(GLNVGcontext* gl, GLNVGtexture* tex, int x, int y, int w, int h, const unsigned char* data)
+{
+	GLsizeiptr size = (GLsizeiptr)w*h*4;
+	unsigned char* dst;
+	int i;
+
+	if (gl->uploadBuf == 0)
+		glGenBuffers(1, &gl->uploadBuf);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->uploadBuf);
+	// Orphan the storage, the previous upload may still be in flight.
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (dst == NULL) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return 0;
+	}
+	for (i = 0; i < h; i++)
+		memcpy(&dst[i*w*4], &data[((y+i)*tex->width + x)*4], w*4);
+	if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return 0;
+	}
+	glTexSubImage2D(GL_TEXTURE_2D, 0, tex->atlasX + x, tex->atlasY + y, w,h, GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid*)0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return 1;
+}
+#endif
+
 static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGtexture* tex = glnvg__findTexture(gl, image);
+	GLenum internalFormat, format, pixelType;
+	int bpp;
 
 	if (tex == NULL) return 0;
+	if (glnvg__textureFormat(tex->type, &internalFormat, &format, &pixelType) != 0) return 0;
+	bpp = nvgTextureBytes(tex->type, 1, 1);
+	// Font atlas updates can fill in glyphs that were already drawn, when they are rasterized
+	// asynchronously or replace evicted glyphs, so every update damages the calls using the texture.
+	tex->generation++;
 	glnvg__bindTexture(gl, tex->tex);
 
+#if NANOVG_GL_USE_RING_BUFFER
+	if ((gl->flags & NVG_PBO_UPLOADS) && tex->type == NVG_TEXTURE_RGBA &&
+		glnvg__uploadPixelBuffer(gl, tex, x, y, w, h, data)) {
+		gl->stats.textureBytes += w*h*4;
+		if (tex->flags & NVG_IMAGE_GENERATE_MIPMAPS)
+			glGenerateMipmap(GL_TEXTURE_2D);
+		glnvg__bindTexture(gl, 0);
+		return 1;
+	}
+#endif
+
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
 
 #ifndef NANOVG_GLES2
@@ -843,22 +1573,13 @@ static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w
 	glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
 #else
 	// No support for all of skip, need to update a whole row at a time.
-	if (tex->type == NVG_TEXTURE_RGBA)
-		data += y*tex->width*4;
-	else
-		data += y*tex->width;
+	data += y*tex->width*bpp;
 	x = 0;
 	w = tex->width;
 #endif
 
-	if (tex->type == NVG_TEXTURE_RGBA)
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_RGBA, GL_UNSIGNED_BYTE, data);
-	else
-#if defined(NANOVG_GLES2) || defined(NANOVG_GL2)
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
-#else
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_RED, GL_UNSIGNED_BYTE, data);
-#endif
+	glTexSubImage2D(GL_TEXTURE_2D, 0, tex->atlasX + x, tex->atlasY + y, w,h, format, pixelType, data);
+	gl->stats.textureBytes += w*h*bpp;
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 #ifndef NANOVG_GLES2
@@ -867,6 +1588,12 @@ static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w
 	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
 #endif
 
+	// GL2 regenerates the mipmaps through the GL_GENERATE_MIPMAP parameter.
+#if !defined(NANOVG_GL2)
+	if (tex->flags & NVG_IMAGE_GENERATE_MIPMAPS)
+		glGenerateMipmap(GL_TEXTURE_2D);
+#endif
+
 	glnvg__bindTexture(gl, 0);
 
 	return 1;
@@ -882,6 +1609,13 @@ static int glnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
 	return 1;
 }
 
+static int glnvg__renderGetTextureType(void* uptr, int image)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGtexture* tex = glnvg__findTexture(gl, image);
+	return tex != NULL ? tex->type : 0;
+}
+
 static void glnvg__xformToMat3x4(float* m3, float* t)
 {
 	m3[0] = t[0];
@@ -941,25 +1675,32 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 		if (tex == NULL) return 0;
 		if ((tex->flags & NVG_IMAGE_FLIPY) != 0) {
 			float m1[6], m2[6];
-			nvgTransformTranslate(m1, 0.0f, frag->extent[1] * 0.5f);
+			nvgTransformTranslate(m1, 0.0f, paint->extent[1] * 0.5f);
 			nvgTransformMultiply(m1, paint->xform);
 			nvgTransformScale(m2, 1.0f, -1.0f);
 			nvgTransformMultiply(m2, m1);
-			nvgTransformTranslate(m1, 0.0f, -frag->extent[1] * 0.5f);
+			nvgTransformTranslate(m1, 0.0f, -paint->extent[1] * 0.5f);
 			nvgTransformMultiply(m1, m2);
 			nvgTransformInverse(invxform, m1);
 		} else {
 			nvgTransformInverse(invxform, paint->xform);
 		}
 		frag->type = NSVG_SHADER_FILLIMG;
+		if (tex->atlas != 0) {
+			frag->type = NSVG_SHADER_FILLIMG_ATLAS;
+			frag->outerCol = nvgRGBAf(tex->atlasX / (float)GLNVG_ATLAS_SIZE, tex->atlasY / (float)GLNVG_ATLAS_SIZE,
+									  tex->width / (float)GLNVG_ATLAS_SIZE, tex->height / (float)GLNVG_ATLAS_SIZE);
+			frag->radius = 0.5f / tex->width;
+			frag->feather = 0.5f / tex->height;
+		}
 
 		#if NANOVG_GL_USE_UNIFORMBUFFER
-		if (tex->type == NVG_TEXTURE_RGBA)
+		if (tex->type != NVG_TEXTURE_ALPHA)
 			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
 		else
 			frag->texType = 2;
 		#else
-		if (tex->type == NVG_TEXTURE_RGBA)
+		if (tex->type != NVG_TEXTURE_ALPHA)
 			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0.0f : 1.0f;
 		else
 			frag->texType = 2.0f;
@@ -979,14 +1720,33 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 
 static GLNVGfragUniforms* nvg__fragUniformPtr(GLNVGcontext* gl, int i);
 
-static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
+static void glnvg__setTextureShader(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpaint* paint)
+{
+	GLNVGtexture* tex = glnvg__findTexture(gl, paint->image);
+	frag->type = NSVG_SHADER_IMG;
+	if (tex != NULL && (tex->flags & NVG_IMAGE_SDF) != 0) {
+		// Radius scales the sampled distance to pixels, feather is the edge width.
+		frag->type = NSVG_SHADER_SDF;
+		frag->radius = paint->radius;
+		frag->feather = paint->feather;
+	}
+}
+
+static void glnvg__setShaderUniforms(GLNVGcontext* gl, GLNVGshader* shader, int uniformOffset, int image)
 {
 	GLNVGtexture* tex = NULL;
 #if NANOVG_GL_USE_UNIFORMBUFFER
+	NVG_NOTUSED(shader);
+#if NANOVG_GL_USE_RING_BUFFER
+	if (gl->flags & NVG_RING_BUFFERS)
+		glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragRing.buf, glnvg__ringOffset(&gl->fragRing) + uniformOffset, sizeof(GLNVGfragUniforms));
+	else
+#endif
 	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf, uniformOffset, sizeof(GLNVGfragUniforms));
 #else
 	GLNVGfragUniforms* frag = nvg__fragUniformPtr(gl, uniformOffset);
-	glUniform4fv(gl->shader.loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE, &(frag->uniformArray[0][0]));
+	glUniform4fv(shader->loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE, &(frag->uniformArray[0][0]));
+	gl->stats.uniformBytes += sizeof(frag->uniformArray);
 #endif
 
 	if (image != 0) {
@@ -1000,18 +1760,75 @@ static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
 	glnvg__checkError(gl, "tex paint tex");
 }
 
+static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
+{
+	glnvg__setShaderUniforms(gl, &gl->shader, uniformOffset, image);
+}
+
+static void glnvg__renderOffscreenFrame(void* uptr)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	gl->offscreen = 1;
+}
+
 static void glnvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio)
 {
-	NVG_NOTUSED(devicePixelRatio);
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	gl->view[0] = width;
 	gl->view[1] = height;
+	gl->devicePxRatio = devicePixelRatio;
+	gl->ndamage = -1;
+	gl->offscreen = 0;
+	memset(&gl->stats, 0, sizeof(gl->stats));
+
+	// The frame arena was reset, allocate the buffers again at the sizes earlier frames needed.
+	if (gl->arena != NULL) {
+		gl->calls = (GLNVGcall*)nvgArenaRealloc(gl->arena, NULL, 0, sizeof(GLNVGcall) * gl->ccalls);
+		if (gl->calls == NULL) gl->ccalls = 0;
+		gl->paths = (GLNVGpath*)nvgArenaRealloc(gl->arena, NULL, 0, sizeof(GLNVGpath) * gl->cpaths);
+		if (gl->paths == NULL) gl->cpaths = 0;
+#if NANOVG_GL_USE_RING_BUFFER
+		if (!glnvg__mappedVerts(gl))
+#endif
+		{
+			gl->verts = (NVGvertex*)nvgArenaRealloc(gl->arena, NULL, 0, sizeof(NVGvertex) * gl->cverts);
+			if (gl->verts == NULL) gl->cverts = 0;
+		}
+		gl->indices = (GLuint*)nvgArenaRealloc(gl->arena, NULL, 0, sizeof(GLuint) * gl->cindices);
+		if (gl->indices == NULL) gl->cindices = 0;
+#if NANOVG_GL_USE_RING_BUFFER && NANOVG_GL_USE_UNIFORMBUFFER
+		if ((gl->flags & NVG_RING_BUFFERS) == 0)
+#endif
+		{
+			gl->uniforms = (unsigned char*)nvgArenaRealloc(gl->arena, NULL, 0, gl->fragSize * gl->cuniforms);
+			if (gl->uniforms == NULL) gl->cuniforms = 0;
+		}
+	}
 }
 
-static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
+static void glnvg__drawIndices(int offset, int count)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
-	int i, npaths = call->pathCount;
+	if (count > 0)
+		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const GLvoid*)(offset * sizeof(GLuint)));
+}
+
+// Draws the stroke strips of all paths of the call, or the fringes of a fill.
+static void glnvg__drawStrokes(GLNVGcontext* gl, GLNVGcall* call)
+{
+	GLNVGpath* paths = &gl->paths[call->pathOffset];
+	int i;
+	if (gl->flags & NVG_INDEXED_GEOMETRY) {
+		glnvg__drawIndices(call->indexOffset + call->fillIndexCount, call->strokeIndexCount);
+		return;
+	}
+	for (i = 0; i < call->pathCount; i++)
+		glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+}
+
+static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
+{
+	GLNVGpath* paths = &gl->paths[call->pathOffset];
+	int i, npaths = call->pathCount;
 
 	// Draw shapes
 	glEnable(GL_STENCIL_TEST);
@@ -1026,8 +1843,12 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 	glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
 	glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
 	glDisable(GL_CULL_FACE);
-	for (i = 0; i < npaths; i++)
-		glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
+	if (gl->flags & NVG_INDEXED_GEOMETRY) {
+		glnvg__drawIndices(call->indexOffset, call->fillIndexCount);
+	} else {
+		for (i = 0; i < npaths; i++)
+			glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
+	}
 	glEnable(GL_CULL_FACE);
 
 	// Draw anti-aliased pixels
@@ -1040,8 +1861,7 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 		glnvg__stencilFunc(gl, GL_EQUAL, 0x00, 0xff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		// Draw fringes
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawStrokes(gl, call);
 	}
 
 	// Draw fill
@@ -1060,8 +1880,12 @@ static void glnvg__convexFill(GLNVGcontext* gl, GLNVGcall* call)
 	glnvg__setUniforms(gl, call->uniformOffset, call->image);
 	glnvg__checkError(gl, "convex fill");
 
+	if (gl->flags & NVG_INDEXED_GEOMETRY) {
+		glnvg__drawIndices(call->indexOffset, call->fillIndexCount);
+		return;
+	}
 	for (i = 0; i < npaths; i++) {
-		glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
+		glDrawArrays(paths[i].fillTriangles ? GL_TRIANGLES : GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
 		// Draw fringes
 		if (paths[i].strokeCount > 0) {
 			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
@@ -1071,9 +1895,6 @@ static void glnvg__convexFill(GLNVGcontext* gl, GLNVGcall* call)
 
 static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
-	int npaths = call->pathCount, i;
-
 	if (gl->flags & NVG_STENCIL_STROKES) {
 
 		glEnable(GL_STENCIL_TEST);
@@ -1084,23 +1905,20 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
 		glnvg__setUniforms(gl, call->uniformOffset + gl->fragSize, call->image);
 		glnvg__checkError(gl, "stroke fill 0");
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawStrokes(gl, call);
 
 		// Draw anti-aliased pixels.
 		glnvg__setUniforms(gl, call->uniformOffset, call->image);
 		glnvg__stencilFunc(gl, GL_EQUAL, 0x00, 0xff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawStrokes(gl, call);
 
 		// Clear stencil buffer.
 		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 		glnvg__stencilFunc(gl, GL_ALWAYS, 0x0, 0xff);
 		glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
 		glnvg__checkError(gl, "stroke fill 1");
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawStrokes(gl, call);
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
 		glDisable(GL_STENCIL_TEST);
@@ -1111,8 +1929,7 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 		glnvg__setUniforms(gl, call->uniformOffset, call->image);
 		glnvg__checkError(gl, "stroke fill");
 		// Draw Strokes
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawStrokes(gl, call);
 	}
 }
 
@@ -1124,12 +1941,99 @@ static void glnvg__triangles(GLNVGcontext* gl, GLNVGcall* call)
 	glDrawArrays(GL_TRIANGLES, call->triangleOffset, call->triangleCount);
 }
 
+static void glnvg__rect(GLNVGcontext* gl, GLNVGcall* call)
+{
+	glUseProgram(gl->rectShader.prog);
+	glUniform1i(gl->rectShader.loc[GLNVG_LOC_TEX], 0);
+	glUniform2fv(gl->rectShader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
+	glnvg__setShaderUniforms(gl, &gl->rectShader, call->uniformOffset, call->image);
+	glnvg__checkError(gl, "rect fill");
+
+	glDrawArrays(GL_TRIANGLES, call->triangleOffset, call->triangleCount);
+
+	glUseProgram(gl->shader.prog);
+}
+
+static unsigned short glnvg__packCoord(float a)
+{
+	if (a <= 0.0f) return 0;
+	if (a >= 1.0f) return 65535;
+	return (unsigned short)(a * 65535.0f + 0.5f);
+}
+
+// Packs n vertices to the compact layout, dst may point to the same memory as src.
+static void glnvg__packVerts(void* dst, const NVGvertex* src, int n)
+{
+	GLNVGcompactVertex c;
+	NVGvertex v;
+	int i;
+	for (i = 0; i < n; i++) {
+		// Copied through locals, vertex i is written over the start of itself when packed in place.
+		memcpy(&v, &src[i], sizeof(v));
+		c.x = v.x;
+		c.y = v.y;
+		c.u = glnvg__packCoord(v.u);
+		c.v = glnvg__packCoord(v.v);
+		memcpy((unsigned char*)dst + i * sizeof(c), &c, sizeof(c));
+	}
+}
+
+static void glnvg__vertexAttribs(GLNVGcontext* gl, GLuint pos, GLuint tcoord, int stride, size_t offset)
+{
+	glVertexAttribPointer(pos, 2, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offset);
+	if (gl->flags & NVG_COMPACT_VERTICES)
+		glVertexAttribPointer(tcoord, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (const GLvoid*)(offset + 2*sizeof(float)));
+	else
+		glVertexAttribPointer(tcoord, 2, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(offset + 2*sizeof(float)));
+}
+
+#if NANOVG_GL_USE_INSTANCING
+static void glnvg__quads(GLNVGcontext* gl, GLNVGcall* call, size_t vertOffset)
+{
+	int i, vertSize = glnvg__vertSize(gl);
+	size_t offset = vertOffset + call->triangleOffset * vertSize;
+
+	glUseProgram(gl->quadShader.prog);
+	glUniform1i(gl->quadShader.loc[GLNVG_LOC_TEX], 0);
+	glUniform2fv(gl->quadShader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
+	glnvg__setShaderUniforms(gl, &gl->quadShader, call->uniformOffset, call->image);
+	glnvg__checkError(gl, "quads fill");
+
+	// One instance per quad, both corners are read from consecutive vertices.
+	for (i = 2; i < 6; i++) {
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
+	}
+	glnvg__vertexAttribs(gl, 2, 3, 2*vertSize, offset);
+	glnvg__vertexAttribs(gl, 4, 5, 2*vertSize, offset + vertSize);
+
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, call->triangleCount);
+
+	for (i = 2; i < 6; i++) {
+		glVertexAttribDivisor(i, 0);
+		glDisableVertexAttribArray(i);
+	}
+
+	glUseProgram(gl->shader.prog);
+}
+#endif
+
 static void glnvg__renderCancel(void* uptr) {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+#if NANOVG_GL_USE_RING_BUFFER
+	// Mapped segments are kept and overwritten by the next frame.
+	gl->vertRing.copied = 0;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	gl->fragRing.copied = 0;
+#endif
+#endif
 	gl->nverts = 0;
+	gl->nindices = 0;
 	gl->npaths = 0;
 	gl->ncalls = 0;
 	gl->nuniforms = 0;
+	gl->lastFragCall = -1;
+	gl->ndamage = -1;
 }
 
 static GLenum glnvg_convertBlendFuncFactor(int factor)
@@ -1176,12 +2080,291 @@ static GLNVGblend glnvg__blendCompositeOperation(NVGcompositeOperationState op)
 	return blend;
 }
 
+static int glnvg__damageTracking(GLNVGcontext* gl)
+{
+	if ((gl->flags & NVG_DAMAGE_REGIONS) == 0 || gl->offscreen) return 0;
+#if NANOVG_GL_USE_RING_BUFFER
+	if (gl->flags & NVG_RING_BUFFERS) return 0;
+#endif
+	return 1;
+}
+
+static unsigned int glnvg__hashBytes(unsigned int h, const void* data, size_t size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	size_t i;
+	for (i = 0; i < size; i++)
+		h = (h ^ p[i]) * 16777619u;	// FNV-1a
+	return h;
+}
+
+static unsigned int glnvg__hashVerts(unsigned int h, float* bounds, const NVGvertex* verts, int nverts)
+{
+	int i;
+	for (i = 0; i < nverts; i++) {
+		bounds[0] = glnvg__minf(bounds[0], verts[i].x);
+		bounds[1] = glnvg__minf(bounds[1], verts[i].y);
+		bounds[2] = glnvg__maxf(bounds[2], verts[i].x);
+		bounds[3] = glnvg__maxf(bounds[3], verts[i].y);
+	}
+	return glnvg__hashBytes(h, verts, sizeof(NVGvertex) * nverts);
+}
+
+// Hashes everything that affects the pixels of the call, and calculates the bounds of its vertices.
+static void glnvg__callInfo(GLNVGcontext* gl, GLNVGcall* call, GLNVGcallInfo* info)
+{
+	GLNVGtexture* tex = call->image != 0 ? glnvg__findTexture(gl, call->image) : NULL;
+	unsigned int h = 2166136261u;
+	int i, nfrag = 1;
+
+	info->bounds[0] = info->bounds[1] = 1e6f;
+	info->bounds[2] = info->bounds[3] = -1e6f;
+
+	h = glnvg__hashBytes(h, &call->type, sizeof(call->type));
+	h = glnvg__hashBytes(h, &call->blendFunc, sizeof(call->blendFunc));
+	h = glnvg__hashBytes(h, &call->image, sizeof(call->image));
+	if (tex != NULL)
+		h = glnvg__hashBytes(h, &tex->generation, sizeof(tex->generation));
+
+	if (call->type == GLNVG_FILL || call->type == GLNVG_CONVEXFILL || call->type == GLNVG_STROKE) {
+		for (i = 0; i < call->pathCount; i++) {
+			GLNVGpath* path = &gl->paths[call->pathOffset + i];
+			h = glnvg__hashVerts(h, info->bounds, &gl->verts[path->fillOffset], path->fillCount);
+			h = glnvg__hashVerts(h, info->bounds, &gl->verts[path->strokeOffset], path->strokeCount);
+		}
+		if (call->type == GLNVG_FILL)
+			h = glnvg__hashVerts(h, info->bounds, &gl->verts[call->triangleOffset], call->triangleCount);
+		if (call->type == GLNVG_FILL || (call->type == GLNVG_STROKE && (gl->flags & NVG_STENCIL_STROKES)))
+			nfrag = 2;
+	} else if (call->type == GLNVG_QUADS) {
+		h = glnvg__hashVerts(h, info->bounds, &gl->verts[call->triangleOffset], call->triangleCount*2);
+	} else {
+		h = glnvg__hashVerts(h, info->bounds, &gl->verts[call->triangleOffset], call->triangleCount);
+	}
+
+	for (i = 0; i < nfrag; i++)
+		h = glnvg__hashBytes(h, &gl->uniforms[call->uniformOffset + i*gl->fragSize], sizeof(GLNVGfragUniforms));
+	info->hash = h;
+}
+
+// Snaps a rect outwards to framebuffer pixels, clamped to the view.
+static void glnvg__snapRect(GLNVGcontext* gl, const float* r, int* px)
+{
+	float s = gl->devicePxRatio;
+	int w = (int)(gl->view[0]*s + 0.5f), h = (int)(gl->view[1]*s + 0.5f);
+	px[0] = glnvg__maxi(0, (int)floorf(r[0]*s));
+	px[1] = glnvg__maxi(0, (int)floorf(r[1]*s));
+	px[2] = glnvg__mini(w, (int)ceilf(r[2]*s));
+	px[3] = glnvg__mini(h, (int)ceilf(r[3]*s));
+}
+
+static int glnvg__rectArea(const int* r)
+{
+	return (r[2] - r[0]) * (r[3] - r[1]);
+}
+
+static void glnvg__unionRect(int* dst, const int* r)
+{
+	dst[0] = glnvg__mini(dst[0], r[0]);
+	dst[1] = glnvg__mini(dst[1], r[1]);
+	dst[2] = glnvg__maxi(dst[2], r[2]);
+	dst[3] = glnvg__maxi(dst[3], r[3]);
+}
+
+// Returns true if the pixel rects share at least one pixel.
+static int glnvg__overlapRect(const int* a, const int* b)
+{
+	return a[0] < b[2] && b[0] < a[2] && a[1] < b[3] && b[1] < a[3];
+}
+
+static void glnvg__fullDamage(GLNVGcontext* gl)
+{
+	float view[4] = { 0, 0, gl->view[0], gl->view[1] };
+	glnvg__snapRect(gl, view, gl->damage[0]);
+	gl->ndamage = 1;
+}
+
+// Adds a damaged pixel rect, merging it with the rects it overlaps, so that no pixel is in
+// two rects and drawn twice. When all rects are in use, it is merged with the rect whose
+// area grows the least.
+static void glnvg__addDamage(GLNVGcontext* gl, const int* px)
+{
+	int r[4];
+	int i, best;
+	int d, bestd;
+
+	if (px[0] >= px[2] || px[1] >= px[3]) return;
+	memcpy(r, px, sizeof(r));
+
+	for (i = 0; i < gl->ndamage; i++) {
+		if (glnvg__overlapRect(gl->damage[i], r)) {
+			// Take the rect out and start over, the union may overlap others.
+			glnvg__unionRect(r, gl->damage[i]);
+			memcpy(gl->damage[i], gl->damage[--gl->ndamage], sizeof(r));
+			i = -1;
+		}
+	}
+
+	if (gl->ndamage == GLNVG_MAX_DAMAGE_RECTS) {
+		best = 0;
+		bestd = -1;
+		for (i = 0; i < gl->ndamage; i++) {
+			int u[4];
+			memcpy(u, gl->damage[i], sizeof(u));
+			glnvg__unionRect(u, r);
+			d = glnvg__rectArea(u) - glnvg__rectArea(gl->damage[i]);
+			if (bestd < 0 || d < bestd) {
+				bestd = d;
+				best = i;
+			}
+		}
+		glnvg__unionRect(r, gl->damage[best]);
+		memcpy(gl->damage[best], gl->damage[--gl->ndamage], sizeof(r));
+		glnvg__addDamage(gl, r);
+		return;
+	}
+
+	memcpy(gl->damage[gl->ndamage++], r, sizeof(r));
+}
+
+// Compares the calls with the previous frame, the calls which differ at the same position are damaged.
+static void glnvg__computeDamage(GLNVGcontext* gl)
+{
+	int i, n = gl->ncalls > gl->nprevCallInfos ? gl->ncalls : gl->nprevCallInfos;
+	// A pixel around the vertices, the edges may round outwards to it.
+	float pad = 1.0f / gl->devicePxRatio;
+
+	if (gl->ndamage >= 0) return;
+	gl->ndamage = 0;
+
+	if (gl->ccallInfos < gl->ncalls) {
+		GLNVGcallInfo* infos;
+		int cinfos = glnvg__maxi(gl->ncalls, 128) + gl->ccallInfos/2; // 1.5x Overallocate
+		infos = (GLNVGcallInfo*)glnvg__realloc(gl, gl->callInfos, sizeof(GLNVGcallInfo) * cinfos);
+		if (infos == NULL) {
+			// Redraw everything, and compare the next frame with nothing.
+			gl->prevView[0] = gl->prevView[1] = 0;
+			gl->nprevCallInfos = 0;
+			glnvg__fullDamage(gl);
+			return;
+		}
+		gl->callInfos = infos;
+		gl->ccallInfos = cinfos;
+	}
+
+	for (i = 0; i < gl->ncalls; i++) {
+		GLNVGcallInfo* info = &gl->callInfos[i];
+		glnvg__callInfo(gl, &gl->calls[i], info);
+		info->bounds[0] -= pad;
+		info->bounds[1] -= pad;
+		info->bounds[2] += pad;
+		info->bounds[3] += pad;
+		glnvg__snapRect(gl, info->bounds, info->pixels);
+	}
+
+	// The previous call bounds are in other pixels when the view or the pixel ratio changed.
+	if (gl->prevView[0] != gl->view[0] || gl->prevView[1] != gl->view[1] || gl->prevPxRatio != gl->devicePxRatio) {
+		glnvg__fullDamage(gl);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		GLNVGcallInfo* cur = i < gl->ncalls ? &gl->callInfos[i] : NULL;
+		GLNVGcallInfo* prev = i < gl->nprevCallInfos ? &gl->prevCallInfos[i] : NULL;
+		if (cur != NULL && prev != NULL && cur->hash == prev->hash && memcmp(cur->bounds, prev->bounds, sizeof(cur->bounds)) == 0)
+			continue;
+		if (cur != NULL) glnvg__addDamage(gl, cur->pixels);
+		if (prev != NULL) glnvg__addDamage(gl, prev->pixels);
+	}
+}
+
+// Keeps the call infos of the drawn frame for comparing the next frame with it.
+static void glnvg__keepCallInfos(GLNVGcontext* gl)
+{
+	GLNVGcallInfo* infos = gl->prevCallInfos;
+	int cinfos = gl->cprevCallInfos;
+	gl->prevCallInfos = gl->callInfos;
+	gl->cprevCallInfos = gl->ccallInfos;
+	gl->nprevCallInfos = gl->ncalls;
+	gl->callInfos = infos;
+	gl->ccallInfos = cinfos;
+	gl->prevView[0] = gl->view[0];
+	gl->prevView[1] = gl->view[1];
+	gl->prevPxRatio = gl->devicePxRatio;
+}
+
+// Converts a damage rect to a GL rect, with the origin at the bottom left.
+static void glnvg__damagePixels(GLNVGcontext* gl, const int* r, int* px)
+{
+	int h = (int)(gl->view[1]*gl->devicePxRatio + 0.5f);
+	px[0] = r[0];
+	px[1] = h - r[3];
+	px[2] = glnvg__maxi(0, r[2] - r[0]);
+	px[3] = glnvg__maxi(0, r[3] - r[1]);
+}
+
+static void glnvg__drawCall(GLNVGcontext* gl, GLNVGcall* call, size_t vertOffset)
+{
+	NVG_NOTUSED(vertOffset);
+	glnvg__blendFuncSeparate(gl,&call->blendFunc);
+	if (call->type == GLNVG_FILL)
+		glnvg__fill(gl, call);
+	else if (call->type == GLNVG_CONVEXFILL)
+		glnvg__convexFill(gl, call);
+	else if (call->type == GLNVG_STROKE)
+		glnvg__stroke(gl, call);
+	else if (call->type == GLNVG_TRIANGLES)
+		glnvg__triangles(gl, call);
+	else if (call->type == GLNVG_RECT)
+		glnvg__rect(gl, call);
+#if NANOVG_GL_USE_INSTANCING
+	else if (call->type == GLNVG_QUADS)
+		glnvg__quads(gl, call, vertOffset);
+#endif
+}
+
+#if NANOVG_GL_TRACE_GPU
+// Reports the GPU times of the earlier flushes whose queries have completed.
+static void glnvg__readGpuTimes(GLNVGcontext* gl)
+{
+	while (gl->queryRet < gl->queryCur) {
+		int q = (gl->queryRet % GLNVG_GPU_QUERY_COUNT) * 2;
+		GLint available = 0;
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectiv(gl->queries[q+1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+		glGetQueryObjectui64v(gl->queries[q], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(gl->queries[q+1], GL_QUERY_RESULT, &end);
+		nvgTraceGpuZone("glnvg__renderFlush", (double)begin * 1e-9, (double)end * 1e-9);
+		gl->queryRet++;
+	}
+}
+#endif
+
 static void glnvg__renderFlush(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
-	int i;
+	size_t vertOffset = 0;
+	int i, j, damage = glnvg__damageTracking(gl);
+#if NANOVG_GL_TRACE_GPU
+	int query = -1;
+#endif
+
+	NVG_TRACE_BEGIN("glnvg__renderFlush");
 
-	if (gl->ncalls > 0) {
+	if (damage)
+		glnvg__computeDamage(gl);
+
+	if (gl->ncalls > 0 && (!damage || gl->ndamage > 0)) {
+
+#if NANOVG_GL_TRACE_GPU
+		// The flush is not measured when all queries are still pending.
+		if (gl->gpuTimer && gl->queryCur - gl->queryRet < GLNVG_GPU_QUERY_COUNT) {
+			query = (gl->queryCur % GLNVG_GPU_QUERY_COUNT) * 2;
+			glQueryCounter(gl->queries[query], GL_TIMESTAMP);
+		}
+#endif
 
 		// Setup require GL state.
 		glUseProgram(gl->shader.prog);
@@ -1210,60 +2393,119 @@ static void glnvg__renderFlush(void* uptr)
 		gl->blendFunc.dstAlpha = GL_INVALID_ENUM;
 		#endif
 
-#if NANOVG_GL_USE_UNIFORMBUFFER
-		// Upload ubo for frag shaders
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
-		glBufferData(GL_UNIFORM_BUFFER, gl->nuniforms * gl->fragSize, gl->uniforms, GL_STREAM_DRAW);
-#endif
-
 		// Upload vertex data
 #if defined NANOVG_GL3
 		glBindVertexArray(gl->vertArr);
 #endif
-		glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf);
-		glBufferData(GL_ARRAY_BUFFER, gl->nverts * sizeof(NVGvertex), gl->verts, GL_STREAM_DRAW);
+#if NANOVG_GL_USE_RING_BUFFER
+		if (gl->flags & NVG_RING_BUFFERS) {
+			// The data is already in the mapped segments, it just needs to be flushed.
+#if NANOVG_GL_USE_UNIFORMBUFFER
+			glnvg__unmapRing(&gl->fragRing, gl->nuniforms);
+			glBindBuffer(GL_UNIFORM_BUFFER, gl->fragRing.buf);
+#endif
+			if (!glnvg__mappedVerts(gl) && glnvg__reserveRing(&gl->vertRing, 0, gl->nverts, 4096))
+				glnvg__packVerts(gl->vertRing.ptr, gl->verts, gl->nverts);
+			glnvg__unmapRing(&gl->vertRing, gl->nverts);
+			glBindBuffer(GL_ARRAY_BUFFER, gl->vertRing.buf);
+			vertOffset = glnvg__ringOffset(&gl->vertRing);
+		} else
+#endif
+		{
+#if NANOVG_GL_USE_UNIFORMBUFFER
+			// Upload ubo for frag shaders
+			glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
+			glBufferData(GL_UNIFORM_BUFFER, gl->nuniforms * gl->fragSize, gl->uniforms, GL_STREAM_DRAW);
+#endif
+			// The damage is already computed, the vertices are not read again this frame.
+			if (gl->flags & NVG_COMPACT_VERTICES)
+				glnvg__packVerts(gl->verts, gl->verts, gl->nverts);
+			glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf);
+			glBufferData(GL_ARRAY_BUFFER, gl->nverts * glnvg__vertSize(gl), gl->verts, GL_STREAM_DRAW);
+		}
+		gl->stats.vertexBytes += gl->nverts * glnvg__vertSize(gl);
+		if (gl->flags & NVG_INDEXED_GEOMETRY) {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl->indexBuf);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, gl->nindices * sizeof(GLuint), gl->indices, GL_STREAM_DRAW);
+			gl->stats.vertexBytes += gl->nindices * sizeof(GLuint);
+		}
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		gl->stats.uniformBytes += gl->nuniforms * gl->fragSize;
+#endif
+
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(size_t)0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(0 + 2*sizeof(float)));
+		glnvg__vertexAttribs(gl, 0, 1, glnvg__vertSize(gl), vertOffset);
 
 		// Set view and texture just once per frame.
 		glUniform1i(gl->shader.loc[GLNVG_LOC_TEX], 0);
 		glUniform2fv(gl->shader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
 
+		if (damage) {
+			// Draw the calls which touch each damage rect, clipped to it.
+			glEnable(GL_SCISSOR_TEST);
+			for (j = 0; j < gl->ndamage; j++) {
+				int px[4];
+				glnvg__damagePixels(gl, gl->damage[j], px);
+				glScissor(px[0], px[1], px[2], px[3]);
+				for (i = 0; i < gl->ncalls; i++) {
+					if (glnvg__overlapRect(gl->callInfos[i].pixels, gl->damage[j]))
+						glnvg__drawCall(gl, &gl->calls[i], vertOffset);
+				}
+			}
+		} else {
+			for (i = 0; i < gl->ncalls; i++)
+				glnvg__drawCall(gl, &gl->calls[i], vertOffset);
+		}
+
+#if NANOVG_GL_USE_RING_BUFFER
+		if (gl->flags & NVG_RING_BUFFERS) {
 #if NANOVG_GL_USE_UNIFORMBUFFER
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
-#endif
-
-		for (i = 0; i < gl->ncalls; i++) {
-			GLNVGcall* call = &gl->calls[i];
-			glnvg__blendFuncSeparate(gl,&call->blendFunc);
-			if (call->type == GLNVG_FILL)
-				glnvg__fill(gl, call);
-			else if (call->type == GLNVG_CONVEXFILL)
-				glnvg__convexFill(gl, call);
-			else if (call->type == GLNVG_STROKE)
-				glnvg__stroke(gl, call);
-			else if (call->type == GLNVG_TRIANGLES)
-				glnvg__triangles(gl, call);
+			glnvg__fenceRing(&gl->fragRing);
+#endif
+			glnvg__fenceRing(&gl->vertRing);
 		}
+#endif
 
 		glDisableVertexAttribArray(0);
 		glDisableVertexAttribArray(1);
+		if (gl->flags & NVG_INDEXED_GEOMETRY)
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #if defined NANOVG_GL3
 		glBindVertexArray(0);
 #endif
 		glDisable(GL_CULL_FACE);
+		glDisable(GL_SCISSOR_TEST);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glUseProgram(0);
 		glnvg__bindTexture(gl, 0);
+
+#if NANOVG_GL_TRACE_GPU
+		if (query != -1) {
+			glQueryCounter(gl->queries[query+1], GL_TIMESTAMP);
+			gl->queryCur++;
+		}
+#endif
 	}
 
+#if NANOVG_GL_TRACE_GPU
+	if (gl->gpuTimer)
+		glnvg__readGpuTimes(gl);
+#endif
+
+	if (damage)
+		glnvg__keepCallInfos(gl);
+
 	// Reset calls
 	gl->nverts = 0;
+	gl->nindices = 0;
 	gl->npaths = 0;
 	gl->ncalls = 0;
 	gl->nuniforms = 0;
+	gl->lastFragCall = -1;
+	gl->ndamage = -1;
+
+	NVG_TRACE_END("glnvg__renderFlush");
 }
 
 static int glnvg__maxVertCount(const NVGpath* paths, int npaths)
@@ -1282,7 +2524,7 @@ static GLNVGcall* glnvg__allocCall(GLNVGcontext* gl)
 	if (gl->ncalls+1 > gl->ccalls) {
 		GLNVGcall* calls;
 		int ccalls = glnvg__maxi(gl->ncalls+1, 128) + gl->ccalls/2; // 1.5x Overallocate
-		calls = (GLNVGcall*)realloc(gl->calls, sizeof(GLNVGcall) * ccalls);
+		calls = (GLNVGcall*)glnvg__frameRealloc(gl, gl->calls, sizeof(GLNVGcall) * gl->ncalls, sizeof(GLNVGcall) * ccalls);
 		if (calls == NULL) return NULL;
 		gl->calls = calls;
 		gl->ccalls = ccalls;
@@ -1298,7 +2540,7 @@ static int glnvg__allocPaths(GLNVGcontext* gl, int n)
 	if (gl->npaths+n > gl->cpaths) {
 		GLNVGpath* paths;
 		int cpaths = glnvg__maxi(gl->npaths + n, 128) + gl->cpaths/2; // 1.5x Overallocate
-		paths = (GLNVGpath*)realloc(gl->paths, sizeof(GLNVGpath) * cpaths);
+		paths = (GLNVGpath*)glnvg__frameRealloc(gl, gl->paths, sizeof(GLNVGpath) * gl->npaths, sizeof(GLNVGpath) * cpaths);
 		if (paths == NULL) return -1;
 		gl->paths = paths;
 		gl->cpaths = cpaths;
@@ -1311,10 +2553,17 @@ static int glnvg__allocPaths(GLNVGcontext* gl, int n)
 static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 {
 	int ret = 0;
+#if NANOVG_GL_USE_RING_BUFFER
+	if (glnvg__mappedVerts(gl)) {
+		if (glnvg__reserveRing(&gl->vertRing, gl->nverts, n, 4096) == 0) return -1;
+		gl->verts = (NVGvertex*)gl->vertRing.ptr;
+		gl->cverts = gl->vertRing.count;
+	}
+#endif
 	if (gl->nverts+n > gl->cverts) {
 		NVGvertex* verts;
 		int cverts = glnvg__maxi(gl->nverts + n, 4096) + gl->cverts/2; // 1.5x Overallocate
-		verts = (NVGvertex*)realloc(gl->verts, sizeof(NVGvertex) * cverts);
+		verts = (NVGvertex*)glnvg__frameRealloc(gl, gl->verts, sizeof(NVGvertex) * gl->nverts, sizeof(NVGvertex) * cverts);
 		if (verts == NULL) return -1;
 		gl->verts = verts;
 		gl->cverts = cverts;
@@ -1324,13 +2573,109 @@ static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 	return ret;
 }
 
+static int glnvg__allocIndices(GLNVGcontext* gl, int n)
+{
+	int ret = 0;
+	if (gl->nindices+n > gl->cindices) {
+		GLuint* indices;
+		int cindices = glnvg__maxi(gl->nindices + n, 4096) + gl->cindices/2; // 1.5x Overallocate
+		indices = (GLuint*)glnvg__frameRealloc(gl, gl->indices, sizeof(GLuint) * gl->nindices, sizeof(GLuint) * cindices);
+		if (indices == NULL) return -1;
+		gl->indices = indices;
+		gl->cindices = cindices;
+	}
+	ret = gl->nindices;
+	gl->nindices += n;
+	return ret;
+}
+
+static int glnvg__stripIndexCount(int n)
+{
+	return n > 2 ? (n-2)*3 : 0;
+}
+
+static int glnvg__fillIndexCount(const GLNVGpath* path)
+{
+	return path->fillTriangles ? path->fillCount : glnvg__stripIndexCount(path->fillCount);
+}
+
+// Writes the triangle list of a fan, or of already triangulated vertices.
+static GLuint* glnvg__fillIndices(GLuint* dst, const GLNVGpath* path)
+{
+	int i;
+	if (path->fillTriangles) {
+		for (i = 0; i < path->fillCount; i++)
+			*dst++ = path->fillOffset + i;
+		return dst;
+	}
+	for (i = 2; i < path->fillCount; i++) {
+		*dst++ = path->fillOffset;
+		*dst++ = path->fillOffset + i-1;
+		*dst++ = path->fillOffset + i;
+	}
+	return dst;
+}
+
+// Writes the triangle list of a strip, every other triangle is flipped to keep the winding of the strip.
+static GLuint* glnvg__stripIndices(GLuint* dst, int offset, int count)
+{
+	int i;
+	for (i = 2; i < count; i++) {
+		*dst++ = offset + ((i & 1) ? i-1 : i-2);
+		*dst++ = offset + ((i & 1) ? i-2 : i-1);
+		*dst++ = offset + i;
+	}
+	return dst;
+}
+
+// Builds the indices of the paths of the call. The fill and fringe of each path are interleaved for
+// convex fills, which are drawn in one pass, otherwise all fills come before all strokes.
+static int glnvg__callIndices(GLNVGcontext* gl, GLNVGcall* call)
+{
+	GLNVGpath* paths = &gl->paths[call->pathOffset];
+	int i, nfill = 0, nstroke = 0;
+	GLuint* dst;
+
+	for (i = 0; i < call->pathCount; i++) {
+		nfill += glnvg__fillIndexCount(&paths[i]);
+		nstroke += glnvg__stripIndexCount(paths[i].strokeCount);
+	}
+	call->indexOffset = glnvg__allocIndices(gl, nfill + nstroke);
+	if (call->indexOffset == -1) return 0;
+
+	dst = &gl->indices[call->indexOffset];
+	if (call->type == GLNVG_CONVEXFILL) {
+		for (i = 0; i < call->pathCount; i++) {
+			dst = glnvg__fillIndices(dst, &paths[i]);
+			dst = glnvg__stripIndices(dst, paths[i].strokeOffset, paths[i].strokeCount);
+		}
+		call->fillIndexCount = nfill + nstroke;
+		call->strokeIndexCount = 0;
+	} else {
+		for (i = 0; i < call->pathCount; i++)
+			dst = glnvg__fillIndices(dst, &paths[i]);
+		for (i = 0; i < call->pathCount; i++)
+			dst = glnvg__stripIndices(dst, paths[i].strokeOffset, paths[i].strokeCount);
+		call->fillIndexCount = nfill;
+		call->strokeIndexCount = nstroke;
+	}
+	return 1;
+}
+
 static int glnvg__allocFragUniforms(GLNVGcontext* gl, int n)
 {
 	int ret = 0, structSize = gl->fragSize;
+#if NANOVG_GL_USE_RING_BUFFER && NANOVG_GL_USE_UNIFORMBUFFER
+	if (gl->flags & NVG_RING_BUFFERS) {
+		if (glnvg__reserveRing(&gl->fragRing, gl->nuniforms, n, 128) == 0) return -1;
+		gl->uniforms = gl->fragRing.ptr;
+		gl->cuniforms = gl->fragRing.count;
+	}
+#endif
 	if (gl->nuniforms+n > gl->cuniforms) {
 		unsigned char* uniforms;
 		int cuniforms = glnvg__maxi(gl->nuniforms+n, 128) + gl->cuniforms/2; // 1.5x Overallocate
-		uniforms = (unsigned char*)realloc(gl->uniforms, structSize * cuniforms);
+		uniforms = (unsigned char*)glnvg__frameRealloc(gl, gl->uniforms, structSize * gl->nuniforms, structSize * cuniforms);
 		if (uniforms == NULL) return -1;
 		gl->uniforms = uniforms;
 		gl->cuniforms = cuniforms;
@@ -1345,6 +2690,54 @@ static GLNVGfragUniforms* nvg__fragUniformPtr(GLNVGcontext* gl, int i)
 	return (GLNVGfragUniforms*)&gl->uniforms[i];
 }
 
+// Merges the last call into the previous call, if they are adjacent and use the same state.
+static int glnvg__mergeCall(GLNVGcontext* gl, const GLNVGfragUniforms* frag)
+{
+	GLNVGcall* call;
+	GLNVGcall* prev;
+
+	if (gl->ncalls < 2 || gl->lastFragCall != gl->ncalls-2) return 0;
+	call = &gl->calls[gl->ncalls-1];
+	prev = &gl->calls[gl->ncalls-2];
+
+	if (prev->type != call->type || prev->image != call->image) return 0;
+	if (memcmp(&prev->blendFunc, &call->blendFunc, sizeof(GLNVGblend)) != 0) return 0;
+	if (memcmp(&gl->lastFrag, frag, sizeof(GLNVGfragUniforms)) != 0) return 0;
+
+	if (call->type == GLNVG_CONVEXFILL || call->type == GLNVG_STROKE) {
+		// Only strokes without the stencil get here, those are drawn in one pass like convex fills.
+		if (prev->pathOffset + prev->pathCount != call->pathOffset) return 0;
+		if ((gl->flags & NVG_INDEXED_GEOMETRY) &&
+			prev->indexOffset + prev->fillIndexCount + prev->strokeIndexCount != call->indexOffset) return 0;
+		prev->pathCount += call->pathCount;
+		prev->fillIndexCount += call->fillIndexCount;
+		prev->strokeIndexCount += call->strokeIndexCount;
+	} else if (call->type == GLNVG_TRIANGLES || call->type == GLNVG_RECT) {
+		if (prev->triangleOffset + prev->triangleCount != call->triangleOffset) return 0;
+		prev->triangleCount += call->triangleCount;
+	} else if (call->type == GLNVG_QUADS) {
+		if (prev->triangleOffset + prev->triangleCount*2 != call->triangleOffset) return 0;
+		prev->triangleCount += call->triangleCount;
+	} else {
+		return 0;
+	}
+
+	gl->ncalls--;
+	gl->stats.mergedCalls++;
+	return 1;
+}
+
+// Allocates uniforms for the last call, and remembers them so that following calls can be merged into it.
+static int glnvg__allocCallUniforms(GLNVGcontext* gl, GLNVGcall* call, const GLNVGfragUniforms* frag)
+{
+	call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
+	if (call->uniformOffset == -1) return 0;
+	memcpy(nvg__fragUniformPtr(gl, call->uniformOffset), frag, sizeof(GLNVGfragUniforms));
+	gl->lastFrag = *frag;
+	gl->lastFragCall = gl->ncalls-1;
+	return 1;
+}
+
 static void glnvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
 {
 	vtx->x = x;
@@ -1359,7 +2752,8 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
 	NVGvertex* quad;
-	GLNVGfragUniforms* frag;
+	GLNVGfragUniforms* stencilFrag;
+	GLNVGfragUniforms frag;
 	int i, maxverts, offset;
 
 	if (call == NULL) return;
@@ -1372,7 +2766,7 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 	call->image = paint->image;
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
-	if (npaths == 1 && paths[0].convex)
+	if (npaths == 1 && (paths[0].convex || paths[0].triangulated))
 	{
 		call->type = GLNVG_CONVEXFILL;
 		call->triangleCount = 0;	// Bounding box fill quad not needed for convex fill
@@ -1390,6 +2784,7 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 		if (path->nfill > 0) {
 			copy->fillOffset = offset;
 			copy->fillCount = path->nfill;
+			copy->fillTriangles = path->triangulated;
 			memcpy(&gl->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
 			offset += path->nfill;
 		}
@@ -1400,6 +2795,7 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 			offset += path->nstroke;
 		}
 	}
+	if ((gl->flags & NVG_INDEXED_GEOMETRY) && glnvg__callIndices(gl, call) == 0) goto error;
 
 	// Setup uniforms for draw calls
 	if (call->type == GLNVG_FILL) {
@@ -1414,17 +2810,17 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 		call->uniformOffset = glnvg__allocFragUniforms(gl, 2);
 		if (call->uniformOffset == -1) goto error;
 		// Simple shader for stencil
-		frag = nvg__fragUniformPtr(gl, call->uniformOffset);
-		memset(frag, 0, sizeof(*frag));
-		frag->strokeThr = -1.0f;
-		frag->type = NSVG_SHADER_SIMPLE;
+		stencilFrag = nvg__fragUniformPtr(gl, call->uniformOffset);
+		memset(stencilFrag, 0, sizeof(*stencilFrag));
+		stencilFrag->strokeThr = -1.0f;
+		stencilFrag->type = NSVG_SHADER_SIMPLE;
 		// Fill shader
 		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset + gl->fragSize), paint, scissor, fringe, fringe, -1.0f);
 	} else {
-		call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
-		if (call->uniformOffset == -1) goto error;
 		// Fill shader
-		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset), paint, scissor, fringe, fringe, -1.0f);
+		glnvg__convertPaint(gl, &frag, paint, scissor, fringe, fringe, -1.0f);
+		if (glnvg__mergeCall(gl, &frag)) return;
+		if (glnvg__allocCallUniforms(gl, call, &frag) == 0) goto error;
 	}
 
 	return;
@@ -1440,6 +2836,7 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
+	GLNVGfragUniforms frag;
 	int i, maxverts, offset;
 
 	if (call == NULL) return;
@@ -1467,6 +2864,7 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 			offset += path->nstroke;
 		}
 	}
+	if ((gl->flags & NVG_INDEXED_GEOMETRY) && glnvg__callIndices(gl, call) == 0) goto error;
 
 	if (gl->flags & NVG_STENCIL_STROKES) {
 		// Fill shader
@@ -1478,9 +2876,9 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 
 	} else {
 		// Fill shader
-		call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
-		if (call->uniformOffset == -1) goto error;
-		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset), paint, scissor, strokeWidth, fringe, -1.0f);
+		glnvg__convertPaint(gl, &frag, paint, scissor, strokeWidth, fringe, -1.0f);
+		if (glnvg__mergeCall(gl, &frag)) return;
+		if (glnvg__allocCallUniforms(gl, call, &frag) == 0) goto error;
 	}
 
 	return;
@@ -1496,7 +2894,7 @@ static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
-	GLNVGfragUniforms* frag;
+	GLNVGfragUniforms frag;
 
 	if (call == NULL) return;
 
@@ -1512,11 +2910,60 @@ static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
 	memcpy(&gl->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
 
 	// Fill shader
-	call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
-	if (call->uniformOffset == -1) goto error;
-	frag = nvg__fragUniformPtr(gl, call->uniformOffset);
-	glnvg__convertPaint(gl, frag, paint, scissor, 1.0f, fringe, -1.0f);
-	frag->type = NSVG_SHADER_IMG;
+	glnvg__convertPaint(gl, &frag, paint, scissor, 1.0f, fringe, -1.0f);
+	glnvg__setTextureShader(gl, &frag, paint);
+	if (glnvg__mergeCall(gl, &frag)) return;
+	if (glnvg__allocCallUniforms(gl, call, &frag) == 0) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (gl->ncalls > 0) gl->ncalls--;
+}
+
+static void glnvg__renderRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							  float fringe, const float* rect, float radius)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGcall* call = glnvg__allocCall(gl);
+	GLNVGfragUniforms frag;
+	NVGvertex* verts;
+	float hw = rect[2]*0.5f, hh = rect[3]*0.5f;
+	float cx = rect[0] + hw, cy = rect[1] + hh;
+	float ex = hw + fringe*0.5f, ey = hh + fringe*0.5f;
+	float aa;
+
+	if (call == NULL) return;
+
+	call->type = GLNVG_RECT;
+	call->image = paint->image;
+	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
+
+	// The quad covers the rect and the outer half of the fringe, the coverage is computed
+	// in the shader from the texture coordinate, which goes from 0 to 1 over the quad.
+	call->triangleOffset = glnvg__allocVerts(gl, 6);
+	if (call->triangleOffset == -1) goto error;
+	call->triangleCount = 6;
+
+	verts = &gl->verts[call->triangleOffset];
+	glnvg__vset(&verts[0], cx-ex, cy-ey, 0, 0);
+	glnvg__vset(&verts[1], cx+ex, cy+ey, 1, 1);
+	glnvg__vset(&verts[2], cx+ex, cy-ey, 1, 0);
+	glnvg__vset(&verts[3], cx-ex, cy-ey, 0, 0);
+	glnvg__vset(&verts[4], cx-ex, cy+ey, 0, 1);
+	glnvg__vset(&verts[5], cx+ex, cy+ey, 1, 1);
+
+	// Fill shader, the scissor is anti-aliased like for fills, even when the rect itself is not.
+	aa = 1.0f / gl->devicePxRatio;
+	glnvg__convertPaint(gl, &frag, paint, scissor, aa, aa, -1.0f);
+	frag.shapeExt[0] = hw;
+	frag.shapeExt[1] = hh;
+	frag.shapeRadius = radius;
+	frag.shapeFringe = fringe;
+	if (glnvg__mergeCall(gl, &frag)) return;
+	if (glnvg__allocCallUniforms(gl, call, &frag) == 0) goto error;
 
 	return;
 
@@ -1526,6 +2973,73 @@ error:
 	if (gl->ncalls > 0) gl->ncalls--;
 }
 
+#if NANOVG_GL_USE_INSTANCING
+static void glnvg__renderQuads(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							   const NVGvertex* verts, int nquads, float fringe)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGcall* call = glnvg__allocCall(gl);
+	GLNVGfragUniforms frag;
+	NVGvertex* quad;
+	int i;
+
+	if (call == NULL) return;
+
+	call->image = paint->image;
+	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
+
+	if (gl->instancedQuads) {
+		// Each quad is stored as two corner vertices, and expanded in the vertex shader.
+		call->type = GLNVG_QUADS;
+		call->triangleOffset = glnvg__allocVerts(gl, nquads*2);
+		if (call->triangleOffset == -1) goto error;
+		call->triangleCount = nquads;
+		memcpy(&gl->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nquads*2);
+	} else {
+		// No instanced arrays, expand the quads to triangles.
+		call->type = GLNVG_TRIANGLES;
+		call->triangleOffset = glnvg__allocVerts(gl, nquads*6);
+		if (call->triangleOffset == -1) goto error;
+		call->triangleCount = nquads*6;
+		quad = &gl->verts[call->triangleOffset];
+		for (i = 0; i < nquads; i++) {
+			const NVGvertex* v0 = &verts[i*2];
+			const NVGvertex* v1 = &verts[i*2+1];
+			glnvg__vset(&quad[0], v0->x, v0->y, v0->u, v0->v);
+			glnvg__vset(&quad[1], v1->x, v1->y, v1->u, v1->v);
+			glnvg__vset(&quad[2], v1->x, v0->y, v1->u, v0->v);
+			glnvg__vset(&quad[3], v0->x, v0->y, v0->u, v0->v);
+			glnvg__vset(&quad[4], v0->x, v1->y, v0->u, v1->v);
+			glnvg__vset(&quad[5], v1->x, v1->y, v1->u, v1->v);
+			quad += 6;
+		}
+	}
+
+	// Fill shader
+	glnvg__convertPaint(gl, &frag, paint, scissor, 1.0f, fringe, -1.0f);
+	glnvg__setTextureShader(gl, &frag, paint);
+	if (glnvg__mergeCall(gl, &frag)) return;
+	if (glnvg__allocCallUniforms(gl, call, &frag) == 0) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (gl->ncalls > 0) gl->ncalls--;
+}
+#endif
+
+static void glnvg__renderFrameStats(void* uptr, NVGframeStats* stats)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	stats->mergedCalls = gl->stats.mergedCalls;
+	stats->vertexBytes = gl->stats.vertexBytes;
+	stats->uniformBytes = gl->stats.uniformBytes;
+	stats->textureBytes = gl->stats.textureBytes;
+	stats->filteredStateChanges = gl->stats.filteredStateChanges;
+}
+
 static void glnvg__renderDelete(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
@@ -1533,6 +3047,10 @@ static void glnvg__renderDelete(void* uptr)
 	if (gl == NULL) return;
 
 	glnvg__deleteShader(&gl->shader);
+	glnvg__deleteShader(&gl->rectShader);
+#if NANOVG_GL_USE_INSTANCING
+	glnvg__deleteShader(&gl->quadShader);
+#endif
 
 #if NANOVG_GL3
 #if NANOVG_GL_USE_UNIFORMBUFFER
@@ -1544,58 +3062,123 @@ static void glnvg__renderDelete(void* uptr)
 #endif
 	if (gl->vertBuf != 0)
 		glDeleteBuffers(1, &gl->vertBuf);
+	if (gl->indexBuf != 0)
+		glDeleteBuffers(1, &gl->indexBuf);
+#if NANOVG_GL_TRACE_GPU
+	if (gl->gpuTimer)
+		glDeleteQueries(GLNVG_GPU_QUERY_COUNT*2, gl->queries);
+#endif
 
-	for (i = 0; i < gl->ntextures; i++) {
-		if (gl->textures[i].tex != 0 && (gl->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
-			glDeleteTextures(1, &gl->textures[i].tex);
+#if NANOVG_GL_USE_RING_BUFFER
+	if (gl->uploadBuf != 0)
+		glDeleteBuffers(1, &gl->uploadBuf);
+	if (gl->flags & NVG_RING_BUFFERS) {
+		// The per frame buffers point to mapped memory.
+		glnvg__deleteRing(&gl->vertRing);
+		if (glnvg__mappedVerts(gl))
+			gl->verts = NULL;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		glnvg__deleteRing(&gl->fragRing);
+		gl->uniforms = NULL;
+#endif
 	}
-	free(gl->textures);
+#endif
 
-	free(gl->paths);
-	free(gl->verts);
-	free(gl->uniforms);
-	free(gl->calls);
+	if (gl->texSet != NULL) {
+		// The last context deletes the shared textures, the others only their dummy texture.
+		if (nvgAtomicAdd(&gl->texSet->refs, -1) == 0) {
+			for (i = 0; i < gl->texSet->ntextures; i++) {
+				if (gl->texSet->textures[i].tex != 0 && (gl->texSet->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
+					glDeleteTextures(1, &gl->texSet->textures[i].tex);
+			}
+			glnvg__free(gl, gl->texSet->textures);
+			for (i = 0; i < gl->texSet->natlases; i++)
+				glnvg__free(gl, gl->texSet->atlases[i].freeRects);
+			glnvg__free(gl, gl->texSet->atlases);
+			glnvg__free(gl, gl->texSet);
+		} else if (gl->dummyTex != 0) {
+			glnvg__deleteTexture(gl, gl->dummyTex);
+		}
+	}
+	glnvg__free(gl, gl->callInfos);
+	glnvg__free(gl, gl->prevCallInfos);
+
+	if (gl->arena == NULL) {
+		glnvg__free(gl, gl->paths);
+		glnvg__free(gl, gl->verts);
+		glnvg__free(gl, gl->indices);
+		glnvg__free(gl, gl->uniforms);
+		glnvg__free(gl, gl->calls);
+	}
 
-	free(gl);
+	glnvg__free(gl, gl);
 }
 
 
-#if defined NANOVG_GL2
-NVGcontext* nvgCreateGL2(int flags)
-#elif defined NANOVG_GL3
-NVGcontext* nvgCreateGL3(int flags)
-#elif defined NANOVG_GLES2
-NVGcontext* nvgCreateGLES2(int flags)
-#elif defined NANOVG_GLES3
-NVGcontext* nvgCreateGLES3(int flags)
-#endif
+static NVGcontext* glnvg__createContext(int flags, const NVGallocator* allocator, NVGcontext* share)
 {
 	NVGparams params;
 	NVGcontext* ctx = NULL;
-	GLNVGcontext* gl = (GLNVGcontext*)malloc(sizeof(GLNVGcontext));
+	NVGallocator alloc;
+	GLNVGcontext* gl;
+
+	memset(&alloc, 0, sizeof(alloc));
+	if (share != NULL)
+		alloc = ((GLNVGcontext*)nvgInternalParams(share)->userPtr)->allocator;
+	else if (allocator != NULL)
+		alloc = *allocator;
+	gl = (GLNVGcontext*)(alloc.reallocMem != NULL ? alloc.reallocMem(alloc.userPtr, NULL, sizeof(GLNVGcontext)) : malloc(sizeof(GLNVGcontext)));
 	if (gl == NULL) goto error;
 	memset(gl, 0, sizeof(GLNVGcontext));
+	gl->allocator = alloc;
+
+	if (share != NULL) {
+		gl->texSet = ((GLNVGcontext*)nvgInternalParams(share)->userPtr)->texSet;
+		nvgAtomicAdd(&gl->texSet->refs, 1);
+	} else {
+		gl->texSet = (GLNVGtextureSet*)glnvg__realloc(gl, NULL, sizeof(GLNVGtextureSet));
+		if (gl->texSet == NULL) {
+			glnvg__free(gl, gl);
+			return NULL;
+		}
+		memset(gl->texSet, 0, sizeof(GLNVGtextureSet));
+		gl->texSet->refs = 1;
+	}
 
 	memset(&params, 0, sizeof(params));
+	params.allocator = alloc;
 	params.renderCreate = glnvg__renderCreate;
 	params.renderCreateTexture = glnvg__renderCreateTexture;
 	params.renderDeleteTexture = glnvg__renderDeleteTexture;
 	params.renderUpdateTexture = glnvg__renderUpdateTexture;
 	params.renderGetTextureSize = glnvg__renderGetTextureSize;
+	params.renderGetTextureType = glnvg__renderGetTextureType;
+	params.renderOffscreenFrame = glnvg__renderOffscreenFrame;
 	params.renderViewport = glnvg__renderViewport;
 	params.renderCancel = glnvg__renderCancel;
 	params.renderFlush = glnvg__renderFlush;
 	params.renderFill = glnvg__renderFill;
 	params.renderStroke = glnvg__renderStroke;
 	params.renderTriangles = glnvg__renderTriangles;
+	params.renderRect = glnvg__renderRect;
+#if NANOVG_GL_USE_INSTANCING
+	params.renderQuads = glnvg__renderQuads;
+#endif
 	params.renderDelete = glnvg__renderDelete;
+	params.renderFrameStats = glnvg__renderFrameStats;
 	params.userPtr = gl;
+	params.share = share;
 	params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
+	params.sdfText = flags & NVG_SDF_TEXT ? 1 : 0;
+	params.triangulateFills = flags & NVG_TRIANGULATE_FILLS ? 1 : 0;
 
 	gl->flags = flags;
+	gl->lastFragCall = -1;
+	gl->ndamage = -1;
 
 	ctx = nvgCreateInternal(&params);
 	if (ctx == NULL) goto error;
+	gl->arena = nvgInternalArena(ctx);
 
 	return ctx;
 
@@ -1605,6 +3188,68 @@ error:
 	return NULL;
 }
 
+#if defined NANOVG_GL2
+NVGcontext* nvgCreateGL2(int flags)
+{
+	return glnvg__createContext(flags, NULL, NULL);
+}
+
+NVGcontext* nvgCreateGL2Alloc(int flags, const NVGallocator* allocator)
+{
+	return glnvg__createContext(flags, allocator, NULL);
+}
+
+NVGcontext* nvgCreateGL2Shared(int flags, NVGcontext* share)
+{
+	return glnvg__createContext(flags, NULL, share);
+}
+#elif defined NANOVG_GL3
+NVGcontext* nvgCreateGL3(int flags)
+{
+	return glnvg__createContext(flags, NULL, NULL);
+}
+
+NVGcontext* nvgCreateGL3Alloc(int flags, const NVGallocator* allocator)
+{
+	return glnvg__createContext(flags, allocator, NULL);
+}
+
+NVGcontext* nvgCreateGL3Shared(int flags, NVGcontext* share)
+{
+	return glnvg__createContext(flags, NULL, share);
+}
+#elif defined NANOVG_GLES2
+NVGcontext* nvgCreateGLES2(int flags)
+{
+	return glnvg__createContext(flags, NULL, NULL);
+}
+
+NVGcontext* nvgCreateGLES2Alloc(int flags, const NVGallocator* allocator)
+{
+	return glnvg__createContext(flags, allocator, NULL);
+}
+
+NVGcontext* nvgCreateGLES2Shared(int flags, NVGcontext* share)
+{
+	return glnvg__createContext(flags, NULL, share);
+}
+#elif defined NANOVG_GLES3
+NVGcontext* nvgCreateGLES3(int flags)
+{
+	return glnvg__createContext(flags, NULL, NULL);
+}
+
+NVGcontext* nvgCreateGLES3Alloc(int flags, const NVGallocator* allocator)
+{
+	return glnvg__createContext(flags, allocator, NULL);
+}
+
+NVGcontext* nvgCreateGLES3Shared(int flags, NVGcontext* share)
+{
+	return glnvg__createContext(flags, NULL, share);
+}
+#endif
+
 #if defined NANOVG_GL2
 void nvgDeleteGL2(NVGcontext* ctx)
 #elif defined NANOVG_GL3
@@ -1657,4 +3302,58 @@ GLuint nvglImageHandleGLES3(NVGcontext* ctx, int image)
 	return tex->tex;
 }
 
+#if defined NANOVG_GL2
+int nvglDamageRectsGL2(NVGcontext* ctx, int* rects, int maxRects)
+#elif defined NANOVG_GL3
+int nvglDamageRectsGL3(NVGcontext* ctx, int* rects, int maxRects)
+#elif defined NANOVG_GLES2
+int nvglDamageRectsGLES2(NVGcontext* ctx, int* rects, int maxRects)
+#elif defined NANOVG_GLES3
+int nvglDamageRectsGLES3(NVGcontext* ctx, int* rects, int maxRects)
+#endif
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	float full[4] = { 0, 0, gl->view[0], gl->view[1] };
+	int view[4];
+	int i, n;
+
+	if (maxRects < 1) return 0;
+	if (!glnvg__damageTracking(gl)) {
+		glnvg__snapRect(gl, full, view);
+		glnvg__damagePixels(gl, view, rects);
+		return 1;
+	}
+
+	glnvg__computeDamage(gl);
+	if (gl->ndamage > maxRects) {
+		// Return the union when the rects do not fit.
+		memcpy(view, gl->damage[0], sizeof(view));
+		for (i = 1; i < gl->ndamage; i++)
+			glnvg__unionRect(view, gl->damage[i]);
+		glnvg__damagePixels(gl, view, rects);
+		return 1;
+	}
+	n = 0;
+	for (i = 0; i < gl->ndamage; i++) {
+		glnvg__damagePixels(gl, gl->damage[i], &rects[n*4]);
+		if (rects[n*4+2] > 0 && rects[n*4+3] > 0) n++;
+	}
+	return n;
+}
+
+#if defined NANOVG_GL2
+void nvglImageChangedGL2(NVGcontext* ctx, int image)
+#elif defined NANOVG_GL3
+void nvglImageChangedGL3(NVGcontext* ctx, int image)
+#elif defined NANOVG_GLES2
+void nvglImageChangedGLES2(NVGcontext* ctx, int image)
+#elif defined NANOVG_GLES3
+void nvglImageChangedGLES3(NVGcontext* ctx, int image)
+#endif
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	GLNVGtexture* tex = glnvg__findTexture(gl, image);
+	if (tex != NULL) tex->generation++;
+}
+
 #endif /* NANOVG_GL_IMPLEMENTATION */
@@ -32,6 +32,45 @@ void nvgluBindFramebuffer(NVGLUframebuffer* fb);
 NVGLUframebuffer* nvgluCreateFramebuffer(NVGcontext* ctx, int w, int h, int imageFlags);
 void nvgluDeleteFramebuffer(NVGLUframebuffer* fb);
 
+// Layers cache drawing which rarely changes, like a complex panel, in a frame buffer. The layer is
+// only redrawn when the key of its inputs, its size or the pixel ratio changes, and is otherwise
+// drawn as a single textured quad.
+struct NVGLUlayer {
+	NVGcontext* ctx;
+	NVGLUframebuffer* fb;
+	int imageFlags;
+	float width, height;
+	float devicePxRatio;
+	unsigned int key;
+	int valid;
+	GLint prevFBO;
+	GLint prevViewport[4];
+	GLfloat prevClearColor[4];
+	GLint prevStencilMask;
+};
+typedef struct NVGLUlayer NVGLUlayer;
+
+NVGLUlayer* nvgluCreateLayer(NVGcontext* ctx, int imageFlags);
+
+// Begins to update the layer, before or after the frames of the context. Returns 1 if the contents
+// must be drawn, followed by nvgluEndLayer(), or 0 if the layer is valid and has the same key and size.
+// When the frame buffer cannot be created, returns 0 and clears valid, and the layer is not drawn.
+// The width and height are in the same units as in nvgBeginFrame(). The layer is drawn in an offscreen
+// frame, see nvgBeginOffscreenFrame(). The frame buffer binding, viewport, clear color and stencil mask
+// are restored by nvgluEndLayer().
+int nvgluBeginLayer(NVGLUlayer* layer, float width, float height, float devicePixelRatio, unsigned int key);
+void nvgluEndLayer(NVGLUlayer* layer);
+
+// Draws the layer into the rect inside a frame, using the current transform and scissor.
+void nvgluDrawLayer(NVGLUlayer* layer, float x, float y, float w, float h, float alpha);
+
+// Forces the layer to be redrawn by the next nvgluBeginLayer().
+void nvgluInvalidateLayer(NVGLUlayer* layer);
+void nvgluDeleteLayer(NVGLUlayer* layer);
+
+// Adds data to a key of layer inputs, start with 0.
+unsigned int nvgluLayerKey(unsigned int key, const void* data, int size);
+
 #endif // NANOVG_GL_UTILS_H
 
 #ifdef NANOVG_GL_IMPLEMENTATION
@@ -151,4 +190,117 @@ void nvgluDeleteFramebuffer(NVGLUframebuffer* fb)
 #endif
 }
 
+NVGLUlayer* nvgluCreateLayer(NVGcontext* ctx, int imageFlags)
+{
+	NVGLUlayer* layer = (NVGLUlayer*)malloc(sizeof(NVGLUlayer));
+	if (layer == NULL) return NULL;
+	memset(layer, 0, sizeof(NVGLUlayer));
+	layer->ctx = ctx;
+	layer->imageFlags = imageFlags;
+	return layer;
+}
+
+int nvgluBeginLayer(NVGLUlayer* layer, float width, float height, float devicePixelRatio, unsigned int key)
+{
+#ifdef NANOVG_FBO_VALID
+	int w = (int)ceilf(width * devicePixelRatio);
+	int h = (int)ceilf(height * devicePixelRatio);
+	int fw = 0, fh = 0;
+
+	if (layer->fb != NULL)
+		nvgImageSize(layer->ctx, layer->fb->image, &fw, &fh);
+	if (layer->valid && layer->key == key && layer->width == width && layer->height == height &&
+		layer->devicePxRatio == devicePixelRatio)
+		return 0;
+
+	if (layer->fb == NULL || fw != w || fh != h) {
+		nvgluDeleteFramebuffer(layer->fb);
+		layer->fb = nvgluCreateFramebuffer(layer->ctx, w, h, layer->imageFlags);
+		if (layer->fb == NULL) {
+			layer->valid = 0;
+			return 0;
+		}
+	}
+	layer->width = width;
+	layer->height = height;
+	layer->devicePxRatio = devicePixelRatio;
+	layer->key = key;
+
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &layer->prevFBO);
+	glGetIntegerv(GL_VIEWPORT, layer->prevViewport);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, layer->prevClearColor);
+	glGetIntegerv(GL_STENCIL_WRITEMASK, &layer->prevStencilMask);
+	glBindFramebuffer(GL_FRAMEBUFFER, layer->fb->fbo);
+	glViewport(0, 0, w, h);
+	glClearColor(0, 0, 0, 0);
+	glStencilMask(0xff);
+	glClear(GL_COLOR_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+	nvgBeginOffscreenFrame(layer->ctx, width, height, devicePixelRatio);
+	return 1;
+#else
+	NVG_NOTUSED(layer);
+	NVG_NOTUSED(width);
+	NVG_NOTUSED(height);
+	NVG_NOTUSED(devicePixelRatio);
+	NVG_NOTUSED(key);
+	return 0;
+#endif
+}
+
+void nvgluEndLayer(NVGLUlayer* layer)
+{
+#ifdef NANOVG_FBO_VALID
+	nvgEndFrame(layer->ctx);
+	glBindFramebuffer(GL_FRAMEBUFFER, layer->prevFBO);
+	glViewport(layer->prevViewport[0], layer->prevViewport[1], layer->prevViewport[2], layer->prevViewport[3]);
+	glClearColor(layer->prevClearColor[0], layer->prevClearColor[1], layer->prevClearColor[2], layer->prevClearColor[3]);
+	glStencilMask((GLuint)layer->prevStencilMask);
+	layer->valid = 1;
+	// Frames which draw the layer are damaged where it is drawn.
+#if defined NANOVG_GL2
+	nvglImageChangedGL2(layer->ctx, layer->fb->image);
+#elif defined NANOVG_GL3
+	nvglImageChangedGL3(layer->ctx, layer->fb->image);
+#elif defined NANOVG_GLES2
+	nvglImageChangedGLES2(layer->ctx, layer->fb->image);
+#elif defined NANOVG_GLES3
+	nvglImageChangedGLES3(layer->ctx, layer->fb->image);
+#endif
+#else
+	NVG_NOTUSED(layer);
+#endif
+}
+
+void nvgluDrawLayer(NVGLUlayer* layer, float x, float y, float w, float h, float alpha)
+{
+	NVGcontext* ctx = layer->ctx;
+	if (layer->fb == NULL || !layer->valid) return;
+	nvgBeginPath(ctx);
+	nvgRect(ctx, x, y, w, h);
+	nvgFillPaint(ctx, nvgImagePattern(ctx, x, y, w, h, 0, layer->fb->image, alpha));
+	nvgFill(ctx);
+}
+
+void nvgluInvalidateLayer(NVGLUlayer* layer)
+{
+	layer->valid = 0;
+}
+
+void nvgluDeleteLayer(NVGLUlayer* layer)
+{
+	if (layer == NULL) return;
+	nvgluDeleteFramebuffer(layer->fb);
+	free(layer);
+}
+
+unsigned int nvgluLayerKey(unsigned int key, const void* data, int size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	int i;
+	if (key == 0) key = 2166136261u;
+	for (i = 0; i < size; i++)
+		key = (key ^ p[i]) * 16777619u;	// FNV-1a
+	return key;
+}
+
 #endif // NANOVG_GL_IMPLEMENTATION
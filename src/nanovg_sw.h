@@ -0,0 +1,1328 @@
+//
+// Copyright (c) 2009-2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef NANOVG_SW_H
+#define NANOVG_SW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Creates a software renderer that draws into 8-bit RGBA pixels with premultiplied alpha.
+// The frame is split into tiles which are rasterized in parallel by nthreads worker threads
+// and the calling thread. With nthreads 0, all tiles are rasterized by the calling thread.
+NVGcontext* nvgCreateSW(int nthreads);
+void nvgDeleteSW(NVGcontext* ctx);
+
+// Sets the pixels the following frames are drawn to, must be called before nvgBeginFrame().
+// The first row is the top of the frame, stride is the number of bytes between rows.
+// The window size passed to nvgBeginFrame() is scaled to cover the whole buffer.
+void nvgswSetFramebuffer(NVGcontext* ctx, unsigned char* pixels, int w, int h, int stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOVG_SW_H */
+
+#ifdef NANOVG_SW_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "nanovg.h"
+
+#if !defined(NVG_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#	include <emmintrin.h>
+#	define NVGSW_SSE2 1
+#endif
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+typedef CRITICAL_SECTION swnvg__mutex;
+typedef CONDITION_VARIABLE swnvg__cond;
+typedef HANDLE swnvg__thread;
+#	define SWNVG_THREAD_FUNC DWORD WINAPI
+#	define swnvg__mutexInit(m) InitializeCriticalSection(m)
+#	define swnvg__mutexDestroy(m) DeleteCriticalSection(m)
+#	define swnvg__lock(m) EnterCriticalSection(m)
+#	define swnvg__unlock(m) LeaveCriticalSection(m)
+#	define swnvg__condInit(c) InitializeConditionVariable(c)
+#	define swnvg__condDestroy(c)
+#	define swnvg__condWait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#	define swnvg__condBroadcast(c) WakeAllConditionVariable(c)
+#	define swnvg__threadStart(t, fn, arg) ((*(t) = CreateThread(NULL, 0, fn, arg, 0, NULL)) != NULL)
+#	define swnvg__threadJoin(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#else
+#	include <pthread.h>
+typedef pthread_mutex_t swnvg__mutex;
+typedef pthread_cond_t swnvg__cond;
+typedef pthread_t swnvg__thread;
+#	define SWNVG_THREAD_FUNC void*
+#	define swnvg__mutexInit(m) pthread_mutex_init(m, NULL)
+#	define swnvg__mutexDestroy(m) pthread_mutex_destroy(m)
+#	define swnvg__lock(m) pthread_mutex_lock(m)
+#	define swnvg__unlock(m) pthread_mutex_unlock(m)
+#	define swnvg__condInit(c) pthread_cond_init(c, NULL)
+#	define swnvg__condDestroy(c) pthread_cond_destroy(c)
+#	define swnvg__condWait(c, m) pthread_cond_wait(c, m)
+#	define swnvg__condBroadcast(c) pthread_cond_broadcast(c)
+#	define swnvg__threadStart(t, fn, arg) (pthread_create(t, NULL, fn, arg) == 0)
+#	define swnvg__threadJoin(t) pthread_join(t, NULL)
+#endif
+
+#ifndef NVGSW_TILE_SIZE
+#	define NVGSW_TILE_SIZE 64
+#endif
+#define NVGSW_MAX_THREADS 32
+// Coverage accumulation rows plus one row of coverage, per thread.
+#define NVGSW_SCRATCH_SIZE ((NVGSW_TILE_SIZE+2) * (NVGSW_TILE_SIZE+1))
+
+enum SWNVGcallType {
+	SWNVG_NONE = 0,
+	SWNVG_FILL,
+	SWNVG_STROKE,
+	SWNVG_TRIANGLES,
+	SWNVG_QUADS,
+};
+
+enum SWNVGpaintType {
+	SWNVG_PAINT_COLOR,
+	SWNVG_PAINT_GRADIENT,
+	SWNVG_PAINT_IMAGE,
+	SWNVG_PAINT_TEXCOORD,	// Texture sampled at vertex texture coordinates.
+};
+
+struct SWNVGtexture {
+	int id;
+	unsigned char* data;
+	int width, height;
+	int type;
+	int flags;
+};
+typedef struct SWNVGtexture SWNVGtexture;
+
+struct SWNVGpaint {
+	int type;
+	int image;
+	const SWNVGtexture* tex;	// Resolved from image when the frame is flushed.
+	int texType;
+	int scissor;
+	float scissorMat[6];
+	float scissorExt[2];
+	float scissorScale[2];
+	float paintMat[6];
+	float innerCol[4];
+	float outerCol[4];
+	float extent[2];
+	float radius;
+	float feather;
+};
+typedef struct SWNVGpaint SWNVGpaint;
+
+struct SWNVGcall {
+	int type;
+	int offset;		// First edge for fills and strokes, first vertex for triangles and quads.
+	int count;
+	int bounds[4];	// Covered pixels, clipped to the framebuffer.
+	int sourceOver;
+	NVGcompositeOperationState blend;
+	SWNVGpaint paint;
+};
+typedef struct SWNVGcall SWNVGcall;
+
+struct SWNVGedge {
+	float x0, y0, x1, y1;
+};
+typedef struct SWNVGedge SWNVGedge;
+
+struct SWNVGcontext;
+
+struct SWNVGworker {
+	struct SWNVGcontext* sw;
+	int index;
+};
+typedef struct SWNVGworker SWNVGworker;
+
+struct SWNVGcontext {
+	SWNVGtexture* textures;
+	int ntextures;
+	int ctextures;
+	int textureId;
+	float view[2];
+	float scale[2];	// From window to framebuffer pixels.
+	unsigned char* pixels;
+	int width, height, stride;
+
+	SWNVGcall* calls;
+	int ccalls;
+	int ncalls;
+	SWNVGedge* edges;
+	int cedges;
+	int nedges;
+	NVGvertex* verts;
+	int cverts;
+	int nverts;
+
+	// Calls binned to tiles, tileStart has an extra entry at the end.
+	int tilesX, tilesY, ntiles;
+	int* tileStart;
+	int* tileCursor;
+	int ctiles;
+	int* tileCalls;
+	int ctileCalls;
+
+	// Worker threads, scratch slot 0 is used by the calling thread.
+	float* scratch;
+	int nthreads;
+	swnvg__thread threads[NVGSW_MAX_THREADS];
+	SWNVGworker workers[NVGSW_MAX_THREADS];
+	swnvg__mutex lock;
+	swnvg__cond wake;
+	swnvg__cond idle;
+	int frame;
+	int nextTile;
+	int busy;
+	int quit;
+};
+typedef struct SWNVGcontext SWNVGcontext;
+
+static int swnvg__maxi(int a, int b) { return a > b ? a : b; }
+static int swnvg__mini(int a, int b) { return a < b ? a : b; }
+static float swnvg__minf(float a, float b) { return a < b ? a : b; }
+static float swnvg__maxf(float a, float b) { return a > b ? a : b; }
+static float swnvg__clampf(float a, float mn, float mx) { return a < mn ? mn : (a > mx ? mx : a); }
+
+static SWNVGtexture* swnvg__allocTexture(SWNVGcontext* sw)
+{
+	SWNVGtexture* tex = NULL;
+	int i;
+
+	for (i = 0; i < sw->ntextures; i++) {
+		if (sw->textures[i].id == 0) {
+			tex = &sw->textures[i];
+			break;
+		}
+	}
+	if (tex == NULL) {
+		if (sw->ntextures+1 > sw->ctextures) {
+			SWNVGtexture* textures;
+			int ctextures = swnvg__maxi(sw->ntextures+1, 4) +  sw->ctextures/2; // 1.5x Overallocate
+			textures = (SWNVGtexture*)realloc(sw->textures, sizeof(SWNVGtexture)*ctextures);
+			if (textures == NULL) return NULL;
+			sw->textures = textures;
+			sw->ctextures = ctextures;
+		}
+		tex = &sw->textures[sw->ntextures++];
+	}
+
+	memset(tex, 0, sizeof(*tex));
+	tex->id = ++sw->textureId;
+
+	return tex;
+}
+
+static SWNVGtexture* swnvg__findTexture(SWNVGcontext* sw, int id)
+{
+	int i;
+	for (i = 0; i < sw->ntextures; i++)
+		if (sw->textures[i].id == id)
+			return &sw->textures[i];
+	return NULL;
+}
+
+static int swnvg__deleteTexture(SWNVGcontext* sw, int id)
+{
+	int i;
+	for (i = 0; i < sw->ntextures; i++) {
+		if (sw->textures[i].id == id) {
+			free(sw->textures[i].data);
+			memset(&sw->textures[i], 0, sizeof(sw->textures[i]));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void swnvg__renderTiles(SWNVGcontext* sw, int index);
+
+static SWNVG_THREAD_FUNC swnvg__worker(void* arg)
+{
+	SWNVGworker* worker = (SWNVGworker*)arg;
+	SWNVGcontext* sw = worker->sw;
+	int frame = 0;
+
+	swnvg__lock(&sw->lock);
+	for (;;) {
+		while (sw->frame == frame && !sw->quit)
+			swnvg__condWait(&sw->wake, &sw->lock);
+		if (sw->quit)
+			break;
+		frame = sw->frame;
+		swnvg__unlock(&sw->lock);
+
+		swnvg__renderTiles(sw, worker->index);
+
+		swnvg__lock(&sw->lock);
+		sw->busy--;
+		if (sw->busy == 0)
+			swnvg__condBroadcast(&sw->idle);
+	}
+	swnvg__unlock(&sw->lock);
+
+	return 0;
+}
+
+static int swnvg__renderCreate(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i, nthreads = sw->nthreads;
+
+	sw->nthreads = 0;
+	sw->scratch = (float*)malloc(sizeof(float) * NVGSW_SCRATCH_SIZE * (nthreads+1));
+	if (sw->scratch == NULL) return 0;
+	memset(sw->scratch, 0, sizeof(float) * NVGSW_SCRATCH_SIZE * (nthreads+1));
+
+	if (nthreads > 0) {
+		swnvg__mutexInit(&sw->lock);
+		swnvg__condInit(&sw->wake);
+		swnvg__condInit(&sw->idle);
+		for (i = 0; i < nthreads; i++) {
+			sw->workers[i].sw = sw;
+			sw->workers[i].index = i+1;
+			if (!swnvg__threadStart(&sw->threads[i], swnvg__worker, &sw->workers[i]))
+				break;
+			sw->nthreads++;
+		}
+		if (sw->nthreads == 0) {
+			swnvg__condDestroy(&sw->idle);
+			swnvg__condDestroy(&sw->wake);
+			swnvg__mutexDestroy(&sw->lock);
+		}
+	}
+
+	return 1;
+}
+
+static int swnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex;
+	int size = w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+
+	// Only 8-bit textures are sampled by the rasterizer.
+	if (type != NVG_TEXTURE_ALPHA && type != NVG_TEXTURE_RGBA) return 0;
+	tex = swnvg__allocTexture(sw);
+	if (tex == NULL) return 0;
+
+	tex->data = (unsigned char*)malloc(size);
+	if (tex->data == NULL) {
+		tex->id = 0;
+		return 0;
+	}
+	if (data != NULL)
+		memcpy(tex->data, data, size);
+	else
+		memset(tex->data, 0, size);
+
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+	tex->flags = imageFlags;
+
+	return tex->id;
+}
+
+static int swnvg__renderDeleteTexture(void* uptr, int image)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	return swnvg__deleteTexture(sw, image);
+}
+
+static int swnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	int i, bpp;
+
+	if (tex == NULL) return 0;
+	bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+	// The data contains the whole image, like with GL_UNPACK_ROW_LENGTH.
+	for (i = y; i < y+h; i++)
+		memcpy(&tex->data[(i*tex->width + x) * bpp], &data[(i*tex->width + x) * bpp], w * bpp);
+
+	return 1;
+}
+
+static int swnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	if (tex == NULL) return 0;
+	*w = tex->width;
+	*h = tex->height;
+	return 1;
+}
+
+static int swnvg__renderGetTextureType(void* uptr, int image)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	return tex != NULL ? tex->type : 0;
+}
+
+static void swnvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	NVG_NOTUSED(devicePixelRatio);
+	sw->view[0] = width;
+	sw->view[1] = height;
+	sw->scale[0] = width > 0.0f ? sw->width / width : 1.0f;
+	sw->scale[1] = height > 0.0f ? sw->height / height : 1.0f;
+}
+
+static void swnvg__renderCancel(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	sw->nverts = 0;
+	sw->nedges = 0;
+	sw->ncalls = 0;
+}
+
+static void swnvg__premulColor(float* dst, NVGcolor c)
+{
+	dst[0] = c.r * c.a;
+	dst[1] = c.g * c.a;
+	dst[2] = c.b * c.a;
+	dst[3] = c.a;
+}
+
+static void swnvg__convertPaint(SWNVGcontext* sw, SWNVGpaint* frag, NVGpaint* paint, NVGscissor* scissor, float fringe)
+{
+	SWNVGtexture* tex;
+	float invxform[6];
+
+	memset(frag, 0, sizeof(*frag));
+
+	swnvg__premulColor(frag->innerCol, paint->innerColor);
+	swnvg__premulColor(frag->outerCol, paint->outerColor);
+
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+		frag->scissor = 0;
+	} else {
+		frag->scissor = 1;
+		nvgTransformInverse(frag->scissorMat, scissor->xform);
+		frag->scissorExt[0] = scissor->extent[0];
+		frag->scissorExt[1] = scissor->extent[1];
+		frag->scissorScale[0] = sqrtf(scissor->xform[0]*scissor->xform[0] + scissor->xform[2]*scissor->xform[2]) / fringe;
+		frag->scissorScale[1] = sqrtf(scissor->xform[1]*scissor->xform[1] + scissor->xform[3]*scissor->xform[3]) / fringe;
+	}
+
+	memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+	frag->image = paint->image;
+
+	if (paint->image != 0) {
+		tex = swnvg__findTexture(sw, paint->image);
+		if (tex != NULL && (tex->flags & NVG_IMAGE_FLIPY) != 0) {
+			float m1[6], m2[6];
+			nvgTransformTranslate(m1, 0.0f, paint->extent[1] * 0.5f);
+			nvgTransformMultiply(m1, paint->xform);
+			nvgTransformScale(m2, 1.0f, -1.0f);
+			nvgTransformMultiply(m2, m1);
+			nvgTransformTranslate(m1, 0.0f, -paint->extent[1] * 0.5f);
+			nvgTransformMultiply(m1, m2);
+			nvgTransformInverse(invxform, m1);
+		} else {
+			nvgTransformInverse(invxform, paint->xform);
+		}
+		frag->type = SWNVG_PAINT_IMAGE;
+		if (tex != NULL && tex->type == NVG_TEXTURE_RGBA)
+			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+		else
+			frag->texType = 2;
+	} else {
+		if (memcmp(frag->innerCol, frag->outerCol, sizeof(frag->innerCol)) == 0)
+			frag->type = SWNVG_PAINT_COLOR;
+		else
+			frag->type = SWNVG_PAINT_GRADIENT;
+		frag->radius = paint->radius;
+		frag->feather = paint->feather;
+		nvgTransformInverse(invxform, paint->xform);
+	}
+
+	memcpy(frag->paintMat, invxform, sizeof(frag->paintMat));
+}
+
+static SWNVGcall* swnvg__allocCall(SWNVGcontext* sw, NVGcompositeOperationState compositeOperation)
+{
+	SWNVGcall* ret = NULL;
+	if (sw->ncalls+1 > sw->ccalls) {
+		SWNVGcall* calls;
+		int ccalls = swnvg__maxi(sw->ncalls+1, 128) + sw->ccalls/2; // 1.5x Overallocate
+		calls = (SWNVGcall*)realloc(sw->calls, sizeof(SWNVGcall) * ccalls);
+		if (calls == NULL) return NULL;
+		sw->calls = calls;
+		sw->ccalls = ccalls;
+	}
+	ret = &sw->calls[sw->ncalls++];
+	memset(ret, 0, sizeof(SWNVGcall));
+	ret->blend = compositeOperation;
+	ret->sourceOver = compositeOperation.srcRGB == NVG_ONE && compositeOperation.srcAlpha == NVG_ONE &&
+		compositeOperation.dstRGB == NVG_ONE_MINUS_SRC_ALPHA && compositeOperation.dstAlpha == NVG_ONE_MINUS_SRC_ALPHA;
+	ret->bounds[0] = sw->width;
+	ret->bounds[1] = sw->height;
+	ret->bounds[2] = 0;
+	ret->bounds[3] = 0;
+	return ret;
+}
+
+static int swnvg__allocEdges(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nedges+n > sw->cedges) {
+		SWNVGedge* edges;
+		int cedges = swnvg__maxi(sw->nedges + n, 4096) + sw->cedges/2; // 1.5x Overallocate
+		edges = (SWNVGedge*)realloc(sw->edges, sizeof(SWNVGedge) * cedges);
+		if (edges == NULL) return -1;
+		sw->edges = edges;
+		sw->cedges = cedges;
+	}
+	ret = sw->nedges;
+	sw->nedges += n;
+	return ret;
+}
+
+static int swnvg__allocVerts(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nverts+n > sw->cverts) {
+		NVGvertex* verts;
+		int cverts = swnvg__maxi(sw->nverts + n, 4096) + sw->cverts/2; // 1.5x Overallocate
+		verts = (NVGvertex*)realloc(sw->verts, sizeof(NVGvertex) * cverts);
+		if (verts == NULL) return -1;
+		sw->verts = verts;
+		sw->cverts = cverts;
+	}
+	ret = sw->nverts;
+	sw->nverts += n;
+	return ret;
+}
+
+static void swnvg__growBounds(SWNVGcall* call, float x, float y)
+{
+	int ix = (int)floorf(x), iy = (int)floorf(y);
+	if (ix < call->bounds[0]) call->bounds[0] = ix;
+	if (iy < call->bounds[1]) call->bounds[1] = iy;
+	if (ix+1 > call->bounds[2]) call->bounds[2] = ix+1;
+	if (iy+1 > call->bounds[3]) call->bounds[3] = iy+1;
+}
+
+// Clips the call bounds to the framebuffer, returns 0 if nothing is covered.
+static int swnvg__clipBounds(SWNVGcontext* sw, SWNVGcall* call)
+{
+	call->bounds[0] = swnvg__maxi(call->bounds[0], 0);
+	call->bounds[1] = swnvg__maxi(call->bounds[1], 0);
+	call->bounds[2] = swnvg__mini(call->bounds[2], sw->width);
+	call->bounds[3] = swnvg__mini(call->bounds[3], sw->height);
+	return call->bounds[0] < call->bounds[2] && call->bounds[1] < call->bounds[3];
+}
+
+static void swnvg__addEdge(SWNVGcontext* sw, SWNVGcall* call, SWNVGedge* e, const NVGvertex* v0, const NVGvertex* v1)
+{
+	e->x0 = v0->x * sw->scale[0];
+	e->y0 = v0->y * sw->scale[1];
+	e->x1 = v1->x * sw->scale[0];
+	e->y1 = v1->y * sw->scale[1];
+	swnvg__growBounds(call, e->x0, e->y0);
+}
+
+static void swnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							  const float* bounds, const NVGpath* paths, int npaths)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw, compositeOperation);
+	SWNVGedge* edge;
+	int i, j, n = 0, offset;
+	NVG_NOTUSED(bounds);
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_FILL;
+	for (i = 0; i < npaths; i++)
+		n += paths[i].nfill;
+	offset = swnvg__allocEdges(sw, n);
+	if (offset == -1) goto error;
+	call->offset = offset;
+	call->count = n;
+
+	// Each path is a closed polygon, the coverage uses non-zero winding like the stencil fill.
+	edge = &sw->edges[offset];
+	for (i = 0; i < npaths; i++) {
+		const NVGpath* path = &paths[i];
+		for (j = 0; j < path->nfill; j++)
+			swnvg__addEdge(sw, call, edge++, &path->fill[j], &path->fill[(j+1) % path->nfill]);
+	}
+	if (!swnvg__clipBounds(sw, call)) goto error;
+
+	swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe);
+	return;
+
+error:
+	if (call->count > 0) sw->nedges = call->offset;
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+								float strokeWidth, const NVGpath* paths, int npaths)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw, compositeOperation);
+	SWNVGedge* edge;
+	int i, j, n = 0, offset;
+	NVG_NOTUSED(strokeWidth);
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_STROKE;
+	for (i = 0; i < npaths; i++)
+		n += swnvg__maxi(paths[i].nstroke - 2, 0) * 3;
+	offset = swnvg__allocEdges(sw, n);
+	if (offset == -1) goto error;
+	call->offset = offset;
+
+	// The strip triangles are wound the same way, so that overlaps are covered just once.
+	edge = &sw->edges[offset];
+	for (i = 0; i < npaths; i++) {
+		const NVGvertex* v = paths[i].stroke;
+		for (j = 0; j+2 < paths[i].nstroke; j++) {
+			const NVGvertex* v0 = &v[j];
+			const NVGvertex* v1 = &v[j+1];
+			const NVGvertex* v2 = &v[j+2];
+			float area = (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+			if (area == 0.0f) continue;
+			if (area < 0.0f) {
+				v1 = &v[j+2];
+				v2 = &v[j+1];
+			}
+			swnvg__addEdge(sw, call, edge++, v0, v1);
+			swnvg__addEdge(sw, call, edge++, v1, v2);
+			swnvg__addEdge(sw, call, edge++, v2, v0);
+		}
+	}
+	call->count = (int)(edge - &sw->edges[offset]);
+	sw->nedges = offset + call->count;
+	if (!swnvg__clipBounds(sw, call)) goto error;
+
+	swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe);
+	return;
+
+error:
+	if (offset != -1) sw->nedges = offset;
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static int swnvg__copyVerts(SWNVGcontext* sw, SWNVGcall* call, const NVGvertex* verts, int nverts)
+{
+	NVGvertex* dst;
+	int i, offset = swnvg__allocVerts(sw, nverts);
+	if (offset == -1) return 0;
+	call->offset = offset;
+	call->count = nverts;
+	dst = &sw->verts[offset];
+	for (i = 0; i < nverts; i++) {
+		dst[i] = verts[i];
+		dst[i].x *= sw->scale[0];
+		dst[i].y *= sw->scale[1];
+		swnvg__growBounds(call, dst[i].x, dst[i].y);
+	}
+	return 1;
+}
+
+static void swnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts, float fringe)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw, compositeOperation);
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_TRIANGLES;
+	if (!swnvg__copyVerts(sw, call, verts, nverts)) goto error;
+	if (!swnvg__clipBounds(sw, call)) goto error;
+
+	swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe);
+	if (call->paint.image != 0)
+		call->paint.type = SWNVG_PAINT_TEXCOORD;
+	return;
+
+error:
+	if (call->count > 0) sw->nverts = call->offset;
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderQuads(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							   const NVGvertex* verts, int nquads, float fringe)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw, compositeOperation);
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_QUADS;
+	if (!swnvg__copyVerts(sw, call, verts, nquads*2)) goto error;
+	if (!swnvg__clipBounds(sw, call)) goto error;
+
+	swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe);
+	if (call->paint.image != 0)
+		call->paint.type = SWNVG_PAINT_TEXCOORD;
+	return;
+
+error:
+	if (call->count > 0) sw->nverts = call->offset;
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+// Accumulates the signed area of a line to the cells it crosses. Coordinates are relative to
+// the tile and clipped to [0,w] horizontally, the running sum of a row gives the coverage.
+static void swnvg__line(float* acc, int stride, int h, float x0, float y0, float x1, float y1)
+{
+	float dir = 1.0f, dxdy, x, ys, ye;
+	int y, yend;
+
+	if (y0 == y1) return;
+	if (y0 > y1) {
+		float t;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+		dir = -1.0f;
+	}
+	ys = swnvg__maxf(y0, 0.0f);
+	ye = swnvg__minf(y1, (float)h);
+	if (ys >= ye) return;
+
+	dxdy = (x1 - x0) / (y1 - y0);
+	x = x0 + (ys - y0) * dxdy;
+	yend = (int)ceilf(ye);
+
+	for (y = (int)ys; y < yend; y++) {
+		float* row = &acc[y * stride];
+		float dy = swnvg__minf((float)(y+1), ye) - swnvg__maxf((float)y, ys);
+		float xnext = x + dxdy * dy;
+		float d = dy * dir;
+		float xa = swnvg__minf(x, xnext), xb = swnvg__maxf(x, xnext);
+		int xai = (int)xa, xbi = (int)ceilf(xb);
+		if (xbi <= xai + 1) {
+			float xmf = 0.5f * (x + xnext) - xai;
+			row[xai] += d - d * xmf;
+			row[xai+1] += d * xmf;
+		} else {
+			float s = 1.0f / (xb - xa);
+			float xaf = xa - xai;
+			float a0 = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+			float xbf = xb - xbi + 1.0f;
+			float am = 0.5f * s * xbf * xbf;
+			row[xai] += d * a0;
+			if (xbi == xai + 2) {
+				row[xai+1] += d * (1.0f - a0 - am);
+			} else {
+				float a1 = s * (1.5f - xaf);
+				float a2;
+				int xi;
+				row[xai+1] += d * (a1 - a0);
+				for (xi = xai+2; xi < xbi-1; xi++)
+					row[xi] += d * s;
+				a2 = a1 + (xbi - xai - 3) * s;
+				row[xbi-1] += d * (1.0f - a2 - am);
+			}
+			row[xbi] += d * am;
+		}
+		x = xnext;
+	}
+}
+
+// Clips an edge to the tile. Parts on the left of the tile cover whole rows and are moved to
+// the first column, parts on the right do not affect the tile.
+static void swnvg__clipEdge(float* acc, int w, int h, float x0, float y0, float x1, float y1)
+{
+	float t[4];
+	int i, n = 0;
+
+	if (y0 == y1) return;
+	if ((y0 <= 0.0f && y1 <= 0.0f) || (y0 >= h && y1 >= h)) return;
+	if (x0 >= w && x1 >= w) return;
+	if (x0 <= 0.0f && x1 <= 0.0f) {
+		swnvg__line(acc, w+2, h, 0.0f, y0, 0.0f, y1);
+		return;
+	}
+	if (x0 >= 0.0f && x1 >= 0.0f && x0 <= w && x1 <= w) {
+		swnvg__line(acc, w+2, h, x0, y0, x1, y1);
+		return;
+	}
+
+	t[n++] = 0.0f;
+	if ((x0 < 0.0f) != (x1 < 0.0f))
+		t[n++] = (0.0f - x0) / (x1 - x0);
+	if ((x0 < w) != (x1 < w))
+		t[n++] = (w - x0) / (x1 - x0);
+	t[n++] = 1.0f;
+	if (n == 4 && t[1] > t[2]) {
+		float tmp = t[1];
+		t[1] = t[2];
+		t[2] = tmp;
+	}
+
+	for (i = 0; i < n-1; i++) {
+		float xa = x0 + (x1 - x0) * t[i], ya = y0 + (y1 - y0) * t[i];
+		float xb = x0 + (x1 - x0) * t[i+1], yb = y0 + (y1 - y0) * t[i+1];
+		float xm = (xa + xb) * 0.5f;
+		if (xm >= w) continue;
+		if (xm <= 0.0f) {
+			xa = xb = 0.0f;
+		} else {
+			xa = swnvg__clampf(xa, 0.0f, (float)w);
+			xb = swnvg__clampf(xb, 0.0f, (float)w);
+		}
+		swnvg__line(acc, w+2, h, xa, ya, xb, yb);
+	}
+}
+
+// Converts a row of accumulated area to coverage, and clears the row.
+static void swnvg__accumulate(float* acc, float* cov, int n)
+{
+	float sum = 0.0f, c;
+	int i = 0;
+#ifdef NVGSW_SSE2
+	__m128 carry = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	for (; i+4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps(&acc[i]);
+		x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+		x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+		x = _mm_add_ps(x, carry);
+		_mm_storeu_ps(&cov[i], _mm_min_ps(_mm_and_ps(x, absmask), one));
+		_mm_storeu_ps(&acc[i], _mm_setzero_ps());
+		carry = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3,3,3,3));
+	}
+	sum = _mm_cvtss_f32(carry);
+#endif
+	for (; i < n; i++) {
+		sum += acc[i];
+		acc[i] = 0.0f;
+		c = fabsf(sum);
+		cov[i] = c < 1.0f ? c : 1.0f;
+	}
+}
+
+static float swnvg__sdroundrect(float px, float py, float ex, float ey, float rad)
+{
+	float dx = fabsf(px) - (ex - rad);
+	float dy = fabsf(py) - (ey - rad);
+	float mx = swnvg__maxf(dx, 0.0f), my = swnvg__maxf(dy, 0.0f);
+	return swnvg__minf(swnvg__maxf(dx, dy), 0.0f) + sqrtf(mx*mx + my*my) - rad;
+}
+
+static float swnvg__scissorMask(const SWNVGpaint* frag, float x, float y)
+{
+	const float* m = frag->scissorMat;
+	float sx = fabsf(m[0]*x + m[2]*y + m[4]) - frag->scissorExt[0];
+	float sy = fabsf(m[1]*x + m[3]*y + m[5]) - frag->scissorExt[1];
+	sx = 0.5f - sx * frag->scissorScale[0];
+	sy = 0.5f - sy * frag->scissorScale[1];
+	return swnvg__clampf(sx, 0.0f, 1.0f) * swnvg__clampf(sy, 0.0f, 1.0f);
+}
+
+static void swnvg__texel(const SWNVGtexture* tex, int x, int y, float* c)
+{
+	const unsigned char* p;
+	if (tex->flags & NVG_IMAGE_REPEATX) {
+		x %= tex->width;
+		if (x < 0) x += tex->width;
+	} else {
+		x = swnvg__mini(swnvg__maxi(x, 0), tex->width-1);
+	}
+	if (tex->flags & NVG_IMAGE_REPEATY) {
+		y %= tex->height;
+		if (y < 0) y += tex->height;
+	} else {
+		y = swnvg__mini(swnvg__maxi(y, 0), tex->height-1);
+	}
+	if (tex->type == NVG_TEXTURE_RGBA) {
+		p = &tex->data[(y*tex->width + x) * 4];
+		c[0] = p[0] * (1.0f/255.0f);
+		c[1] = p[1] * (1.0f/255.0f);
+		c[2] = p[2] * (1.0f/255.0f);
+		c[3] = p[3] * (1.0f/255.0f);
+	} else {
+		c[0] = tex->data[y*tex->width + x] * (1.0f/255.0f);
+		c[1] = c[2] = 0.0f;
+		c[3] = 1.0f;
+	}
+}
+
+static void swnvg__sample(const SWNVGtexture* tex, float u, float v, float* c)
+{
+	float fx, fy, tx, ty, c00[4], c10[4], c01[4], c11[4];
+	int x, y, i;
+
+	if (tex == NULL || tex->width == 0 || tex->height == 0) {
+		c[0] = c[1] = c[2] = c[3] = 0.0f;
+		return;
+	}
+	if (tex->flags & NVG_IMAGE_NEAREST) {
+		swnvg__texel(tex, (int)floorf(u * tex->width), (int)floorf(v * tex->height), c);
+		return;
+	}
+
+	fx = u * tex->width - 0.5f;
+	fy = v * tex->height - 0.5f;
+	x = (int)floorf(fx);
+	y = (int)floorf(fy);
+	tx = fx - x;
+	ty = fy - y;
+	swnvg__texel(tex, x, y, c00);
+	swnvg__texel(tex, x+1, y, c10);
+	swnvg__texel(tex, x, y+1, c01);
+	swnvg__texel(tex, x+1, y+1, c11);
+	for (i = 0; i < 4; i++) {
+		float a = c00[i] + (c10[i] - c00[i]) * tx;
+		float b = c01[i] + (c11[i] - c01[i]) * tx;
+		c[i] = a + (b - a) * ty;
+	}
+}
+
+// Evaluates the premultiplied paint color at window position x,y.
+static void swnvg__paintColor(const SWNVGpaint* frag, float x, float y, float u, float v, float* c)
+{
+	const float* m = frag->paintMat;
+	float px, py, d;
+	int i;
+
+	switch (frag->type) {
+	case SWNVG_PAINT_COLOR:
+		memcpy(c, frag->innerCol, sizeof(float)*4);
+		return;
+	case SWNVG_PAINT_GRADIENT:
+		px = m[0]*x + m[2]*y + m[4];
+		py = m[1]*x + m[3]*y + m[5];
+		d = swnvg__clampf((swnvg__sdroundrect(px, py, frag->extent[0], frag->extent[1], frag->radius) + frag->feather*0.5f) / frag->feather, 0.0f, 1.0f);
+		for (i = 0; i < 4; i++)
+			c[i] = frag->innerCol[i] + (frag->outerCol[i] - frag->innerCol[i]) * d;
+		return;
+	case SWNVG_PAINT_IMAGE:
+		px = m[0]*x + m[2]*y + m[4];
+		py = m[1]*x + m[3]*y + m[5];
+		swnvg__sample(frag->tex, px / frag->extent[0], py / frag->extent[1], c);
+		break;
+	default:
+		swnvg__sample(frag->tex, u, v, c);
+		break;
+	}
+
+	if (frag->texType == 1) {
+		c[0] *= c[3];
+		c[1] *= c[3];
+		c[2] *= c[3];
+	} else if (frag->texType == 2) {
+		c[1] = c[2] = c[3] = c[0];
+	}
+	for (i = 0; i < 4; i++)
+		c[i] *= frag->innerCol[i];
+}
+
+static float swnvg__blendFactor(int factor, const float* src, const float* dst, int i)
+{
+	switch (factor) {
+	case NVG_ZERO: return 0.0f;
+	case NVG_ONE: return 1.0f;
+	case NVG_SRC_COLOR: return src[i];
+	case NVG_ONE_MINUS_SRC_COLOR: return 1.0f - src[i];
+	case NVG_DST_COLOR: return dst[i];
+	case NVG_ONE_MINUS_DST_COLOR: return 1.0f - dst[i];
+	case NVG_SRC_ALPHA: return src[3];
+	case NVG_ONE_MINUS_SRC_ALPHA: return 1.0f - src[3];
+	case NVG_DST_ALPHA: return dst[3];
+	case NVG_ONE_MINUS_DST_ALPHA: return 1.0f - dst[3];
+	case NVG_SRC_ALPHA_SATURATE: return i == 3 ? 1.0f : swnvg__minf(src[3], 1.0f - dst[3]);
+	}
+	return 0.0f;
+}
+
+static void swnvg__blend(const SWNVGcall* call, unsigned char* p, const float* src, float cov)
+{
+	float s[4], d[4], r;
+	int i;
+
+	s[0] = src[0] * cov;
+	s[1] = src[1] * cov;
+	s[2] = src[2] * cov;
+	s[3] = src[3] * cov;
+
+	if (call->sourceOver) {
+		float ia = 1.0f - s[3];
+		for (i = 0; i < 4; i++) {
+			r = s[i] * 255.0f + p[i] * ia;
+			p[i] = (unsigned char)(swnvg__minf(r, 255.0f) + 0.5f);
+		}
+		return;
+	}
+
+	for (i = 0; i < 4; i++)
+		d[i] = p[i] * (1.0f/255.0f);
+	for (i = 0; i < 4; i++) {
+		int sf = i < 3 ? call->blend.srcRGB : call->blend.srcAlpha;
+		int df = i < 3 ? call->blend.dstRGB : call->blend.dstAlpha;
+		r = s[i] * swnvg__blendFactor(sf, s, d, i) + d[i] * swnvg__blendFactor(df, s, d, i);
+		p[i] = (unsigned char)(swnvg__clampf(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+static void swnvg__shadePixel(SWNVGcontext* sw, const SWNVGcall* call, int x, int y, float cov, float u, float v)
+{
+	const SWNVGpaint* frag = &call->paint;
+	float c[4];
+	float wx = (x + 0.5f) / sw->scale[0];
+	float wy = (y + 0.5f) / sw->scale[1];
+
+	if (frag->scissor) {
+		cov *= swnvg__scissorMask(frag, wx, wy);
+		if (cov <= 0.0f) return;
+	}
+	swnvg__paintColor(frag, wx, wy, u, v, c);
+	swnvg__blend(call, &sw->pixels[y * sw->stride + x * 4], c, cov);
+}
+
+static void swnvg__rasterCoverage(SWNVGcontext* sw, const SWNVGcall* call, float* scratch, int tx, int ty, int tw, int th, const int* rect)
+{
+	float* acc = scratch;
+	float* cov = &scratch[(NVGSW_TILE_SIZE+2) * NVGSW_TILE_SIZE];
+	int i, x, y;
+
+	for (i = 0; i < call->count; i++) {
+		const SWNVGedge* e = &sw->edges[call->offset + i];
+		swnvg__clipEdge(acc, tw, th, e->x0 - tx, e->y0 - ty, e->x1 - tx, e->y1 - ty);
+	}
+
+	for (y = rect[1]; y < rect[3]; y++) {
+		float* row = &acc[y * (tw+2)];
+		swnvg__accumulate(row, cov, tw);
+		row[tw] = row[tw+1] = 0.0f;
+		for (x = rect[0]; x < rect[2]; x++) {
+			if (cov[x] < 1.0f/512.0f) continue;
+			swnvg__shadePixel(sw, call, tx + x, ty + y, cov[x], 0.0f, 0.0f);
+		}
+	}
+}
+
+static float swnvg__edgeFunc(const NVGvertex* a, const NVGvertex* b, float x, float y)
+{
+	return (b->x - a->x) * (y - a->y) - (b->y - a->y) * (x - a->x);
+}
+
+// Pixels exactly on an edge shared by two triangles are drawn by one of them.
+static int swnvg__edgeOwns(const NVGvertex* a, const NVGvertex* b)
+{
+	float dx = b->x - a->x, dy = b->y - a->y;
+	return dy < 0.0f || (dy == 0.0f && dx > 0.0f);
+}
+
+static void swnvg__rasterTriangle(SWNVGcontext* sw, const SWNVGcall* call, const NVGvertex* v0, const NVGvertex* v1, const NVGvertex* v2,
+								  int tx, int ty, const int* rect)
+{
+	float area = swnvg__edgeFunc(v0, v1, v2->x, v2->y);
+	int x, y, x0, y0, x1, y1, own0, own1, own2;
+
+	if (area == 0.0f) return;
+	if (area < 0.0f) {
+		const NVGvertex* t = v1;
+		v1 = v2;
+		v2 = t;
+		area = -area;
+	}
+
+	x0 = swnvg__maxi((int)floorf(swnvg__minf(v0->x, swnvg__minf(v1->x, v2->x))), tx + rect[0]);
+	y0 = swnvg__maxi((int)floorf(swnvg__minf(v0->y, swnvg__minf(v1->y, v2->y))), ty + rect[1]);
+	x1 = swnvg__mini((int)ceilf(swnvg__maxf(v0->x, swnvg__maxf(v1->x, v2->x))), tx + rect[2]);
+	y1 = swnvg__mini((int)ceilf(swnvg__maxf(v0->y, swnvg__maxf(v1->y, v2->y))), ty + rect[3]);
+	own0 = swnvg__edgeOwns(v1, v2);
+	own1 = swnvg__edgeOwns(v2, v0);
+	own2 = swnvg__edgeOwns(v0, v1);
+
+	for (y = y0; y < y1; y++) {
+		float cy = y + 0.5f;
+		for (x = x0; x < x1; x++) {
+			float cx = x + 0.5f;
+			float w0 = swnvg__edgeFunc(v1, v2, cx, cy);
+			float w1 = swnvg__edgeFunc(v2, v0, cx, cy);
+			float w2 = swnvg__edgeFunc(v0, v1, cx, cy);
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+			if ((w0 == 0.0f && !own0) || (w1 == 0.0f && !own1) || (w2 == 0.0f && !own2)) continue;
+			swnvg__shadePixel(sw, call, x, y, 1.0f,
+							  (w0*v0->u + w1*v1->u + w2*v2->u) / area,
+							  (w0*v0->v + w1*v1->v + w2*v2->v) / area);
+		}
+	}
+}
+
+static void swnvg__rasterQuad(SWNVGcontext* sw, const SWNVGcall* call, const NVGvertex* v0, const NVGvertex* v1,
+							  int tx, int ty, const int* rect)
+{
+	float dx = v1->x - v0->x, dy = v1->y - v0->y;
+	int x, y, x0, y0, x1, y1;
+
+	if (dx == 0.0f || dy == 0.0f) return;
+
+	// Pixels whose center is inside the quad.
+	x0 = swnvg__maxi((int)ceilf(swnvg__minf(v0->x, v1->x) - 0.5f), tx + rect[0]);
+	y0 = swnvg__maxi((int)ceilf(swnvg__minf(v0->y, v1->y) - 0.5f), ty + rect[1]);
+	x1 = swnvg__mini((int)ceilf(swnvg__maxf(v0->x, v1->x) - 0.5f), tx + rect[2]);
+	y1 = swnvg__mini((int)ceilf(swnvg__maxf(v0->y, v1->y) - 0.5f), ty + rect[3]);
+
+	for (y = y0; y < y1; y++) {
+		float v = v0->v + (v1->v - v0->v) * ((y + 0.5f - v0->y) / dy);
+		for (x = x0; x < x1; x++) {
+			float u = v0->u + (v1->u - v0->u) * ((x + 0.5f - v0->x) / dx);
+			swnvg__shadePixel(sw, call, x, y, 1.0f, u, v);
+		}
+	}
+}
+
+static void swnvg__renderTile(SWNVGcontext* sw, float* scratch, int tile)
+{
+	int tx = (tile % sw->tilesX) * NVGSW_TILE_SIZE;
+	int ty = (tile / sw->tilesX) * NVGSW_TILE_SIZE;
+	int tw = swnvg__mini(NVGSW_TILE_SIZE, sw->width - tx);
+	int th = swnvg__mini(NVGSW_TILE_SIZE, sw->height - ty);
+	int i, j, rect[4];
+
+	for (i = sw->tileStart[tile]; i < sw->tileStart[tile+1]; i++) {
+		const SWNVGcall* call = &sw->calls[sw->tileCalls[i]];
+		const NVGvertex* verts = &sw->verts[call->offset];
+
+		// Part of the call inside the tile, relative to the tile.
+		rect[0] = swnvg__maxi(call->bounds[0] - tx, 0);
+		rect[1] = swnvg__maxi(call->bounds[1] - ty, 0);
+		rect[2] = swnvg__mini(call->bounds[2] - tx, tw);
+		rect[3] = swnvg__mini(call->bounds[3] - ty, th);
+
+		switch (call->type) {
+		case SWNVG_FILL:
+		case SWNVG_STROKE:
+			swnvg__rasterCoverage(sw, call, scratch, tx, ty, tw, th, rect);
+			break;
+		case SWNVG_TRIANGLES:
+			for (j = 0; j+2 < call->count; j += 3)
+				swnvg__rasterTriangle(sw, call, &verts[j], &verts[j+1], &verts[j+2], tx, ty, rect);
+			break;
+		case SWNVG_QUADS:
+			for (j = 0; j+1 < call->count; j += 2)
+				swnvg__rasterQuad(sw, call, &verts[j], &verts[j+1], tx, ty, rect);
+			break;
+		}
+	}
+}
+
+static void swnvg__renderTiles(SWNVGcontext* sw, int index)
+{
+	float* scratch = &sw->scratch[index * NVGSW_SCRATCH_SIZE];
+	int tile;
+
+	for (;;) {
+		if (sw->nthreads > 0) swnvg__lock(&sw->lock);
+		tile = sw->nextTile++;
+		if (sw->nthreads > 0) swnvg__unlock(&sw->lock);
+		if (tile >= sw->ntiles) break;
+		swnvg__renderTile(sw, scratch, tile);
+	}
+}
+
+// Lists the calls touching each tile, in drawing order.
+static int swnvg__binCalls(SWNVGcontext* sw)
+{
+	int i, x, y, n = 0;
+
+	sw->tilesX = (sw->width + NVGSW_TILE_SIZE-1) / NVGSW_TILE_SIZE;
+	sw->tilesY = (sw->height + NVGSW_TILE_SIZE-1) / NVGSW_TILE_SIZE;
+	sw->ntiles = sw->tilesX * sw->tilesY;
+
+	if (sw->ntiles+1 > sw->ctiles) {
+		int ctiles = sw->ntiles+1;
+		int* tileStart = (int*)realloc(sw->tileStart, sizeof(int) * ctiles);
+		int* tileCursor;
+		if (tileStart == NULL) return 0;
+		sw->tileStart = tileStart;
+		tileCursor = (int*)realloc(sw->tileCursor, sizeof(int) * ctiles);
+		if (tileCursor == NULL) return 0;
+		sw->tileCursor = tileCursor;
+		sw->ctiles = ctiles;
+	}
+	memset(sw->tileStart, 0, sizeof(int) * (sw->ntiles+1));
+
+	for (i = 0; i < sw->ncalls; i++) {
+		SWNVGcall* call = &sw->calls[i];
+		for (y = call->bounds[1] / NVGSW_TILE_SIZE; y <= (call->bounds[3]-1) / NVGSW_TILE_SIZE; y++)
+			for (x = call->bounds[0] / NVGSW_TILE_SIZE; x <= (call->bounds[2]-1) / NVGSW_TILE_SIZE; x++)
+				sw->tileStart[y * sw->tilesX + x + 1]++;
+	}
+	for (i = 0; i < sw->ntiles; i++) {
+		sw->tileStart[i+1] += sw->tileStart[i];
+		sw->tileCursor[i] = sw->tileStart[i];
+	}
+	n = sw->tileStart[sw->ntiles];
+
+	if (n > sw->ctileCalls) {
+		int ctileCalls = swnvg__maxi(n, 256) + sw->ctileCalls/2; // 1.5x Overallocate
+		int* tileCalls = (int*)realloc(sw->tileCalls, sizeof(int) * ctileCalls);
+		if (tileCalls == NULL) return 0;
+		sw->tileCalls = tileCalls;
+		sw->ctileCalls = ctileCalls;
+	}
+
+	for (i = 0; i < sw->ncalls; i++) {
+		SWNVGcall* call = &sw->calls[i];
+		for (y = call->bounds[1] / NVGSW_TILE_SIZE; y <= (call->bounds[3]-1) / NVGSW_TILE_SIZE; y++)
+			for (x = call->bounds[0] / NVGSW_TILE_SIZE; x <= (call->bounds[2]-1) / NVGSW_TILE_SIZE; x++)
+				sw->tileCalls[sw->tileCursor[y * sw->tilesX + x]++] = i;
+	}
+
+	return 1;
+}
+
+static void swnvg__renderFlush(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i;
+
+	if (sw->pixels != NULL && sw->ncalls > 0 && swnvg__binCalls(sw)) {
+		for (i = 0; i < sw->ncalls; i++)
+			sw->calls[i].paint.tex = swnvg__findTexture(sw, sw->calls[i].paint.image);
+
+		sw->nextTile = 0;
+		if (sw->nthreads > 0) {
+			swnvg__lock(&sw->lock);
+			sw->busy = sw->nthreads;
+			sw->frame++;
+			swnvg__condBroadcast(&sw->wake);
+			swnvg__unlock(&sw->lock);
+		}
+
+		swnvg__renderTiles(sw, 0);
+
+		if (sw->nthreads > 0) {
+			swnvg__lock(&sw->lock);
+			while (sw->busy > 0)
+				swnvg__condWait(&sw->idle, &sw->lock);
+			swnvg__unlock(&sw->lock);
+		}
+	}
+
+	// Reset calls
+	sw->nverts = 0;
+	sw->nedges = 0;
+	sw->ncalls = 0;
+}
+
+static void swnvg__renderDelete(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i;
+	if (sw == NULL) return;
+
+	if (sw->nthreads > 0) {
+		swnvg__lock(&sw->lock);
+		sw->quit = 1;
+		swnvg__condBroadcast(&sw->wake);
+		swnvg__unlock(&sw->lock);
+		for (i = 0; i < sw->nthreads; i++)
+			swnvg__threadJoin(sw->threads[i]);
+		swnvg__condDestroy(&sw->idle);
+		swnvg__condDestroy(&sw->wake);
+		swnvg__mutexDestroy(&sw->lock);
+	}
+
+	for (i = 0; i < sw->ntextures; i++)
+		free(sw->textures[i].data);
+
+	free(sw->textures);
+	free(sw->calls);
+	free(sw->edges);
+	free(sw->verts);
+	free(sw->tileStart);
+	free(sw->tileCursor);
+	free(sw->tileCalls);
+	free(sw->scratch);
+	free(sw);
+}
+
+NVGcontext* nvgCreateSW(int nthreads)
+{
+	NVGparams params;
+	NVGcontext* ctx = NULL;
+	SWNVGcontext* sw = (SWNVGcontext*)malloc(sizeof(SWNVGcontext));
+	if (sw == NULL) goto error;
+	memset(sw, 0, sizeof(SWNVGcontext));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = swnvg__renderCreate;
+	params.renderCreateTexture = swnvg__renderCreateTexture;
+	params.renderDeleteTexture = swnvg__renderDeleteTexture;
+	params.renderUpdateTexture = swnvg__renderUpdateTexture;
+	params.renderGetTextureSize = swnvg__renderGetTextureSize;
+	params.renderGetTextureType = swnvg__renderGetTextureType;
+	params.renderViewport = swnvg__renderViewport;
+	params.renderCancel = swnvg__renderCancel;
+	params.renderFlush = swnvg__renderFlush;
+	params.renderFill = swnvg__renderFill;
+	params.renderStroke = swnvg__renderStroke;
+	params.renderTriangles = swnvg__renderTriangles;
+	params.renderQuads = swnvg__renderQuads;
+	params.renderDelete = swnvg__renderDelete;
+	params.userPtr = sw;
+	// Coverage is computed from the exact outlines, no anti-aliasing fringes are needed.
+	params.edgeAntiAlias = 0;
+
+	sw->nthreads = swnvg__mini(swnvg__maxi(nthreads, 0), NVGSW_MAX_THREADS);
+
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
+
+	return ctx;
+
+error:
+	// 'sw' is freed by nvgDeleteInternal.
+	if (ctx != NULL) nvgDeleteInternal(ctx);
+	return NULL;
+}
+
+void nvgDeleteSW(NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
+
+void nvgswSetFramebuffer(NVGcontext* ctx, unsigned char* pixels, int w, int h, int stride)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	sw->pixels = pixels;
+	sw->width = w;
+	sw->height = h;
+	sw->stride = stride;
+}
+
+#endif /* NANOVG_SW_IMPLEMENTATION */
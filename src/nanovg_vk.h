@@ -0,0 +1,1972 @@
+//
+// Copyright (c) 2009-2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef NANOVG_VK_H
+#define NANOVG_VK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create flags, the values are the same as the NVGcreateFlags of nanovg_gl.h.
+
+enum NVGVKcreateFlags {
+	// Flag indicating if geometry based anti-aliasing is used (may not be needed when using MSAA).
+	NVGVK_ANTIALIAS 		= 1<<0,
+	// Flag indicating if strokes should be drawn using stencil buffer.
+	NVGVK_STENCIL_STROKES	= 1<<1,
+	// Flag indicating that failed Vulkan calls are reported.
+	NVGVK_DEBUG 			= 1<<2,
+	// Flag indicating that text is drawn from signed distance field glyphs.
+	NVGVK_SDF_TEXT			= 1<<4,
+	// Flag indicating that single, simple concave fill paths are triangulated instead of stenciled.
+	NVGVK_TRIANGULATE_FILLS	= 1<<5,
+};
+
+// Maximum number of frames in flight.
+#define NVGVK_MAX_FRAMES 4
+
+struct NVGVKcreateInfo {
+	VkPhysicalDevice physicalDevice;
+	VkDevice device;
+	VkRenderPass renderPass;		// Render pass nanovg is drawn in, needs a stencil attachment.
+	uint32_t subpass;
+	VkSampleCountFlagBits samples;	// Sample count of the subpass, 0 for single sampled.
+	VkPipelineCache pipelineCache;	// Optional.
+	const VkAllocationCallbacks* allocator;	// Optional.
+	int framesInFlight;				// Number of per frame buffers, at most NVGVK_MAX_FRAMES.
+	const uint32_t* vertCode;		// SPIR-V of nanovg_vk.vert.
+	size_t vertCodeSize;			// Size of vertCode in bytes.
+	const uint32_t* fragCode;		// SPIR-V of nanovg_vk.frag.
+	size_t fragCodeSize;			// Size of fragCode in bytes.
+};
+typedef struct NVGVKcreateInfo NVGVKcreateInfo;
+
+// Creates a Vulkan renderer which records to command buffers owned by the application.
+// It never submits to or waits on a queue, so the application keeps the external synchronization of
+// its queues. Flags should be combination of the create flags above.
+NVGcontext* nvgCreateVk(const NVGVKcreateInfo* info, int flags);
+// The GPU must be done with all frames, e.g. after vkDeviceWaitIdle().
+void nvgDeleteVk(NVGcontext* ctx);
+
+// Sets the command buffer of the next frame, and the index of the frame in flight whose buffers are used.
+// The command buffer must be recording outside of a render pass, nvgEndFrame() records the texture uploads
+// of the frame to it. The GPU must be done with the previous frame that used the same index,
+// e.g. the application has waited for the fence of that frame.
+void nvgvkBeginFrame(NVGcontext* ctx, VkCommandBuffer cmd, int frame);
+
+// Records the draw calls of the frame ended by nvgEndFrame() to its command buffer, which must be inside
+// the render pass given at creation by now. The filtered state changes of the frame statistics are counted
+// here, and reported with the next frame.
+void nvgvkRenderFrame(NVGcontext* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOVG_VK_H */
+
+#ifdef NANOVG_VK_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "nanovg.h"
+
+#define NVGVK_DESCRIPTOR_POOL_SIZE 64
+
+enum VKNVGshaderType {
+	VKNVG_SHADER_FILLGRAD,
+	VKNVG_SHADER_FILLIMG,
+	VKNVG_SHADER_SIMPLE,
+	VKNVG_SHADER_IMG,
+	VKNVG_SHADER_SDF
+};
+
+// Pipeline states needed to draw the calls, see vknvg__pipelineDescs.
+enum VKNVGpipelineType {
+	VKNVG_PIPELINE_FILL_STENCIL,
+	VKNVG_PIPELINE_FRINGE,
+	VKNVG_PIPELINE_FILL_COVER,
+	VKNVG_PIPELINE_CONVEX_FILL,
+	VKNVG_PIPELINE_STROKE,
+	VKNVG_PIPELINE_STROKE_BASE,
+	VKNVG_PIPELINE_STROKE_CLEAR,
+	VKNVG_PIPELINE_TRIANGLES,
+	VKNVG_PIPELINE_COUNT
+};
+
+struct VKNVGpipelineDesc {
+	VkPrimitiveTopology topology;
+	VkCullModeFlags cullMode;
+	int colorWrite;
+	int stencilTest;
+	VkCompareOp compareOp;
+	VkStencilOp failOp;
+	VkStencilOp passOp;
+	VkStencilOp backPassOp;
+};
+typedef struct VKNVGpipelineDesc VKNVGpipelineDesc;
+
+// Same states as used by the draw functions of nanovg_gl.h.
+static const VKNVGpipelineDesc vknvg__pipelineDescs[VKNVG_PIPELINE_COUNT] = {
+	// Fill shapes to stencil.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN, VK_CULL_MODE_NONE, 0, 1, VK_COMPARE_OP_ALWAYS,
+	  VK_STENCIL_OP_KEEP, VK_STENCIL_OP_INCREMENT_AND_WRAP, VK_STENCIL_OP_DECREMENT_AND_WRAP },
+	// Anti-aliased fringes of stencil fills and strokes.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_CULL_MODE_BACK_BIT, 1, 1, VK_COMPARE_OP_EQUAL,
+	  VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP },
+	// Cover quad of stencil fills, clears the stencil.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_CULL_MODE_BACK_BIT, 1, 1, VK_COMPARE_OP_NOT_EQUAL,
+	  VK_STENCIL_OP_ZERO, VK_STENCIL_OP_ZERO, VK_STENCIL_OP_ZERO },
+	// Convex fills.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN, VK_CULL_MODE_BACK_BIT, 1, 0, VK_COMPARE_OP_ALWAYS,
+	  VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP },
+	// Strokes and fringes of convex fills.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_CULL_MODE_BACK_BIT, 1, 0, VK_COMPARE_OP_ALWAYS,
+	  VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP },
+	// Stencil strokes without overlap.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_CULL_MODE_BACK_BIT, 1, 1, VK_COMPARE_OP_EQUAL,
+	  VK_STENCIL_OP_KEEP, VK_STENCIL_OP_INCREMENT_AND_CLAMP, VK_STENCIL_OP_INCREMENT_AND_CLAMP },
+	// Clear stencil of stencil strokes.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_CULL_MODE_BACK_BIT, 0, 1, VK_COMPARE_OP_ALWAYS,
+	  VK_STENCIL_OP_ZERO, VK_STENCIL_OP_ZERO, VK_STENCIL_OP_ZERO },
+	// Triangles.
+	{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_CULL_MODE_BACK_BIT, 1, 0, VK_COMPARE_OP_ALWAYS,
+	  VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP },
+};
+
+struct VKNVGblend
+{
+	VkBlendFactor srcRGB;
+	VkBlendFactor dstRGB;
+	VkBlendFactor srcAlpha;
+	VkBlendFactor dstAlpha;
+};
+typedef struct VKNVGblend VKNVGblend;
+
+struct VKNVGpipeline {
+	int type;
+	VKNVGblend blend;
+	VkPipeline pipeline;
+};
+typedef struct VKNVGpipeline VKNVGpipeline;
+
+struct VKNVGtexture {
+	int id;
+	VkImage image;
+	VkDeviceMemory memory;
+	VkImageView view;
+	VkDescriptorSet set;
+	int pool;
+	int width, height;
+	int type;
+	int flags;
+	int mipLevels;
+	int ready;		// Image has been uploaded and is in shader read layout.
+};
+typedef struct VKNVGtexture VKNVGtexture;
+
+// Samplers are shared by textures with the same filtering and wrap flags.
+#define VKNVG_SAMPLER_COUNT 16
+
+enum VKNVGcallType {
+	VKNVG_NONE = 0,
+	VKNVG_FILL,
+	VKNVG_CONVEXFILL,
+	VKNVG_STROKE,
+	VKNVG_TRIANGLES,
+};
+
+struct VKNVGcall {
+	int type;
+	int image;
+	int pathOffset;
+	int pathCount;
+	int triangleOffset;
+	int triangleCount;
+	int uniformOffset;
+	VKNVGblend blendFunc;
+};
+typedef struct VKNVGcall VKNVGcall;
+
+struct VKNVGpath {
+	int fillOffset;
+	int fillCount;
+	int fillTriangles;
+	int strokeOffset;
+	int strokeCount;
+};
+typedef struct VKNVGpath VKNVGpath;
+
+// Matches the std140 uniform block of nanovg_vk.frag.
+struct VKNVGfragUniforms {
+	float scissorMat[12]; // matrices are actually 3 vec4s
+	float paintMat[12];
+	struct NVGcolor innerCol;
+	struct NVGcolor outerCol;
+	float scissorExt[2];
+	float scissorScale[2];
+	float extent[2];
+	float radius;
+	float feather;
+	float strokeMult;
+	float strokeThr;
+	int texType;
+	int type;
+};
+typedef struct VKNVGfragUniforms VKNVGfragUniforms;
+
+// Host visible buffer which stays mapped.
+struct VKNVGbuffer {
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	void* ptr;
+};
+typedef struct VKNVGbuffer VKNVGbuffer;
+
+// Texture upload waiting to be recorded to the command buffer of a frame.
+struct VKNVGupload {
+	int image;
+	int x, y, w, h;
+	int offset;		// Offset of the rows in uploadData, -1 to clear the image.
+};
+typedef struct VKNVGupload VKNVGupload;
+
+// Buffers of one frame in flight. They are only written after the GPU is done with the
+// previous frame that used them, so that building a frame never waits for the GPU.
+struct VKNVGframe {
+	VKNVGbuffer vertBuf;
+	VKNVGbuffer fragBuf;
+	VkDescriptorSet fragSet;	// Points to fragBuf, the uniforms of a call are selected with a dynamic offset.
+	VKNVGbuffer staging;		// Source of the texture uploads recorded in the frame.
+	VKNVGtexture* garbage;		// Textures deleted while the frame was built, destroyed when the frame comes around again.
+	int ngarbage;
+	int cgarbage;
+};
+typedef struct VKNVGframe VKNVGframe;
+
+struct VKNVGcontext {
+	NVGVKcreateInfo info;
+	VkPhysicalDeviceMemoryProperties memProps;
+
+	VkShaderModule vertShader;
+	VkShaderModule fragShader;
+	VkDescriptorSetLayout fragSetLayout;
+	VkDescriptorSetLayout texSetLayout;
+	VkPipelineLayout pipelineLayout;
+	VkDescriptorPool fragPool;
+	VkDescriptorPool* texPools;
+	int ntexPools;
+	int ctexPools;
+	VkSampler samplers[VKNVG_SAMPLER_COUNT];
+
+	// Pipelines by type and blend, the source over pipelines are created up front.
+	VKNVGpipeline* pipelines;
+	int npipelines;
+	int cpipelines;
+
+	// Texture uploads wait here until nvgEndFrame() copies them to the staging buffer of the frame.
+	VKNVGupload* uploads;
+	int nuploads;
+	int cuploads;
+	unsigned char* uploadData;
+	int nuploadData;
+	int cuploadData;
+
+	VKNVGframe frames[NVGVK_MAX_FRAMES];
+	int nframes;
+	int frame;
+	VkCommandBuffer cmd;
+
+	VKNVGtexture* textures;
+	float view[2];
+	float devicePixelRatio;
+	int ntextures;
+	int ctextures;
+	int textureId;
+	int fragSize;
+	int flags;
+
+	// Per frame buffers
+	VKNVGcall* calls;
+	int ccalls;
+	int ncalls;
+	VKNVGpath* paths;
+	int cpaths;
+	int npaths;
+	struct NVGvertex* verts;
+	int cverts;
+	int nverts;
+	unsigned char* uniforms;
+	int cuniforms;
+	int nuniforms;
+
+	// Uniforms of the last mergeable call, and the index of the call.
+	VKNVGfragUniforms lastFrag;
+	int lastFragCall;
+
+	// Back-end statistics of the current frame.
+	NVGframeStats stats;
+	int stateChanges;	// Filtered state changes of the last frame recorded by nvgvkRenderFrame().
+
+	// cached state
+	VkPipeline boundPipeline;
+	VkDescriptorSet boundTexSet;
+
+	int dummyTex;
+};
+typedef struct VKNVGcontext VKNVGcontext;
+
+static int vknvg__maxi(int a, int b) { return a > b ? a : b; }
+
+static int vknvg__checkResult(VKNVGcontext* vk, VkResult res, const char* str)
+{
+	if (res == VK_SUCCESS) return 1;
+	if (vk->flags & NVGVK_DEBUG)
+		printf("Vulkan error %d after %s\n", (int)res, str);
+	return 0;
+}
+
+static int vknvg__memoryType(VKNVGcontext* vk, uint32_t typeBits, VkMemoryPropertyFlags props, uint32_t* index)
+{
+	uint32_t i;
+	for (i = 0; i < vk->memProps.memoryTypeCount; i++) {
+		if ((typeBits & (1u << i)) != 0 && (vk->memProps.memoryTypes[i].propertyFlags & props) == props) {
+			*index = i;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void vknvg__deleteBuffer(VKNVGcontext* vk, VKNVGbuffer* buf)
+{
+	if (buf->buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(vk->info.device, buf->buffer, vk->info.allocator);
+	if (buf->memory != VK_NULL_HANDLE)
+		vkFreeMemory(vk->info.device, buf->memory, vk->info.allocator);
+	memset(buf, 0, sizeof(*buf));
+}
+
+static int vknvg__createBuffer(VKNVGcontext* vk, VKNVGbuffer* buf, VkBufferUsageFlags usage, VkDeviceSize size)
+{
+	VkBufferCreateInfo info;
+	VkMemoryAllocateInfo alloc;
+	VkMemoryRequirements req;
+
+	memset(buf, 0, sizeof(*buf));
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	info.size = size;
+	info.usage = usage;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (!vknvg__checkResult(vk, vkCreateBuffer(vk->info.device, &info, vk->info.allocator, &buf->buffer), "create buffer"))
+		goto error;
+
+	vkGetBufferMemoryRequirements(vk->info.device, buf->buffer, &req);
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc.allocationSize = req.size;
+	if (!vknvg__memoryType(vk, req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &alloc.memoryTypeIndex))
+		goto error;
+	if (!vknvg__checkResult(vk, vkAllocateMemory(vk->info.device, &alloc, vk->info.allocator, &buf->memory), "alloc buffer"))
+		goto error;
+	if (!vknvg__checkResult(vk, vkBindBufferMemory(vk->info.device, buf->buffer, buf->memory, 0), "bind buffer"))
+		goto error;
+	if (!vknvg__checkResult(vk, vkMapMemory(vk->info.device, buf->memory, 0, VK_WHOLE_SIZE, 0, &buf->ptr), "map buffer"))
+		goto error;
+	buf->size = size;
+
+	return 1;
+
+error:
+	vknvg__deleteBuffer(vk, buf);
+	return 0;
+}
+
+// Makes sure that the buffer holds at least size bytes. The contents are not kept.
+static int vknvg__reserveBuffer(VKNVGcontext* vk, VKNVGbuffer* buf, VkBufferUsageFlags usage, VkDeviceSize size, VkDeviceSize minSize)
+{
+	VkDeviceSize cur = buf->size;
+	if (size <= cur) return 1;
+	vknvg__deleteBuffer(vk, buf);
+	return vknvg__createBuffer(vk, buf, usage, (size > minSize ? size : minSize) + cur/2); // 1.5x Overallocate
+}
+
+static VKNVGtexture* vknvg__allocTexture(VKNVGcontext* vk)
+{
+	VKNVGtexture* tex = NULL;
+	int i;
+
+	for (i = 0; i < vk->ntextures; i++) {
+		if (vk->textures[i].id == 0) {
+			tex = &vk->textures[i];
+			break;
+		}
+	}
+	if (tex == NULL) {
+		if (vk->ntextures+1 > vk->ctextures) {
+			VKNVGtexture* textures;
+			int ctextures = vknvg__maxi(vk->ntextures+1, 4) +  vk->ctextures/2; // 1.5x Overallocate
+			textures = (VKNVGtexture*)realloc(vk->textures, sizeof(VKNVGtexture)*ctextures);
+			if (textures == NULL) return NULL;
+			vk->textures = textures;
+			vk->ctextures = ctextures;
+		}
+		tex = &vk->textures[vk->ntextures++];
+	}
+
+	memset(tex, 0, sizeof(*tex));
+	tex->id = ++vk->textureId;
+	tex->pool = -1;
+
+	return tex;
+}
+
+static VKNVGtexture* vknvg__findTexture(VKNVGcontext* vk, int id)
+{
+	int i;
+	for (i = 0; i < vk->ntextures; i++)
+		if (vk->textures[i].id == id)
+			return &vk->textures[i];
+	return NULL;
+}
+
+static void vknvg__destroyTexture(VKNVGcontext* vk, VKNVGtexture* tex)
+{
+	if (tex->set != VK_NULL_HANDLE)
+		vkFreeDescriptorSets(vk->info.device, vk->texPools[tex->pool], 1, &tex->set);
+	if (tex->view != VK_NULL_HANDLE)
+		vkDestroyImageView(vk->info.device, tex->view, vk->info.allocator);
+	if (tex->image != VK_NULL_HANDLE)
+		vkDestroyImage(vk->info.device, tex->image, vk->info.allocator);
+	if (tex->memory != VK_NULL_HANDLE)
+		vkFreeMemory(vk->info.device, tex->memory, vk->info.allocator);
+	memset(tex, 0, sizeof(*tex));
+}
+
+static void vknvg__destroyGarbage(VKNVGcontext* vk, VKNVGframe* frame)
+{
+	int i;
+	for (i = 0; i < frame->ngarbage; i++)
+		vknvg__destroyTexture(vk, &frame->garbage[i]);
+	frame->ngarbage = 0;
+}
+
+static int vknvg__deleteTexture(VKNVGcontext* vk, int id)
+{
+	VKNVGframe* frame = &vk->frames[vk->frame];
+	VKNVGtexture* tex = vknvg__findTexture(vk, id);
+	if (tex == NULL) return 0;
+
+	// The texture may still be used by frames in flight, keep it until this frame comes around again.
+	if (frame->ngarbage+1 > frame->cgarbage) {
+		VKNVGtexture* garbage;
+		int cgarbage = vknvg__maxi(frame->ngarbage+1, 4) + frame->cgarbage/2; // 1.5x Overallocate
+		garbage = (VKNVGtexture*)realloc(frame->garbage, sizeof(VKNVGtexture)*cgarbage);
+		if (garbage == NULL) return 0;
+		frame->garbage = garbage;
+		frame->cgarbage = cgarbage;
+	}
+	frame->garbage[frame->ngarbage++] = *tex;
+	memset(tex, 0, sizeof(*tex));
+
+	return 1;
+}
+
+static VkSampler vknvg__getSampler(VKNVGcontext* vk, int imageFlags)
+{
+	VkSamplerCreateInfo info;
+	int nearest = (imageFlags & NVG_IMAGE_NEAREST) != 0;
+	int mips = (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) != 0;
+	int idx = (mips ? 1 : 0) | ((imageFlags & NVG_IMAGE_REPEATX) ? 2 : 0) | ((imageFlags & NVG_IMAGE_REPEATY) ? 4 : 0) | (nearest ? 8 : 0);
+
+	if (vk->samplers[idx] != VK_NULL_HANDLE)
+		return vk->samplers[idx];
+
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	info.magFilter = nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+	info.minFilter = nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+	info.mipmapMode = nearest ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	info.addressModeU = (imageFlags & NVG_IMAGE_REPEATX) ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	info.addressModeV = (imageFlags & NVG_IMAGE_REPEATY) ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	info.maxLod = mips ? VK_LOD_CLAMP_NONE : 0.0f;
+	if (!vknvg__checkResult(vk, vkCreateSampler(vk->info.device, &info, vk->info.allocator, &vk->samplers[idx]), "create sampler"))
+		vk->samplers[idx] = VK_NULL_HANDLE;
+
+	return vk->samplers[idx];
+}
+
+// Allocates the descriptor set of a texture, the set is kept until the texture is deleted.
+static int vknvg__allocTextureSet(VKNVGcontext* vk, VKNVGtexture* tex)
+{
+	VkDescriptorSetAllocateInfo alloc;
+	VkDescriptorPoolCreateInfo info;
+	VkDescriptorPoolSize size;
+	int i;
+
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc.descriptorSetCount = 1;
+	alloc.pSetLayouts = &vk->texSetLayout;
+
+	for (i = vk->ntexPools-1; i >= 0; i--) {
+		alloc.descriptorPool = vk->texPools[i];
+		if (vkAllocateDescriptorSets(vk->info.device, &alloc, &tex->set) == VK_SUCCESS) {
+			tex->pool = i;
+			return 1;
+		}
+	}
+
+	// All pools are full, add a new one.
+	if (vk->ntexPools+1 > vk->ctexPools) {
+		VkDescriptorPool* pools;
+		int cpools = vknvg__maxi(vk->ntexPools+1, 4) + vk->ctexPools/2; // 1.5x Overallocate
+		pools = (VkDescriptorPool*)realloc(vk->texPools, sizeof(VkDescriptorPool)*cpools);
+		if (pools == NULL) return 0;
+		vk->texPools = pools;
+		vk->ctexPools = cpools;
+	}
+
+	memset(&size, 0, sizeof(size));
+	size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	size.descriptorCount = NVGVK_DESCRIPTOR_POOL_SIZE;
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	info.maxSets = NVGVK_DESCRIPTOR_POOL_SIZE;
+	info.poolSizeCount = 1;
+	info.pPoolSizes = &size;
+	if (!vknvg__checkResult(vk, vkCreateDescriptorPool(vk->info.device, &info, vk->info.allocator, &vk->texPools[vk->ntexPools]), "create pool"))
+		return 0;
+	vk->ntexPools++;
+
+	alloc.descriptorPool = vk->texPools[vk->ntexPools-1];
+	if (!vknvg__checkResult(vk, vkAllocateDescriptorSets(vk->info.device, &alloc, &tex->set), "alloc set")) {
+		tex->set = VK_NULL_HANDLE;
+		return 0;
+	}
+	tex->pool = vk->ntexPools-1;
+
+	return 1;
+}
+
+static void vknvg__imageBarrier(VkCommandBuffer cmd, VkImage image, int level, int count, VkImageLayout oldLayout, VkImageLayout newLayout,
+								VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+{
+	VkImageMemoryBarrier barrier;
+	memset(&barrier, 0, sizeof(barrier));
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = level;
+	barrier.subresourceRange.levelCount = count;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+// Queues a copy of a region of the texture data to the image, or a clear of the image if data is NULL.
+// The rows are copied right away, so the data can change before the upload is recorded.
+static int vknvg__uploadTexture(VKNVGcontext* vk, VKNVGtexture* tex, int x, int y, int w, int h, const unsigned char* data)
+{
+	VKNVGupload* upload;
+	int bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+	int i, size = (w*h*bpp + 3) & ~3;
+
+	if (vk->nuploads+1 > vk->cuploads) {
+		VKNVGupload* uploads;
+		int cuploads = vknvg__maxi(vk->nuploads+1, 16) + vk->cuploads/2; // 1.5x Overallocate
+		uploads = (VKNVGupload*)realloc(vk->uploads, sizeof(VKNVGupload)*cuploads);
+		if (uploads == NULL) return 0;
+		vk->uploads = uploads;
+		vk->cuploads = cuploads;
+	}
+	upload = &vk->uploads[vk->nuploads];
+	upload->image = tex->id;
+	upload->x = x;
+	upload->y = y;
+	upload->w = w;
+	upload->h = h;
+	upload->offset = -1;
+
+	if (data != NULL) {
+		unsigned char* dst;
+		if (vk->nuploadData+size > vk->cuploadData) {
+			unsigned char* uploadData;
+			int cuploadData = vknvg__maxi(vk->nuploadData+size, 4096) + vk->cuploadData/2; // 1.5x Overallocate
+			uploadData = (unsigned char*)realloc(vk->uploadData, cuploadData);
+			if (uploadData == NULL) return 0;
+			vk->uploadData = uploadData;
+			vk->cuploadData = cuploadData;
+		}
+		upload->offset = vk->nuploadData;
+		dst = &vk->uploadData[upload->offset];
+		for (i = 0; i < h; i++)
+			memcpy(&dst[i*w*bpp], &data[((y+i)*tex->width + x)*bpp], w*bpp);
+		vk->nuploadData += size;
+	}
+	vk->nuploads++;
+
+	return 1;
+}
+
+// Records an upload, whose rows are at offset in the staging buffer of the frame.
+// Barriers make it wait for earlier frames which sample the image, and the frame wait for it.
+static void vknvg__recordUpload(VKNVGcontext* vk, VKNVGtexture* tex, const VKNVGupload* upload, VkBuffer staging, VkDeviceSize offset)
+{
+	VkCommandBuffer cmd = vk->cmd;
+	int i, mw, mh;
+
+	if (tex->ready)
+		vknvg__imageBarrier(cmd, tex->image, 0, tex->mipLevels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+							0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	else
+		vknvg__imageBarrier(cmd, tex->image, 0, tex->mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+							0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	if (upload->offset >= 0) {
+		VkBufferImageCopy region;
+		memset(&region, 0, sizeof(region));
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset.x = upload->x;
+		region.imageOffset.y = upload->y;
+		region.imageExtent.width = upload->w;
+		region.imageExtent.height = upload->h;
+		region.imageExtent.depth = 1;
+		vkCmdCopyBufferToImage(cmd, staging, tex->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	} else {
+		VkClearColorValue clear;
+		VkImageSubresourceRange range;
+		memset(&clear, 0, sizeof(clear));
+		memset(&range, 0, sizeof(range));
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.levelCount = tex->mipLevels;
+		range.layerCount = 1;
+		vkCmdClearColorImage(cmd, tex->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &range);
+	}
+
+	// Build mipmaps by blitting each level from the previous one.
+	mw = tex->width;
+	mh = tex->height;
+	for (i = 1; i < tex->mipLevels; i++) {
+		VkImageBlit blit;
+		vknvg__imageBarrier(cmd, tex->image, i-1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+							VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		memset(&blit, 0, sizeof(blit));
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = i-1;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1].x = mw;
+		blit.srcOffsets[1].y = mh;
+		blit.srcOffsets[1].z = 1;
+		mw = vknvg__maxi(mw/2, 1);
+		mh = vknvg__maxi(mh/2, 1);
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = i;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[1].x = mw;
+		blit.dstOffsets[1].y = mh;
+		blit.dstOffsets[1].z = 1;
+		vkCmdBlitImage(cmd, tex->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, tex->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+	}
+	if (tex->mipLevels > 1)
+		vknvg__imageBarrier(cmd, tex->image, 0, tex->mipLevels-1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+							VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	vknvg__imageBarrier(cmd, tex->image, tex->mipLevels-1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	tex->ready = 1;
+}
+
+// Copies the queued uploads to the staging buffer of the frame and records them to its command buffer.
+// The GPU is done with the previous use of the staging buffer, so it can be written without waiting.
+// Uploads of deleted textures are dropped.
+static int vknvg__recordUploads(VKNVGcontext* vk)
+{
+	VKNVGframe* frame = &vk->frames[vk->frame];
+	int i;
+
+	if (vk->nuploads == 0) return 1;
+	if (vk->nuploadData > 0) {
+		if (!vknvg__reserveBuffer(vk, &frame->staging, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, vk->nuploadData, 65536))
+			return 0;
+		memcpy(frame->staging.ptr, vk->uploadData, vk->nuploadData);
+	}
+	for (i = 0; i < vk->nuploads; i++) {
+		VKNVGupload* upload = &vk->uploads[i];
+		VKNVGtexture* tex = vknvg__findTexture(vk, upload->image);
+		if (tex == NULL) continue;
+		vknvg__recordUpload(vk, tex, upload, frame->staging.buffer, upload->offset >= 0 ? (VkDeviceSize)upload->offset : 0);
+		if (upload->offset >= 0)
+			vk->stats.textureBytes += upload->w * upload->h * (tex->type == NVG_TEXTURE_RGBA ? 4 : 1);
+	}
+	vk->nuploads = 0;
+	vk->nuploadData = 0;
+
+	return 1;
+}
+
+static VkShaderModule vknvg__createShaderModule(VKNVGcontext* vk, const uint32_t* code, size_t size, const char* name)
+{
+	VkShaderModuleCreateInfo info;
+	VkShaderModule module = VK_NULL_HANDLE;
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	info.codeSize = size;
+	info.pCode = code;
+	if (!vknvg__checkResult(vk, vkCreateShaderModule(vk->info.device, &info, vk->info.allocator, &module), name))
+		return VK_NULL_HANDLE;
+	return module;
+}
+
+static VkPipeline vknvg__createPipeline(VKNVGcontext* vk, int type, const VKNVGblend* blend)
+{
+	const VKNVGpipelineDesc* desc = &vknvg__pipelineDescs[type];
+	VkGraphicsPipelineCreateInfo info;
+	VkPipelineShaderStageCreateInfo stages[2];
+	VkSpecializationMapEntry specEntry;
+	VkSpecializationInfo spec;
+	VkVertexInputBindingDescription binding;
+	VkVertexInputAttributeDescription attribs[2];
+	VkPipelineVertexInputStateCreateInfo vertexInput;
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+	VkPipelineViewportStateCreateInfo viewport;
+	VkPipelineRasterizationStateCreateInfo raster;
+	VkPipelineMultisampleStateCreateInfo multisample;
+	VkPipelineDepthStencilStateCreateInfo depthStencil;
+	VkPipelineColorBlendAttachmentState attachment;
+	VkPipelineColorBlendStateCreateInfo colorBlend;
+	VkPipelineDynamicStateCreateInfo dynamic;
+	VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkBool32 edgeAA = (vk->flags & NVGVK_ANTIALIAS) ? VK_TRUE : VK_FALSE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	// Edge anti-aliasing is a specialization constant of the fragment shader.
+	memset(&specEntry, 0, sizeof(specEntry));
+	specEntry.constantID = 0;
+	specEntry.size = sizeof(VkBool32);
+	memset(&spec, 0, sizeof(spec));
+	spec.mapEntryCount = 1;
+	spec.pMapEntries = &specEntry;
+	spec.dataSize = sizeof(VkBool32);
+	spec.pData = &edgeAA;
+
+	memset(stages, 0, sizeof(stages));
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vk->vertShader;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = vk->fragShader;
+	stages[1].pName = "main";
+	stages[1].pSpecializationInfo = &spec;
+
+	memset(&binding, 0, sizeof(binding));
+	binding.stride = sizeof(NVGvertex);
+	binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	memset(attribs, 0, sizeof(attribs));
+	attribs[0].location = 0;
+	attribs[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attribs[0].offset = 0;
+	attribs[1].location = 1;
+	attribs[1].format = VK_FORMAT_R32G32_SFLOAT;
+	attribs[1].offset = 2*sizeof(float);
+	memset(&vertexInput, 0, sizeof(vertexInput));
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = 1;
+	vertexInput.pVertexBindingDescriptions = &binding;
+	vertexInput.vertexAttributeDescriptionCount = 2;
+	vertexInput.pVertexAttributeDescriptions = attribs;
+
+	memset(&inputAssembly, 0, sizeof(inputAssembly));
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = desc->topology;
+
+	memset(&viewport, 0, sizeof(viewport));
+	viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport.viewportCount = 1;
+	viewport.scissorCount = 1;
+
+	// Clip space y points down, so the front faces are counter clockwise on screen just like in GL.
+	memset(&raster, 0, sizeof(raster));
+	raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	raster.polygonMode = VK_POLYGON_MODE_FILL;
+	raster.cullMode = desc->cullMode;
+	raster.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	raster.lineWidth = 1.0f;
+
+	memset(&multisample, 0, sizeof(multisample));
+	multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = vk->info.samples != 0 ? vk->info.samples : VK_SAMPLE_COUNT_1_BIT;
+
+	memset(&depthStencil, 0, sizeof(depthStencil));
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.stencilTestEnable = desc->stencilTest ? VK_TRUE : VK_FALSE;
+	depthStencil.front.failOp = desc->failOp;
+	depthStencil.front.passOp = desc->passOp;
+	depthStencil.front.depthFailOp = VK_STENCIL_OP_KEEP;
+	depthStencil.front.compareOp = desc->compareOp;
+	depthStencil.front.compareMask = 0xff;
+	depthStencil.front.writeMask = 0xff;
+	depthStencil.front.reference = 0;
+	depthStencil.back = depthStencil.front;
+	depthStencil.back.passOp = desc->backPassOp;
+
+	memset(&attachment, 0, sizeof(attachment));
+	attachment.blendEnable = VK_TRUE;
+	attachment.srcColorBlendFactor = blend->srcRGB;
+	attachment.dstColorBlendFactor = blend->dstRGB;
+	attachment.colorBlendOp = VK_BLEND_OP_ADD;
+	attachment.srcAlphaBlendFactor = blend->srcAlpha;
+	attachment.dstAlphaBlendFactor = blend->dstAlpha;
+	attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	if (desc->colorWrite)
+		attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	memset(&colorBlend, 0, sizeof(colorBlend));
+	colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlend.attachmentCount = 1;
+	colorBlend.pAttachments = &attachment;
+
+	memset(&dynamic, 0, sizeof(dynamic));
+	dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic.dynamicStateCount = 2;
+	dynamic.pDynamicStates = dynamicStates;
+
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	info.stageCount = 2;
+	info.pStages = stages;
+	info.pVertexInputState = &vertexInput;
+	info.pInputAssemblyState = &inputAssembly;
+	info.pViewportState = &viewport;
+	info.pRasterizationState = &raster;
+	info.pMultisampleState = &multisample;
+	info.pDepthStencilState = &depthStencil;
+	info.pColorBlendState = &colorBlend;
+	info.pDynamicState = &dynamic;
+	info.layout = vk->pipelineLayout;
+	info.renderPass = vk->info.renderPass;
+	info.subpass = vk->info.subpass;
+
+	if (!vknvg__checkResult(vk, vkCreateGraphicsPipelines(vk->info.device, vk->info.pipelineCache, 1, &info, vk->info.allocator, &pipeline), "create pipeline"))
+		return VK_NULL_HANDLE;
+
+	return pipeline;
+}
+
+static const VKNVGblend vknvg__sourceOver = {
+	VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA
+};
+
+// Returns the pipeline of given type and blend, it is created on first use.
+static VkPipeline vknvg__getPipeline(VKNVGcontext* vk, int type, const VKNVGblend* blend)
+{
+	VKNVGpipeline* p;
+	int i;
+
+	// Stencil only pipelines do not write color, they can share a pipeline whatever the blend.
+	if (!vknvg__pipelineDescs[type].colorWrite)
+		blend = &vknvg__sourceOver;
+
+	for (i = 0; i < vk->npipelines; i++) {
+		p = &vk->pipelines[i];
+		if (p->type == type && memcmp(&p->blend, blend, sizeof(VKNVGblend)) == 0)
+			return p->pipeline;
+	}
+
+	if (vk->npipelines+1 > vk->cpipelines) {
+		VKNVGpipeline* pipelines;
+		int cpipelines = vknvg__maxi(vk->npipelines+1, 16) + vk->cpipelines/2; // 1.5x Overallocate
+		pipelines = (VKNVGpipeline*)realloc(vk->pipelines, sizeof(VKNVGpipeline)*cpipelines);
+		if (pipelines == NULL) return VK_NULL_HANDLE;
+		vk->pipelines = pipelines;
+		vk->cpipelines = cpipelines;
+	}
+
+	p = &vk->pipelines[vk->npipelines];
+	p->type = type;
+	p->blend = *blend;
+	p->pipeline = vknvg__createPipeline(vk, type, blend);
+	if (p->pipeline == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+	vk->npipelines++;
+
+	return p->pipeline;
+}
+
+static int vknvg__bindPipeline(VKNVGcontext* vk, int type, const VKNVGblend* blend)
+{
+	VkPipeline pipeline = vknvg__getPipeline(vk, type, blend);
+	if (pipeline == VK_NULL_HANDLE) return 0;
+	if (vk->boundPipeline != pipeline) {
+		vk->boundPipeline = pipeline;
+		vkCmdBindPipeline(vk->cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	} else {
+		vk->stateChanges++;
+	}
+	return 1;
+}
+
+static int vknvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data);
+
+static int vknvg__renderCreate(void* uptr)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VkDevice device = vk->info.device;
+	const VkAllocationCallbacks* allocator = vk->info.allocator;
+	VkPhysicalDeviceProperties props;
+	VkDescriptorSetLayoutBinding binding;
+	VkDescriptorSetLayoutCreateInfo layoutInfo;
+	VkDescriptorSetLayout setLayouts[NVGVK_MAX_FRAMES];
+	VkPushConstantRange pushRange;
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo;
+	VkDescriptorPoolSize poolSize;
+	VkDescriptorPoolCreateInfo poolInfo;
+	VkDescriptorSetAllocateInfo setAlloc;
+	VkDescriptorSet sets[NVGVK_MAX_FRAMES];
+	VkDeviceSize align;
+	int i;
+
+	vkGetPhysicalDeviceMemoryProperties(vk->info.physicalDevice, &vk->memProps);
+	vkGetPhysicalDeviceProperties(vk->info.physicalDevice, &props);
+
+	vk->vertShader = vknvg__createShaderModule(vk, vk->info.vertCode, vk->info.vertCodeSize, "vert shader");
+	vk->fragShader = vknvg__createShaderModule(vk, vk->info.fragCode, vk->info.fragCodeSize, "frag shader");
+	if (vk->vertShader == VK_NULL_HANDLE || vk->fragShader == VK_NULL_HANDLE)
+		return 0;
+
+	// Set 0 holds the frag uniforms, set 1 the texture.
+	memset(&binding, 0, sizeof(binding));
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	memset(&layoutInfo, 0, sizeof(layoutInfo));
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+	if (!vknvg__checkResult(vk, vkCreateDescriptorSetLayout(device, &layoutInfo, allocator, &vk->fragSetLayout), "frag set layout"))
+		return 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	if (!vknvg__checkResult(vk, vkCreateDescriptorSetLayout(device, &layoutInfo, allocator, &vk->texSetLayout), "tex set layout"))
+		return 0;
+
+	memset(&pushRange, 0, sizeof(pushRange));
+	pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushRange.size = 2*sizeof(float);
+	setLayouts[0] = vk->fragSetLayout;
+	setLayouts[1] = vk->texSetLayout;
+	memset(&pipelineLayoutInfo, 0, sizeof(pipelineLayoutInfo));
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+	if (!vknvg__checkResult(vk, vkCreatePipelineLayout(device, &pipelineLayoutInfo, allocator, &vk->pipelineLayout), "pipeline layout"))
+		return 0;
+
+	// One persistent uniform set per frame in flight.
+	memset(&poolSize, 0, sizeof(poolSize));
+	poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSize.descriptorCount = vk->nframes;
+	memset(&poolInfo, 0, sizeof(poolInfo));
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = vk->nframes;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	if (!vknvg__checkResult(vk, vkCreateDescriptorPool(device, &poolInfo, allocator, &vk->fragPool), "frag pool"))
+		return 0;
+	for (i = 0; i < vk->nframes; i++)
+		setLayouts[i] = vk->fragSetLayout;
+	memset(&setAlloc, 0, sizeof(setAlloc));
+	setAlloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAlloc.descriptorPool = vk->fragPool;
+	setAlloc.descriptorSetCount = vk->nframes;
+	setAlloc.pSetLayouts = setLayouts;
+	if (!vknvg__checkResult(vk, vkAllocateDescriptorSets(device, &setAlloc, sets), "frag sets"))
+		return 0;
+	for (i = 0; i < vk->nframes; i++)
+		vk->frames[i].fragSet = sets[i];
+
+	align = props.limits.minUniformBufferOffsetAlignment;
+	if (align < 1) align = 1;
+	vk->fragSize = (int)((sizeof(VKNVGfragUniforms) + align - 1) / align * align);
+
+	// Create the pipelines of the default blend up front.
+	for (i = 0; i < VKNVG_PIPELINE_COUNT; i++) {
+		if (vknvg__getPipeline(vk, i, &vknvg__sourceOver) == VK_NULL_HANDLE)
+			return 0;
+	}
+
+	// Calls without image sample an empty texture.
+	vk->dummyTex = vknvg__renderCreateTexture(vk, NVG_TEXTURE_ALPHA, 1, 1, 0, NULL);
+	if (vk->dummyTex == 0)
+		return 0;
+
+	return 1;
+}
+
+static int vknvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGtexture* tex;
+	VkImageCreateInfo info;
+	VkImageViewCreateInfo viewInfo;
+	VkMemoryAllocateInfo alloc;
+	VkMemoryRequirements req;
+	VkDescriptorImageInfo imageInfo;
+	VkWriteDescriptorSet write;
+	VkFormat format = type == NVG_TEXTURE_RGBA ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8_UNORM;
+
+	// Other formats would need a check of the device format features.
+	if (type != NVG_TEXTURE_ALPHA && type != NVG_TEXTURE_RGBA) return 0;
+	tex = vknvg__allocTexture(vk);
+	if (tex == NULL) return 0;
+
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+	tex->flags = imageFlags;
+	tex->mipLevels = 1;
+	if (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS)
+		tex->mipLevels = (int)floorf(log2f((float)vknvg__maxi(w, h))) + 1;
+
+	memset(&info, 0, sizeof(info));
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	info.imageType = VK_IMAGE_TYPE_2D;
+	info.format = format;
+	info.extent.width = w;
+	info.extent.height = h;
+	info.extent.depth = 1;
+	info.mipLevels = tex->mipLevels;
+	info.arrayLayers = 1;
+	info.samples = VK_SAMPLE_COUNT_1_BIT;
+	info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (!vknvg__checkResult(vk, vkCreateImage(vk->info.device, &info, vk->info.allocator, &tex->image), "create image"))
+		goto error;
+
+	vkGetImageMemoryRequirements(vk->info.device, tex->image, &req);
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc.allocationSize = req.size;
+	if (!vknvg__memoryType(vk, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc.memoryTypeIndex))
+		goto error;
+	if (!vknvg__checkResult(vk, vkAllocateMemory(vk->info.device, &alloc, vk->info.allocator, &tex->memory), "alloc image"))
+		goto error;
+	if (!vknvg__checkResult(vk, vkBindImageMemory(vk->info.device, tex->image, tex->memory, 0), "bind image"))
+		goto error;
+
+	memset(&viewInfo, 0, sizeof(viewInfo));
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = tex->image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.levelCount = tex->mipLevels;
+	viewInfo.subresourceRange.layerCount = 1;
+	if (!vknvg__checkResult(vk, vkCreateImageView(vk->info.device, &viewInfo, vk->info.allocator, &tex->view), "create view"))
+		goto error;
+
+	if (!vknvg__allocTextureSet(vk, tex))
+		goto error;
+	memset(&imageInfo, 0, sizeof(imageInfo));
+	imageInfo.sampler = vknvg__getSampler(vk, imageFlags);
+	imageInfo.imageView = tex->view;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	if (imageInfo.sampler == VK_NULL_HANDLE)
+		goto error;
+	memset(&write, 0, sizeof(write));
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = tex->set;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(vk->info.device, 1, &write, 0, NULL);
+
+	if (!vknvg__uploadTexture(vk, tex, 0, 0, w, h, data))
+		goto error;
+
+	return tex->id;
+
+error:
+	// Nothing has been recorded yet, so the texture can be destroyed right away.
+	vknvg__destroyTexture(vk, tex);
+	return 0;
+}
+
+static int vknvg__renderDeleteTexture(void* uptr, int image)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	return vknvg__deleteTexture(vk, image);
+}
+
+static int vknvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGtexture* tex = vknvg__findTexture(vk, image);
+
+	if (tex == NULL) return 0;
+	return vknvg__uploadTexture(vk, tex, x, y, w, h, data);
+}
+
+static int vknvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGtexture* tex = vknvg__findTexture(vk, image);
+	if (tex == NULL) return 0;
+	*w = tex->width;
+	*h = tex->height;
+	return 1;
+}
+
+static int vknvg__renderGetTextureType(void* uptr, int image)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGtexture* tex = vknvg__findTexture(vk, image);
+	return tex != NULL ? tex->type : 0;
+}
+
+static void vknvg__xformToMat3x4(float* m3, float* t)
+{
+	m3[0] = t[0];
+	m3[1] = t[1];
+	m3[2] = 0.0f;
+	m3[3] = 0.0f;
+	m3[4] = t[2];
+	m3[5] = t[3];
+	m3[6] = 0.0f;
+	m3[7] = 0.0f;
+	m3[8] = t[4];
+	m3[9] = t[5];
+	m3[10] = 1.0f;
+	m3[11] = 0.0f;
+}
+
+static NVGcolor vknvg__premulColor(NVGcolor c)
+{
+	c.r *= c.a;
+	c.g *= c.a;
+	c.b *= c.a;
+	return c;
+}
+
+static int vknvg__convertPaint(VKNVGcontext* vk, VKNVGfragUniforms* frag, NVGpaint* paint,
+							   NVGscissor* scissor, float width, float fringe, float strokeThr)
+{
+	VKNVGtexture* tex = NULL;
+	float invxform[6];
+
+	memset(frag, 0, sizeof(*frag));
+
+	frag->innerCol = vknvg__premulColor(paint->innerColor);
+	frag->outerCol = vknvg__premulColor(paint->outerColor);
+
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+		memset(frag->scissorMat, 0, sizeof(frag->scissorMat));
+		frag->scissorExt[0] = 1.0f;
+		frag->scissorExt[1] = 1.0f;
+		frag->scissorScale[0] = 1.0f;
+		frag->scissorScale[1] = 1.0f;
+	} else {
+		nvgTransformInverse(invxform, scissor->xform);
+		vknvg__xformToMat3x4(frag->scissorMat, invxform);
+		frag->scissorExt[0] = scissor->extent[0];
+		frag->scissorExt[1] = scissor->extent[1];
+		frag->scissorScale[0] = sqrtf(scissor->xform[0]*scissor->xform[0] + scissor->xform[2]*scissor->xform[2]) / fringe;
+		frag->scissorScale[1] = sqrtf(scissor->xform[1]*scissor->xform[1] + scissor->xform[3]*scissor->xform[3]) / fringe;
+	}
+
+	memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+	frag->strokeMult = (width*0.5f + fringe*0.5f) / fringe;
+	frag->strokeThr = strokeThr;
+
+	if (paint->image != 0) {
+		tex = vknvg__findTexture(vk, paint->image);
+		if (tex == NULL) return 0;
+		if ((tex->flags & NVG_IMAGE_FLIPY) != 0) {
+			float m1[6], m2[6];
+			nvgTransformTranslate(m1, 0.0f, paint->extent[1] * 0.5f);
+			nvgTransformMultiply(m1, paint->xform);
+			nvgTransformScale(m2, 1.0f, -1.0f);
+			nvgTransformMultiply(m2, m1);
+			nvgTransformTranslate(m1, 0.0f, -paint->extent[1] * 0.5f);
+			nvgTransformMultiply(m1, m2);
+			nvgTransformInverse(invxform, m1);
+		} else {
+			nvgTransformInverse(invxform, paint->xform);
+		}
+		frag->type = VKNVG_SHADER_FILLIMG;
+
+		if (tex->type == NVG_TEXTURE_RGBA)
+			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+		else
+			frag->texType = 2;
+	} else {
+		frag->type = VKNVG_SHADER_FILLGRAD;
+		frag->radius = paint->radius;
+		frag->feather = paint->feather;
+		nvgTransformInverse(invxform, paint->xform);
+	}
+
+	vknvg__xformToMat3x4(frag->paintMat, invxform);
+
+	return 1;
+}
+
+static VKNVGfragUniforms* vknvg__fragUniformPtr(VKNVGcontext* vk, int i);
+
+static void vknvg__setTextureShader(VKNVGcontext* vk, VKNVGfragUniforms* frag, NVGpaint* paint)
+{
+	VKNVGtexture* tex = vknvg__findTexture(vk, paint->image);
+	frag->type = VKNVG_SHADER_IMG;
+	if (tex != NULL && (tex->flags & NVG_IMAGE_SDF) != 0) {
+		// Radius scales the sampled distance to pixels, feather is the edge width.
+		frag->type = VKNVG_SHADER_SDF;
+		frag->radius = paint->radius;
+		frag->feather = paint->feather;
+	}
+}
+
+// Selects the uniforms of a call with a dynamic offset into the frame's uniform buffer.
+// The texture set is only rebound when the texture changes.
+static void vknvg__setUniforms(VKNVGcontext* vk, int uniformOffset, int image)
+{
+	VKNVGtexture* tex = NULL;
+	VkDescriptorSet sets[2];
+	uint32_t offset = (uint32_t)uniformOffset;
+
+	if (image != 0) {
+		tex = vknvg__findTexture(vk, image);
+	}
+	// If no image is set, use empty texture
+	if (tex == NULL) {
+		tex = vknvg__findTexture(vk, vk->dummyTex);
+	}
+
+	sets[0] = vk->frames[vk->frame].fragSet;
+	sets[1] = tex->set;
+	if (vk->boundTexSet != sets[1]) {
+		vk->boundTexSet = sets[1];
+		vkCmdBindDescriptorSets(vk->cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->pipelineLayout, 0, 2, sets, 1, &offset);
+	} else {
+		vkCmdBindDescriptorSets(vk->cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->pipelineLayout, 0, 1, sets, 1, &offset);
+		vk->stateChanges++;
+	}
+}
+
+static void vknvg__resetCalls(VKNVGcontext* vk)
+{
+	vk->nverts = 0;
+	vk->npaths = 0;
+	vk->ncalls = 0;
+	vk->nuniforms = 0;
+	vk->lastFragCall = -1;
+}
+
+static void vknvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	vk->view[0] = width;
+	vk->view[1] = height;
+	vk->devicePixelRatio = devicePixelRatio;
+	memset(&vk->stats, 0, sizeof(vk->stats));
+	vk->stats.filteredStateChanges = vk->stateChanges;
+	vknvg__resetCalls(vk);
+}
+
+static void vknvg__fill(VKNVGcontext* vk, VKNVGcall* call)
+{
+	VKNVGpath* paths = &vk->paths[call->pathOffset];
+	int i, npaths = call->pathCount;
+
+	// Draw shapes
+	if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_FILL_STENCIL, &call->blendFunc)) return;
+	vknvg__setUniforms(vk, call->uniformOffset, 0);
+	for (i = 0; i < npaths; i++)
+		vkCmdDraw(vk->cmd, paths[i].fillCount, 1, paths[i].fillOffset, 0);
+
+	// Draw anti-aliased pixels
+	vknvg__setUniforms(vk, call->uniformOffset + vk->fragSize, call->image);
+
+	if (vk->flags & NVGVK_ANTIALIAS) {
+		if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_FRINGE, &call->blendFunc)) return;
+		// Draw fringes
+		for (i = 0; i < npaths; i++)
+			vkCmdDraw(vk->cmd, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
+	}
+
+	// Draw fill
+	if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_FILL_COVER, &call->blendFunc)) return;
+	vkCmdDraw(vk->cmd, call->triangleCount, 1, call->triangleOffset, 0);
+}
+
+static void vknvg__convexFill(VKNVGcontext* vk, VKNVGcall* call)
+{
+	VKNVGpath* paths = &vk->paths[call->pathOffset];
+	int i, npaths = call->pathCount;
+
+	vknvg__setUniforms(vk, call->uniformOffset, call->image);
+
+	// Fans, triangulated fills and fringes use different pipelines, draw all the fills first.
+	if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_CONVEX_FILL, &call->blendFunc)) return;
+	for (i = 0; i < npaths; i++) {
+		if (!paths[i].fillTriangles)
+			vkCmdDraw(vk->cmd, paths[i].fillCount, 1, paths[i].fillOffset, 0);
+	}
+	for (i = 0; i < npaths; i++) {
+		if (paths[i].fillTriangles) {
+			if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_TRIANGLES, &call->blendFunc)) return;
+			vkCmdDraw(vk->cmd, paths[i].fillCount, 1, paths[i].fillOffset, 0);
+		}
+	}
+
+	// Draw fringes
+	if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_STROKE, &call->blendFunc)) return;
+	for (i = 0; i < npaths; i++) {
+		if (paths[i].strokeCount > 0)
+			vkCmdDraw(vk->cmd, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
+	}
+}
+
+static void vknvg__stroke(VKNVGcontext* vk, VKNVGcall* call)
+{
+	VKNVGpath* paths = &vk->paths[call->pathOffset];
+	int npaths = call->pathCount, i;
+
+	if (vk->flags & NVGVK_STENCIL_STROKES) {
+
+		// Fill the stroke base without overlap
+		if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_STROKE_BASE, &call->blendFunc)) return;
+		vknvg__setUniforms(vk, call->uniformOffset + vk->fragSize, call->image);
+		for (i = 0; i < npaths; i++)
+			vkCmdDraw(vk->cmd, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
+
+		// Draw anti-aliased pixels.
+		if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_FRINGE, &call->blendFunc)) return;
+		vknvg__setUniforms(vk, call->uniformOffset, call->image);
+		for (i = 0; i < npaths; i++)
+			vkCmdDraw(vk->cmd, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
+
+		// Clear stencil buffer.
+		if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_STROKE_CLEAR, &call->blendFunc)) return;
+		for (i = 0; i < npaths; i++)
+			vkCmdDraw(vk->cmd, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
+
+	} else {
+		if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_STROKE, &call->blendFunc)) return;
+		vknvg__setUniforms(vk, call->uniformOffset, call->image);
+		// Draw Strokes
+		for (i = 0; i < npaths; i++)
+			vkCmdDraw(vk->cmd, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
+	}
+}
+
+static void vknvg__triangles(VKNVGcontext* vk, VKNVGcall* call)
+{
+	if (!vknvg__bindPipeline(vk, VKNVG_PIPELINE_TRIANGLES, &call->blendFunc)) return;
+	vknvg__setUniforms(vk, call->uniformOffset, call->image);
+	vkCmdDraw(vk->cmd, call->triangleCount, 1, call->triangleOffset, 0);
+}
+
+static void vknvg__renderCancel(void* uptr) {
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	vknvg__resetCalls(vk);
+	vk->cmd = VK_NULL_HANDLE;
+}
+
+static int vknvg_convertBlendFuncFactor(int factor, VkBlendFactor* ret)
+{
+	if (factor == NVG_ZERO)
+		*ret = VK_BLEND_FACTOR_ZERO;
+	else if (factor == NVG_ONE)
+		*ret = VK_BLEND_FACTOR_ONE;
+	else if (factor == NVG_SRC_COLOR)
+		*ret = VK_BLEND_FACTOR_SRC_COLOR;
+	else if (factor == NVG_ONE_MINUS_SRC_COLOR)
+		*ret = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+	else if (factor == NVG_DST_COLOR)
+		*ret = VK_BLEND_FACTOR_DST_COLOR;
+	else if (factor == NVG_ONE_MINUS_DST_COLOR)
+		*ret = VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+	else if (factor == NVG_SRC_ALPHA)
+		*ret = VK_BLEND_FACTOR_SRC_ALPHA;
+	else if (factor == NVG_ONE_MINUS_SRC_ALPHA)
+		*ret = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	else if (factor == NVG_DST_ALPHA)
+		*ret = VK_BLEND_FACTOR_DST_ALPHA;
+	else if (factor == NVG_ONE_MINUS_DST_ALPHA)
+		*ret = VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+	else if (factor == NVG_SRC_ALPHA_SATURATE)
+		*ret = VK_BLEND_FACTOR_SRC_ALPHA_SATURATE;
+	else
+		return 0;
+	return 1;
+}
+
+static VKNVGblend vknvg__blendCompositeOperation(NVGcompositeOperationState op)
+{
+	VKNVGblend blend;
+	if (!vknvg_convertBlendFuncFactor(op.srcRGB, &blend.srcRGB) ||
+		!vknvg_convertBlendFuncFactor(op.dstRGB, &blend.dstRGB) ||
+		!vknvg_convertBlendFuncFactor(op.srcAlpha, &blend.srcAlpha) ||
+		!vknvg_convertBlendFuncFactor(op.dstAlpha, &blend.dstAlpha))
+	{
+		blend = vknvg__sourceOver;
+	}
+	return blend;
+}
+
+// Records the texture uploads and copies the vertices and uniforms to the buffers of the frame.
+// The calls are kept until nvgvkRenderFrame() records them inside the render pass.
+static void vknvg__renderFlush(void* uptr)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGframe* frame = &vk->frames[vk->frame];
+
+	// Without a command buffer the uploads wait for the next frame.
+	if (vk->cmd == VK_NULL_HANDLE) goto error;
+	// Calls could sample textures before their upload.
+	if (!vknvg__recordUploads(vk)) goto error;
+
+	if (vk->ncalls > 0) {
+		VkDeviceSize fragBytes = (VkDeviceSize)vk->nuniforms * vk->fragSize;
+		VkBuffer oldFragBuf = frame->fragBuf.buffer;
+
+		// The GPU is done with this frame's buffers, they can be written without waiting.
+		if (!vknvg__reserveBuffer(vk, &frame->vertBuf, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vk->nverts * sizeof(NVGvertex), 4096 * sizeof(NVGvertex)))
+			goto error;
+		if (!vknvg__reserveBuffer(vk, &frame->fragBuf, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, fragBytes, 128 * vk->fragSize))
+			goto error;
+		if (frame->fragBuf.buffer != oldFragBuf) {
+			VkDescriptorBufferInfo bufInfo;
+			VkWriteDescriptorSet write;
+			memset(&bufInfo, 0, sizeof(bufInfo));
+			bufInfo.buffer = frame->fragBuf.buffer;
+			bufInfo.range = sizeof(VKNVGfragUniforms);
+			memset(&write, 0, sizeof(write));
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = frame->fragSet;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			write.pBufferInfo = &bufInfo;
+			vkUpdateDescriptorSets(vk->info.device, 1, &write, 0, NULL);
+		}
+		memcpy(frame->vertBuf.ptr, vk->verts, vk->nverts * sizeof(NVGvertex));
+		memcpy(frame->fragBuf.ptr, vk->uniforms, (size_t)fragBytes);
+		vk->stats.vertexBytes += vk->nverts * sizeof(NVGvertex);
+		vk->stats.uniformBytes += (int)fragBytes;
+	}
+	return;
+
+error:
+	vknvg__resetCalls(vk);
+	vk->cmd = VK_NULL_HANDLE;
+}
+
+static int vknvg__maxVertCount(const NVGpath* paths, int npaths)
+{
+	int i, count = 0;
+	for (i = 0; i < npaths; i++) {
+		count += paths[i].nfill;
+		count += paths[i].nstroke;
+	}
+	return count;
+}
+
+static VKNVGcall* vknvg__allocCall(VKNVGcontext* vk)
+{
+	VKNVGcall* ret = NULL;
+	if (vk->ncalls+1 > vk->ccalls) {
+		VKNVGcall* calls;
+		int ccalls = vknvg__maxi(vk->ncalls+1, 128) + vk->ccalls/2; // 1.5x Overallocate
+		calls = (VKNVGcall*)realloc(vk->calls, sizeof(VKNVGcall) * ccalls);
+		if (calls == NULL) return NULL;
+		vk->calls = calls;
+		vk->ccalls = ccalls;
+	}
+	ret = &vk->calls[vk->ncalls++];
+	memset(ret, 0, sizeof(VKNVGcall));
+	return ret;
+}
+
+static int vknvg__allocPaths(VKNVGcontext* vk, int n)
+{
+	int ret = 0;
+	if (vk->npaths+n > vk->cpaths) {
+		VKNVGpath* paths;
+		int cpaths = vknvg__maxi(vk->npaths + n, 128) + vk->cpaths/2; // 1.5x Overallocate
+		paths = (VKNVGpath*)realloc(vk->paths, sizeof(VKNVGpath) * cpaths);
+		if (paths == NULL) return -1;
+		vk->paths = paths;
+		vk->cpaths = cpaths;
+	}
+	ret = vk->npaths;
+	vk->npaths += n;
+	return ret;
+}
+
+static int vknvg__allocVerts(VKNVGcontext* vk, int n)
+{
+	int ret = 0;
+	if (vk->nverts+n > vk->cverts) {
+		NVGvertex* verts;
+		int cverts = vknvg__maxi(vk->nverts + n, 4096) + vk->cverts/2; // 1.5x Overallocate
+		verts = (NVGvertex*)realloc(vk->verts, sizeof(NVGvertex) * cverts);
+		if (verts == NULL) return -1;
+		vk->verts = verts;
+		vk->cverts = cverts;
+	}
+	ret = vk->nverts;
+	vk->nverts += n;
+	return ret;
+}
+
+static int vknvg__allocFragUniforms(VKNVGcontext* vk, int n)
+{
+	int ret = 0, structSize = vk->fragSize;
+	if (vk->nuniforms+n > vk->cuniforms) {
+		unsigned char* uniforms;
+		int cuniforms = vknvg__maxi(vk->nuniforms+n, 128) + vk->cuniforms/2; // 1.5x Overallocate
+		uniforms = (unsigned char*)realloc(vk->uniforms, structSize * cuniforms);
+		if (uniforms == NULL) return -1;
+		vk->uniforms = uniforms;
+		vk->cuniforms = cuniforms;
+	}
+	ret = vk->nuniforms * structSize;
+	vk->nuniforms += n;
+	return ret;
+}
+
+static VKNVGfragUniforms* vknvg__fragUniformPtr(VKNVGcontext* vk, int i)
+{
+	return (VKNVGfragUniforms*)&vk->uniforms[i];
+}
+
+// Merges the last call into the previous call, if they are adjacent and use the same state.
+static int vknvg__mergeCall(VKNVGcontext* vk, const VKNVGfragUniforms* frag)
+{
+	VKNVGcall* call;
+	VKNVGcall* prev;
+
+	if (vk->ncalls < 2 || vk->lastFragCall != vk->ncalls-2) return 0;
+	call = &vk->calls[vk->ncalls-1];
+	prev = &vk->calls[vk->ncalls-2];
+
+	if (prev->type != call->type || prev->image != call->image) return 0;
+	if (memcmp(&prev->blendFunc, &call->blendFunc, sizeof(VKNVGblend)) != 0) return 0;
+	if (memcmp(&vk->lastFrag, frag, sizeof(VKNVGfragUniforms)) != 0) return 0;
+
+	if (call->type == VKNVG_CONVEXFILL) {
+		if (prev->pathOffset + prev->pathCount != call->pathOffset) return 0;
+		prev->pathCount += call->pathCount;
+	} else if (call->type == VKNVG_TRIANGLES) {
+		if (prev->triangleOffset + prev->triangleCount != call->triangleOffset) return 0;
+		prev->triangleCount += call->triangleCount;
+	} else {
+		return 0;
+	}
+
+	vk->ncalls--;
+	vk->stats.mergedCalls++;
+	return 1;
+}
+
+// Allocates uniforms for the last call, and remembers them so that following calls can be merged into it.
+static int vknvg__allocCallUniforms(VKNVGcontext* vk, VKNVGcall* call, const VKNVGfragUniforms* frag)
+{
+	call->uniformOffset = vknvg__allocFragUniforms(vk, 1);
+	if (call->uniformOffset == -1) return 0;
+	memcpy(vknvg__fragUniformPtr(vk, call->uniformOffset), frag, sizeof(VKNVGfragUniforms));
+	vk->lastFrag = *frag;
+	vk->lastFragCall = vk->ncalls-1;
+	return 1;
+}
+
+static void vknvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
+{
+	vtx->x = x;
+	vtx->y = y;
+	vtx->u = u;
+	vtx->v = v;
+}
+
+static void vknvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							  const float* bounds, const NVGpath* paths, int npaths)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGcall* call = vknvg__allocCall(vk);
+	NVGvertex* quad;
+	VKNVGfragUniforms* stencilFrag;
+	VKNVGfragUniforms frag;
+	int i, maxverts, offset;
+
+	if (call == NULL) return;
+
+	call->type = VKNVG_FILL;
+	call->triangleCount = 4;
+	call->pathOffset = vknvg__allocPaths(vk, npaths);
+	if (call->pathOffset == -1) goto error;
+	call->pathCount = npaths;
+	call->image = paint->image;
+	call->blendFunc = vknvg__blendCompositeOperation(compositeOperation);
+
+	if (npaths == 1 && (paths[0].convex || paths[0].triangulated))
+	{
+		call->type = VKNVG_CONVEXFILL;
+		call->triangleCount = 0;	// Bounding box fill quad not needed for convex fill
+	}
+
+	// Allocate vertices for all the paths.
+	maxverts = vknvg__maxVertCount(paths, npaths) + call->triangleCount;
+	offset = vknvg__allocVerts(vk, maxverts);
+	if (offset == -1) goto error;
+
+	for (i = 0; i < npaths; i++) {
+		VKNVGpath* copy = &vk->paths[call->pathOffset + i];
+		const NVGpath* path = &paths[i];
+		memset(copy, 0, sizeof(VKNVGpath));
+		if (path->nfill > 0) {
+			copy->fillOffset = offset;
+			copy->fillCount = path->nfill;
+			copy->fillTriangles = path->triangulated;
+			memcpy(&vk->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
+			offset += path->nfill;
+		}
+		if (path->nstroke > 0) {
+			copy->strokeOffset = offset;
+			copy->strokeCount = path->nstroke;
+			memcpy(&vk->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			offset += path->nstroke;
+		}
+	}
+
+	// Setup uniforms for draw calls
+	if (call->type == VKNVG_FILL) {
+		// Quad
+		call->triangleOffset = offset;
+		quad = &vk->verts[call->triangleOffset];
+		vknvg__vset(&quad[0], bounds[2], bounds[3], 0.5f, 1.0f);
+		vknvg__vset(&quad[1], bounds[2], bounds[1], 0.5f, 1.0f);
+		vknvg__vset(&quad[2], bounds[0], bounds[3], 0.5f, 1.0f);
+		vknvg__vset(&quad[3], bounds[0], bounds[1], 0.5f, 1.0f);
+
+		call->uniformOffset = vknvg__allocFragUniforms(vk, 2);
+		if (call->uniformOffset == -1) goto error;
+		// Simple shader for stencil
+		stencilFrag = vknvg__fragUniformPtr(vk, call->uniformOffset);
+		memset(stencilFrag, 0, sizeof(*stencilFrag));
+		stencilFrag->strokeThr = -1.0f;
+		stencilFrag->type = VKNVG_SHADER_SIMPLE;
+		// Fill shader
+		vknvg__convertPaint(vk, vknvg__fragUniformPtr(vk, call->uniformOffset + vk->fragSize), paint, scissor, fringe, fringe, -1.0f);
+	} else {
+		// Fill shader
+		vknvg__convertPaint(vk, &frag, paint, scissor, fringe, fringe, -1.0f);
+		if (vknvg__mergeCall(vk, &frag)) return;
+		if (vknvg__allocCallUniforms(vk, call, &frag) == 0) goto error;
+	}
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (vk->ncalls > 0) vk->ncalls--;
+}
+
+static void vknvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+								float strokeWidth, const NVGpath* paths, int npaths)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGcall* call = vknvg__allocCall(vk);
+	int i, maxverts, offset;
+
+	if (call == NULL) return;
+
+	call->type = VKNVG_STROKE;
+	call->pathOffset = vknvg__allocPaths(vk, npaths);
+	if (call->pathOffset == -1) goto error;
+	call->pathCount = npaths;
+	call->image = paint->image;
+	call->blendFunc = vknvg__blendCompositeOperation(compositeOperation);
+
+	// Allocate vertices for all the paths.
+	maxverts = vknvg__maxVertCount(paths, npaths);
+	offset = vknvg__allocVerts(vk, maxverts);
+	if (offset == -1) goto error;
+
+	for (i = 0; i < npaths; i++) {
+		VKNVGpath* copy = &vk->paths[call->pathOffset + i];
+		const NVGpath* path = &paths[i];
+		memset(copy, 0, sizeof(VKNVGpath));
+		if (path->nstroke) {
+			copy->strokeOffset = offset;
+			copy->strokeCount = path->nstroke;
+			memcpy(&vk->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			offset += path->nstroke;
+		}
+	}
+
+	if (vk->flags & NVGVK_STENCIL_STROKES) {
+		// Fill shader
+		call->uniformOffset = vknvg__allocFragUniforms(vk, 2);
+		if (call->uniformOffset == -1) goto error;
+
+		vknvg__convertPaint(vk, vknvg__fragUniformPtr(vk, call->uniformOffset), paint, scissor, strokeWidth, fringe, -1.0f);
+		vknvg__convertPaint(vk, vknvg__fragUniformPtr(vk, call->uniformOffset + vk->fragSize), paint, scissor, strokeWidth, fringe, 1.0f - 0.5f/255.0f);
+
+	} else {
+		// Fill shader
+		call->uniformOffset = vknvg__allocFragUniforms(vk, 1);
+		if (call->uniformOffset == -1) goto error;
+		vknvg__convertPaint(vk, vknvg__fragUniformPtr(vk, call->uniformOffset), paint, scissor, strokeWidth, fringe, -1.0f);
+	}
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (vk->ncalls > 0) vk->ncalls--;
+}
+
+static void vknvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts, float fringe)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VKNVGcall* call = vknvg__allocCall(vk);
+	VKNVGfragUniforms frag;
+
+	if (call == NULL) return;
+
+	call->type = VKNVG_TRIANGLES;
+	call->image = paint->image;
+	call->blendFunc = vknvg__blendCompositeOperation(compositeOperation);
+
+	// Allocate vertices for all the paths.
+	call->triangleOffset = vknvg__allocVerts(vk, nverts);
+	if (call->triangleOffset == -1) goto error;
+	call->triangleCount = nverts;
+
+	memcpy(&vk->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+
+	// Fill shader
+	vknvg__convertPaint(vk, &frag, paint, scissor, 1.0f, fringe, -1.0f);
+	vknvg__setTextureShader(vk, &frag, paint);
+	if (vknvg__mergeCall(vk, &frag)) return;
+	if (vknvg__allocCallUniforms(vk, call, &frag) == 0) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (vk->ncalls > 0) vk->ncalls--;
+}
+
+static void vknvg__renderFrameStats(void* uptr, NVGframeStats* stats)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	stats->mergedCalls = vk->stats.mergedCalls;
+	stats->vertexBytes = vk->stats.vertexBytes;
+	stats->uniformBytes = vk->stats.uniformBytes;
+	stats->textureBytes = vk->stats.textureBytes;
+	stats->filteredStateChanges = vk->stats.filteredStateChanges;
+}
+
+static void vknvg__renderDelete(void* uptr)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)uptr;
+	VkDevice device;
+	const VkAllocationCallbacks* allocator;
+	int i;
+	if (vk == NULL) return;
+
+	device = vk->info.device;
+	allocator = vk->info.allocator;
+	if (device != VK_NULL_HANDLE) {
+		for (i = 0; i < vk->nframes; i++) {
+			vknvg__destroyGarbage(vk, &vk->frames[i]);
+			vknvg__deleteBuffer(vk, &vk->frames[i].vertBuf);
+			vknvg__deleteBuffer(vk, &vk->frames[i].fragBuf);
+			vknvg__deleteBuffer(vk, &vk->frames[i].staging);
+		}
+		for (i = 0; i < vk->ntextures; i++) {
+			if (vk->textures[i].id != 0)
+				vknvg__destroyTexture(vk, &vk->textures[i]);
+		}
+
+		for (i = 0; i < vk->npipelines; i++)
+			vkDestroyPipeline(device, vk->pipelines[i].pipeline, allocator);
+		for (i = 0; i < VKNVG_SAMPLER_COUNT; i++) {
+			if (vk->samplers[i] != VK_NULL_HANDLE)
+				vkDestroySampler(device, vk->samplers[i], allocator);
+		}
+		for (i = 0; i < vk->ntexPools; i++)
+			vkDestroyDescriptorPool(device, vk->texPools[i], allocator);
+		if (vk->fragPool != VK_NULL_HANDLE)
+			vkDestroyDescriptorPool(device, vk->fragPool, allocator);
+		if (vk->pipelineLayout != VK_NULL_HANDLE)
+			vkDestroyPipelineLayout(device, vk->pipelineLayout, allocator);
+		if (vk->texSetLayout != VK_NULL_HANDLE)
+			vkDestroyDescriptorSetLayout(device, vk->texSetLayout, allocator);
+		if (vk->fragSetLayout != VK_NULL_HANDLE)
+			vkDestroyDescriptorSetLayout(device, vk->fragSetLayout, allocator);
+		if (vk->fragShader != VK_NULL_HANDLE)
+			vkDestroyShaderModule(device, vk->fragShader, allocator);
+		if (vk->vertShader != VK_NULL_HANDLE)
+			vkDestroyShaderModule(device, vk->vertShader, allocator);
+	}
+
+	for (i = 0; i < vk->nframes; i++)
+		free(vk->frames[i].garbage);
+	free(vk->texPools);
+	free(vk->pipelines);
+	free(vk->textures);
+	free(vk->uploads);
+	free(vk->uploadData);
+
+	free(vk->paths);
+	free(vk->verts);
+	free(vk->uniforms);
+	free(vk->calls);
+
+	free(vk);
+}
+
+NVGcontext* nvgCreateVk(const NVGVKcreateInfo* info, int flags)
+{
+	NVGparams params;
+	NVGcontext* ctx = NULL;
+	VKNVGcontext* vk = (VKNVGcontext*)malloc(sizeof(VKNVGcontext));
+	if (vk == NULL) goto error;
+	memset(vk, 0, sizeof(VKNVGcontext));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = vknvg__renderCreate;
+	params.renderCreateTexture = vknvg__renderCreateTexture;
+	params.renderDeleteTexture = vknvg__renderDeleteTexture;
+	params.renderUpdateTexture = vknvg__renderUpdateTexture;
+	params.renderGetTextureSize = vknvg__renderGetTextureSize;
+	params.renderGetTextureType = vknvg__renderGetTextureType;
+	params.renderViewport = vknvg__renderViewport;
+	params.renderCancel = vknvg__renderCancel;
+	params.renderFlush = vknvg__renderFlush;
+	params.renderFill = vknvg__renderFill;
+	params.renderStroke = vknvg__renderStroke;
+	params.renderTriangles = vknvg__renderTriangles;
+	params.renderDelete = vknvg__renderDelete;
+	params.renderFrameStats = vknvg__renderFrameStats;
+	params.userPtr = vk;
+	params.edgeAntiAlias = flags & NVGVK_ANTIALIAS ? 1 : 0;
+	params.sdfText = flags & NVGVK_SDF_TEXT ? 1 : 0;
+	params.triangulateFills = flags & NVGVK_TRIANGULATE_FILLS ? 1 : 0;
+
+	vk->info = *info;
+	vk->nframes = info->framesInFlight;
+	if (vk->nframes < 1) vk->nframes = 1;
+	if (vk->nframes > NVGVK_MAX_FRAMES) vk->nframes = NVGVK_MAX_FRAMES;
+	vk->flags = flags;
+	vk->lastFragCall = -1;
+
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
+
+	return ctx;
+
+error:
+	// 'vk' is freed by nvgDeleteInternal.
+	if (ctx != NULL) nvgDeleteInternal(ctx);
+	return NULL;
+}
+
+void nvgDeleteVk(NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
+
+void nvgvkBeginFrame(NVGcontext* ctx, VkCommandBuffer cmd, int frame)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	vk->frame = frame % vk->nframes;
+	vk->cmd = cmd;
+	// The previous use of the frame is done, so are the textures deleted during it.
+	vknvg__destroyGarbage(vk, &vk->frames[vk->frame]);
+}
+
+void nvgvkRenderFrame(NVGcontext* ctx)
+{
+	VKNVGcontext* vk = (VKNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	VKNVGframe* frame = &vk->frames[vk->frame];
+	VkDeviceSize vertOffset = 0;
+	int i;
+
+	vk->stateChanges = 0;
+	if (vk->ncalls > 0 && vk->cmd != VK_NULL_HANDLE) {
+		VkViewport viewport;
+		VkRect2D scissor;
+
+		vkCmdBindVertexBuffers(vk->cmd, 0, 1, &frame->vertBuf.buffer, &vertOffset);
+		vkCmdPushConstants(vk->cmd, vk->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, 2*sizeof(float), vk->view);
+
+		// The viewport covers the framebuffer from the top left corner.
+		memset(&viewport, 0, sizeof(viewport));
+		viewport.width = vk->view[0] * vk->devicePixelRatio;
+		viewport.height = vk->view[1] * vk->devicePixelRatio;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(vk->cmd, 0, 1, &viewport);
+		memset(&scissor, 0, sizeof(scissor));
+		scissor.extent.width = (uint32_t)(viewport.width + 0.5f);
+		scissor.extent.height = (uint32_t)(viewport.height + 0.5f);
+		vkCmdSetScissor(vk->cmd, 0, 1, &scissor);
+
+		vk->boundPipeline = VK_NULL_HANDLE;
+		vk->boundTexSet = VK_NULL_HANDLE;
+
+		for (i = 0; i < vk->ncalls; i++) {
+			VKNVGcall* call = &vk->calls[i];
+			if (call->type == VKNVG_FILL)
+				vknvg__fill(vk, call);
+			else if (call->type == VKNVG_CONVEXFILL)
+				vknvg__convexFill(vk, call);
+			else if (call->type == VKNVG_STROKE)
+				vknvg__stroke(vk, call);
+			else if (call->type == VKNVG_TRIANGLES)
+				vknvg__triangles(vk, call);
+		}
+	}
+
+	vknvg__resetCalls(vk);
+	vk->cmd = VK_NULL_HANDLE;
+}
+
+#endif /* NANOVG_VK_IMPLEMENTATION */
@@ -0,0 +1,19 @@
+// Vertex shader of the Vulkan back-end, compile to SPIR-V with e.g.
+// glslangValidator -V nanovg_vk.vert -o nanovg_vk.vert.spv
+#version 450
+
+layout(push_constant) uniform view {
+	vec2 viewSize;
+};
+
+layout(location = 0) in vec2 vertex;
+layout(location = 1) in vec2 tcoord;
+layout(location = 0) out vec2 ftcoord;
+layout(location = 1) out vec2 fpos;
+
+void main(void) {
+	ftcoord = tcoord;
+	fpos = vertex;
+	// Vulkan clip space has y pointing down, like the nanovg coordinates.
+	gl_Position = vec4(2.0*vertex.x/viewSize.x - 1.0, 2.0*vertex.y/viewSize.y - 1.0, 0, 1);
+}